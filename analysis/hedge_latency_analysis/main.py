@@ -17,8 +17,10 @@ class MarketDataManager:
             self._load_from_npz(data_file)
         elif file_ext == ".csv":
             self._load_from_csv(data_file)
+        elif file_ext == ".ticks":
+            self._load_from_ticks(data_file)
         else:
-            raise ValueError(f"Unsupported file format: {file_ext}. Use .csv or .npz")
+            raise ValueError(f"Unsupported file format: {file_ext}. Use .csv, .npz or .ticks")
 
     def _load_from_npz(self, npz_file):
         # Load arrays from NPZ file
@@ -28,6 +30,15 @@ class MarketDataManager:
         self.bid_timestamps = data["bid_timestamps"]
         self.bid_prices = data["bid_prices"]
 
+    def _load_from_ticks(self, ticks_file):
+        # One day file of the tick store, see python_packages/tick_store
+        from tick_store import TickFile
+
+        ticks = TickFile(ticks_file).read()
+        self.ask_timestamps = self.bid_timestamps = ticks["timestamp_ns"]
+        self.ask_prices = ticks["ask_price"]
+        self.bid_prices = ticks["bid_price"]
+
     def _load_from_csv(self, csv_file):
         self.data_file = csv_file
         self.df = pd.read_csv(csv_file)
@@ -0,0 +1,622 @@
+#pragma once
+
+#include "../infra/book.hpp"
+#include "../src/Configuration.h"
+#include "../src/HedgeRouter.h"
+#include "../src/Hedger.h"
+#include "../src/OrderHealthCheck.h"
+#include "../src/FairValueService.h"
+#include "../src/PnlManager.h"
+#include "../src/Side.h"
+#include "../src/TargetOrderManager.h"
+#include "../src/TradeAnalysis.h"
+#include "../src/rounding.h"
+#include "../utils/helper.hpp"
+#include "../utils/instrumentregistry.hpp"
+#include "MarketData.h"
+#include "SimulatedExchange.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <memory>
+#include <nlohmann/json.hpp>
+#include <span>
+#include <string>
+#include <vector>
+
+#ifndef BACKTEST_SIMULATED_CLOCK
+#error "backtests need BACKTEST_SIMULATED_CLOCK so the strategy components read replay time"
+#endif
+
+namespace backtest {
+
+// Simulation parameters from the `backtest` section of the strategy config
+struct BacktestConfig {
+    LatencyModel quote_latency;
+    LatencyModel hedge_latency;
+    uint64_t reference_latency_ns{0}; // market data only, nothing is traded there
+    FeeModel quote_fees;
+    FeeModel hedge_fees;
+    QueueModel quote_queue;
+    QueueModel hedge_queue;
+    double min_hedge_size{0.0}; // defaults to the hedge quantity tick
+
+    static BacktestConfig from_config(const Configuration& config) {
+        BacktestConfig settings;
+        settings.min_hedge_size =
+            config.child("markets").child("hedge").child("tick_sizes").get<double>("quantity", 0.0001);
+        if(!config.has_key("backtest")) {
+            return settings;
+        }
+        const auto node = config.child("backtest");
+        settings.reference_latency_ns = micros_to_ns(node.get<double>("reference_latency_us", 0.0));
+        settings.min_hedge_size = node.get<double>("min_hedge_size", settings.min_hedge_size);
+        read_venue(node, "quote", settings.quote_latency, settings.quote_fees, settings.quote_queue);
+        read_venue(node, "hedge", settings.hedge_latency, settings.hedge_fees, settings.hedge_queue);
+        return settings;
+    }
+
+private:
+    static uint64_t micros_to_ns(double micros) { return static_cast<uint64_t>(micros * 1'000.0); }
+
+    static void read_venue(
+        const Configuration& node, const std::string& key, LatencyModel& latency, FeeModel& fees, QueueModel& queue) {
+        if(!node.has_key(key)) {
+            return;
+        }
+        const auto venue = node.child(key);
+        latency.market_data_ns = micros_to_ns(venue.get<double>("market_data_latency_us", 0.0));
+        latency.order_ns = micros_to_ns(venue.get<double>("order_latency_us", 0.0));
+        latency.report_ns = micros_to_ns(venue.get<double>("report_latency_us", 0.0));
+        latency.fill_ns = venue.has_key("fill_latency_us") ? micros_to_ns(venue.get<double>("fill_latency_us"))
+                                                           : latency.report_ns;
+        queue.cancel_power = venue.get<double>("queue_cancel_power", queue.cancel_power);
+        fees.maker_rate = venue.get<double>("maker_fee", 0.0);
+        fees.taker_rate = venue.get<double>("taker_fee", 0.0);
+    }
+};
+
+struct BacktestResult {
+    uint64_t market_events{0};
+    uint64_t first_timestamp_ns{0};
+    uint64_t last_timestamp_ns{0};
+    SimulatedExchange::Stats quote;
+    SimulatedExchange::Stats hedge; // summed over the routed hedge venues when hedge routing is on
+    double quote_position{0.0};
+    double hedge_position{0.0};
+    double realized_pnl{0.0};
+    double unrealized_pnl{0.0};
+    double maker_fee{0.0};
+    double taker_fee{0.0};
+    double total_pnl_with_fee{0.0};
+    nlohmann::json quote_trades;
+    nlohmann::json hedge_trades;
+
+    [[nodiscard]] nlohmann::json to_json() const {
+        const auto venue = [](const SimulatedExchange::Stats& stats, double position) {
+            return nlohmann::json{{"orders", stats.orders},
+                                  {"amends", stats.amends},
+                                  {"cancels", stats.cancels},
+                                  {"rejects", stats.rejects},
+                                  {"maker_fills", stats.maker_fills},
+                                  {"taker_fills", stats.taker_fills},
+                                  {"maker_volume", stats.maker_volume},
+                                  {"taker_volume", stats.taker_volume},
+                                  {"fees", stats.fees},
+                                  {"position", position}};
+        };
+        nlohmann::json result;
+        result["market_events"] = market_events;
+        result["first_timestamp_ns"] = first_timestamp_ns;
+        result["last_timestamp_ns"] = last_timestamp_ns;
+        result["quote"] = venue(quote, quote_position);
+        result["hedge"] = venue(hedge, hedge_position);
+        result["pnl"] = {{"realized", realized_pnl},
+                         {"unrealized", unrealized_pnl},
+                         {"maker_fee", maker_fee},
+                         {"taker_fee", taker_fee},
+                         {"total_with_fee", total_pnl_with_fee}};
+        result["quote_trades"] = quote_trades;
+        result["hedge_trades"] = hedge_trades;
+        return result;
+    }
+};
+
+// Replays recorded market data through the production quoting and hedging components. The quote
+// and hedge instruments each get a SimulatedExchange; the strategy sees every book after the
+// venue's market data latency and every order report after its report latency, all on one replay
+// clock that helper::get_current_timestamp_ns() returns, so staleness checks and hedge budgets
+// fire as they would live.
+//
+// On every book update the strategy refreshes its target orders, pulls a side whose orders fail
+// the health checks or would grow the position past max_position, cancels working orders that are
+// no longer targets and places the missing ones. Every delivered fill goes to PnlManager and
+// TradeAnalysis and triggers Hedger, which also runs on hedge book updates while exposure is left.
+//
+// With hedge_routing enabled a HedgeRouter takes Hedger's place and hedges across its venues. Every
+// venue gets its own SimulatedExchange, with the hedge market's latency and queue models and the
+// venue's taker_fee unless it is the hedge market itself, and every order response of a venue feeds
+// the router's ack latency.
+//
+// One engine runs one backtest on the calling thread; engines on different threads may share the
+// MarketDataSet.
+// @example
+//   const auto data = MarketDataSet::load_csv("btc_20240610.csv");
+//   BacktestEngine engine(config, data);
+//   const BacktestResult result = engine.run();
+class BacktestEngine {
+public:
+    using QuoteMidServiceType = FairValueService<Book, SimulatedExchange>;
+    using TargetOrderManagerType = TargetOrderManager<Book, QuoteMidServiceType>;
+    using OrderHealthCheckerType = OrderHealthChecker<Book, QuoteMidServiceType, TargetOrderManagerType>;
+    using HedgerType = Hedger<SimulatedExchange, SimulatedExchange, SimulatedExchange>;
+    using HedgeRouterType = HedgeRouter<SimulatedExchange>;
+
+    BacktestEngine(const Configuration& config, const MarketDataSet& data)
+        : BacktestEngine(config, data, BacktestConfig::from_config(config)) {}
+
+    BacktestEngine(const Configuration& config, const MarketDataSet& data, const BacktestConfig& settings)
+        : data_(data)
+        , settings_(settings)
+        , quote_id_(registry().require(config.child("markets").child("quote").get<std::string>("name")).id)
+        , hedge_id_(registry().require(config.child("markets").child("hedge").get<std::string>("name")).id)
+        , reference_id_(registry().require(config.child("quoting_reference_price").get<std::string>("source")).id)
+        , routed_ids_(routing_venues(config))
+        , hedge_instrument_(registry().get(hedge_id_).name)
+        , books_(make_books(book_instruments()))
+        , quote_exchange_(quote_id_, settings_.quote_latency, settings_.quote_fees, settings_.quote_queue)
+        , hedge_exchange_(hedge_id_, settings_.hedge_latency, settings_.hedge_fees, settings_.hedge_queue)
+        , quote_mid_service_(make_quote_mid_config(config, books_), quote_exchange_)
+        , target_order_manager_(book(quote_id_),
+                                book(reference_id_),
+                                make_target_order_config(config),
+                                make_order_configs(config),
+                                quote_mid_service_)
+        , health_checker_(config.child("quote_safety_control").child("price_distance_control").get<double>(
+                              "minimum_distance"),
+                          book(reference_id_),
+                          quote_mid_service_,
+                          target_order_manager_)
+        , hedger_(hedge_exchange_,
+                  quote_exchange_,
+                  hedge_exchange_,
+                  book(hedge_id_),
+                  hedge_instrument_,
+                  settings_.min_hedge_size,
+                  static_cast<uint64_t>(config.child("exchange_stability").get<double>("stale_threshold_ns")),
+                  config.child("hedge_safety_control").get<double>("max_spread"),
+                  HedgeExecutionConfig::from_config(config))
+        , pnl_manager_(book(hedge_id_))
+        , order_type_(config.child("order_placement_policy").get<std::string>("order_type", "post_only"))
+        , quote_tick_(config.child("markets").child("quote").child("tick_sizes").get<double>("price"))
+        , max_position_(config.child(registry().get(quote_id_).exchange + "_position").get<double>("max_position"))
+        , quote_trades_(TradeAnalysis::default_windows())
+        , hedge_trades_(TradeAnalysis::default_windows()) {
+        if(quote_id_ == hedge_id_) {
+            throw std::runtime_error("quote and hedge instrument must differ");
+        }
+        if(!routed_ids_.empty()) {
+            setup_hedge_routing(config);
+        }
+    }
+
+    BacktestEngine(const BacktestEngine&) = delete;
+    BacktestEngine& operator=(const BacktestEngine&) = delete;
+
+    // Quote, hedge, reference and routed hedge instruments of a strategy config, what a tick store
+    // load needs
+    static std::vector<std::string> instruments(const Configuration& config) {
+        std::vector<std::string> names = {config.child("markets").child("quote").get<std::string>("name"),
+                                          config.child("markets").child("hedge").get<std::string>("name"),
+                                          config.child("quoting_reference_price").get<std::string>("source")};
+        for(const auto id : routing_venues(config)) {
+            const auto& name = registry().get(id).name;
+            if(std::find(names.begin(), names.end(), name) == names.end()) {
+                names.push_back(name);
+            }
+        }
+        return names;
+    }
+
+    BacktestResult run() {
+        const std::vector<SimulatedExchange*> exchanges = all_exchanges();
+        std::vector<Source> sources;
+        for(auto* exchange : exchanges) {
+            const auto id = exchange->spec().id;
+            sources.push_back({SourceKind::ExchangeMarket, exchange, id, data_.events(id), 0});
+        }
+        for(auto* exchange : exchanges) {
+            sources.push_back({SourceKind::OrderArrival, exchange, exchange->spec().id, {}, 0});
+        }
+        // the reference and the routed venues may be the quote or hedge instrument, or each other; the
+        // updates of an instrument must not be replayed twice
+        std::vector<mapping::InstrumentId> replayed;
+        const auto add_strategy_market = [&](mapping::InstrumentId id, uint64_t delay_ns) {
+            if(std::find(replayed.begin(), replayed.end(), id) == replayed.end()) {
+                replayed.push_back(id);
+                sources.push_back({SourceKind::StrategyMarket, nullptr, id, data_.events(id), delay_ns});
+            }
+        };
+        add_strategy_market(quote_id_, settings_.quote_latency.market_data_ns);
+        add_strategy_market(hedge_id_, settings_.hedge_latency.market_data_ns);
+        add_strategy_market(reference_id_, settings_.reference_latency_ns);
+        for(const auto id : routed_ids_) {
+            add_strategy_market(id, settings_.hedge_latency.market_data_ns);
+        }
+        for(auto* exchange : exchanges) {
+            sources.push_back({SourceKind::Report, exchange, exchange->spec().id, {}, 0});
+        }
+
+        BacktestResult result;
+        // sources are ranked by kind, so at equal times the exchange moves before the strategy reacts
+        while(true) {
+            Source* next = nullptr;
+            uint64_t next_ns = UINT64_MAX;
+            for(auto& source : sources) {
+                const uint64_t at = source.next_ns();
+                if(at < next_ns) {
+                    next_ns = at;
+                    next = &source;
+                }
+            }
+            if(!next) {
+                break;
+            }
+
+            switch(next->kind) {
+            case SourceKind::ExchangeMarket: next->exchange->on_market_event(next->events[next->index++]); break;
+            case SourceKind::OrderArrival: next->exchange->process_arrival(); break;
+            case SourceKind::StrategyMarket:
+                set_time(next_ns);
+                on_market_data(next->instrument, next->events[next->index++]);
+                ++result.market_events;
+                break;
+            case SourceKind::Report:
+                set_time(next_ns);
+                next->exchange->deliver_report([this, next](const SimReport& report, const SimClientOrder& order) {
+                    on_report(*next->exchange, report, order);
+                });
+                break;
+            }
+        }
+
+        result.first_timestamp_ns = data_.first_timestamp_ns();
+        result.last_timestamp_ns = data_.last_timestamp_ns();
+        result.quote = quote_exchange_.stats();
+        result.hedge = hedge_exchange_.stats();
+        result.quote_position = quote_exchange_.get_position();
+        result.hedge_position = hedge_exchange_.get_position();
+        for(const auto& exchange : routed_exchanges_) {
+            result.hedge += exchange->stats();
+            result.hedge_position += exchange->get_position();
+        }
+        result.realized_pnl = pnl_manager_.get_realized_pnl();
+        result.unrealized_pnl = pnl_manager_.get_unrealized_pnl();
+        result.maker_fee = pnl_manager_.get_maker_fee();
+        result.taker_fee = pnl_manager_.get_taker_fee();
+        result.total_pnl_with_fee = pnl_manager_.get_total_pnl_with_fee();
+        result.quote_trades = quote_trades_.get_status();
+        result.hedge_trades = hedge_trades_.get_status();
+        return result;
+    }
+
+private:
+    enum class SourceKind : uint8_t { ExchangeMarket, OrderArrival, StrategyMarket, Report };
+
+    struct Source {
+        SourceKind kind;
+        SimulatedExchange* exchange;
+        mapping::InstrumentId instrument;
+        std::span<const MarketEvent> events;
+        uint64_t delay_ns;
+        size_t index = 0;
+
+        [[nodiscard]] uint64_t next_ns() const {
+            switch(kind) {
+            case SourceKind::ExchangeMarket:
+            case SourceKind::StrategyMarket:
+                return index < events.size() ? events[index].timestamp_ns + delay_ns : UINT64_MAX;
+            case SourceKind::OrderArrival: return exchange->next_arrival_ns();
+            case SourceKind::Report: return exchange->next_report_ns();
+            }
+            return UINT64_MAX;
+        }
+    };
+
+    static mapping::InstrumentRegistry& registry() { return mapping::InstrumentRegistry::instance(); }
+
+    // Instruments of hedge_routing.venues, none unless hedge routing is enabled
+    static std::vector<mapping::InstrumentId> routing_venues(const Configuration& config) {
+        std::vector<mapping::InstrumentId> ids;
+        if(!config.has_key("hedge_routing") || !config.child("hedge_routing").get<bool>("enabled", true)) {
+            return ids;
+        }
+        config.child("hedge_routing").child("venues").for_each_child([&ids](const Configuration& venue) {
+            const auto& spec = registry().require(venue.get<std::string>("name"));
+            if(std::find(ids.begin(), ids.end(), spec.id) != ids.end()) {
+                throw std::runtime_error("hedge routing venue " + spec.name + " is listed twice");
+            }
+            ids.push_back(spec.id);
+        });
+        return ids;
+    }
+
+    // Instruments the strategy keeps a book of
+    [[nodiscard]] std::vector<mapping::InstrumentId> book_instruments() const {
+        std::vector<mapping::InstrumentId> ids = {quote_id_, hedge_id_, reference_id_};
+        ids.insert(ids.end(), routed_ids_.begin(), routed_ids_.end());
+        return ids;
+    }
+
+    static std::vector<std::unique_ptr<Book>> make_books(const std::vector<mapping::InstrumentId>& instruments) {
+        std::vector<std::unique_ptr<Book>> books;
+        for(const auto id : instruments) {
+            if(id >= books.size()) {
+                books.resize(id + 1);
+            }
+            if(!books[id]) {
+                books[id] = std::make_unique<Book>(registry().get(id).name);
+            }
+        }
+        return books;
+    }
+
+    // Fair-value sources must be books the engine replays: the quote, hedge or reference instrument
+    static QuoteMidServiceType::Config make_quote_mid_config(const Configuration& config,
+                                                             const std::vector<std::unique_ptr<Book>>& books) {
+        const auto node = config.child("quoting_reference_price");
+        QuoteMidServiceType::Config quote_mid;
+        quote_mid.quote_mid.use_const_shift = node.has_key("constant_shift");
+        quote_mid.quote_mid.const_shift_ratio = node.get<double>("constant_shift", 0.0);
+        quote_mid.quote_mid.use_position_shift = node.has_key("position_shift");
+        quote_mid.quote_mid.shift_ratio_per_position = node.get<double>("position_shift", 0.0);
+        if(!node.has_key("fair_value") || !node.child("fair_value").get<bool>("enabled", true)) {
+            return quote_mid;
+        }
+        const auto fair_value = node.child("fair_value");
+        fair_value.child("sources").for_each_child([&](const Configuration& source) {
+            const auto name = source.get<std::string>("name");
+            const auto id = registry().require(name).id;
+            if(id >= books.size() || !books[id]) {
+                throw std::runtime_error("fair value source " + name + " is not a quote, hedge or reference book");
+            }
+            quote_mid.sources.push_back({books[id].get(), source.get<double>("weight", 1.0)});
+        });
+        quote_mid.microprice_weight = fair_value.get<double>("microprice_weight", quote_mid.microprice_weight);
+        quote_mid.imbalance_levels = fair_value.get<size_t>("imbalance_levels", quote_mid.imbalance_levels);
+        quote_mid.imbalance_decay = fair_value.get<double>("imbalance_decay", quote_mid.imbalance_decay);
+        quote_mid.imbalance_shift = fair_value.get<double>("imbalance_shift", quote_mid.imbalance_shift);
+        quote_mid.drift_halflife_ns =
+            static_cast<uint64_t>(fair_value.get<double>("drift_halflife_ms", 0.0) * 1'000'000.0);
+        quote_mid.drift_weight = fair_value.get<double>("drift_weight", quote_mid.drift_weight);
+        quote_mid.max_shift = fair_value.get<double>("max_shift", quote_mid.max_shift);
+        return quote_mid;
+    }
+
+    static TargetOrderManagerType::Config make_target_order_config(const Configuration& config) {
+        const auto ticks = config.child("markets").child("quote").child("tick_sizes");
+        const auto policy = config.child("order_placement_policy");
+        return {ticks.get<double>("price"),
+                ticks.get<double>("quantity"),
+                parse_price_round_mode(policy.get<std::string>("price_round_mode")),
+                parse_size_round_mode(policy.get<std::string>("size_round_mode")),
+                policy.child("shift_to_touch").get<bool>("enabled"),
+                policy.child("shift_to_touch").get<double>("ticks_from_touch"),
+                policy.child("shift_to_postable").get<bool>("enabled"),
+                policy.child("shift_to_postable").get<double>("ticks_from_postable"),
+                policy.get<std::string>("offset_base", "mid") == "touch" ? TargetOrderManagerType::OffsetBase::Touch
+                                                                         : TargetOrderManagerType::OffsetBase::Mid};
+    }
+
+    static std::vector<TargetOrderManagerType::OrderConfig> make_order_configs(const Configuration& config) {
+        std::vector<TargetOrderManagerType::OrderConfig> orders;
+        config.child("orders").for_each_child([&orders](const Configuration& order) {
+            orders.emplace_back(order.get<double>("price_offset"), order.get<double>("quantity"));
+        });
+        return orders;
+    }
+
+    [[nodiscard]] Book& book(mapping::InstrumentId id) const { return *books_[id]; }
+
+    // The hedge market keeps its exchange, the other venues get one each. A venue's index in
+    // hedge_venues_ is its index in the router.
+    void setup_hedge_routing(const Configuration& config) {
+        const auto routing = config.child("hedge_routing");
+        hedge_router_ = std::make_unique<HedgeRouterType>(
+            quote_exchange_,
+            settings_.min_hedge_size,
+            static_cast<uint64_t>(config.child("exchange_stability").get<double>("stale_threshold_ns")),
+            config.child("hedge_safety_control").get<double>("max_spread"),
+            routing.get<double>("latency_penalty_per_ms", 0.0));
+        const auto execution = HedgeExecutionConfig::from_config(config);
+        routing.child("venues").for_each_child([&](const Configuration& node) {
+            const auto id = routed_ids_[hedge_venues_.size()];
+            const auto& name = registry().get(id).name;
+            if(id == quote_id_) {
+                throw std::runtime_error("hedge routing venue " + name + " is the quote instrument");
+            }
+            const auto venue = HedgeVenueConfig::from_config(node, execution);
+            SimulatedExchange* exchange = &hedge_exchange_;
+            if(id != hedge_id_) {
+                routed_exchanges_.push_back(std::make_unique<SimulatedExchange>(
+                    id,
+                    settings_.hedge_latency,
+                    FeeModel{settings_.hedge_fees.maker_rate, venue.taker_fee},
+                    settings_.hedge_queue));
+                exchange = routed_exchanges_.back().get();
+            }
+            using Venue = HedgeVenue<SimulatedExchange, SimulatedExchange>;
+            hedge_router_->add_venue(std::make_unique<Venue>(name, *exchange, *exchange, book(id)), venue);
+            hedge_venues_.push_back(exchange);
+        });
+    }
+
+    [[nodiscard]] std::vector<SimulatedExchange*> all_exchanges() {
+        std::vector<SimulatedExchange*> exchanges = {&quote_exchange_, &hedge_exchange_};
+        for(const auto& exchange : routed_exchanges_) {
+            exchanges.push_back(exchange.get());
+        }
+        return exchanges;
+    }
+
+    void set_time(uint64_t now_ns) {
+        now_ns_ = now_ns;
+        helper::simulated_timestamp_ns = now_ns;
+        quote_exchange_.set_time(now_ns);
+        hedge_exchange_.set_time(now_ns);
+        for(const auto& exchange : routed_exchanges_) {
+            exchange->set_time(now_ns);
+        }
+    }
+
+    [[nodiscard]] TradeAnalysis::Clock::time_point time_point() const {
+        return TradeAnalysis::Clock::time_point(
+            std::chrono::duration_cast<TradeAnalysis::Clock::duration>(std::chrono::nanoseconds(now_ns_)));
+    }
+
+    [[nodiscard]] static bool has_touch(const Book& book) { return book.getBestBid() > 0. && book.getBestAsk() > 0.; }
+
+    [[nodiscard]] bool is_warmed_up() const {
+        return has_touch(book(quote_id_)) && has_touch(book(hedge_id_)) && has_touch(book(reference_id_));
+    }
+
+    [[nodiscard]] bool has_unhedged_exposure() const {
+        const double exposure = hedge_router_ ? hedge_router_->get_exposure()
+                                              : quote_exchange_.get_position() + hedge_exchange_.get_position();
+        return std::abs(exposure) >= settings_.min_hedge_size;
+    }
+
+    [[nodiscard]] bool is_hedge_venue(mapping::InstrumentId instrument) const {
+        return hedge_router_ ? std::find(routed_ids_.begin(), routed_ids_.end(), instrument) != routed_ids_.end()
+                             : instrument == hedge_id_;
+    }
+
+    [[nodiscard]] bool is_hedge_healthy() const {
+        return hedge_router_ ? hedge_router_->healthcheck().first : hedger_.healthcheck().first;
+    }
+
+    void hedge() {
+        if(hedge_router_) {
+            hedge_router_->hedge();
+        } else {
+            hedger_.hedge();
+        }
+    }
+
+    void on_market_data(mapping::InstrumentId instrument, const MarketEvent& event) {
+        if(event.kind != MarketEventKind::Level) {
+            return;
+        }
+        apply_level(book(instrument), event);
+        quote_mid_service_.on_book_update(book(instrument));
+        if(!is_warmed_up()) {
+            return;
+        }
+        if(is_hedge_venue(instrument) && has_unhedged_exposure()) {
+            hedge();
+        }
+        requote();
+    }
+
+    void on_report(SimulatedExchange& exchange, const SimReport& report, const SimClientOrder& order) {
+        const bool is_quote = &exchange == &quote_exchange_;
+        if(hedge_router_ && !is_quote) {
+            const auto venue = std::find(hedge_venues_.begin(), hedge_venues_.end(), &exchange) - hedge_venues_.begin();
+            hedge_router_->record_ack_latency(static_cast<size_t>(venue), report.deliver_ns - order.sent_ns);
+        }
+        if(report.kind == SimReportKind::Fill) {
+            pnl_manager_.add_trade(order.is_buy ? report.quantity : -report.quantity,
+                                   report.price,
+                                   report.fee,
+                                   report.is_maker);
+            (is_quote ? quote_trades_ : hedge_trades_)
+                .add_trade({time_point(), report.price, report.quantity, order.is_buy, report.is_maker});
+        }
+        if(!is_warmed_up()) {
+            return;
+        }
+        if(report.kind != SimReportKind::CancelRejected && report.kind != SimReportKind::AmendRejected) {
+            hedge();
+        }
+        if(is_quote) {
+            requote();
+        }
+    }
+
+    void requote() {
+        const bool hedger_healthy = is_hedge_healthy();
+        target_order_manager_.set_dirty<Side::Type::Ask>();
+        target_order_manager_.set_dirty<Side::Type::Bid>();
+        target_order_manager_.refresh_ask_target_orders();
+        target_order_manager_.refresh_bid_target_orders();
+        requote_side<Side::Type::Ask>(hedger_healthy);
+        requote_side<Side::Type::Bid>(hedger_healthy);
+    }
+
+    template<Side::Type SideType>
+    void requote_side(bool hedger_healthy) {
+        constexpr bool is_buy = SideType == Side::Type::Bid;
+        const double position = quote_exchange_.get_position();
+        const bool within_limit = is_buy ? position < max_position_ : position > -max_position_;
+        const bool healthy = hedger_healthy && within_limit && health_checker_.template check<SideType>();
+
+        cancel_ids_.clear();
+        for(const auto& order : quote_exchange_.client_orders()) {
+            if(order.is_buy != is_buy || order.cancel_sent) {
+                continue;
+            }
+            if(!healthy || !target_order_manager_.template is_in_target_orders<SideType>(order.price, order.size)) {
+                cancel_ids_.push_back(order.id);
+            }
+        }
+        for(const auto id : cancel_ids_) {
+            quote_exchange_.cancelOrder(id);
+        }
+        if(!healthy) {
+            return;
+        }
+
+        for(const auto& [price, target] : target_order_manager_.template get_target_orders<SideType>()) {
+            bool working = false;
+            for(const auto& order : quote_exchange_.client_orders()) {
+                if(order.is_buy == is_buy && !order.cancel_sent && std::abs(order.price - price) < quote_tick_ / 2) {
+                    working = true;
+                    break;
+                }
+            }
+            if(!working) {
+                quote_exchange_.placeOrder(quote_id_, target.price, target.size, is_buy, order_type_);
+            }
+        }
+    }
+
+    const MarketDataSet& data_;
+    const BacktestConfig settings_;
+    const mapping::InstrumentId quote_id_;
+    const mapping::InstrumentId hedge_id_;
+    const mapping::InstrumentId reference_id_;
+    const std::vector<mapping::InstrumentId> routed_ids_; // hedge_routing venues, empty without routing
+    const std::string hedge_instrument_;
+    const std::vector<std::unique_ptr<Book>> books_; // strategy view, index is the instrument id
+
+    SimulatedExchange quote_exchange_;
+    SimulatedExchange hedge_exchange_;
+    QuoteMidServiceType quote_mid_service_;
+    TargetOrderManagerType target_order_manager_;
+    OrderHealthCheckerType health_checker_;
+    HedgerType hedger_;
+    std::vector<std::unique_ptr<SimulatedExchange>> routed_exchanges_;
+    std::vector<SimulatedExchange*> hedge_venues_;
+    std::unique_ptr<HedgeRouterType> hedge_router_; // replaces hedger_ when set
+    PnlManager<Book> pnl_manager_;
+
+    const std::string order_type_;
+    const double quote_tick_;
+    const double max_position_;
+    TradeAnalysis quote_trades_;
+    TradeAnalysis hedge_trades_;
+    std::vector<uint64_t> cancel_ids_;
+    uint64_t now_ns_{0};
+};
+
+} // namespace backtest
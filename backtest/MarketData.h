@@ -0,0 +1,439 @@
+#pragma once
+
+#include "../infra/book.hpp"
+#include "../src/Side.h"
+#include "../utils/instrumentregistry.hpp"
+#include "../utils/mappedfile.hpp"
+#include "../utils/tickstore.hpp"
+#include <algorithm>
+#include <charconv>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <span>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+namespace backtest {
+
+enum class MarketEventKind : uint8_t {
+    Level, // absolute quantity of a price level, 0 removes it
+    Trade, // quantity executed against the resting orders of `side` at `price`
+};
+
+struct MarketEvent {
+    uint64_t timestamp_ns; // exchange time, the same clock Book::m_timestamp carries live
+    mapping::InstrumentId instrument;
+    Side::Type side;
+    MarketEventKind kind;
+    double price;
+    double quantity; // exchange units, i.e. contracts on venues that quote in contracts
+};
+
+static_assert(std::is_trivially_copyable_v<MarketEvent>, "market events are written to and mapped from files");
+
+// Applies a level event the way the feed handlers do: the level array first, then the touch
+inline void apply_level(Book& book, const MarketEvent& event) {
+    if(event.side == Side::Type::Ask) {
+        book.askSide.insert(event.price, event.quantity);
+        book.setBestAsk(book.askSide.getBestPrice());
+    } else {
+        book.bidSide.insert(event.price, event.quantity);
+        book.setBestBid(book.bidSide.getBestPrice());
+    }
+    book.m_timestamp = event.timestamp_ns;
+}
+
+// Recorded market data of every instrument of a backtest, split per instrument and sorted by time.
+// Read-only once loaded, so one data set can back any number of concurrent backtests.
+//
+// write_binary() stores the sorted events as raw arrays and map_binary() maps such a file instead
+// of parsing it again; all backtests of a sweep then read the same page-cache copy. Sections are
+// keyed by instrument name, so a file stays valid when the registry assigns other ids.
+// load_tick_store() reads the top of book the live engine records instead of a CSV.
+//
+// The CSV has a header naming its columns in any order:
+//   timestamp_ns (or exchangeTimestamp)  ns since the epoch
+//   instrument                           registry name, optional when a default instrument is given
+//   type                                 level/trade, optional and level by default
+//   side                                 ask/bid or 1/0 like the recorder output
+//   price, quantity
+// @example
+//   // timestamp_ns,instrument,type,side,price,quantity
+//   // 1718000000000000000,bybit_perp_btc_usdt,level,bid,67000.1,1.25
+//   // 1718000000000500000,bybit_perp_btc_usdt,trade,bid,67000.1,0.4
+//   const auto data = MarketDataSet::load_csv("btc_20240610.csv");
+//   for(const auto& event : data.events(bybit_id)) { ... }
+//   data.write_binary("btc_20240610.events");
+//   const auto mapped = MarketDataSet::map_binary("btc_20240610.events");
+class MarketDataSet {
+public:
+    static constexpr double UNKNOWN_SIZE = 1e9; // replayed for levels a venue reported without size
+
+    MarketDataSet() = default;
+    MarketDataSet(MarketDataSet&&) noexcept = default;
+    MarketDataSet& operator=(MarketDataSet&&) noexcept = default;
+    MarketDataSet(const MarketDataSet&) = delete; // the views point into this set's own storage
+    MarketDataSet& operator=(const MarketDataSet&) = delete;
+
+    static MarketDataSet load_csv(const std::string& path, std::string_view default_instrument = {}) {
+        std::ifstream file(path, std::ios::binary);
+        if(!file.is_open()) {
+            throw std::runtime_error("cannot open market data file: " + path);
+        }
+        std::stringstream buffer;
+        buffer << file.rdbuf();
+        return parse_csv(buffer.str(), default_instrument);
+    }
+
+    // Replays the top-of-book ticks of a tick store (utils/tickstore.hpp) as level events: a best
+    // price that moved is removed and the new one set. Venues without sizes replay UNKNOWN_SIZE, a
+    // level deep enough that only trades through it fill resting orders.
+    static MarketDataSet load_tick_store(const std::string& root,
+                                         const std::vector<std::string>& instruments,
+                                         uint64_t from_ns = 0,
+                                         uint64_t to_ns = UINT64_MAX) {
+        const auto& registry = mapping::InstrumentRegistry::instance();
+        MarketDataSet data;
+        for(const auto& name : instruments) {
+            const mapping::InstrumentId instrument = registry.require(name).id;
+            double bid = 0.0;
+            double ask = 0.0;
+            for(const auto& tick : tick_store::read(root, name, from_ns, to_ns)) {
+                const auto level = [&](Side::Type side, double price, double quantity) {
+                    data.add({tick.timestampNs, instrument, side, MarketEventKind::Level, price, quantity});
+                };
+                if(bid > 0.0 && bid != tick.bidPrice) {
+                    level(Side::Type::Bid, bid, 0.0);
+                }
+                if(ask > 0.0 && ask != tick.askPrice) {
+                    level(Side::Type::Ask, ask, 0.0);
+                }
+                if(tick.bidPrice > 0.0) {
+                    level(Side::Type::Bid, tick.bidPrice, tick.bidSize > 0.0 ? tick.bidSize : UNKNOWN_SIZE);
+                }
+                if(tick.askPrice > 0.0) {
+                    level(Side::Type::Ask, tick.askPrice, tick.askSize > 0.0 ? tick.askSize : UNKNOWN_SIZE);
+                }
+                bid = tick.bidPrice;
+                ask = tick.askPrice;
+            }
+        }
+        data.sort();
+        return data;
+    }
+
+    static MarketDataSet parse_csv(std::string_view text, std::string_view default_instrument = {}) {
+        const auto& registry = mapping::InstrumentRegistry::instance();
+        const mapping::InstrumentId default_id =
+            default_instrument.empty() ? mapping::InstrumentRegistry::INVALID : registry.id(default_instrument);
+        if(!default_instrument.empty() && default_id == mapping::InstrumentRegistry::INVALID) {
+            throw std::runtime_error("unknown instrument: " + std::string(default_instrument));
+        }
+
+        size_t pos = 0;
+        const Columns columns = parse_header(next_line(text, pos));
+        if(columns.instrument < 0 && default_id == mapping::InstrumentRegistry::INVALID) {
+            throw std::runtime_error("market data has no instrument column and no default instrument");
+        }
+
+        MarketDataSet data;
+        std::vector<std::string_view> fields;
+        size_t line_number = 1;
+        mapping::InstrumentId last_id = default_id;
+        std::string_view last_name;
+        while(pos < text.size()) {
+            const std::string_view line = next_line(text, pos);
+            ++line_number;
+            if(line.empty()) {
+                continue;
+            }
+            split(line, fields);
+            if(fields.size() < columns.count) {
+                throw std::runtime_error("market data line " + std::to_string(line_number) + " has " +
+                                         std::to_string(fields.size()) + " fields, expected " +
+                                         std::to_string(columns.count));
+            }
+
+            MarketEvent event{};
+            event.instrument = default_id;
+            if(columns.instrument >= 0) {
+                const auto name = fields[columns.instrument];
+                if(name != last_name) {
+                    last_id = registry.id(name);
+                    last_name = name;
+                    if(last_id == mapping::InstrumentRegistry::INVALID) {
+                        throw std::runtime_error("unknown instrument " + std::string(name) + " on market data line " +
+                                                 std::to_string(line_number));
+                    }
+                }
+                event.instrument = last_id;
+            }
+            event.timestamp_ns = parse_number<uint64_t>(fields[columns.timestamp], line_number);
+            event.kind = columns.type >= 0 ? parse_kind(fields[columns.type], line_number) : MarketEventKind::Level;
+            event.side = parse_side(fields[columns.side], line_number);
+            event.price = parse_number<double>(fields[columns.price], line_number);
+            event.quantity = parse_number<double>(fields[columns.quantity], line_number);
+            data.add(event);
+        }
+        data.sort();
+        return data;
+    }
+
+    // Events are visible through events() once sort() ran
+    void add(const MarketEvent& event) {
+        if(event.instrument >= events_.size()) {
+            events_.resize(event.instrument + 1);
+        }
+        events_[event.instrument].push_back(event);
+        ++size_;
+    }
+
+    // Stable, so updates sharing a timestamp keep their recorded order
+    void sort() {
+        views_.assign(events_.size(), {});
+        for(size_t instrument = 0; instrument < events_.size(); ++instrument) {
+            auto& events = events_[instrument];
+            std::stable_sort(events.begin(), events.end(), [](const MarketEvent& lhs, const MarketEvent& rhs) {
+                return lhs.timestamp_ns < rhs.timestamp_ns;
+            });
+            views_[instrument] = events;
+        }
+    }
+
+    void write_binary(const std::string& path) const {
+        const auto& registry = mapping::InstrumentRegistry::instance();
+        FileHeader header{};
+        std::memcpy(header.magic, FILE_MAGIC, sizeof(header.magic));
+        header.event_size = sizeof(MarketEvent);
+        const auto non_empty = std::count_if(
+            views_.begin(), views_.end(), [](std::span<const MarketEvent> events) { return !events.empty(); });
+        std::vector<FileSection> sections;
+        uint64_t offset = sizeof(FileHeader) + non_empty * sizeof(FileSection);
+        for(size_t instrument = 0; instrument < views_.size(); ++instrument) {
+            if(views_[instrument].empty()) {
+                continue;
+            }
+            const std::string& name = registry.get(static_cast<mapping::InstrumentId>(instrument)).name;
+            if(name.size() >= sizeof(FileSection::name)) {
+                throw std::runtime_error("instrument name too long for market data file: " + name);
+            }
+            FileSection& section = sections.emplace_back();
+            std::memcpy(section.name, name.data(), name.size());
+            section.offset = offset;
+            section.count = views_[instrument].size();
+            offset += views_[instrument].size_bytes();
+        }
+        header.section_count = sections.size();
+
+        std::ofstream file(path, std::ios::binary | std::ios::trunc);
+        if(!file.is_open()) {
+            throw std::runtime_error("cannot create market data file: " + path);
+        }
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.write(reinterpret_cast<const char*>(sections.data()), sections.size() * sizeof(FileSection));
+        for(const auto& events : views_) {
+            file.write(reinterpret_cast<const char*>(events.data()), events.size_bytes());
+        }
+        if(!file) {
+            throw std::runtime_error("cannot write market data file: " + path);
+        }
+    }
+
+    static MarketDataSet map_binary(const std::string& path) {
+        const auto& registry = mapping::InstrumentRegistry::instance();
+        MarketDataSet data;
+        data.mapping_ = std::make_shared<MappedFile>(path);
+        const std::byte* base = data.mapping_->data();
+        const size_t size = data.mapping_->size();
+        FileHeader header{};
+        if(size < sizeof(header)) {
+            throw std::runtime_error("market data file too short: " + path);
+        }
+        std::memcpy(&header, base, sizeof(header));
+        if(std::memcmp(header.magic, FILE_MAGIC, sizeof(header.magic)) != 0 ||
+           header.event_size != sizeof(MarketEvent)) {
+            throw std::runtime_error("unexpected market data file layout: " + path);
+        }
+        if(sizeof(FileHeader) + header.section_count * sizeof(FileSection) > size) {
+            throw std::runtime_error("market data file truncated: " + path);
+        }
+        for(uint64_t i = 0; i < header.section_count; ++i) {
+            FileSection section{};
+            std::memcpy(&section, base + sizeof(FileHeader) + i * sizeof(FileSection), sizeof(section));
+            const std::string_view name(section.name, strnlen(section.name, sizeof(section.name)));
+            const mapping::InstrumentId instrument = registry.id(name);
+            if(instrument == mapping::InstrumentRegistry::INVALID) {
+                throw std::runtime_error("unknown instrument " + std::string(name) + " in " + path);
+            }
+            if(section.offset % alignof(MarketEvent) != 0 ||
+               section.offset + section.count * sizeof(MarketEvent) > size) {
+                throw std::runtime_error("market data file truncated: " + path);
+            }
+            if(instrument >= data.views_.size()) {
+                data.views_.resize(instrument + 1);
+            }
+            data.views_[instrument] = {reinterpret_cast<const MarketEvent*>(base + section.offset), section.count};
+            data.size_ += section.count;
+        }
+        return data;
+    }
+
+    [[nodiscard]] std::span<const MarketEvent> events(mapping::InstrumentId instrument) const {
+        if(instrument >= views_.size()) {
+            return {};
+        }
+        return views_[instrument];
+    }
+
+    [[nodiscard]] size_t size() const { return size_; }
+
+    [[nodiscard]] uint64_t first_timestamp_ns() const {
+        uint64_t first = UINT64_MAX;
+        for(const auto& events : views_) {
+            if(!events.empty()) {
+                first = std::min(first, events.front().timestamp_ns);
+            }
+        }
+        return first == UINT64_MAX ? 0 : first;
+    }
+
+    [[nodiscard]] uint64_t last_timestamp_ns() const {
+        uint64_t last = 0;
+        for(const auto& events : views_) {
+            if(!events.empty()) {
+                last = std::max(last, events.back().timestamp_ns);
+            }
+        }
+        return last;
+    }
+
+private:
+    static constexpr char FILE_MAGIC[8] = {'B', 'T', 'E', 'V', 'E', 'N', 'T', '1'};
+
+    struct FileHeader {
+        char magic[8];
+        uint64_t event_size; // sizeof(MarketEvent) of the writer
+        uint64_t section_count;
+    };
+
+    // One instrument's events, `count` MarketEvents at `offset` from the start of the file
+    struct FileSection {
+        char name[48]; // registry name, zero padded
+        uint64_t offset;
+        uint64_t count;
+    };
+
+    struct Columns {
+        int timestamp = -1;
+        int instrument = -1;
+        int type = -1;
+        int side = -1;
+        int price = -1;
+        int quantity = -1;
+        size_t count = 0; // fields a line needs to hold every used column
+    };
+
+    static std::string_view next_line(std::string_view text, size_t& pos) {
+        const size_t end = std::min(text.find('\n', pos), text.size());
+        std::string_view line = text.substr(pos, end - pos);
+        pos = end + 1;
+        if(!line.empty() && line.back() == '\r') {
+            line.remove_suffix(1);
+        }
+        return line;
+    }
+
+    static void split(std::string_view line, std::vector<std::string_view>& fields) {
+        fields.clear();
+        size_t start = 0;
+        while(true) {
+            const size_t comma = line.find(',', start);
+            if(comma == std::string_view::npos) {
+                fields.push_back(line.substr(start));
+                return;
+            }
+            fields.push_back(line.substr(start, comma - start));
+            start = comma + 1;
+        }
+    }
+
+    static Columns parse_header(std::string_view header) {
+        std::vector<std::string_view> names;
+        split(header, names);
+        Columns columns;
+        for(size_t i = 0; i < names.size(); ++i) {
+            const auto name = names[i];
+            const int index = static_cast<int>(i);
+            if(name == "timestamp_ns" || name == "exchangeTimestamp") {
+                columns.timestamp = index;
+            } else if(name == "instrument") {
+                columns.instrument = index;
+            } else if(name == "type") {
+                columns.type = index;
+            } else if(name == "side") {
+                columns.side = index;
+            } else if(name == "price") {
+                columns.price = index;
+            } else if(name == "quantity") {
+                columns.quantity = index;
+            }
+        }
+        if(columns.timestamp < 0 || columns.side < 0 || columns.price < 0 || columns.quantity < 0) {
+            throw std::runtime_error("market data header needs timestamp_ns, side, price and quantity columns");
+        }
+        columns.count = static_cast<size_t>(std::max({columns.timestamp,
+                                                      columns.instrument,
+                                                      columns.type,
+                                                      columns.side,
+                                                      columns.price,
+                                                      columns.quantity})) +
+                        1;
+        return columns;
+    }
+
+    template<typename T>
+    static T parse_number(std::string_view field, size_t line_number) {
+        T value{};
+        const auto [end, error] = std::from_chars(field.data(), field.data() + field.size(), value);
+        if(error != std::errc{} || end != field.data() + field.size()) {
+            throw std::runtime_error("invalid number '" + std::string(field) + "' on market data line " +
+                                     std::to_string(line_number));
+        }
+        return value;
+    }
+
+    static Side::Type parse_side(std::string_view field, size_t line_number) {
+        if(field == "ask" || field == "1") {
+            return Side::Type::Ask;
+        }
+        if(field == "bid" || field == "0") {
+            return Side::Type::Bid;
+        }
+        throw std::runtime_error("invalid side '" + std::string(field) + "' on market data line " +
+                                 std::to_string(line_number));
+    }
+
+    static MarketEventKind parse_kind(std::string_view field, size_t line_number) {
+        if(field == "level") {
+            return MarketEventKind::Level;
+        }
+        if(field == "trade") {
+            return MarketEventKind::Trade;
+        }
+        throw std::runtime_error("invalid event type '" + std::string(field) + "' on market data line " +
+                                 std::to_string(line_number));
+    }
+
+    std::vector<std::vector<MarketEvent>> events_; // parsed events, empty when mapped
+    std::vector<std::span<const MarketEvent>> views_; // index is the instrument id
+    std::shared_ptr<const MappedFile> mapping_;
+    size_t size_ = 0;
+};
+
+} // namespace backtest
@@ -0,0 +1,278 @@
+#pragma once
+
+#include "../src/Configuration.h"
+#include "BacktestEngine.h"
+#include <charconv>
+#include <cmath>
+#include <cstdint>
+#include <mutex>
+#include <ostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace backtest {
+
+// One strategy knob a sweep varies, `path` is the dotted key in the strategy config it overrides
+struct SweepParameter {
+    std::string name;
+    std::string path;
+    std::vector<double> values; // grid points, random search draws from them unless a range is given
+    double min{0.0};
+    double max{0.0};
+    bool continuous{false}; // random search draws uniformly from [min, max]
+};
+
+// Parameter grid or random sample read from a sweep config:
+//   mode: grid            # grid (every combination) or random
+//   samples: 2000         # random only
+//   seed: 42              # random only
+//   parameters:
+//     - {name: ticks_from_touch, values: [0, 1, 2, 4]}
+//     - {name: const_shift_ratio, min: 0.0, max: 6e-4, steps: 7}
+//     - {path: hedge_safety_control.max_spread, values: [5e-4, 1e-3]}
+// Well-known knobs are found by name, anything else by its dotted path. Every key must already
+// exist in the strategy config, a sweep only overrides values.
+class ParameterSweep {
+public:
+    static ParameterSweep from_config(const Configuration& config) {
+        ParameterSweep sweep;
+        const auto mode = config.get<std::string>("mode", "grid");
+        if(mode != "grid" && mode != "random") {
+            throw std::runtime_error("unknown sweep mode " + mode + ", expected grid or random");
+        }
+        const auto parameters = config.child("parameters");
+        if(!parameters.is_seq() || parameters.num_children() == 0) {
+            throw std::runtime_error("sweep config needs a non-empty `parameters` list");
+        }
+        parameters.for_each_child(
+            [&](const Configuration& node) { sweep.parameters_.push_back(read_parameter(node)); });
+
+        if(mode == "grid") {
+            sweep.build_grid();
+        } else {
+            sweep.build_random(config.get<size_t>("samples"), config.get<uint64_t>("seed", 42));
+        }
+        return sweep;
+    }
+
+    [[nodiscard]] const std::vector<SweepParameter>& parameters() const { return parameters_; }
+    [[nodiscard]] size_t size() const { return combinations_.size(); }
+    [[nodiscard]] const std::vector<double>& combination(size_t run) const { return combinations_[run]; }
+
+    // Parses a private copy of the base config and overrides every swept key with this run's values
+    [[nodiscard]] Configuration make_config(const std::string& base_yaml, size_t run) const {
+        auto config = Configuration::from_string(base_yaml);
+        const auto& values = combinations_[run];
+        for(size_t i = 0; i < parameters_.size(); ++i) {
+            override_value(config, parameters_[i].path, format_value(values[i]));
+        }
+        return config;
+    }
+
+    // Fails before any thread starts when a swept key is missing from the base config
+    void validate(const Configuration& base) const {
+        for(const auto& parameter : parameters_) {
+            resolve_parent(base, parameter.path);
+        }
+    }
+
+private:
+    static const std::unordered_map<std::string_view, std::string_view>& known_paths() {
+        static const std::unordered_map<std::string_view, std::string_view> paths = {
+            {"ticks_from_touch", "order_placement_policy.shift_to_touch.ticks_from_touch"},
+            {"ticks_from_postable", "order_placement_policy.shift_to_postable.ticks_from_postable"},
+            {"const_shift_ratio", "quoting_reference_price.constant_shift"},
+            {"shift_ratio_per_position", "quoting_reference_price.position_shift"},
+            {"min_hedge_size", "backtest.min_hedge_size"},
+            {"minimum_distance", "quote_safety_control.price_distance_control.minimum_distance"},
+            {"microprice_weight", "quoting_reference_price.fair_value.microprice_weight"},
+            {"imbalance_shift", "quoting_reference_price.fair_value.imbalance_shift"},
+            {"drift_weight", "quoting_reference_price.fair_value.drift_weight"},
+        };
+        return paths;
+    }
+
+    static SweepParameter read_parameter(const Configuration& node) {
+        SweepParameter parameter;
+        parameter.path = node.get<std::string>("path", "");
+        parameter.name = node.get<std::string>("name", parameter.path);
+        if(parameter.path.empty()) {
+            const auto it = known_paths().find(parameter.name);
+            if(it == known_paths().end()) {
+                throw std::runtime_error("sweep parameter " + parameter.name + " is not a known knob, give its path");
+            }
+            parameter.path = it->second;
+        }
+
+        if(node.has_key("values")) {
+            node.child("values").for_each_child(
+                [&](const Configuration& value) { parameter.values.push_back(value.as<double>()); });
+        } else {
+            parameter.min = node.get<double>("min");
+            parameter.max = node.get<double>("max");
+            parameter.continuous = true;
+            const auto steps = node.get<size_t>("steps", 0);
+            for(size_t step = 0; step < steps; ++step) {
+                const double ratio = steps == 1 ? 0.0 : static_cast<double>(step) / static_cast<double>(steps - 1);
+                parameter.values.push_back(parameter.min + (parameter.max - parameter.min) * ratio);
+            }
+        }
+        if(parameter.values.empty() && !parameter.continuous) {
+            throw std::runtime_error("sweep parameter " + parameter.name + " has no values");
+        }
+        return parameter;
+    }
+
+    void build_grid() {
+        size_t total = 1;
+        for(const auto& parameter : parameters_) {
+            if(parameter.values.empty()) {
+                throw std::runtime_error("grid parameter " + parameter.name + " needs values or steps");
+            }
+            total *= parameter.values.size();
+        }
+        combinations_.reserve(total);
+        // mixed radix counter, the last parameter varies fastest
+        std::vector<size_t> digits(parameters_.size(), 0);
+        for(size_t run = 0; run < total; ++run) {
+            std::vector<double> values(parameters_.size());
+            for(size_t i = 0; i < parameters_.size(); ++i) {
+                values[i] = parameters_[i].values[digits[i]];
+            }
+            combinations_.push_back(std::move(values));
+            for(size_t i = parameters_.size(); i-- > 0;) {
+                if(++digits[i] < parameters_[i].values.size()) {
+                    break;
+                }
+                digits[i] = 0;
+            }
+        }
+    }
+
+    void build_random(size_t samples, uint64_t seed) {
+        std::mt19937_64 rng(seed);
+        combinations_.reserve(samples);
+        for(size_t run = 0; run < samples; ++run) {
+            std::vector<double> values(parameters_.size());
+            for(size_t i = 0; i < parameters_.size(); ++i) {
+                const auto& parameter = parameters_[i];
+                if(parameter.continuous) {
+                    values[i] = std::uniform_real_distribution<double>(parameter.min, parameter.max)(rng);
+                } else {
+                    values[i] = parameter.values[std::uniform_int_distribution<size_t>(
+                        0, parameter.values.size() - 1)(rng)];
+                }
+            }
+            combinations_.push_back(std::move(values));
+        }
+    }
+
+    // Returns the map holding the last path segment, throws when any segment is missing
+    static Configuration resolve_parent(const Configuration& root, const std::string& path) {
+        Configuration node = root;
+        size_t begin = 0;
+        while(true) {
+            const size_t dot = path.find('.', begin);
+            const std::string key = path.substr(begin, dot == std::string::npos ? std::string::npos : dot - begin);
+            if(!node.has_key(key)) {
+                throw std::runtime_error("swept key " + path + " is not in the strategy config");
+            }
+            if(dot == std::string::npos) {
+                return node;
+            }
+            node = node.child(key);
+            begin = dot + 1;
+        }
+    }
+
+    // Only existing keys are overridden, the tree keeps referring to the key text it was parsed from
+    static void override_value(const Configuration& root, const std::string& path, const std::string& value) {
+        auto parent = resolve_parent(root, path);
+        const size_t dot = path.rfind('.');
+        parent.set(dot == std::string::npos ? path : path.substr(dot + 1), value);
+    }
+
+    static std::string format_value(double value) {
+        char buffer[32];
+        const auto [end, ec] = std::to_chars(buffer, buffer + sizeof(buffer), value);
+        return ec == std::errc() ? std::string(buffer, end) : std::to_string(value);
+    }
+
+    std::vector<SweepParameter> parameters_;
+    std::vector<std::vector<double>> combinations_;
+};
+
+// Streams one CSV row per finished run, rows arrive in completion order so `run` keys them back to
+// the sweep. Thread-safe, every row is flushed so a killed sweep keeps what it finished.
+class SweepResultWriter {
+public:
+    SweepResultWriter(std::ostream& output, const std::vector<SweepParameter>& parameters)
+        : output_(output) {
+        output_.precision(12);
+        output_ << "run";
+        for(const auto& parameter : parameters) {
+            output_ << ',' << parameter.name;
+        }
+        output_ << ",total_with_fee,realized,unrealized,maker_fee,taker_fee,quote_maker_fills,quote_maker_volume"
+                   ",quote_taker_fills,quote_orders,quote_rejects,hedge_taker_fills,hedge_taker_volume"
+                   ",quote_position,hedge_position,run_ms,error\n";
+        output_.flush();
+    }
+
+    void write(size_t run, const std::vector<double>& values, const BacktestResult& result, int64_t run_ms) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        write_prefix(run, values);
+        output_ << result.total_pnl_with_fee << ',' << result.realized_pnl << ',' << result.unrealized_pnl << ','
+                << result.maker_fee << ',' << result.taker_fee << ',' << result.quote.maker_fills << ','
+                << result.quote.maker_volume << ',' << result.quote.taker_fills << ',' << result.quote.orders << ','
+                << result.quote.rejects << ',' << result.hedge.taker_fills << ',' << result.hedge.taker_volume << ','
+                << result.quote_position << ',' << result.hedge_position << ',' << run_ms << ",\n";
+        output_.flush();
+        ++written_;
+    }
+
+    void write_error(size_t run, const std::vector<double>& values, const std::string& error) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        write_prefix(run, values);
+        std::string cleaned = error;
+        for(char& c : cleaned) {
+            if(c == ',' || c == '\n' || c == '"') {
+                c = ' ';
+            }
+        }
+        output_ << ",,,,,,,,,,,,,,," << cleaned << '\n';
+        output_.flush();
+        ++written_;
+        ++failed_;
+    }
+
+    [[nodiscard]] size_t written() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return written_;
+    }
+
+    [[nodiscard]] size_t failed() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return failed_;
+    }
+
+private:
+    void write_prefix(size_t run, const std::vector<double>& values) {
+        output_ << run;
+        for(const double value : values) {
+            output_ << ',' << value;
+        }
+        output_ << ',';
+    }
+
+    std::ostream& output_;
+    mutable std::mutex mutex_;
+    size_t written_{0};
+    size_t failed_{0};
+};
+
+} // namespace backtest
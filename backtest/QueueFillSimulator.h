@@ -0,0 +1,203 @@
+#pragma once
+
+#include "../infra/book.hpp"
+#include "../utils/instrumentregistry.hpp"
+#include "MarketData.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+namespace backtest {
+
+// How the queue in front of a resting order moves on the quantity changes the feed shows
+struct QueueModel {
+    // A level shrinking without trades is cancels, split between the quantity ahead of and behind our
+    // order in proportion to ahead^p : behind^p. 1 spreads them evenly over the level, larger values
+    // assume cancels come mostly from the longer part.
+    double cancel_power{1.0};
+};
+
+// Visible quantity at one price of a side, 0 when the level does not exist
+[[nodiscard]] inline double level_quantity(const PriceLevelArray& side, double price) {
+    const int index = side.findIndex(price);
+    if(index < static_cast<int>(side.size) && std::abs(side.levels[index].price - price) < PRICE_EPSILON) {
+        return side.levels[index].quantity;
+    }
+    return 0.0;
+}
+
+// Whether the opposite touch of book trades with a limit order at price
+[[nodiscard]] inline bool touch_crosses(const Book& book, bool is_buy, double price) {
+    if(is_buy) {
+        const double ask = book.getBestAsk();
+        return ask > 0.0 && ask <= price + PRICE_EPSILON;
+    }
+    const double bid = book.getBestBid();
+    return bid > 0.0 && bid >= price - PRICE_EPSILON;
+}
+
+// Resting orders of one instrument and their estimated place in the queue of their price level,
+// driven by the level deltas and trade prints of the recorded feed. The recorded book never holds
+// our orders, so the visible quantity of our level is what is ahead of us plus what joined later:
+//   - a new order, a price amend or a size increase goes to the back: everything visible is ahead,
+//   - quantity added to the level queues behind us,
+//   - trades at our price consume the queue ahead first and fill us with what reaches us,
+//   - the level shrinking by more than the prints since its last update is cancels, see QueueModel,
+//   - trades or the opposite touch through our price fill the order completely.
+// Quantities are in base currency like the strategy's, level and trade sizes are converted with the
+// instrument's contract size. Orders of ours at the same price do not queue behind each other.
+//
+// fill(order, price, quantity) is called for every maker execution, with the order's leaves already
+// reduced; orders without leaves are dropped after the event.
+// @example
+//   QueueFillSimulator queue(spec, QueueModel{});
+//   queue.join(id, true, 67000.1, 0.01, 0.01, book);
+//   queue.on_trade(event, [&](const QueueFillSimulator::Order& order, double price, double qty) { ... });
+class QueueFillSimulator {
+public:
+    struct Order {
+        uint64_t id;
+        bool is_buy;
+        double price;
+        double size; // total, an amend sets it like Bybit's qty
+        double leaves;
+        double ahead;  // base quantity in front of us at our price
+        double traded; // printed at our price since its last level update, the decrease it explains
+    };
+
+    QueueFillSimulator(const mapping::InstrumentSpec& spec, const QueueModel& model)
+        : spec_(spec)
+        , model_(model) {}
+
+    // Rests an order at the back of its level
+    void join(uint64_t id, bool is_buy, double price, double size, double leaves, const Book& book) {
+        orders_.push_back({id, is_buy, price, size, leaves, visible(book, is_buy, price), 0.0});
+    }
+
+    // Leaves of the removed order, 0 when it is not resting
+    double cancel(uint64_t id) {
+        const auto it = find(id);
+        if(it == orders_.end()) {
+            return 0.0;
+        }
+        const double leaves = it->leaves;
+        *it = orders_.back();
+        orders_.pop_back();
+        return leaves;
+    }
+
+    // New price and total size of a resting order, what it executed so far stays executed. Keeps the
+    // queue position only for a size decrease at the same price, like Bybit does. False when the order
+    // is not resting or the new size does not exceed what it executed.
+    bool amend(uint64_t id, double price, double size, const Book& book) {
+        const auto it = find(id);
+        if(it == orders_.end()) {
+            return false;
+        }
+        const double leaves = size - (it->size - it->leaves);
+        if(leaves <= QTY_EPSILON) {
+            return false;
+        }
+        if(std::abs(it->price - price) >= PRICE_EPSILON || leaves > it->leaves + QTY_EPSILON) {
+            it->ahead = visible(book, it->is_buy, price);
+            it->traded = 0.0;
+        }
+        it->price = price;
+        it->size = size;
+        it->leaves = leaves;
+        return true;
+    }
+
+    // Invalidated by the next call that changes the orders
+    [[nodiscard]] const Order* get(uint64_t id) const {
+        const auto it = std::find_if(
+            orders_.begin(), orders_.end(), [id](const Order& order) { return order.id == id; });
+        return it == orders_.end() ? nullptr : &*it;
+    }
+
+    [[nodiscard]] const std::vector<Order>& orders() const { return orders_; }
+
+    // Level event already applied to book, previous is the level's quantity before it
+    template<typename Fill>
+    void on_level(const Book& book, const MarketEvent& event, double previous, Fill&& fill) {
+        const bool bid_level = event.side == Side::Type::Bid;
+        for(auto& order : orders_) {
+            if(order.is_buy == bid_level && std::abs(order.price - event.price) < PRICE_EPSILON) {
+                requeue(order, spec_.toBaseQty(previous), spec_.toBaseQty(event.quantity));
+            } else if(order.is_buy != bid_level && touch_crosses(book, order.is_buy, order.price)) {
+                execute(order, order.leaves, fill);
+            }
+        }
+        erase_filled();
+    }
+
+    // A trade against one side executes every order of that side priced through it, and the part of
+    // the queue at its price that the traded volume reaches
+    template<typename Fill>
+    void on_trade(const MarketEvent& event, Fill&& fill) {
+        const bool bid_trade = event.side == Side::Type::Bid;
+        const double traded = spec_.toBaseQty(event.quantity);
+        for(auto& order : orders_) {
+            if(order.is_buy != bid_trade) {
+                continue;
+            }
+            const bool through =
+                order.is_buy ? order.price > event.price + PRICE_EPSILON : order.price < event.price - PRICE_EPSILON;
+            if(through) {
+                execute(order, order.leaves, fill);
+            } else if(std::abs(order.price - event.price) < PRICE_EPSILON) {
+                const double reached = traded - order.ahead;
+                order.ahead = std::max(0.0, order.ahead - traded);
+                order.traded += traded;
+                execute(order, std::min(order.leaves, reached), fill);
+            }
+        }
+        erase_filled();
+    }
+
+private:
+    static constexpr double QTY_EPSILON = 1e-9;
+
+    std::vector<Order>::iterator find(uint64_t id) {
+        return std::find_if(orders_.begin(), orders_.end(), [id](const Order& order) { return order.id == id; });
+    }
+
+    [[nodiscard]] double visible(const Book& book, bool is_buy, double price) const {
+        return spec_.toBaseQty(level_quantity(is_buy ? book.bidSide : book.askSide, price));
+    }
+
+    // The prints since the last update already moved us, only the rest of a decrease is cancels. A
+    // print the venue reports after its level delta is counted twice, which errs towards fills.
+    void requeue(Order& order, double previous, double quantity) const {
+        const double decrease = previous - quantity;
+        const double cancelled = decrease - std::min(std::max(decrease, 0.0), order.traded);
+        order.traded = 0.0;
+        if(cancelled > QTY_EPSILON && order.ahead > QTY_EPSILON) {
+            const double behind = std::max(0.0, previous - (decrease - cancelled) - order.ahead);
+            const double front_weight = std::pow(order.ahead, model_.cancel_power);
+            const double back_weight = std::pow(behind, model_.cancel_power);
+            order.ahead -= cancelled * front_weight / (front_weight + back_weight);
+        }
+        order.ahead = std::clamp(order.ahead, 0.0, quantity);
+    }
+
+    template<typename Fill>
+    void execute(Order& order, double quantity, Fill& fill) {
+        if(quantity <= QTY_EPSILON) {
+            return;
+        }
+        order.leaves -= quantity;
+        fill(order, order.price, quantity);
+    }
+
+    void erase_filled() {
+        std::erase_if(orders_, [](const Order& order) { return order.leaves <= QTY_EPSILON; });
+    }
+
+    const mapping::InstrumentSpec& spec_;
+    const QueueModel model_;
+    std::vector<Order> orders_;
+};
+
+} // namespace backtest
@@ -0,0 +1,454 @@
+#pragma once
+
+#include "../infra/book.hpp"
+#include "../utils/instrumentregistry.hpp"
+#include "MarketData.h"
+#include "QueueFillSimulator.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <deque>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace backtest {
+
+enum class SimOrderType : uint8_t { Limit, PostOnly, Ioc, Market };
+
+inline SimOrderType parse_sim_order_type(std::string_view type) {
+    if(type == "limit") return SimOrderType::Limit;
+    if(type == "post_only") return SimOrderType::PostOnly;
+    if(type == "ioc") return SimOrderType::Ioc;
+    if(type == "market") return SimOrderType::Market;
+    throw std::runtime_error("Invalid order type: " + std::string(type));
+}
+
+// One-way delays of a venue as seen from the strategy
+struct LatencyModel {
+    uint64_t market_data_ns{0}; // exchange event to the strategy's book
+    uint64_t order_ns{0};       // order, amend or cancel sent to its arrival at the matching engine
+    uint64_t report_ns{0};      // order response (cancel, amend, reject) to the strategy's order state
+    uint64_t fill_ns{0};        // execution to the strategy, fills come on their own stream
+};
+
+// Rates on notional, negative for a rebate
+struct FeeModel {
+    double maker_rate{0.0};
+    double taker_rate{0.0};
+};
+
+enum class SimReportKind : uint8_t { Fill, Canceled, Rejected, CancelRejected, Amended, AmendRejected };
+
+struct SimReport {
+    uint64_t exchange_ns; // when the matching engine produced it
+    uint64_t deliver_ns;  // when the strategy sees it
+    uint64_t order_id;
+    SimReportKind kind;
+    bool is_maker;
+    double price;
+    double quantity; // base currency, fill size, the leaves a cancel removed or the amended size
+    double fee;      // quote currency, fills only
+};
+
+// An order as the strategy knows it: updated only when reports are delivered
+struct SimClientOrder {
+    uint64_t id;
+    bool is_buy;
+    SimOrderType type;
+    double price;
+    double size;
+    double leaves; // includes executions whose fill is still on its way
+    bool cancel_sent;
+    bool amend_sent;
+    uint64_t sent_ns; // strategy clock when the order was placed
+};
+
+// Matching engine of one instrument on recorded data. The exchange-side book follows the recorded
+// events at exchange time; orders, amends and cancels reach it after the order latency, their
+// responses reach the strategy after the report latency and executions after the fill latency.
+// The recorded book never contains our orders, so takers sweep the visible opposite levels and the
+// quantity they took stays off those levels until the level's next recorded update; resting orders
+// are matched by a QueueFillSimulator.
+// Quantities are in base currency like the rest of the strategy, book and trade sizes are
+// converted with the instrument's contract size.
+//
+// The strategy-facing half mirrors the order managers (placeOrder/modifyOrder/cancelOrder,
+// getOutstandingQty, isWebSocketReady) and the position managers (get_position), so Hedger and
+// QuoteMidService take a SimulatedExchange where they take an order or position manager live.
+class SimulatedExchange {
+public:
+    SimulatedExchange(mapping::InstrumentId instrument,
+                      const LatencyModel& latency,
+                      const FeeModel& fees,
+                      const QueueModel& queue = {})
+        : spec_(mapping::InstrumentRegistry::instance().get(instrument))
+        , latency_(latency)
+        , fees_(fees)
+        , book_(spec_.name)
+        , queue_(spec_, queue) {}
+
+    SimulatedExchange(const SimulatedExchange&) = delete;
+    SimulatedExchange& operator=(const SimulatedExchange&) = delete;
+
+    /* ------------------------------ strategy side ----------------------------- */
+
+    // Client order id, 0 when the request is invalid
+    uint64_t
+    placeOrder(mapping::InstrumentId instrument, double price, double size, bool isBuy, const std::string& type) {
+        const SimOrderType order_type = parse_sim_order_type(type);
+        if(instrument != spec_.id || size <= QTY_EPSILON || (order_type != SimOrderType::Market && price <= 0.0)) {
+            return 0;
+        }
+        const uint64_t id = next_order_id_++;
+        clients_.push_back({id, isBuy, order_type, price, size, size, false, false, now_ns_});
+        outstanding_[side_index(isBuy)] += size;
+        requests_.push_back({now_ns_ + latency_.order_ns, RequestKind::New, {id, isBuy, order_type, price, size, 0.0}});
+        ++stats_.orders;
+        return id;
+    }
+
+    // New price and total size of a working order, 0 when no amend can be sent for it
+    uint64_t modifyOrder(uint64_t order_id, double newPrice, double newQty, mapping::InstrumentId instrument) {
+        SimClientOrder* order = find_client(order_id);
+        if(!order || instrument != spec_.id || order->cancel_sent || order->amend_sent || newPrice <= 0.0 ||
+           newQty <= QTY_EPSILON) {
+            return 0;
+        }
+        order->amend_sent = true;
+        requests_.push_back({now_ns_ + latency_.order_ns,
+                             RequestKind::Amend,
+                             {order_id, order->is_buy, order->type, newPrice, newQty, 0.0}});
+        ++stats_.amends;
+        return order_id;
+    }
+
+    bool cancelOrder(uint64_t order_id) {
+        SimClientOrder* order = find_client(order_id);
+        if(!order || order->cancel_sent) {
+            return false;
+        }
+        order->cancel_sent = true;
+        requests_.push_back({now_ns_ + latency_.order_ns, RequestKind::Cancel, {order_id}});
+        ++stats_.cancels;
+        return true;
+    }
+
+    // Quantity that can still fill on a side, orders count in full until the strategy hears otherwise
+    [[nodiscard]] double getOutstandingQty(bool isBid) const {
+        const double qty = outstanding_[side_index(isBid)];
+        return qty < QTY_EPSILON ? 0.0 : qty;
+    }
+
+    [[nodiscard]] bool isWebSocketReady() const { return true; }
+
+    // Signed base quantity from the fills delivered so far
+    [[nodiscard]] double get_position() const { return position_; }
+
+    [[nodiscard]] const std::vector<SimClientOrder>& client_orders() const { return clients_; }
+
+    // Strategy clock of the next order or cancel; requests sent later are stamped with it
+    void set_time(uint64_t now_ns) { now_ns_ = now_ns; }
+
+    [[nodiscard]] uint64_t next_report_ns() const {
+        return std::min(reports_.empty() ? UINT64_MAX : reports_.front().deliver_ns,
+                        fills_.empty() ? UINT64_MAX : fills_.front().deliver_ns);
+    }
+
+    // Hands the next due report to fn(report, order) after updating the order and the position
+    template<typename Fn>
+    void deliver_report(Fn&& fn) {
+        auto& stream = fills_.empty() || (!reports_.empty() && reports_.front().deliver_ns < fills_.front().deliver_ns)
+                           ? reports_
+                           : fills_;
+        const SimReport report = stream.front();
+        stream.pop_front();
+        const auto it = std::find_if(
+            clients_.begin(), clients_.end(), [&](const SimClientOrder& order) { return order.id == report.order_id; });
+        if(it == clients_.end()) {
+            return;
+        }
+        SimClientOrder& order = *it;
+        double& outstanding = outstanding_[side_index(order.is_buy)];
+        switch(report.kind) {
+        case SimReportKind::Fill:
+            order.leaves -= report.quantity;
+            outstanding -= report.quantity;
+            position_ += order.is_buy ? report.quantity : -report.quantity;
+            break;
+        // fills of the order still on their way keep it alive until they arrive
+        case SimReportKind::Canceled:
+        case SimReportKind::Rejected:
+            order.leaves -= report.quantity;
+            outstanding -= report.quantity;
+            break;
+        case SimReportKind::CancelRejected: order.cancel_sent = false; break;
+        case SimReportKind::Amended:
+            order.leaves += report.quantity - order.size;
+            outstanding += report.quantity - order.size;
+            order.price = report.price;
+            order.size = report.quantity;
+            order.amend_sent = false;
+            break;
+        case SimReportKind::AmendRejected: order.amend_sent = false; break;
+        }
+        // fn may send orders, so it gets a copy and a finished order is gone before it runs. Fills can
+        // overtake an amend's response and run the leaves below zero until it arrives.
+        const SimClientOrder updated = order;
+        if(order.leaves <= QTY_EPSILON && !order.amend_sent) {
+            *it = clients_.back();
+            clients_.pop_back();
+        }
+        fn(report, updated);
+    }
+
+    /* ------------------------------ exchange side ----------------------------- */
+
+    [[nodiscard]] uint64_t next_arrival_ns() const {
+        return requests_.empty() ? UINT64_MAX : requests_.front().arrive_ns;
+    }
+
+    // Matches the next request that reached the exchange
+    void process_arrival() {
+        const Request request = requests_.front();
+        requests_.pop_front();
+        const uint64_t now = request.arrive_ns;
+        if(request.kind == RequestKind::Cancel) {
+            const QueueFillSimulator::Order* resting = queue_.get(request.order.id);
+            if(!resting) {
+                report(now, request.order.id, SimReportKind::CancelRejected, false, 0.0, 0.0);
+                return;
+            }
+            const double price = resting->price;
+            report(now, request.order.id, SimReportKind::Canceled, false, price, queue_.cancel(request.order.id));
+            return;
+        }
+        if(request.kind == RequestKind::Amend) {
+            amend(request.order, now);
+            return;
+        }
+
+        RestingOrder order = request.order;
+        order.leaves = order.size;
+        if(order.type == SimOrderType::PostOnly && crosses(order)) {
+            report(now, order.id, SimReportKind::Rejected, false, order.price, order.leaves);
+            ++stats_.rejects;
+            return;
+        }
+        take(order, now);
+        if(order.leaves <= QTY_EPSILON) {
+            return;
+        }
+        if(order.type == SimOrderType::Ioc || order.type == SimOrderType::Market) {
+            report(now, order.id, SimReportKind::Canceled, false, order.price, order.leaves);
+            return;
+        }
+        queue_.join(order.id, order.is_buy, order.price, order.size, order.leaves, book_);
+    }
+
+    // Recorded event of this instrument at exchange time
+    void on_market_event(const MarketEvent& event) {
+        const auto fill = [this, now = event.timestamp_ns](const QueueFillSimulator::Order& order,
+                                                           double price,
+                                                           double quantity) {
+            record_fill(order.id, price, quantity, true, now);
+        };
+        if(event.kind == MarketEventKind::Trade) {
+            queue_.on_trade(event, fill);
+            return;
+        }
+        const PriceLevelArray& side = event.side == Side::Type::Bid ? book_.bidSide : book_.askSide;
+        const double previous = level_quantity(side, event.price);
+        restore_level(event.side == Side::Type::Bid, event.price);
+        apply_level(book_, event);
+        queue_.on_level(book_, event, previous, fill);
+    }
+
+    [[nodiscard]] const Book& book() const { return book_; }
+    [[nodiscard]] const mapping::InstrumentSpec& spec() const { return spec_; }
+    [[nodiscard]] const LatencyModel& latency() const { return latency_; }
+
+    struct Stats {
+        uint64_t orders{0};
+        uint64_t amends{0};
+        uint64_t cancels{0};
+        uint64_t rejects{0};
+        uint64_t maker_fills{0};
+        uint64_t taker_fills{0};
+        double maker_volume{0.0}; // base currency
+        double taker_volume{0.0};
+        double fees{0.0}; // quote currency
+
+        Stats& operator+=(const Stats& other) {
+            orders += other.orders;
+            amends += other.amends;
+            cancels += other.cancels;
+            rejects += other.rejects;
+            maker_fills += other.maker_fills;
+            taker_fills += other.taker_fills;
+            maker_volume += other.maker_volume;
+            taker_volume += other.taker_volume;
+            fees += other.fees;
+            return *this;
+        }
+    };
+
+    [[nodiscard]] const Stats& stats() const { return stats_; }
+
+private:
+    static constexpr double QTY_EPSILON = 1e-9;
+
+    enum class RequestKind : uint8_t { New, Amend, Cancel };
+
+    // An order on its way to the book or taking liquidity, the book's own are in queue_
+    struct RestingOrder {
+        uint64_t id{0};
+        bool is_buy{false};
+        SimOrderType type{SimOrderType::Limit};
+        double price{0.0};
+        double size{0.0};
+        double leaves{0.0};
+    };
+
+    // Base quantity our takers removed from a level that has not been updated since
+    struct ConsumedLevel {
+        bool bid;
+        double price;
+        double quantity;
+    };
+
+    struct Request {
+        uint64_t arrive_ns;
+        RequestKind kind;
+        RestingOrder order; // only the id for cancels, the new price and size for amends
+    };
+
+    static size_t side_index(bool buy) { return buy ? 0 : 1; }
+
+    SimClientOrder* find_client(uint64_t order_id) {
+        const auto it = std::find_if(
+            clients_.begin(), clients_.end(), [&](const SimClientOrder& order) { return order.id == order_id; });
+        return it == clients_.end() ? nullptr : &*it;
+    }
+
+    [[nodiscard]] bool crosses(const RestingOrder& order) const {
+        return touch_crosses(book_, order.is_buy, order.price);
+    }
+
+    // An amend that would take liquidity is rejected for post-only orders and otherwise leaves the
+    // queue, takes and rests what is left at the back of its new level
+    void amend(const RestingOrder& request, uint64_t now) {
+        const QueueFillSimulator::Order* resting = queue_.get(request.id);
+        const double leaves = resting ? request.size - (resting->size - resting->leaves) : 0.0;
+        if(leaves <= QTY_EPSILON || (request.type == SimOrderType::PostOnly && crosses(request))) {
+            report(now, request.id, SimReportKind::AmendRejected, false, request.price, request.size);
+            return;
+        }
+        report(now, request.id, SimReportKind::Amended, false, request.price, request.size);
+        if(!crosses(request)) {
+            queue_.amend(request.id, request.price, request.size, book_);
+            return;
+        }
+        queue_.cancel(request.id);
+        RestingOrder order = request;
+        order.leaves = leaves;
+        take(order, now);
+        if(order.leaves > QTY_EPSILON) {
+            queue_.join(order.id, order.is_buy, order.price, order.size, order.leaves, book_);
+        }
+    }
+
+    // Sweeps the visible opposite levels up to the order's limit, minus what earlier takers consumed
+    void take(RestingOrder& order, uint64_t now) {
+        const bool bid = !order.is_buy;
+        const PriceLevelArray& levels = bid ? book_.bidSide : book_.askSide;
+        for(size_t i = 0; i < levels.size && order.leaves > QTY_EPSILON; ++i) {
+            const double price = levels.levels[i].price;
+            if(order.type != SimOrderType::Market &&
+               (order.is_buy ? price > order.price + PRICE_EPSILON : price < order.price - PRICE_EPSILON)) {
+                break;
+            }
+            const double available = spec_.toBaseQty(levels.levels[i].quantity) - consumed(bid, price);
+            const double quantity = std::min(order.leaves, available);
+            if(quantity <= QTY_EPSILON) {
+                continue;
+            }
+            order.leaves -= quantity;
+            consume(bid, price, quantity);
+            record_fill(order.id, price, quantity, false, now);
+        }
+    }
+
+    [[nodiscard]] double consumed(bool bid, double price) const {
+        for(const ConsumedLevel& level : consumed_) {
+            if(level.bid == bid && std::abs(level.price - price) < PRICE_EPSILON) {
+                return level.quantity;
+            }
+        }
+        return 0.0;
+    }
+
+    void consume(bool bid, double price, double quantity) {
+        for(ConsumedLevel& level : consumed_) {
+            if(level.bid == bid && std::abs(level.price - price) < PRICE_EPSILON) {
+                level.quantity += quantity;
+                return;
+            }
+        }
+        consumed_.push_back({bid, price, quantity});
+    }
+
+    // The recorded update carries the level's new quantity, which is taken as including our takes
+    void restore_level(bool bid, double price) {
+        std::erase_if(consumed_, [&](const ConsumedLevel& level) {
+            return level.bid == bid && std::abs(level.price - price) < PRICE_EPSILON;
+        });
+    }
+
+    void record_fill(uint64_t order_id, double price, double quantity, bool is_maker, uint64_t now) {
+        if(quantity <= QTY_EPSILON) {
+            return;
+        }
+        const double fee = price * quantity * (is_maker ? fees_.maker_rate : fees_.taker_rate);
+        fills_.push_back({now, now + latency_.fill_ns, order_id, SimReportKind::Fill, is_maker, price, quantity, fee});
+        if(is_maker) {
+            ++stats_.maker_fills;
+            stats_.maker_volume += quantity;
+        } else {
+            ++stats_.taker_fills;
+            stats_.taker_volume += quantity;
+        }
+        stats_.fees += fee;
+    }
+
+    void report(uint64_t now,
+                uint64_t order_id,
+                SimReportKind kind,
+                bool is_maker,
+                double price,
+                double quantity) {
+        reports_.push_back({now, now + latency_.report_ns, order_id, kind, is_maker, price, quantity, 0.0});
+    }
+
+    const mapping::InstrumentSpec& spec_;
+    const LatencyModel latency_;
+    const FeeModel fees_;
+    Book book_;
+
+    // every queue is in time order: all messages of one kind have the same delay on a venue
+    std::deque<Request> requests_;
+    std::deque<SimReport> reports_;
+    std::deque<SimReport> fills_;
+    QueueFillSimulator queue_;
+    std::vector<ConsumedLevel> consumed_; // a few levels at most, cleared as the book moves
+
+    std::vector<SimClientOrder> clients_;
+    double outstanding_[2]{0.0, 0.0};
+    double position_{0.0};
+    uint64_t now_ns_{0};
+    uint64_t next_order_id_{1};
+    Stats stats_;
+};
+
+} // namespace backtest
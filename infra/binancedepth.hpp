@@ -0,0 +1,131 @@
+#pragma once
+#include "book.hpp"
+#include <cstdint>
+#include <vector>
+
+// Keeps a Book's level arrays in step with Binance's diff depth stream (<symbol>@depth@<speed>).
+// Diffs only carry the levels that changed, so the stream is bridged to a REST snapshot once:
+//   1. diffs are buffered until a snapshot (lastUpdateId) is handed in,
+//   2. buffered and later diffs with u < lastUpdateId are older than the snapshot and dropped,
+//   3. the first applied diff must span the snapshot, U <= lastUpdateId <= u,
+//   4. from then on every diff's pu must equal the previous diff's u.
+// A gap in 3 or 4 clears the levels and starts over from 1. Quantities are absolute, 0 removes the
+// level. Only the level arrays are touched; who owns the best bid/ask is up to the caller.
+// @example
+//   BinanceDepthSync sync;
+//   sync.onDiff(std::move(diff), book);          // Buffered until the snapshot arrives
+//   if(sync.needsSnapshot()) fetchSnapshot(...);
+//   sync.onSnapshot(std::move(snapshot), book);  // applies the snapshot and the buffered diffs
+class BinanceDepthSync {
+public:
+    struct Level {
+        double price;
+        double quantity;
+    };
+
+    struct Diff {
+        uint64_t firstUpdateId = 0;     // U
+        uint64_t finalUpdateId = 0;     // u
+        uint64_t previousUpdateId = 0;  // pu, u of the previous diff of the stream
+        uint64_t timestampNs = 0;       // T
+        std::vector<Level> bids;
+        std::vector<Level> asks;
+    };
+
+    struct Snapshot {
+        uint64_t lastUpdateId = 0;
+        std::vector<Level> bids;
+        std::vector<Level> asks;
+    };
+
+    enum class State : uint8_t { AwaitingSnapshot, Bridging, Synced };
+    enum class Result : uint8_t { Buffered, Stale, Applied, Gap };
+
+    // Diffs held while a snapshot is fetched; a slow snapshot starts over instead of growing without bound
+    static constexpr size_t MAX_BUFFERED = 10000;
+
+    explicit BinanceDepthSync(size_t maxBuffered = MAX_BUFFERED)
+        : m_maxBuffered(maxBuffered) {}
+
+    Result onDiff(Diff&& diff, Book& book) {
+        if(m_state == State::AwaitingSnapshot) {
+            if(m_buffer.size() >= m_maxBuffered) {
+                m_buffer.clear();
+                ++m_gaps;
+            }
+            m_buffer.push_back(std::move(diff));
+            return Result::Buffered;
+        }
+        return apply(diff, book);
+    }
+
+    // The levels are replaced by the snapshot, buffered diffs are replayed on top of it
+    void onSnapshot(Snapshot&& snapshot, Book& book) {
+        book.bidSide.size = 0;
+        book.askSide.size = 0;
+        for(const auto& level : snapshot.bids) {
+            book.bidSide.insert(level.price, level.quantity);
+        }
+        for(const auto& level : snapshot.asks) {
+            book.askSide.insert(level.price, level.quantity);
+        }
+        m_lastUpdateId = snapshot.lastUpdateId;
+        m_state = State::Bridging;
+        ++m_snapshots;
+
+        std::vector<Diff> buffered;
+        buffered.swap(m_buffer);
+        for(auto& diff : buffered) {
+            if(apply(diff, book) == Result::Gap) {
+                return;
+            }
+        }
+    }
+
+    // True while diffs are buffered for a snapshot that has not been handed in
+    [[nodiscard]] bool needsSnapshot() const { return m_state == State::AwaitingSnapshot; }
+
+    // Forgets the levels, e.g. after a reconnect, the next diffs wait for a new snapshot
+    void reset(Book& book) {
+        book.bidSide.size = 0;
+        book.askSide.size = 0;
+        m_buffer.clear();
+        m_state = State::AwaitingSnapshot;
+    }
+
+    [[nodiscard]] State state() const { return m_state; }
+    [[nodiscard]] uint64_t lastUpdateId() const { return m_lastUpdateId; }
+    [[nodiscard]] uint64_t gaps() const { return m_gaps; }
+    [[nodiscard]] uint64_t snapshots() const { return m_snapshots; }
+
+private:
+    Result apply(const Diff& diff, Book& book) {
+        if(diff.finalUpdateId < m_lastUpdateId) {
+            return Result::Stale;
+        }
+        const bool continues = m_state == State::Bridging
+                                   ? diff.firstUpdateId <= m_lastUpdateId
+                                   : diff.previousUpdateId == m_lastUpdateId;
+        if(!continues) {
+            ++m_gaps;
+            reset(book);
+            return Result::Gap;
+        }
+        for(const auto& level : diff.bids) {
+            book.bidSide.insert(level.price, level.quantity);
+        }
+        for(const auto& level : diff.asks) {
+            book.askSide.insert(level.price, level.quantity);
+        }
+        m_lastUpdateId = diff.finalUpdateId;
+        m_state = State::Synced;
+        return Result::Applied;
+    }
+
+    const size_t m_maxBuffered;
+    State m_state = State::AwaitingSnapshot;
+    uint64_t m_lastUpdateId = 0;
+    std::vector<Diff> m_buffer;
+    uint64_t m_gaps = 0;
+    uint64_t m_snapshots = 0;
+};
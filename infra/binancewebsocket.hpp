@@ -1,31 +1,94 @@
 #pragma once
 #include "../utils/logger.hpp"
 #include "../utils/requests.hpp"
+#include "binancedepth.hpp"
 #include "book.hpp"
+#include "symbolrouter.hpp"
+#include "tradeflow.hpp"
 #include "websocket.hpp"
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <curl/curl.h>
+#include <future>
+#include <memory>
 #include <queue>
 #include <rapidjson/document.h>
 #include <rapidjson/stringbuffer.h>
 #include <rapidjson/writer.h>
 
+// Streams consumed next to bookTicker in trading mode, see BinanceWebSocketClient::liveStreams
+struct BinanceStreamConfig {
+    bool depth = false;                // <symbol>@depth diffs kept as the full book behind the touch
+    std::string depthSpeed = "100ms";  // 100ms, 250ms or 500ms
+    uint32_t snapshotLimit = 500;      // levels of the REST snapshot the diffs are bridged to
+    bool aggTrade = false;             // <symbol>@aggTrade into a TradeFlow per symbol
+    uint64_t tradeFlowHalflifeNs = 1'000'000'000;
+    std::string restBaseUrl;           // e.g. https://fapi.binance.com
+};
+
 class BinanceWebSocketClient : public WebSocketClient<BinanceWebSocketClient> {
 public:
-    using MarketDataUpdateCallback = std::function<void()>;
+    static constexpr latency::Venue LATENCY_VENUE = latency::Venue::Binance;
+
+    using MarketDataUpdateCallback = std::function<void(mapping::InstrumentId instrument)>;
+    using TradeUpdateCallback = std::function<void(mapping::InstrumentId instrument)>;
     using WebSocketStatusUpdateCallback = std::function<void(bool)>;
     using PoolAllocator = rapidjson::MemoryPoolAllocator<rapidjson::CrtAllocator>;
+    // Body of GET <restBaseUrl>/fapi/v1/depth, empty on failure. Runs off the connection thread.
+    using SnapshotFetcher = std::function<std::string(const std::string& symbol, uint32_t limit)>;
+
+    // A failed snapshot is requested again after this much exchange time
+    static constexpr uint64_t SNAPSHOT_RETRY_NS = 1'000'000'000;
 
+    // All instruments share the connection, updates are reported with their InstrumentRegistry id. In trading mode
+    // the streams are part of the uri, the mock server is subscribed to after the connection opens.
     explicit BinanceWebSocketClient(const bool trading_mode,
                                     const uint32_t retry_limit,
                                     const std::string& uri,
                                     const std::string& proxy_uri,
-                                    const std::string instrument)
+                                    const std::vector<std::string>& instruments,
+                                    const BinanceStreamConfig& streams = {})
         : WebSocketClient(retry_limit, uri, proxy_uri, true)
-        , m_binanceBook(instrument)
-        , m_instrument(instrument)
-        , trading_mode(trading_mode) {
+        , m_router(instruments, exchangeSymbols(trading_mode, instruments))
+        , trading_mode(trading_mode)
+        , m_streams(streams)
+        , m_depth(instruments.size()) {
         document = rapidjson::Document(&allocator);
+        m_tradeFlows.reserve(instruments.size());
+        for(size_t i = 0; i < instruments.size(); ++i) {
+            m_tradeFlows.push_back(std::make_unique<TradeFlow>(streams.tradeFlowHalflifeNs));
+        }
+        m_fetchSnapshot = [baseUrl = streams.restBaseUrl, proxy_uri](const std::string& symbol, uint32_t limit) {
+            return httpGet(baseUrl + "/fapi/v1/depth?symbol=" + symbol + "&limit=" + std::to_string(limit), proxy_uri);
+        };
     }
 
+    // Streams of one instrument in the combined live uri, e.g. btcusdt@bookTicker/btcusdt@depth@100ms
+    static std::string liveStreams(const std::string& symbol, const BinanceStreamConfig& streams) {
+        std::string path = symbol + "@bookTicker";
+        if(streams.depth) {
+            if(streams.depthSpeed == "250ms") {
+                path += "/" + symbol + "@depth"; // the default speed has no suffix
+            } else if(streams.depthSpeed == "100ms" || streams.depthSpeed == "500ms") {
+                path += "/" + symbol + "@depth@" + streams.depthSpeed;
+            } else {
+                throw std::invalid_argument("binance depth speed must be 100ms, 250ms or 500ms, got: " +
+                                            streams.depthSpeed);
+            }
+        }
+        if(streams.aggTrade) {
+            path += "/" + symbol + "@aggTrade";
+        }
+        return path;
+    }
+
+    // Must be called before start(), replaces the REST request of the depth snapshot
+    void setSnapshotFetcher(SnapshotFetcher fetcher) { m_fetchSnapshot = std::move(fetcher); }
+
+    // Called on the connection thread after a trade was added to tradeFlow(instrument)
+    void setTradeUpdateCallback(TradeUpdateCallback callback) { tradeUpdateCallback = std::move(callback); }
+
     void setMarketDataUpdateCallback(MarketDataUpdateCallback callback) {
         marketDataUpdateCallback = std::move(callback);
     }
@@ -35,6 +98,10 @@ public:
     }
     void onClose(websocketpp::connection_hdl hdl, std::string message) {
         LoggerSingleton::get().infra().error("binance md channel closed");
+        m_router.resetReady();
+        for(size_t symbol = 0; symbol < m_depth.size(); ++symbol) {
+            m_depth[symbol].sync.reset(m_router.book(symbol)); // diffs missed while down, start over
+        }
         if(message == "disconnect") {
             if(websocketStatusUpdateCallback) {
                 websocketStatusUpdateCallback(false);
@@ -61,50 +128,88 @@ public:
         return -1; // Invalid type
     }
 
-    inline void parseMessage(const std::string& marketData) {
-        document.Parse<rapidjson::kParseFullPrecisionFlag>(marketData.c_str());
+    // Returns the id of the symbol the frame updated, NOT_FOUND if it could not be routed
+    inline size_t parseMessage(std::string_view marketData) {
+        document.Parse<rapidjson::kParseFullPrecisionFlag>(marketData.data(), marketData.size());
 
         if(document.HasParseError()) {
             LoggerSingleton::get().infra().error("RapidJSON parse error: ", document.GetParseError());
-            return;
+            return SymbolRouter::NOT_FOUND;
         }
 
         if(!document.IsObject()) {
             LoggerSingleton::get().infra().error("Expected top-level JSON object");
-            return;
+            return SymbolRouter::NOT_FOUND;
+        }
+
+        const size_t symbol = routeSymbol(document);
+        if(symbol == SymbolRouter::NOT_FOUND) {
+            return symbol;
+        }
+        Book& binanceBook = m_router.book(symbol);
+        m_oldBestBid = binanceBook.getBestBid();
+        m_oldBestAsk = binanceBook.getBestAsk();
+
+        m_event = eventType(document);
+        if(m_event == StreamEvent::DepthUpdate) {
+            onDepthUpdate(symbol, document);
+            return symbol;
+        }
+        if(m_event == StreamEvent::AggTrade) {
+            onAggTrade(symbol, document);
+            return symbol;
         }
 
         if(document.HasMember("T") && document["T"].IsUint64()) {
-            m_binanceBook.m_timestamp = document["T"].GetUint64() * 1000000ULL;
+            binanceBook.m_timestamp = document["T"].GetUint64() * 1000000ULL;
         } else {
             LoggerSingleton::get().infra().error("No 'T' (timestamp) in data");
         }
 
+        // "u" is the order book update id, used to arbitrate between redundant connections
+        m_updateId = document.HasMember("u") && document["u"].IsUint64() ? document["u"].GetUint64()
+                                                                         : binanceBook.m_timestamp;
+
         // Extract best bid price from "b"
         if(document.HasMember("b") && document["b"].IsString()) {
             double bestBid = fastStrtod(document["b"].GetString());
-            m_binanceBook.setBestBid(bestBid);
+            binanceBook.setBestBid(bestBid);
         }
 
         // Extract best ask price from "a"
         if(document.HasMember("a") && document["a"].IsString()) {
             double bestAsk = fastStrtod(document["a"].GetString());
-            m_binanceBook.setBestAsk(bestAsk);
+            binanceBook.setBestAsk(bestAsk);
+        }
+
+        if(m_streams.depth) {
+            alignTouch(symbol, document);
         }
+        return symbol;
     }
 
-    inline void parseMockMessage(std::string& marketData) {
+    inline size_t parseMockMessage(std::string_view marketData) {
         rapidjson::Document document;
-        document.Parse<rapidjson::kParseFullPrecisionFlag>(marketData.c_str());
+        document.Parse<rapidjson::kParseFullPrecisionFlag>(marketData.data(), marketData.size());
 
         if(document.HasParseError() || !document.IsObject()) {
-            return; // Handle parsing error gracefully
+            return SymbolRouter::NOT_FOUND; // Handle parsing error gracefully
+        }
+
+        const size_t symbol = routeSymbol(document);
+        if(symbol == SymbolRouter::NOT_FOUND) {
+            return symbol;
         }
+        Book& binanceBook = m_router.book(symbol);
+        m_oldBestBid = binanceBook.getBestBid();
+        m_oldBestAsk = binanceBook.getBestAsk();
 
         // Extract and update timestamp (E field), multiply by 10^6
         if(document.HasMember("E") && document["E"].IsUint64()) {
-            m_binanceBook.m_timestamp = document["E"].GetUint64() * 1000000ULL;
+            binanceBook.m_timestamp = document["E"].GetUint64() * 1000000ULL;
         }
+        m_updateId = document.HasMember("u") && document["u"].IsUint64() ? document["u"].GetUint64()
+                                                                         : binanceBook.m_timestamp;
 
         // Extract bids and asks
         if(document.HasMember("b") && document["b"].IsArray() && document.HasMember("a") && document["a"].IsArray()) {
@@ -124,30 +229,34 @@ public:
                 const char* bestAskQtyStr = asks[0][1].GetString();
                 double bestAskPrice = fastStrtod(bestAskPriceStr);
                 double bestAskQty = fastStrtod(bestAskQtyStr);
-                m_binanceBook.setBestBid(bestBidPrice);
-                m_binanceBook.setBestAsk(bestAskPrice);
+                binanceBook.setBestBid(bestBidPrice);
+                binanceBook.setBestAsk(bestAskPrice);
             }
         }
+        return symbol;
     }
 
-    void onMessage(websocketpp::connection_hdl hdl, client_non_tls::message_ptr msg) {
-        // Parse the message payload into MarketData
-        std::string message = msg->get_payload();
+    // The payload view is only valid for the duration of the call
+    void onMessage(std::string_view message) {
         LOG_INFRA_DEBUG("binance md payload: ", message);
         cnt += 1;
         if(cnt <= 2) return;
-        double old_best_bid = m_binanceBook.getBestBid();
-        double old_best_ask = m_binanceBook.getBestAsk();
-        if(trading_mode)
-            parseMessage(message);
-        else
-            parseMockMessage(message);
-        this->m_bookWarmedUp = true;
-        if(old_best_ask == m_binanceBook.getBestAsk() && old_best_bid == m_binanceBook.getBestBid()) {
+        m_event = StreamEvent::BookTicker;
+        const size_t symbol = trading_mode ? parseMessage(message) : parseMockMessage(message);
+        if(symbol == SymbolRouter::NOT_FOUND) {
+            return;
+        }
+        // Depth and trades keep their own state, only bookTicker moves the touch that is published
+        if(m_event != StreamEvent::BookTicker) {
+            return;
+        }
+        m_router.setReady(symbol);
+        const mapping::InstrumentId instrument = m_router.instrument(symbol);
+        if(!accept_update(instrument, m_updateId, m_router.book(symbol), m_oldBestBid, m_oldBestAsk)) {
             return;
         }
         if(marketDataUpdateCallback) {
-            marketDataUpdateCallback();
+            marketDataUpdateCallback(instrument);
         }
     }
 
@@ -159,33 +268,277 @@ public:
                 LoggerSingleton::get().infra().error("error sending binance subscribe message: ", ec.message());
             }
         } else {
-            m_instrument = mapping::getMockInstrument(m_instrument);
-            std::string md_subscribe = requests::getBinanceDirectStream(m_instrument);
-            ws_client->send(hdl, md_subscribe, websocketpp::frame::opcode::text);
-            if(ec) {
-                LoggerSingleton::get().infra().error("error sending binance subscribe message: ", ec.message());
+            std::vector<std::string> streams;
+            for(const auto& symbol : m_router.exchangeSymbols()) {
+                streams.push_back(lowercase(symbol));
+            }
+            std::string md_subscribe = requests::getBinanceDirectStream(streams);
+            if(!send_text(md_subscribe)) {
+                LoggerSingleton::get().infra().error("error sending binance subscribe message");
             }
         }
     }
 
+    // Every subscribed symbol has received a book update since the connection opened
     [[nodiscard]]
     bool isBookReady() const noexcept {
-        return m_bookWarmedUp;
+        return m_router.allReady();
     }
 
-    const Book& getBook() const { return m_binanceBook; }
+    [[nodiscard]]
+    bool isBookReady(mapping::InstrumentId instrument) const noexcept {
+        const size_t slot = m_router.slot(instrument);
+        return slot != SymbolRouter::NOT_FOUND && m_router.isReady(slot);
+    }
+
+    // The instrument must be one of instruments()
+    const Book& getBook(mapping::InstrumentId instrument) const { return m_router.book(m_router.slot(instrument)); }
+
+    // Registry ids of the subscribed instruments, in subscription order
+    [[nodiscard]] const std::vector<mapping::InstrumentId>& instruments() const { return m_router.instruments(); }
+
+    // Decayed aggTrade statistics, empty unless the aggTrade stream is enabled
+    [[nodiscard]] const TradeFlow& tradeFlow(mapping::InstrumentId instrument) const {
+        return *m_tradeFlows[m_router.slot(instrument)];
+    }
+
+    [[nodiscard]] const BinanceDepthSync& depthSync(mapping::InstrumentId instrument) const {
+        return m_depth[m_router.slot(instrument)].sync;
+    }
 
 protected:
-    Book m_binanceBook;
+    SymbolRouter m_router;
 
 private:
     MarketDataUpdateCallback marketDataUpdateCallback;
     uint64_t m_timestamp;
+    uint64_t m_updateId = 0;
+    double m_oldBestBid = 0.0;
+    double m_oldBestAsk = 0.0;
     int cnt = 0;
     rapidjson::Document document;
     PoolAllocator allocator;
     WebSocketStatusUpdateCallback websocketStatusUpdateCallback;
-    bool m_bookWarmedUp = false;
-    std::string m_instrument;
+    TradeUpdateCallback tradeUpdateCallback;
     bool trading_mode = false;
+
+    enum class StreamEvent : uint8_t { BookTicker, DepthUpdate, AggTrade };
+
+    struct DepthState {
+        BinanceDepthSync sync;
+        std::future<std::string> snapshot; // valid while a REST snapshot is in flight
+        uint64_t retryAfterNs = 0;
+        uint64_t touchNs = 0;  // exchange time of the last bookTicker
+        uint64_t diffNs = 0;   // exchange time of the last diff
+    };
+
+    const BinanceStreamConfig m_streams;
+    StreamEvent m_event = StreamEvent::BookTicker;
+    std::vector<DepthState> m_depth;                     // by slot
+    std::vector<std::unique_ptr<TradeFlow>> m_tradeFlows; // by slot
+    SnapshotFetcher m_fetchSnapshot;
+
+    static StreamEvent eventType(const rapidjson::Document& frame) {
+        if(frame.HasMember("e") && frame["e"].IsString()) {
+            const std::string_view event(frame["e"].GetString(), frame["e"].GetStringLength());
+            if(event == "depthUpdate") {
+                return StreamEvent::DepthUpdate;
+            }
+            if(event == "aggTrade") {
+                return StreamEvent::AggTrade;
+            }
+        }
+        return StreamEvent::BookTicker;
+    }
+
+    static uint64_t updateId(const rapidjson::Value& frame, const char* key) {
+        return frame.HasMember(key) && frame[key].IsUint64() ? frame[key].GetUint64() : 0;
+    }
+
+    // [["price", "quantity"], ...] as sent by the depth stream and the REST snapshot
+    static void parseLevels(const rapidjson::Value& frame, const char* key, std::vector<BinanceDepthSync::Level>& out) {
+        if(!frame.HasMember(key) || !frame[key].IsArray()) {
+            return;
+        }
+        const auto& levels = frame[key];
+        out.reserve(levels.Size());
+        for(const auto& level : levels.GetArray()) {
+            if(level.IsArray() && level.Size() >= 2 && level[0].IsString() && level[1].IsString()) {
+                out.push_back({fastStrtod(level[0].GetString()), fastStrtod(level[1].GetString())});
+            }
+        }
+    }
+
+    // A bookTicker is faster than the diffs: its prices own the touch and its sizes the levels there,
+    // levels the diffs still have through the touch are gone already
+    void alignTouch(size_t symbol, const rapidjson::Document& frame) {
+        Book& book = m_router.book(symbol);
+        DepthState& depth = m_depth[symbol];
+        depth.touchNs = book.m_timestamp;
+        if(depth.sync.state() != BinanceDepthSync::State::Synced) {
+            return;
+        }
+        trimToTouch(book);
+        if(frame.HasMember("B") && frame["B"].IsString() && book.getBestBid() > 0.0) {
+            book.bidSide.insert(book.getBestBid(), fastStrtod(frame["B"].GetString()));
+        }
+        if(frame.HasMember("A") && frame["A"].IsString() && book.getBestAsk() > 0.0) {
+            book.askSide.insert(book.getBestAsk(), fastStrtod(frame["A"].GetString()));
+        }
+    }
+
+    static void trimToTouch(Book& book) {
+        const double bestBid = book.getBestBid();
+        const double bestAsk = book.getBestAsk();
+        while(bestBid > 0.0 && book.bidSide.size > 0 && book.bidSide.levels[0].price > bestBid + PRICE_EPSILON) {
+            book.bidSide.eraseAt(0);
+        }
+        while(bestAsk > 0.0 && book.askSide.size > 0 && book.askSide.levels[0].price < bestAsk - PRICE_EPSILON) {
+            book.askSide.eraseAt(0);
+        }
+    }
+
+    void onDepthUpdate(size_t symbol, const rapidjson::Document& frame) {
+        Book& book = m_router.book(symbol);
+        DepthState& depth = m_depth[symbol];
+        pollSnapshot(symbol);
+
+        BinanceDepthSync::Diff diff;
+        diff.firstUpdateId = updateId(frame, "U");
+        diff.finalUpdateId = updateId(frame, "u");
+        diff.previousUpdateId = updateId(frame, "pu");
+        diff.timestampNs = updateId(frame, "T") * 1000000ULL;
+        parseLevels(frame, "b", diff.bids);
+        parseLevels(frame, "a", diff.asks);
+        depth.diffNs = diff.timestampNs;
+
+        const auto result = depth.sync.onDiff(std::move(diff), book);
+        if(result == BinanceDepthSync::Result::Gap) {
+            LoggerSingleton::get().infra().warning("action=binance_depth_gap symbol=",
+                                                   m_router.exchangeSymbol(symbol),
+                                                   " last_update_id=",
+                                                   depth.sync.lastUpdateId(),
+                                                   " gaps=",
+                                                   depth.sync.gaps());
+        }
+        // diffs older than the last bookTicker may bring back levels it already moved through
+        if(result == BinanceDepthSync::Result::Applied && depth.diffNs <= depth.touchNs) {
+            trimToTouch(book);
+        }
+        if(depth.sync.needsSnapshot() && !depth.snapshot.valid() && depth.diffNs >= depth.retryAfterNs) {
+            depth.snapshot = std::async(std::launch::async,
+                                        m_fetchSnapshot,
+                                        m_router.exchangeSymbol(symbol),
+                                        m_streams.snapshotLimit);
+        }
+    }
+
+    // Applies a snapshot that arrived since the last diff, never waits for one
+    void pollSnapshot(size_t symbol) {
+        DepthState& depth = m_depth[symbol];
+        if(!depth.snapshot.valid() ||
+           depth.snapshot.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+            return;
+        }
+        const std::string body = depth.snapshot.get();
+        rapidjson::Document snapshotDocument;
+        snapshotDocument.Parse<rapidjson::kParseFullPrecisionFlag>(body.data(), body.size());
+        if(snapshotDocument.HasParseError() || !snapshotDocument.IsObject() ||
+           !snapshotDocument.HasMember("lastUpdateId")) {
+            LoggerSingleton::get().infra().error("action=binance_depth_snapshot_failed symbol=",
+                                                 m_router.exchangeSymbol(symbol),
+                                                 " response=",
+                                                 body.substr(0, 256));
+            depth.retryAfterNs = depth.diffNs + SNAPSHOT_RETRY_NS;
+            return;
+        }
+        BinanceDepthSync::Snapshot snapshot;
+        snapshot.lastUpdateId = updateId(snapshotDocument, "lastUpdateId");
+        parseLevels(snapshotDocument, "bids", snapshot.bids);
+        parseLevels(snapshotDocument, "asks", snapshot.asks);
+        Book& book = m_router.book(symbol);
+        depth.sync.onSnapshot(std::move(snapshot), book);
+        trimToTouch(book);
+        LoggerSingleton::get().infra().info("action=binance_depth_snapshot symbol=",
+                                            m_router.exchangeSymbol(symbol),
+                                            " last_update_id=",
+                                            depth.sync.lastUpdateId(),
+                                            " synced=",
+                                            depth.sync.state() == BinanceDepthSync::State::Synced,
+                                            " bid_levels=",
+                                            book.bidSide.size,
+                                            " ask_levels=",
+                                            book.askSide.size);
+    }
+
+    // "m" is true when the buyer was the maker, i.e. a sell hit the bid
+    void onAggTrade(size_t symbol, const rapidjson::Document& frame) {
+        if(!frame.HasMember("p") || !frame["p"].IsString() || !frame.HasMember("q") || !frame["q"].IsString() ||
+           !frame.HasMember("m") || !frame["m"].IsBool()) {
+            return;
+        }
+        m_tradeFlows[symbol]->onTrade(updateId(frame, "T") * 1000000ULL,
+                                      fastStrtod(frame["p"].GetString()),
+                                      fastStrtod(frame["q"].GetString()),
+                                      !frame["m"].GetBool());
+        if(tradeUpdateCallback) {
+            tradeUpdateCallback(m_router.instrument(symbol));
+        }
+    }
+
+    static size_t writeCallback(void* contents, size_t size, size_t nmemb, std::string* userp) {
+        userp->append(static_cast<char*>(contents), size * nmemb);
+        return size * nmemb;
+    }
+
+    static std::string httpGet(const std::string& url, const std::string& proxy) {
+        CURL* curl = curl_easy_init();
+        if(!curl) {
+            return "";
+        }
+        std::string body;
+        curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
+        curl_easy_setopt(curl, CURLOPT_HTTPGET, 1L);
+        curl_easy_setopt(curl, CURLOPT_TIMEOUT_MS, 5000L);
+        curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, writeCallback);
+        curl_easy_setopt(curl, CURLOPT_WRITEDATA, &body);
+        if(!proxy.empty()) {
+            curl_easy_setopt(curl, CURLOPT_PROXY, proxy.c_str());
+        }
+        const CURLcode res = curl_easy_perform(curl);
+        long httpCode = 0;
+        curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &httpCode);
+        curl_easy_cleanup(curl);
+        if(res != CURLE_OK || httpCode != 200) {
+            LoggerSingleton::get().infra().error(
+                "binance rest request failed: ", url, " error=", curl_easy_strerror(res), " http_code=", httpCode);
+            return "";
+        }
+        return body;
+    }
+
+    // Both bookTicker and depth events name their instrument in "s", in upper case
+    size_t routeSymbol(const rapidjson::Document& frame) const {
+        if(!frame.HasMember("s") || !frame["s"].IsString()) {
+            return m_router.find("");
+        }
+        return m_router.find(std::string_view(frame["s"].GetString(), frame["s"].GetStringLength()));
+    }
+
+    static std::string lowercase(std::string symbol) {
+        std::transform(symbol.begin(), symbol.end(), symbol.begin(), [](unsigned char c) { return std::tolower(c); });
+        return symbol;
+    }
+
+    static std::vector<std::string> exchangeSymbols(bool trading_mode, const std::vector<std::string>& instruments) {
+        std::vector<std::string> symbols;
+        for(const auto& instrument : instruments) {
+            std::string symbol = trading_mode ? mapping::getInstrumentInfo(instrument).instrument
+                                              : mapping::getMockInstrument(instrument);
+            std::transform(
+                symbol.begin(), symbol.end(), symbol.begin(), [](unsigned char c) { return std::toupper(c); });
+            symbols.push_back(std::move(symbol));
+        }
+        return symbols;
+    }
 };
@@ -4,7 +4,10 @@
 #include <charconv>
 #include <cstring>
 #include <immintrin.h>
+#include <sstream>
+#include <string>
 #include <unordered_map>
+#include <vector>
 #include <x86intrin.h>
 
 constexpr size_t MAX_LEVELS = 1000;
@@ -4,6 +4,7 @@
 #include "../utils/logger.hpp"
 #include "../utils/requests.hpp"
 #include "book.hpp"
+#include "symbolrouter.hpp"
 #include "websocket.hpp"
 #include <rapidjson/document.h>
 #include <rapidjson/stringbuffer.h>
@@ -14,19 +15,21 @@ using nlohmann::json;
 
 class ByBitWebSocketClient : public WebSocketClient<ByBitWebSocketClient> {
 public:
-    using MarketDataUpdateCallback = std::function<void()>;
+    static constexpr latency::Venue LATENCY_VENUE = latency::Venue::Bybit;
+
+    using MarketDataUpdateCallback = std::function<void(mapping::InstrumentId instrument)>;
     using WebSocketStatusUpdateCallback = std::function<void(bool)>;
     using PoolAllocator = rapidjson::MemoryPoolAllocator<rapidjson::CrtAllocator>;
 
+    // All instruments share the connection, updates are reported with their InstrumentRegistry id
     explicit ByBitWebSocketClient(const std::string& uri,
                                   const std::string& proxy_uri,
-                                  const std::string instrument,
+                                  const std::vector<std::string>& instruments,
                                   const uint32_t retry_limit,
                                   const std::string apiKey,
                                   const std::string apiSecret)
         : WebSocketClient(retry_limit, uri, proxy_uri)
-        , m_instrument(instrument)
-        , m_byBitBook(instrument)
+        , m_router(instruments, exchangeSymbols(instruments))
         , apiKey(apiKey)
         , apiSecret(apiSecret) {}
 
@@ -40,7 +43,7 @@ public:
 
     void onClose(websocketpp::connection_hdl hdl, std::string message) {
         LoggerSingleton::get().infra().error("bybit md channel closed");
-        m_bookWarmedUp = false;
+        m_router.resetReady();
         if(message == "disconnect") {
             if(webSocketStatusUpdateCallback) {
                 webSocketStatusUpdateCallback(false);
@@ -55,57 +58,71 @@ public:
     }
 
     void send_heartbeat() {
-        try {
-            nlohmann::json ping_msg = {{"op", "ping"}};
-            LOG_INFRA_DEBUG("bybit md channel heartbeat: ping");
-            ws_client->send(current_hdl, ping_msg.dump(), websocketpp::frame::opcode::text);
-        } catch(const std::exception& e) {
-            LoggerSingleton::get().infra().error("action=heartbeat exchage=bybit stream=md result=fail reason=",
-                                                 e.what());
+        nlohmann::json ping_msg = {{"op", "ping"}};
+        LOG_INFRA_DEBUG("bybit md channel heartbeat: ping");
+        if(!send_text(ping_msg.dump())) {
+            LoggerSingleton::get().infra().error(
+                "action=heartbeat exchage=bybit stream=md result=fail reason=send_failed");
             if(webSocketStatusUpdateCallback) {
                 webSocketStatusUpdateCallback(false);
             }
         }
     }
 
-    inline void parseMessage(std::string& message) {
+    // Returns the id of the symbol the frame updated, NOT_FOUND for control frames
+    inline size_t parseMessage(std::string_view message) {
         json parsedJson = json::parse(message);
         if(parsedJson.contains("op") && parsedJson["op"] == "ping") {
             LOG_INFRA_DEBUG("bybit md channel heartbeat: pong");
             LOG_INFRA_DEBUG("action=heartbeat exchange=bybit stream=md result=pass");
-            return;
+            return SymbolRouter::NOT_FOUND;
+        }
+        if(!parsedJson.contains("data")) {
+            return SymbolRouter::NOT_FOUND; // subscription acks
         }
         LOG_INFRA_DEBUG("bybit md payload: ", message);
+        const auto& data = parsedJson["data"];
+        const size_t symbol = m_router.find(data.contains("s") ? data["s"].get_ref<const std::string&>() : "");
+        if(symbol == SymbolRouter::NOT_FOUND) {
+            return symbol;
+        }
+        Book& book = m_router.book(symbol);
+        m_oldBestBid = book.getBestBid();
+        m_oldBestAsk = book.getBestAsk();
         if(parsedJson.contains("ts")) {
             long long ts = parsedJson["ts"];
-            m_byBitBook.m_timestamp = ts * milliToNano;
+            book.m_timestamp = ts * milliToNano;
         }
-        for(const auto& bid : parsedJson["data"]["b"]) {
-            m_byBitBook.setBestBid(std::stod(bid[0].get<std::string>()));
+        // "u" restarts from 1 when bybit resets the book, accept_update takes that as a sequence reset
+        m_updateId = data.value("u", static_cast<uint64_t>(book.m_timestamp));
+        // operator[] on a const json is undefined for a missing key, a side without changes may be left out
+        if(const auto bids = data.find("b"); bids != data.end()) {
+            for(const auto& bid : *bids) {
+                book.setBestBid(std::stod(bid[0].get<std::string>()));
+            }
         }
-        for(const auto& ask : parsedJson["data"]["a"]) {
-            m_byBitBook.setBestAsk(std::stod(ask[0].get<std::string>()));
+        if(const auto asks = data.find("a"); asks != data.end()) {
+            for(const auto& ask : *asks) {
+                book.setBestAsk(std::stod(ask[0].get<std::string>()));
+            }
         }
+        return symbol;
     }
 
-    void onMessage(websocketpp::connection_hdl hdl, client_tls::message_ptr msg) {
-        // cnt += 1;
-        std::string message = msg->get_payload();
-        double old_best_bid = m_byBitBook.getBestBid();
-        double old_best_ask = m_byBitBook.getBestAsk();
-        parseMessage(message);
-        this->m_bookWarmedUp = true;
-        if(old_best_bid == m_byBitBook.getBestBid() && old_best_ask == m_byBitBook.getBestAsk()) {
+    // The payload view is only valid for the duration of the call
+    void onMessage(std::string_view message) {
+        const size_t symbol = parseMessage(message);
+        if(symbol == SymbolRouter::NOT_FOUND) {
+            return;
+        }
+        m_router.setReady(symbol);
+        const mapping::InstrumentId instrument = m_router.instrument(symbol);
+        if(!accept_update(instrument, m_updateId, m_router.book(symbol), m_oldBestBid, m_oldBestAsk)) {
             return;
         }
         if(marketDataUpdateCallback) {
-            marketDataUpdateCallback();
+            marketDataUpdateCallback(instrument);
         }
-
-        // if (cnt%100 == 0) {
-        //     ws_client->close(current_hdl, websocketpp::close::status::normal, "Testing closure");
-        //     LoggerSingleton::get().infra().warning("closed bybit md channel for testing purposes");
-        // }
     }
 
     void authenticate() {
@@ -118,31 +135,50 @@ public:
     }
 
     void onOpen(websocketpp::connection_hdl hdl) {
-        websocketpp::lib::error_code ec;
         LoggerSingleton::get().infra().info("bybit websocket connection opened");
-        mapping::InstrumentInfo exchangeInst = mapping::getInstrumentInfo(m_instrument);
-        std::string subscribeMessage = requests::getByBitOrderBookMessage(1, exchangeInst.instrument);
-        ws_client->send(hdl, subscribeMessage, websocketpp::frame::opcode::text, ec);
+        std::string subscribeMessage = requests::getByBitOrderBookMessage(1, m_router.exchangeSymbols());
+        if(!send_text(subscribeMessage)) {
+            LoggerSingleton::get().infra().error("error sending bybit subscribe message");
+        }
     }
 
+    // Every subscribed symbol has received a book update since the connection opened
     [[nodiscard]]
     bool isBookReady() const noexcept {
-        return m_bookWarmedUp;
+        return m_router.allReady();
+    }
+
+    [[nodiscard]]
+    bool isBookReady(mapping::InstrumentId instrument) const noexcept {
+        const size_t slot = m_router.slot(instrument);
+        return slot != SymbolRouter::NOT_FOUND && m_router.isReady(slot);
     }
 
-    const Book& getBook() const { return m_byBitBook; }
+    // The instrument must be one of instruments()
+    const Book& getBook(mapping::InstrumentId instrument) const { return m_router.book(m_router.slot(instrument)); }
+
+    // Registry ids of the subscribed instruments, in subscription order
+    [[nodiscard]] const std::vector<mapping::InstrumentId>& instruments() const { return m_router.instruments(); }
 
     static const uint32_t milliToNano = 1000000;
 
 protected:
-    Book m_byBitBook;
+    SymbolRouter m_router;
 
 private:
     MarketDataUpdateCallback marketDataUpdateCallback;
     WebSocketStatusUpdateCallback webSocketStatusUpdateCallback;
-    bool m_bookWarmedUp = false;
     const std::string apiKey;
     const std::string apiSecret;
-    const std::string m_instrument;
-    int cnt = 0;
+    uint64_t m_updateId = 0;
+    double m_oldBestBid = 0.0;
+    double m_oldBestAsk = 0.0;
+
+    static std::vector<std::string> exchangeSymbols(const std::vector<std::string>& instruments) {
+        std::vector<std::string> symbols;
+        for(const auto& instrument : instruments) {
+            symbols.push_back(mapping::getInstrumentInfo(instrument).instrument);
+        }
+        return symbols;
+    }
 };
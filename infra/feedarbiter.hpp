@@ -0,0 +1,96 @@
+#pragma once
+#include "book.hpp"
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+// Best prices of a book read together, so a bid and an ask always come from the same update
+struct TopOfBook {
+    double bid = 0.0;
+    double ask = 0.0;
+    uint64_t timestamp = 0;
+};
+
+// Merges the same market-data feed received over several connections. Every connection
+// parses into its own Book and offers the result here; the first arrival of a newer update
+// id is published as the shared top of book and later copies of the same update are dropped.
+// A feed of one connection is not arbitrated, the arbiter only hands its touch to other threads.
+// Publishers and readers take the same spin lock, readers get a copy.
+class FeedArbiter {
+public:
+    static constexpr size_t MAX_CONNECTIONS = 4;
+
+    struct Stats {
+        uint64_t published = 0;
+        uint64_t duplicates = 0;
+        std::array<uint64_t, MAX_CONNECTIONS> wins{};
+    };
+
+    FeedArbiter(std::string instrument, size_t connections)
+        : m_instrument(std::move(instrument))
+        , m_arbitrate(connections > 1) {}
+
+    FeedArbiter(const FeedArbiter&) = delete;
+    FeedArbiter& operator=(const FeedArbiter&) = delete;
+
+    // Returns true when the update was the first arrival and moved the top of book.
+    // resetFrom is the id the connection saw last before its ids went backwards (an exchange-side
+    // sequence reset), 0 otherwise. The first connection to report a reset moves the arbiter to the
+    // new sequence; the other connections' copies of it find the arbiter already behind their old id
+    // and are arbitrated as usual.
+    bool publish(size_t connection, uint64_t updateId, uint64_t resetFrom, const Book& source) {
+        lock();
+        const bool reset = resetFrom != 0 && m_lastUpdateId >= resetFrom;
+        if(m_arbitrate && updateId <= m_lastUpdateId && !reset) {
+            m_duplicates.fetch_add(1, std::memory_order_relaxed);
+            unlock();
+            return false;
+        }
+        m_lastUpdateId = updateId;
+        const bool changed = source.getBestBid() != m_top.bid || source.getBestAsk() != m_top.ask;
+        m_top = {source.getBestBid(), source.getBestAsk(), source.m_timestamp};
+        unlock();
+
+        m_published.fetch_add(1, std::memory_order_relaxed);
+        m_wins[connection % MAX_CONNECTIONS].fetch_add(1, std::memory_order_relaxed);
+        return changed;
+    }
+
+    [[nodiscard]] TopOfBook getTopOfBook() const {
+        lock();
+        const TopOfBook top = m_top;
+        unlock();
+        return top;
+    }
+
+    [[nodiscard]] const std::string& getInstrumentName() const { return m_instrument; }
+
+    [[nodiscard]] Stats getStats() const {
+        Stats stats;
+        stats.published = m_published.load(std::memory_order_relaxed);
+        stats.duplicates = m_duplicates.load(std::memory_order_relaxed);
+        for(size_t i = 0; i < MAX_CONNECTIONS; ++i) {
+            stats.wins[i] = m_wins[i].load(std::memory_order_relaxed);
+        }
+        return stats;
+    }
+
+private:
+    void lock() const {
+        while(m_lock.test_and_set(std::memory_order_acquire)) {
+            _mm_pause();
+        }
+    }
+
+    void unlock() const { m_lock.clear(std::memory_order_release); }
+
+    mutable std::atomic_flag m_lock = ATOMIC_FLAG_INIT;
+    uint64_t m_lastUpdateId = 0;
+    const std::string m_instrument;
+    const bool m_arbitrate;
+    TopOfBook m_top;
+    std::atomic<uint64_t> m_published{0};
+    std::atomic<uint64_t> m_duplicates{0};
+    std::array<std::atomic<uint64_t>, MAX_CONNECTIONS> m_wins{};
+};
@@ -0,0 +1,527 @@
+#pragma once
+#include "../utils/logger.hpp"
+#include <algorithm>
+#include <array>
+#include <boost/asio.hpp>
+#include <boost/asio/ssl.hpp>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <immintrin.h>
+#include <openssl/evp.h>
+#include <openssl/sha.h>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Minimal RFC 6455 client used on the hot market-data streams instead of websocketpp.
+// Frames are unframed in place inside one reusable receive buffer and handed to the owner
+// as std::string_view, so no message object or payload copy is created per frame.
+namespace native_ws {
+
+enum class Opcode : uint8_t {
+    Continuation = 0x0,
+    Text = 0x1,
+    Binary = 0x2,
+    Close = 0x8,
+    Ping = 0x9,
+    Pong = 0xA,
+};
+
+struct Endpoint {
+    bool tls = true;
+    std::string host;
+    std::string port;
+    std::string target = "/";
+};
+
+// Accepts ws://, wss:// and http:// (proxy) URIs
+inline bool parseEndpoint(std::string_view uri, Endpoint& out) {
+    std::string_view rest;
+    if(uri.starts_with("wss://")) {
+        out.tls = true;
+        out.port = "443";
+        rest = uri.substr(6);
+    } else if(uri.starts_with("ws://")) {
+        out.tls = false;
+        out.port = "80";
+        rest = uri.substr(5);
+    } else if(uri.starts_with("http://")) {
+        out.tls = false;
+        out.port = "80";
+        rest = uri.substr(7);
+    } else {
+        return false;
+    }
+    const auto slash = rest.find('/');
+    const std::string_view authority = rest.substr(0, slash);
+    out.target = slash == std::string_view::npos ? "/" : std::string(rest.substr(slash));
+    const auto colon = authority.rfind(':');
+    if(colon != std::string_view::npos) {
+        out.host = std::string(authority.substr(0, colon));
+        out.port = std::string(authority.substr(colon + 1));
+    } else {
+        out.host = std::string(authority);
+    }
+    return !out.host.empty() && !out.port.empty();
+}
+
+// XOR the payload with the 4-byte masking key (RFC 6455 section 5.3)
+inline void applyMask(char* data, size_t len, const std::array<uint8_t, 4>& key) {
+    size_t i = 0;
+#if defined(USE_AVX2) && defined(__AVX2__)
+    uint32_t key32;
+    std::memcpy(&key32, key.data(), sizeof(key32));
+    const __m256i mask = _mm256_set1_epi32(static_cast<int>(key32));
+    for(; i + 32 <= len; i += 32) {
+        __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(data + i), _mm256_xor_si256(block, mask));
+    }
+#endif
+    uint64_t key64;
+    std::memcpy(&key64, key.data(), 4);
+    std::memcpy(reinterpret_cast<char*>(&key64) + 4, key.data(), 4);
+    for(; i + 8 <= len; i += 8) {
+        uint64_t block;
+        std::memcpy(&block, data + i, sizeof(block));
+        block ^= key64;
+        std::memcpy(data + i, &block, sizeof(block));
+    }
+    for(; i < len; ++i) {
+        data[i] ^= static_cast<char>(key[i & 3]);
+    }
+}
+
+inline std::string base64(const unsigned char* data, size_t len) {
+    std::string out(4 * ((len + 2) / 3), '\0');
+    const int written = EVP_EncodeBlock(reinterpret_cast<unsigned char*>(out.data()), data, static_cast<int>(len));
+    out.resize(written);
+    return out;
+}
+
+inline std::string expectedAccept(const std::string& key) {
+    static constexpr std::string_view guid = "258EAFA5-E914-47DA-95CA-C5AB0DC85B11";
+    const std::string input = key + std::string(guid);
+    unsigned char digest[SHA_DIGEST_LENGTH];
+    SHA1(reinterpret_cast<const unsigned char*>(input.data()), input.size(), digest);
+    return base64(digest, SHA_DIGEST_LENGTH);
+}
+
+// Owner must provide on_native_open(), on_native_message(std::string_view) and on_native_close().
+// All callbacks run on the thread driving run()/poll(); send_text() may be called from any thread.
+template<typename Owner>
+class NativeWebSocket {
+public:
+    using tcp = boost::asio::ip::tcp;
+    using ssl_stream = boost::asio::ssl::stream<tcp::socket>;
+
+    static constexpr size_t min_read_size = 16 * 1024;
+    static constexpr size_t max_frame_size = 16 * 1024 * 1024;
+    // Same budget as websocketpp's open_handshake_timeout default, covers resolve through the 101 response
+    static constexpr std::chrono::milliseconds open_handshake_timeout{5000};
+
+    NativeWebSocket(Owner& owner, const std::string& uri, const std::string& proxy_uri)
+        : owner_(owner)
+        , uri_(uri)
+        , proxy_uri_(proxy_uri)
+        , ssl_ctx_(boost::asio::ssl::context::tlsv12)
+        , resolver_(io_)
+        , handshake_timer_(io_)
+        , stream_(io_, ssl_ctx_)
+        , rng_(std::random_device{}())
+        , rx_(4 * min_read_size) {
+        ssl_ctx_.set_options(boost::asio::ssl::context::default_workarounds | boost::asio::ssl::context::no_sslv2 |
+                             boost::asio::ssl::context::no_sslv3 | boost::asio::ssl::context::single_dh_use);
+    }
+
+    NativeWebSocket(const NativeWebSocket&) = delete;
+    NativeWebSocket& operator=(const NativeWebSocket&) = delete;
+
+    // Starts resolve -> connect -> [proxy CONNECT] -> [TLS] -> upgrade; completes inside run()/poll()
+    bool connect() {
+        if(!parseEndpoint(uri_, endpoint_)) {
+            LoggerSingleton::get().infra().error("action=native_ws_connect result=fail reason=invalid_uri uri=", uri_);
+            return false;
+        }
+        Endpoint target = endpoint_;
+        if(!proxy_uri_.empty()) {
+            if(!parseEndpoint(proxy_uri_, proxy_)) {
+                LoggerSingleton::get().infra().error("action=native_ws_connect result=fail reason=invalid_proxy uri=",
+                                                     proxy_uri_);
+                return false;
+            }
+            target = proxy_;
+        }
+        // A stalled peer fails the connection like any other error, so the owner's reconnect backoff takes over
+        handshake_timer_.expires_after(open_handshake_timeout);
+        handshake_timer_.async_wait([this](const boost::system::error_code& ec) {
+            if(!ec && !isOpen()) {
+                fail("open_handshake", "timeout");
+            }
+        });
+        resolver_.async_resolve(
+            target.host, target.port, [this](const boost::system::error_code& ec, tcp::resolver::results_type results) {
+                if(ec) {
+                    return fail("resolve", ec);
+                }
+                if(finished_) {
+                    return;
+                }
+                boost::asio::async_connect(stream_.lowest_layer(),
+                                           results,
+                                           [this](const boost::system::error_code& ec, const tcp::endpoint&) {
+                                               if(ec) {
+                                                   return fail("connect", ec);
+                                               }
+                                               proxy_uri_.empty() ? start_tls() : proxy_connect();
+                                           });
+            });
+        return true;
+    }
+
+    size_t run() { return io_.run(); }
+
+    size_t poll() { return io_.poll(); }
+
+    [[nodiscard]] bool stopped() const { return io_.stopped(); }
+
+    // Mirrors websocketpp's endpoint::stop(): the io_service is stopped without a close handshake
+    void stop() { io_.stop(); }
+
+    [[nodiscard]] bool isOpen() const { return open_.load(std::memory_order_acquire); }
+
+    [[nodiscard]] int native_handle() { return stream_.lowest_layer().native_handle(); }
+
+    bool send_text(std::string_view payload) {
+        if(!isOpen()) {
+            return false;
+        }
+        boost::asio::post(io_, [this, frame = encode(Opcode::Text, payload)]() mutable { enqueue(std::move(frame)); });
+        return true;
+    }
+
+private:
+    void proxy_connect() {
+        handshake_request_ = "CONNECT " + endpoint_.host + ":" + endpoint_.port + " HTTP/1.1\r\nHost: " +
+                             endpoint_.host + ":" + endpoint_.port + "\r\n\r\n";
+        boost::asio::async_write(stream_.next_layer(),
+                                 boost::asio::buffer(handshake_request_),
+                                 [this](const boost::system::error_code& ec, size_t) {
+                                     if(ec) {
+                                         return fail("proxy_connect", ec);
+                                     }
+                                     read_http_response(false, [this](std::string_view status, std::string_view) {
+                                         if(status.find(" 200") == std::string_view::npos) {
+                                             return fail("proxy_connect", status);
+                                         }
+                                         start_tls();
+                                     });
+                                 });
+    }
+
+    void start_tls() {
+        if(!endpoint_.tls) {
+            return upgrade();
+        }
+        SSL_set_tlsext_host_name(stream_.native_handle(), endpoint_.host.c_str());
+        stream_.async_handshake(boost::asio::ssl::stream_base::client, [this](const boost::system::error_code& ec) {
+            if(ec) {
+                return fail("tls_handshake", ec);
+            }
+            upgrade();
+        });
+    }
+
+    void upgrade() {
+        std::array<unsigned char, 16> nonce;
+        for(auto& byte : nonce) {
+            byte = static_cast<unsigned char>(rng_());
+        }
+        ws_key_ = base64(nonce.data(), nonce.size());
+        const bool default_port = endpoint_.port == (endpoint_.tls ? "443" : "80");
+        handshake_request_ = "GET " + endpoint_.target + " HTTP/1.1\r\nHost: " + endpoint_.host +
+                             (default_port ? "" : ":" + endpoint_.port) +
+                             "\r\nUpgrade: websocket\r\nConnection: Upgrade\r\nSec-WebSocket-Key: " + ws_key_ +
+                             "\r\nSec-WebSocket-Version: 13\r\n\r\n";
+        async_write_raw(boost::asio::buffer(handshake_request_), [this](const boost::system::error_code& ec, size_t) {
+            if(ec) {
+                return fail("upgrade", ec);
+            }
+            read_http_response(endpoint_.tls, [this](std::string_view status, std::string_view headers) {
+                if(status.find(" 101") == std::string_view::npos) {
+                    return fail("upgrade", status);
+                }
+                std::string lowered(headers);
+                std::transform(lowered.begin(), lowered.end(), lowered.begin(), [](unsigned char c) {
+                    return static_cast<char>(std::tolower(c));
+                });
+                const std::string accept = expectedAccept(ws_key_);
+                const auto pos = lowered.find("sec-websocket-accept:");
+                if(pos == std::string::npos || headers.find(accept, pos) == std::string_view::npos) {
+                    return fail("upgrade", "bad_accept_key");
+                }
+                open_.store(true, std::memory_order_release);
+                handshake_timer_.cancel();
+                owner_.on_native_open();
+                // The server may have pushed frames in the same segment as the 101 response
+                parse_frames();
+                if(!finished_) {
+                    read_frames();
+                }
+            });
+        });
+    }
+
+    // Reads into rx_ until the end of the HTTP header block; bytes after it stay buffered
+    template<typename Handler>
+    void read_http_response(bool through_tls, Handler handler) {
+        const std::string_view buffered(rx_.data() + read_pos_, write_pos_ - read_pos_);
+        const auto end = buffered.find("\r\n\r\n");
+        if(end != std::string_view::npos) {
+            const std::string header_block(buffered.substr(0, end));
+            read_pos_ += end + 4;
+            const auto line_end = header_block.find("\r\n");
+            const std::string_view block(header_block);
+            return handler(block.substr(0, line_end), block);
+        }
+        prepare_read(0);
+        auto on_read = [this, through_tls, handler](const boost::system::error_code& ec, size_t n) mutable {
+            if(ec) {
+                return fail("read_http_response", ec);
+            }
+            write_pos_ += n;
+            read_http_response(through_tls, std::move(handler));
+        };
+        auto buffer = boost::asio::buffer(rx_.data() + write_pos_, rx_.size() - write_pos_);
+        through_tls ? stream_.async_read_some(buffer, std::move(on_read))
+                    : stream_.next_layer().async_read_some(buffer, std::move(on_read));
+    }
+
+    void read_frames() {
+        prepare_read(pending_frame_size_);
+        auto on_read = [this](const boost::system::error_code& ec, size_t n) {
+            if(ec) {
+                return fail("read", ec);
+            }
+            write_pos_ += n;
+            parse_frames();
+            if(!finished_ && !closing_) {
+                read_frames();
+            }
+        };
+        auto buffer = boost::asio::buffer(rx_.data() + write_pos_, rx_.size() - write_pos_);
+        endpoint_.tls ? stream_.async_read_some(buffer, std::move(on_read))
+                      : stream_.next_layer().async_read_some(buffer, std::move(on_read));
+    }
+
+    // Compacts the buffer and grows it so that `needed` bytes from read_pos_ fit plus one read
+    void prepare_read(size_t needed) {
+        if(read_pos_ > 0 && (rx_.size() - write_pos_ < min_read_size || rx_.size() - read_pos_ < needed)) {
+            std::memmove(rx_.data(), rx_.data() + read_pos_, write_pos_ - read_pos_);
+            write_pos_ -= read_pos_;
+            read_pos_ = 0;
+        }
+        const size_t required = std::max(read_pos_ + needed, write_pos_ + min_read_size);
+        if(rx_.size() < required) {
+            rx_.resize(required);
+        }
+    }
+
+    void parse_frames() {
+        pending_frame_size_ = 0;
+        while(!finished_ && !closing_) {
+            const size_t available = write_pos_ - read_pos_;
+            if(available < 2) {
+                break;
+            }
+            auto* header = reinterpret_cast<uint8_t*>(rx_.data() + read_pos_);
+            const bool fin = header[0] & 0x80;
+            const auto opcode = static_cast<Opcode>(header[0] & 0x0F);
+            // Servers never mask their frames (RFC 6455 section 5.1)
+            if(header[1] & 0x80) {
+                return fail("parse_frame", "masked_server_frame");
+            }
+            uint64_t length = header[1] & 0x7F;
+            size_t header_size = 2;
+            if(length == 126) {
+                if(available < 4) {
+                    break;
+                }
+                length = (static_cast<uint64_t>(header[2]) << 8) | header[3];
+                header_size = 4;
+            } else if(length == 127) {
+                if(available < 10) {
+                    break;
+                }
+                length = 0;
+                for(int i = 0; i < 8; ++i) {
+                    length = (length << 8) | header[2 + i];
+                }
+                header_size = 10;
+            }
+            if(length > max_frame_size) {
+                return fail("parse_frame", "frame_too_large");
+            }
+            const size_t frame_size = header_size + length;
+            if(available < frame_size) {
+                pending_frame_size_ = frame_size;
+                break;
+            }
+            char* payload = rx_.data() + read_pos_ + header_size;
+            read_pos_ += frame_size;
+            on_frame(fin, opcode, std::string_view(payload, length));
+        }
+        if(read_pos_ == write_pos_) {
+            read_pos_ = write_pos_ = 0;
+        }
+    }
+
+    void on_frame(bool fin, Opcode opcode, std::string_view payload) {
+        switch(opcode) {
+        case Opcode::Text:
+        case Opcode::Binary:
+            if(fin) {
+                owner_.on_native_message(payload);
+            } else {
+                fragment_.assign(payload);
+            }
+            break;
+        case Opcode::Continuation:
+            fragment_.append(payload);
+            if(fin) {
+                owner_.on_native_message(std::string_view(fragment_));
+                fragment_.clear();
+            }
+            break;
+        case Opcode::Ping:
+            enqueue(encode(Opcode::Pong, payload));
+            break;
+        case Opcode::Pong:
+            break;
+        case Opcode::Close:
+            // Echo the status code and close the socket once the echo is written
+            LoggerSingleton::get().infra().warning("action=native_ws_close_received uri=", uri_);
+            closing_ = true;
+            open_.store(false, std::memory_order_release);
+            enqueue(encode(Opcode::Close, payload.substr(0, std::min<size_t>(payload.size(), 2))));
+            break;
+        default:
+            fail("parse_frame", "unknown_opcode");
+            break;
+        }
+    }
+
+    // Builds a client frame; the masking key is filled in on the io thread by enqueue()
+    static std::string encode(Opcode opcode, std::string_view payload) {
+        std::string frame;
+        const size_t len = payload.size();
+        frame.reserve(14 + len);
+        frame.push_back(static_cast<char>(0x80 | static_cast<uint8_t>(opcode)));
+        if(len < 126) {
+            frame.push_back(static_cast<char>(0x80 | len));
+        } else if(len <= 0xFFFF) {
+            frame.push_back(static_cast<char>(0x80 | 126));
+            frame.push_back(static_cast<char>((len >> 8) & 0xFF));
+            frame.push_back(static_cast<char>(len & 0xFF));
+        } else {
+            frame.push_back(static_cast<char>(0x80 | 127));
+            for(int shift = 56; shift >= 0; shift -= 8) {
+                frame.push_back(static_cast<char>((static_cast<uint64_t>(len) >> shift) & 0xFF));
+            }
+        }
+        frame.append(4, '\0');
+        frame.append(payload);
+        return frame;
+    }
+
+    void enqueue(std::string frame) {
+        if(finished_) {
+            return;
+        }
+        const uint8_t len_byte = static_cast<uint8_t>(frame[1]) & 0x7F;
+        const size_t key_offset = len_byte == 126 ? 4 : (len_byte == 127 ? 10 : 2);
+        const uint32_t random = static_cast<uint32_t>(rng_());
+        std::array<uint8_t, 4> key;
+        std::memcpy(key.data(), &random, 4);
+        std::memcpy(frame.data() + key_offset, key.data(), 4);
+        applyMask(frame.data() + key_offset + 4, frame.size() - key_offset - 4, key);
+        write_queue_.push_back(std::move(frame));
+        if(write_queue_.size() == 1) {
+            write_next();
+        }
+    }
+
+    void write_next() {
+        async_write_raw(boost::asio::buffer(write_queue_.front()), [this](const boost::system::error_code& ec, size_t) {
+            if(ec) {
+                return fail("write", ec);
+            }
+            write_queue_.pop_front();
+            if(!write_queue_.empty()) {
+                write_next();
+            } else if(closing_) {
+                finish();
+            }
+        });
+    }
+
+    template<typename Buffer, typename Handler>
+    void async_write_raw(const Buffer& buffer, Handler handler) {
+        endpoint_.tls ? boost::asio::async_write(stream_, buffer, std::move(handler))
+                      : boost::asio::async_write(stream_.next_layer(), buffer, std::move(handler));
+    }
+
+    void fail(std::string_view stage, const boost::system::error_code& ec) { fail(stage, ec.message()); }
+
+    void fail(std::string_view stage, std::string_view reason) {
+        if(finished_) {
+            return;
+        }
+        LoggerSingleton::get().infra().error(
+            "action=native_ws result=fail stage=", stage, " reason=", reason, " uri=", uri_);
+        finish();
+    }
+
+    // Closes the socket so that every outstanding operation completes and the io_service runs out of work
+    void finish() {
+        if(finished_) {
+            return;
+        }
+        finished_ = true;
+        open_.store(false, std::memory_order_release);
+        handshake_timer_.cancel();
+        resolver_.cancel();
+        boost::system::error_code ignored;
+        stream_.lowest_layer().close(ignored);
+        owner_.on_native_close();
+    }
+
+    Owner& owner_;
+    std::string uri_;
+    std::string proxy_uri_;
+    Endpoint endpoint_;
+    Endpoint proxy_;
+    boost::asio::io_context io_;
+    boost::asio::ssl::context ssl_ctx_;
+    tcp::resolver resolver_;
+    boost::asio::steady_timer handshake_timer_;
+    ssl_stream stream_;
+    std::mt19937 rng_;
+    std::string ws_key_;
+    std::string handshake_request_;
+
+    std::vector<char> rx_;
+    size_t read_pos_ = 0;
+    size_t write_pos_ = 0;
+    size_t pending_frame_size_ = 0;
+    std::string fragment_;
+    std::deque<std::string> write_queue_;
+
+    std::atomic<bool> open_{false};
+    bool closing_ = false;
+    bool finished_ = false;
+};
+
+} // namespace native_ws
@@ -5,6 +5,7 @@
 #include "../utils/logger.hpp"
 #include "../utils/requests.hpp"
 #include "book.hpp"
+#include "symbolrouter.hpp"
 #include "websocket.hpp"
 #include <algorithm>
 #include <array>
@@ -19,20 +20,23 @@
 
 class OKXWebSocketClient : public WebSocketClient<OKXWebSocketClient> {
 public:
-    using MarketDataUpdateCallback = std::function<void()>;
+    static constexpr latency::Venue LATENCY_VENUE = latency::Venue::Okx;
+
+    using MarketDataUpdateCallback = std::function<void(mapping::InstrumentId instrument)>;
     using WebSocketStatusUpdateCallback = std::function<void(bool)>;
     using PoolAllocator = rapidjson::MemoryPoolAllocator<rapidjson::CrtAllocator>;
 
+    // All instruments share the connection, updates are reported with their InstrumentRegistry id
     explicit OKXWebSocketClient(const std::string& uri,
                                 const std::string& proxy_uri,
-                                const std::string instrument,
+                                const std::vector<std::string>& instruments,
                                 const uint32_t retry_limit,
                                 const std::string apiKey,
                                 const std::string apiSecret,
                                 const std::string apiPassphrase)
         : WebSocketClient(retry_limit, uri, proxy_uri)
-        , m_instrument(instrument)
-        , m_okxBook(instrument)
+        , m_router(instruments, exchangeSymbols(instruments))
+        , m_timestampIds(instruments.size(), 0)
         , apiKey(apiKey)
         , apiSecret(apiSecret)
         , apiPassphrase(apiPassphrase) {
@@ -49,8 +53,7 @@ public:
 
     void onClose(websocketpp::connection_hdl hdl, std::string message) {
         LoggerSingleton::get().infra().error("okx md channel closed");
-        m_bookWarmedUp = false;
-        cnt = 0;
+        m_router.resetReady();
         if(message == "disconnect") {
             if(webSocketStatusUpdateCallback) {
                 webSocketStatusUpdateCallback(false);
@@ -65,12 +68,10 @@ public:
     }
 
     void send_heartbeat() {
-        try {
-            LOG_INFRA_DEBUG("okx md channel heartbeat: ping");
-            ws_client->send(current_hdl, "ping", websocketpp::frame::opcode::text);
-        } catch(const websocketpp::exception& e) {
-            LoggerSingleton::get().infra().error("action=heartbeat exchage=okx stream=md result=fail reason=",
-                                                 e.what());
+        LOG_INFRA_DEBUG("okx md channel heartbeat: ping");
+        if(!send_text("ping")) {
+            LoggerSingleton::get().infra().error(
+                "action=heartbeat exchage=okx stream=md result=fail reason=send_failed");
             if(webSocketStatusUpdateCallback) {
                 webSocketStatusUpdateCallback(false);
             }
@@ -106,12 +107,24 @@ public:
         LoggerSingleton::get().plain().ws_request("login payload: ", login_payload);
     }
 
-    inline void parseMessage(std::string& marketData) {
-        document.Parse<rapidjson::kParseNumbersAsStringsFlag | rapidjson::kParseFullPrecisionFlag>(marketData.c_str());
-
+    inline size_t parseMessage(std::string_view marketData) {
+        document.Parse<rapidjson::kParseNumbersAsStringsFlag | rapidjson::kParseFullPrecisionFlag>(marketData.data(),
+                                                                                                   marketData.size());
+        if(document.HasParseError() || !document.IsObject() || !document.HasMember("data") ||
+           !document["data"].IsArray() || document["data"].Empty()) {
+            return SymbolRouter::NOT_FOUND;
+        }
+        const size_t symbol = routeSymbol();
+        if(symbol == SymbolRouter::NOT_FOUND) {
+            return symbol;
+        }
         const auto& data = document["data"][0];
-        m_okxBook.bidSide.size = 0;
-        m_okxBook.askSide.size = 0;
+        if(!data.HasMember("asks") || !data.HasMember("bids")) {
+            return SymbolRouter::NOT_FOUND;
+        }
+        Book& okxBook = m_router.book(symbol);
+        okxBook.bidSide.size = 0;
+        okxBook.askSide.size = 0;
 
         // Process asks
         const auto& asks = data["asks"];
@@ -119,7 +132,7 @@ public:
             // if (level.IsArray() && level.Size() >= 2) {
             double price = fastStrtod(level[0].GetString());
             double qty = fastStrtod(level[1].GetString());
-            m_okxBook.askSide.insert(price, qty); // Using PriceLevelArray's insert method
+            okxBook.askSide.insert(price, qty); // Using PriceLevelArray's insert method
             //}
         }
 
@@ -129,63 +142,83 @@ public:
             // if (level.IsArray() && level.Size() >= 2) {
             double price = fastStrtod(level[0].GetString());
             double qty = fastStrtod(level[1].GetString());
-            m_okxBook.bidSide.insert(price, qty); // Using PriceLevelArray's insert method
+            okxBook.bidSide.insert(price, qty); // Using PriceLevelArray's insert method
             //}
         }
-        // static_cast<Derived*>(this)->onOkxMarketDataUpdate(m_okxBook);
+        return symbol;
     }
 
-    inline void parseBookMessage(std::string& marketData) {
-        document.Parse<rapidjson::kParseFullPrecisionFlag>(marketData.c_str());
-        uint64_t timestamp = std::stoull(document["data"][0]["ts"].GetString());
-        m_okxBook.m_timestamp = timestamp * milliToNano;
-        const auto& asks = document["data"][0]["asks"];
+    // Returns the id of the symbol the frame updated, NOT_FOUND for event frames (subscribe acks, errors)
+    inline size_t parseBookMessage(std::string_view marketData) {
+        document.Parse<rapidjson::kParseFullPrecisionFlag>(marketData.data(), marketData.size());
+        if(document.HasParseError() || !document.IsObject() || document.HasMember("event") ||
+           !document.HasMember("data") || !document["data"].IsArray() || document["data"].Empty()) {
+            return SymbolRouter::NOT_FOUND;
+        }
+        const size_t symbol = routeSymbol();
+        if(symbol == SymbolRouter::NOT_FOUND) {
+            return symbol;
+        }
+        const auto& data = document["data"][0];
+        if(!data.HasMember("ts") || !data.HasMember("asks") || !data.HasMember("bids")) {
+            return SymbolRouter::NOT_FOUND;
+        }
+        Book& okxBook = m_router.book(symbol);
+        m_oldBestBid = okxBook.getBestBid();
+        m_oldBestAsk = okxBook.getBestAsk();
+        uint64_t timestamp = std::stoull(data["ts"].GetString());
+        okxBook.m_timestamp = timestamp * milliToNano;
+        m_updateId = data.HasMember("seqId") && data["seqId"].IsUint64() ? data["seqId"].GetUint64()
+                                                                         : timestampUpdateId(symbol, timestamp);
+        // Snapshot channels (bbo-tbt, books5): the levels replace the previous depth, best level first
+        okxBook.askSide.size = 0;
+        okxBook.bidSide.size = 0;
+        const auto& asks = data["asks"];
         for(const auto& level : asks.GetArray()) {
             double price = fastStrtod(level[0].GetString());
             double qty = fastStrtod(level[1].GetString());
-            m_okxBook.setBestAsk(price);
+            okxBook.askSide.insert(price, qty);
+        }
+        if(okxBook.askSide.size > 0) {
+            okxBook.setBestAsk(okxBook.askSide.getBestPrice());
         }
 
-        const auto& bids = document["data"][0]["bids"];
+        const auto& bids = data["bids"];
         for(const auto& level : bids.GetArray()) {
             double price = fastStrtod(level[0].GetString());
             double qty = fastStrtod(level[1].GetString());
-            m_okxBook.setBestBid(price);
+            okxBook.bidSide.insert(price, qty);
         }
-        // static_cast<Derived*>(this)->onOkxMarketDataUpdate(m_okxBook);
+        if(okxBook.bidSide.size > 0) {
+            okxBook.setBestBid(okxBook.bidSide.getBestPrice());
+        }
+        return symbol;
     }
 
-    void onMessage(websocketpp::connection_hdl hdl, client_tls::message_ptr msg) {
-        // Parse the message payload into MarketData
-        cnt += 1;
-        std::string message = msg->get_payload();
+    // The payload view is only valid for the duration of the call
+    void onMessage(std::string_view message) {
         LOG_INFRA_DEBUG("okx md payload: ", message);
-        if(cnt == 1) {
-            return;
-        }
         if(message == "pong") {
             LOG_INFRA_DEBUG("okx md channel heartbeat: pong");
             LOG_INFRA_DEBUG("action=heartbeat exchange=okx stream=md result=pass");
             return;
         }
-        double old_best_bid = m_okxBook.getBestBid();
-        double old_best_ask = m_okxBook.getBestAsk();
-        parseBookMessage(message);
-        this->m_bookWarmedUp = true;
-        if(old_best_bid == m_okxBook.getBestBid() && old_best_ask == m_okxBook.getBestAsk()) {
+        // One subscribe ack per symbol arrives on a multiplexed connection, they carry "event"
+        const size_t symbol = parseBookMessage(message);
+        if(symbol == SymbolRouter::NOT_FOUND) {
+            return;
+        }
+        m_router.setReady(symbol);
+        const mapping::InstrumentId instrument = m_router.instrument(symbol);
+        if(!accept_update(instrument, m_updateId, m_router.book(symbol), m_oldBestBid, m_oldBestAsk)) {
             return;
         }
         if(marketDataUpdateCallback) {
-            marketDataUpdateCallback();
+            marketDataUpdateCallback(instrument);
         }
-        // if (cnt%100 == 0) {
-        //     ws_client->close(current_hdl, websocketpp::close::status::normal, "Testing closure");
-        //     LoggerSingleton::get().infra().warning("closed okx md channel for testing purposes");
-        // }
     }
 
     void onOpen(websocketpp::connection_hdl hdl) {
-        websocketpp::lib::error_code ec;
         LoggerSingleton::get().infra().info("okx websocket connection opened");
         flag = true;
         if(!flag) {
@@ -209,39 +242,81 @@ public:
                                         "\"timestamp\": \"" +
                                         timestamp + "\"}]}";
             LoggerSingleton::get().plain().ws_request("login payload: ", login_payload);
-            this->ws_client->send(hdl, std::move(login_payload), websocketpp::frame::opcode::text);
+            send_text(login_payload);
         }
-        mapping::InstrumentInfo exchangeInst = mapping::getInstrumentInfo(m_instrument);
-        std::string OKX_SUBSCRIBE_MESSAGE = requests::getOkxTopOfBookSubscribeMessage(exchangeInst.instrument);
-        this->ws_client->send(hdl, OKX_SUBSCRIBE_MESSAGE, websocketpp::frame::opcode::text, ec);
-        if(ec) {
-            LoggerSingleton::get().infra().error("error sending okx subscribe message: ", ec.message());
+        std::string OKX_SUBSCRIBE_MESSAGE = requests::getOkxTopOfBookSubscribeMessage(m_router.exchangeSymbols());
+        if(!send_text(OKX_SUBSCRIBE_MESSAGE)) {
+            LoggerSingleton::get().infra().error("error sending okx subscribe message");
         }
     }
 
+    // Every subscribed symbol has received a book update since the connection opened
     [[nodiscard]]
     bool isBookReady() const noexcept {
-        return this->m_bookWarmedUp;
+        return m_router.allReady();
+    }
+
+    [[nodiscard]]
+    bool isBookReady(mapping::InstrumentId instrument) const noexcept {
+        const size_t slot = m_router.slot(instrument);
+        return slot != SymbolRouter::NOT_FOUND && m_router.isReady(slot);
     }
 
-    const Book& getBook() const { return m_okxBook; }
+    // The instrument must be one of instruments()
+    const Book& getBook(mapping::InstrumentId instrument) const { return m_router.book(m_router.slot(instrument)); }
+
+    // Registry ids of the subscribed instruments, in subscription order
+    [[nodiscard]] const std::vector<mapping::InstrumentId>& instruments() const { return m_router.instruments(); }
 
     static const uint32_t milliToNano = 1000000;
 
 protected:
-    Book m_okxBook;
+    SymbolRouter m_router;
 
 private:
     MarketDataUpdateCallback marketDataUpdateCallback;
     WebSocketStatusUpdateCallback webSocketStatusUpdateCallback;
     uint64_t m_timestamp;
+    uint64_t m_updateId = 0;
+    std::vector<uint64_t> m_timestampIds; // by symbol slot, last id timestampUpdateId handed out
+    double m_oldBestBid = 0.0;
+    double m_oldBestAsk = 0.0;
     rapidjson::Document document;
     PoolAllocator allocator;
-    int cnt = 0;
     bool flag = false;
-    bool m_bookWarmedUp = false;
-    const std::string m_instrument;
     const std::string apiKey;
     const std::string apiSecret;
     const std::string apiPassphrase;
+
+    // Update id of a frame without seqId: its ms timestamp, then its place among the symbol's updates
+    // of that millisecond, which every connection receives in the same order. Distinct updates of one
+    // millisecond keep distinct ids, a copy from another connection gets the same one.
+    uint64_t timestampUpdateId(size_t symbol, uint64_t timestampMs) {
+        constexpr unsigned ORDER_BITS = 10;
+        const uint64_t first = timestampMs << ORDER_BITS;
+        uint64_t& last = m_timestampIds[symbol];
+        if(last < first) {
+            last = first;
+        } else if(last - first < (1u << ORDER_BITS) - 1) {
+            ++last;
+        }
+        return last;
+    }
+
+    // Frames name their instrument in arg.instId
+    size_t routeSymbol() const {
+        if(!document.HasMember("arg") || !document["arg"].HasMember("instId")) {
+            return m_router.find("");
+        }
+        const auto& instId = document["arg"]["instId"];
+        return m_router.find(std::string_view(instId.GetString(), instId.GetStringLength()));
+    }
+
+    static std::vector<std::string> exchangeSymbols(const std::vector<std::string>& instruments) {
+        std::vector<std::string> symbols;
+        for(const auto& instrument : instruments) {
+            symbols.push_back(mapping::getInstrumentInfo(instrument).instrument);
+        }
+        return symbols;
+    }
 };
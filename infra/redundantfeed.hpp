@@ -0,0 +1,261 @@
+#pragma once
+#include "../utils/logger.hpp"
+#include "../utils/pinthreads.hpp"
+#include "../utils/tickstore.hpp"
+#include "feedarbiter.hpp"
+#include "tradeflow.hpp"
+#include "websocket.hpp"
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <thread>
+#include <vector>
+
+// Runs N hot-standby connections of the same market-data feed, each on its own thread.
+// The clients publish through a FeedArbiter per instrument; with more than one connection it
+// arbitrates, so a single dropped or slow TCP path neither stalls the book nor reaches the
+// strategy as a disconnect. Every connection carries the same list of multiplexed instruments.
+// Instruments are addressed by their InstrumentRegistry id throughout.
+template<typename Client>
+class RedundantFeed {
+public:
+    using Factory = std::function<std::unique_ptr<Client>(size_t index)>;
+    using MarketDataUpdateCallback = typename Client::MarketDataUpdateCallback;
+    using WebSocketStatusUpdateCallback = typename Client::WebSocketStatusUpdateCallback;
+
+    RedundantFeed(size_t connections, const Factory& factory) {
+        if(connections == 0 || connections > FeedArbiter::MAX_CONNECTIONS) {
+            throw std::invalid_argument("md connections must be between 1 and " +
+                                        std::to_string(FeedArbiter::MAX_CONNECTIONS));
+        }
+        for(size_t i = 0; i < connections; ++i) {
+            m_clients.push_back(factory(i));
+        }
+        for(const auto& client : m_clients) {
+            if(client->instruments() != instruments()) {
+                throw std::invalid_argument("md connections of one feed must carry the same instruments");
+            }
+        }
+        const auto& front = *m_clients.front();
+        for(const mapping::InstrumentId instrument : instruments()) {
+            auto& arbiter = slot(m_arbiters, instrument);
+            arbiter = std::make_unique<FeedArbiter>(front.getBook(instrument).getInstrumentName(), connections);
+            for(size_t i = 0; i < connections; ++i) {
+                m_clients[i]->setFeedArbiter(instrument, arbiter.get(), i);
+            }
+        }
+    }
+
+    RedundantFeed(const RedundantFeed&) = delete;
+    RedundantFeed& operator=(const RedundantFeed&) = delete;
+
+    void start() {
+        if(m_recording) {
+            m_recording->start();
+        }
+        m_threads.reserve(m_clients.size());
+        for(auto& client : m_clients) {
+            m_threads.emplace_back([&client] { client->start(); });
+        }
+    }
+
+    void stop() {
+        for(auto& client : m_clients) {
+            client->stop();
+        }
+        if(m_clients.size() == 1) {
+            return; // nothing was arbitrated
+        }
+        for(const auto& arbiter : m_arbiters) {
+            if(!arbiter) {
+                continue;
+            }
+            const auto stats = arbiter->getStats();
+            std::string wins;
+            for(size_t i = 0; i < m_clients.size(); ++i) {
+                wins += " wins_" + std::to_string(i) + "=" + std::to_string(stats.wins[i]);
+            }
+            LoggerSingleton::get().infra().info("action=feed_arbiter_stats instrument=",
+                                                arbiter->getInstrumentName(),
+                                                " published=",
+                                                stats.published,
+                                                " duplicates=",
+                                                stats.duplicates,
+                                                wins);
+        }
+    }
+
+    // The tick store is closed here, once no connection can queue another tick
+    void join() {
+        for(auto& thread : m_threads) {
+            if(thread.joinable()) {
+                thread.join();
+            }
+        }
+        if(!m_recording) {
+            return;
+        }
+        m_recording->stop();
+        for(const auto& recorder : m_recorders) {
+            if(!recorder) {
+                continue; // not carried by this feed
+            }
+            recorder->flush();
+            LoggerSingleton::get().infra().info(
+                "action=tick_store_stats instrument=", recorder->instrument(), " ticks=", recorder->appended());
+        }
+        LoggerSingleton::get().infra().info("action=tick_recording_stats dropped=",
+                                            m_recording->dropped(),
+                                            " failed=",
+                                            m_recording->failed());
+        m_recording.reset();
+    }
+
+    // Each connection gets its own core, busy-polling readers must not share one
+    void pinThread(size_t connection, int core) {
+        if(connection < m_threads.size()) {
+            setThreadAffinity(m_threads[connection], core);
+        }
+    }
+
+    void setMarketDataUpdateCallback(const MarketDataUpdateCallback& callback) {
+        for(auto& client : m_clients) {
+            client->setMarketDataUpdateCallback(callback);
+        }
+    }
+
+    // Every connection reports its own trades, a trade seen on several connections is reported by each
+    template<typename Callback>
+    void setTradeUpdateCallback(const Callback& callback) {
+        if constexpr(requires(Client& client) { client.setTradeUpdateCallback(callback); }) {
+            for(auto& client : m_clients) {
+                client->setTradeUpdateCallback(callback);
+            }
+        }
+    }
+
+    // A connection dropping is only reported once no other connection of the feed is up
+    void setWebSocketStatusUpdateCallback(const WebSocketStatusUpdateCallback& callback) {
+        for(auto& client : m_clients) {
+            client->setWebSocketStatusUpdateCallback([this, callback](bool reachedRetryLimit) {
+                if(!anyConnected() && callback) {
+                    callback(reachedRetryLimit);
+                }
+            });
+        }
+    }
+
+    void setBusyPoll(const BusyPollConfig& config) {
+        for(auto& client : m_clients) {
+            client->setBusyPoll(config);
+        }
+    }
+
+    void setNativeFraming(bool enabled) {
+        for(auto& client : m_clients) {
+            client->setNativeFraming(enabled);
+        }
+    }
+
+    // Must be called before start(); records what the feed publishes of every symbol, once however
+    // many connections carry it. The connections only queue the ticks, see TickRecordingThread.
+    void recordTicks(const std::filesystem::path& root,
+                     uint32_t blockTicks,
+                     uint64_t maxBlockAgeNs,
+                     size_t queueCapacity = tick_store::TickRecordingThread::DEFAULT_CAPACITY) {
+        m_recording = std::make_unique<tick_store::TickRecordingThread>(m_clients.size(), queueCapacity);
+        const auto& front = *m_clients.front();
+        for(const mapping::InstrumentId instrument : instruments()) {
+            auto& recorder = slot(m_recorders, instrument);
+            recorder = std::make_unique<tick_store::TickStoreWriter>(
+                root, front.getBook(instrument).getInstrumentName(), blockTicks, maxBlockAgeNs);
+            for(size_t i = 0; i < m_clients.size(); ++i) {
+                m_clients[i]->setTickRecorder(instrument, recorder.get(), &m_recording->producer(i));
+            }
+        }
+    }
+
+    void setReconnectPolicy(const ReconnectPolicy& policy) {
+        for(auto& client : m_clients) {
+            client->setReconnectPolicy(policy);
+        }
+    }
+
+    void send_heartbeat() {
+        if constexpr(requires(Client& client) { client.send_heartbeat(); }) {
+            for(auto& client : m_clients) {
+                client->send_heartbeat();
+            }
+        }
+    }
+
+    // Every instrument has a warm book on at least one connection
+    [[nodiscard]] bool isBookReady() const noexcept {
+        for(const mapping::InstrumentId instrument : instruments()) {
+            if(!isBookReady(instrument)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    [[nodiscard]] bool isBookReady(mapping::InstrumentId instrument) const noexcept {
+        for(const auto& client : m_clients) {
+            if(client->isBookReady(instrument)) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // The arbiter's, copied under its lock, so any thread may read it
+    [[nodiscard]] TopOfBook getTopOfBook(mapping::InstrumentId instrument) const {
+        return m_arbiters[instrument]->getTopOfBook();
+    }
+
+    // Trade flow of the first connected connection, the arbiter only carries the touch. Null for
+    // clients without a trade stream.
+    [[nodiscard]] const TradeFlow* tradeFlow(mapping::InstrumentId instrument) const {
+        if constexpr(requires(const Client& client) { client.tradeFlow(instrument); }) {
+            for(const auto& client : m_clients) {
+                if(client->isConnected()) {
+                    return &client->tradeFlow(instrument);
+                }
+            }
+            return &m_clients.front()->tradeFlow(instrument);
+        } else {
+            return nullptr;
+        }
+    }
+
+    // Registry ids of the instruments the feed carries, in subscription order
+    [[nodiscard]] const std::vector<mapping::InstrumentId>& instruments() const {
+        return m_clients.front()->instruments();
+    }
+
+    [[nodiscard]] size_t connections() const { return m_clients.size(); }
+
+private:
+    template<typename T>
+    static std::unique_ptr<T>& slot(std::vector<std::unique_ptr<T>>& entries, mapping::InstrumentId instrument) {
+        if(entries.size() <= instrument) {
+            entries.resize(instrument + 1);
+        }
+        return entries[instrument];
+    }
+
+    bool anyConnected() const {
+        for(const auto& client : m_clients) {
+            if(client->isConnected()) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    std::vector<std::unique_ptr<Client>> m_clients;
+    std::vector<std::unique_ptr<FeedArbiter>> m_arbiters; // by InstrumentRegistry id, null for other instruments
+    std::vector<std::unique_ptr<tick_store::TickStoreWriter>> m_recorders; // by InstrumentRegistry id, likewise
+    std::unique_ptr<tick_store::TickRecordingThread> m_recording;
+    std::vector<std::thread> m_threads;
+};
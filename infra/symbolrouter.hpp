@@ -0,0 +1,111 @@
+#pragma once
+#include "../utils/instrumentregistry.hpp"
+#include "book.hpp"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+// Instruments multiplexed on one md connection. Every subscribed instrument gets a dense slot, its
+// position in the subscription list, and a Book preallocated in a flat array. A frame is routed with
+// a single lookup of the exchange symbol it carries; everything after that is indexed by slot.
+// Slots are private to the connection: whatever leaves the client (callbacks, book and readiness
+// queries) is keyed by the InstrumentRegistry id, which means the same instrument on every connection.
+class SymbolRouter {
+public:
+    static constexpr size_t NOT_FOUND = std::numeric_limits<size_t>::max();
+
+    // exchangeSymbols[i] is the symbol the exchange puts in frames of instruments[i]
+    SymbolRouter(const std::vector<std::string>& instruments, const std::vector<std::string>& exchangeSymbols) {
+        if(instruments.empty() || instruments.size() != exchangeSymbols.size()) {
+            throw std::invalid_argument("symbol router needs one exchange symbol per instrument");
+        }
+        const auto& registry = mapping::InstrumentRegistry::instance();
+        m_books.reserve(instruments.size());
+        m_symbols.reserve(instruments.size());
+        m_instruments.reserve(instruments.size());
+        for(size_t slot = 0; slot < instruments.size(); ++slot) {
+            const mapping::InstrumentId instrument = registry.id(instruments[slot]);
+            if(instrument == mapping::InstrumentRegistry::INVALID) {
+                throw std::invalid_argument("unknown instrument: " + instruments[slot]);
+            }
+            if(!m_ids.emplace(exchangeSymbols[slot], slot).second) {
+                throw std::invalid_argument("instrument subscribed twice on one connection: " + instruments[slot]);
+            }
+            if(m_slots.size() <= instrument) {
+                m_slots.resize(instrument + 1, NOT_FOUND);
+            }
+            m_slots[instrument] = slot;
+            m_instruments.push_back(instrument);
+            m_books.emplace_back(instruments[slot]);
+            m_symbols.push_back(exchangeSymbols[slot]);
+        }
+        m_ready = std::make_unique<std::atomic<bool>[]>(instruments.size());
+        resetReady();
+    }
+
+    // Slot of the instrument a frame belongs to. Frames without a symbol can only be routed on
+    // single-instrument connections.
+    [[nodiscard]] size_t find(std::string_view exchangeSymbol) const {
+        if(exchangeSymbol.empty()) {
+            return m_books.size() == 1 ? 0 : NOT_FOUND;
+        }
+        const auto it = m_ids.find(exchangeSymbol);
+        return it == m_ids.end() ? NOT_FOUND : it->second;
+    }
+
+    // Slot of a registry id, NOT_FOUND when the connection does not carry the instrument
+    [[nodiscard]] size_t slot(mapping::InstrumentId instrument) const {
+        return instrument < m_slots.size() ? m_slots[instrument] : NOT_FOUND;
+    }
+
+    [[nodiscard]] mapping::InstrumentId instrument(size_t slot) const { return m_instruments[slot]; }
+    [[nodiscard]] const std::vector<mapping::InstrumentId>& instruments() const { return m_instruments; }
+
+    [[nodiscard]] size_t size() const { return m_books.size(); }
+
+    Book& book(size_t slot) { return m_books[slot]; }
+    const Book& book(size_t slot) const { return m_books[slot]; }
+
+    [[nodiscard]] const std::string& exchangeSymbol(size_t slot) const { return m_symbols[slot]; }
+    [[nodiscard]] const std::vector<std::string>& exchangeSymbols() const { return m_symbols; }
+
+    // Written by the connection thread, read by the strategy threads asking whether a book is warm
+    void setReady(size_t slot) { m_ready[slot].store(true, std::memory_order_release); }
+
+    void resetReady() {
+        for(size_t slot = 0; slot < size(); ++slot) {
+            m_ready[slot].store(false, std::memory_order_release);
+        }
+    }
+
+    [[nodiscard]] bool isReady(size_t slot) const { return m_ready[slot].load(std::memory_order_acquire); }
+
+    [[nodiscard]] bool allReady() const {
+        for(size_t slot = 0; slot < size(); ++slot) {
+            if(!isReady(slot)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+private:
+    struct SymbolHash {
+        using is_transparent = void;
+        size_t operator()(std::string_view symbol) const { return std::hash<std::string_view>{}(symbol); }
+    };
+
+    std::vector<Book> m_books;
+    std::vector<std::string> m_symbols;
+    std::vector<mapping::InstrumentId> m_instruments; // by slot
+    std::vector<size_t> m_slots;                      // by registry id, NOT_FOUND for other instruments
+    std::unique_ptr<std::atomic<bool>[]> m_ready;     // by slot
+    std::unordered_map<std::string, size_t, SymbolHash, std::equal_to<>> m_ids;
+};
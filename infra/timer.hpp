@@ -1,6 +1,9 @@
+#pragma once
+#include "timerwheel.hpp"
 #include <any>
 #include <atomic>
 #include <chrono>
+#include <condition_variable>
 #include <functional>
 #include <memory>
 #include <mutex>
@@ -32,6 +35,10 @@ private:
     std::tuple<Args...> m_args;
 };
 
+// Thread driving a TimerWheel. The callbacks added with addCallback() run every start() interval,
+// measured on the engine clock so the period does not drift by the callbacks' run time; one-shot
+// and periodic timers can be added with schedule*() from any thread, including from callbacks.
+// The thread sleeps until the wheel's next deadline and stop() wakes it right away.
 class Timer {
 public:
     Timer()
@@ -55,24 +62,55 @@ public:
         callbacks.clear();
     }
 
+    TimerWheel::TimerId scheduleAfter(uint64_t delayNs, TimerWheel::Callback callback) {
+        std::lock_guard<std::recursive_mutex> lock(wheelMutex);
+        const auto id = wheel.scheduleAfter(delayNs, std::move(callback));
+        wakeup.notify_one();
+        return id;
+    }
+
+    TimerWheel::TimerId scheduleEvery(uint64_t periodNs, TimerWheel::Callback callback) {
+        std::lock_guard<std::recursive_mutex> lock(wheelMutex);
+        const auto id = wheel.scheduleEvery(periodNs, std::move(callback));
+        wakeup.notify_one();
+        return id;
+    }
+
+    bool cancel(TimerWheel::TimerId id) {
+        std::lock_guard<std::recursive_mutex> lock(wheelMutex);
+        return wheel.cancel(id);
+    }
+
     void start(uint64_t milliseconds) {
         if(running) {
             stop();
         }
         running = true;
+        periodicTimer = scheduleEvery(milliseconds * 1'000'000, [this] { triggerCallbacks(); });
 
-        timerThread = std::thread([this, milliseconds]() {
+        timerThread = std::thread([this]() {
+            std::unique_lock<std::recursive_mutex> lock(wheelMutex);
             while(running) {
-                std::this_thread::sleep_for(std::chrono::milliseconds(milliseconds));
-                if(running) {
-                    triggerCallbacks();
+                wheel.advance(TscClock::instance().now_ns());
+                const uint64_t deadline = wheel.nextDeadlineNs();
+                if(deadline == TimerWheel::NO_DEADLINE) {
+                    wakeup.wait(lock);
+                } else {
+                    const std::chrono::system_clock::time_point until{std::chrono::duration_cast<
+                        std::chrono::system_clock::duration>(std::chrono::nanoseconds(deadline))};
+                    wakeup.wait_until(lock, until);
                 }
             }
         });
     }
 
     void stop() {
-        running = false;
+        {
+            std::lock_guard<std::recursive_mutex> lock(wheelMutex);
+            running = false;
+            wheel.cancel(periodicTimer);
+            wakeup.notify_one();
+        }
         if(timerThread.joinable()) {
             timerThread.join();
         }
@@ -92,6 +130,10 @@ private:
 
     std::atomic<bool> running;
     std::thread timerThread;
+    std::recursive_mutex wheelMutex; // held while the wheel runs callbacks, which may reschedule
+    std::condition_variable_any wakeup;
+    TimerWheel wheel;
+    TimerWheel::TimerId periodicTimer = TimerWheel::INVALID_TIMER;
     std::mutex callbackMutex;
     std::vector<std::unique_ptr<CallbackInterface>> callbacks;
 };
@@ -0,0 +1,270 @@
+#pragma once
+#include "../utils/tscclock.hpp"
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <utility>
+#include <vector>
+
+// Hierarchical timing wheel for one-shot and periodic timers. Expiries are kept in ticks of the
+// engine clock (TscClock wall ns divided by the tick length); LEVELS wheels of SLOTS slots cover
+// SLOTS^LEVELS ticks and farther timers are parked on the top level until they come into range.
+// Insert and cancel unlink one node of an intrusive list, so both are O(1); advance() costs one
+// slot per elapsed tick plus a cascade every SLOTS ticks.
+//
+// The wheel is not thread safe. The strategy event loop drives its own wheel between events, and
+// Timer drives one from its thread for everything else.
+// @example
+//   TimerWheel wheel; // 1 ms ticks
+//   const auto id = wheel.scheduleAfter(5'000'000, [] { resend_cancel(); });
+//   wheel.scheduleEvery(200'000'000, [] { publish_gauges(); });
+//   wheel.cancel(id);
+//   wheel.advance(TscClock::instance().now_ns());
+class TimerWheel {
+public:
+    using TimerId = uint64_t;
+    using Callback = std::function<void()>;
+
+    static constexpr TimerId INVALID_TIMER = 0;
+    static constexpr uint64_t NO_DEADLINE = std::numeric_limits<uint64_t>::max();
+    static constexpr uint64_t DEFAULT_TICK_NS = 1'000'000;
+
+    explicit TimerWheel(uint64_t tickNs = DEFAULT_TICK_NS, uint64_t nowNs = TscClock::instance().now_ns())
+        : m_tickNs(tickNs == 0 ? DEFAULT_TICK_NS : tickNs)
+        , m_current(nowNs / m_tickNs) {
+        for(auto& level : m_slots) {
+            level.fill(NIL);
+        }
+    }
+
+    TimerWheel(const TimerWheel&) = delete;
+    TimerWheel& operator=(const TimerWheel&) = delete;
+
+    // Fires once at the first tick at or after deadlineNs, never in the tick advance() is running
+    TimerId scheduleAt(uint64_t deadlineNs, Callback callback) {
+        return insert(deadlineNs / m_tickNs + (deadlineNs % m_tickNs != 0), 0, std::move(callback));
+    }
+
+    TimerId scheduleAfter(uint64_t delayNs, Callback callback) {
+        return scheduleAt(TscClock::instance().now_ns() + delayNs, std::move(callback));
+    }
+
+    // Fires every periodNs, first after one period. Missed periods are skipped, not replayed.
+    TimerId scheduleEvery(uint64_t periodNs, Callback callback) {
+        const uint64_t period = std::max<uint64_t>(1, (periodNs + m_tickNs - 1) / m_tickNs);
+        const uint64_t first = (TscClock::instance().now_ns() + periodNs + m_tickNs - 1) / m_tickNs;
+        return insert(first, period, std::move(callback));
+    }
+
+    // False when the timer already fired (one-shot) or was cancelled. Safe from inside callbacks.
+    bool cancel(TimerId id) {
+        const uint32_t index = indexOf(id);
+        if(index >= m_nodes.size() || m_nodes[index].generation != generationOf(id) || !m_nodes[index].armed) {
+            return false;
+        }
+        unlink(index);
+        release(index);
+        return true;
+    }
+
+    [[nodiscard]] bool isScheduled(TimerId id) const {
+        const uint32_t index = indexOf(id);
+        return index < m_nodes.size() && m_nodes[index].generation == generationOf(id) && m_nodes[index].armed;
+    }
+
+    // Runs every timer due up to nowNs, returns how many fired
+    size_t advance(uint64_t nowNs) {
+        const uint64_t target = nowNs / m_tickNs;
+        if(m_active == 0) {
+            m_current = std::max(m_current, target);
+            return 0;
+        }
+        size_t fired = 0;
+        while(m_current < target) {
+            ++m_current;
+            cascade();
+            fired += expire();
+            if(m_active == 0) {
+                m_current = target;
+            }
+        }
+        return fired;
+    }
+
+    // Wall ns by which advance() should run next, never later than the earliest expiry.
+    // NO_DEADLINE when nothing is scheduled.
+    [[nodiscard]] uint64_t nextDeadlineNs() const {
+        if(m_active == 0) {
+            return NO_DEADLINE;
+        }
+        // level 0 holds expiries m_current + 1 .. m_current + SLOTS - 1
+        const uint64_t occupied = std::rotr(m_occupied[0], static_cast<int>((m_current + 1) & SLOT_MASK));
+        if(occupied != 0) {
+            return (m_current + 1 + static_cast<uint64_t>(std::countr_zero(occupied))) * m_tickNs;
+        }
+        return ((m_current >> SLOT_BITS) + 1) * SLOTS * m_tickNs;
+    }
+
+    [[nodiscard]] size_t size() const { return m_active; }
+    [[nodiscard]] uint64_t tickNs() const { return m_tickNs; }
+    [[nodiscard]] uint64_t currentNs() const { return m_current * m_tickNs; }
+
+private:
+    static constexpr uint32_t SLOT_BITS = 6;
+    static constexpr uint64_t SLOTS = uint64_t{1} << SLOT_BITS;
+    static constexpr uint64_t SLOT_MASK = SLOTS - 1;
+    static constexpr size_t LEVELS = 4;
+    static constexpr uint64_t MAX_SPAN = uint64_t{1} << (SLOT_BITS * LEVELS);
+    static constexpr uint32_t NIL = std::numeric_limits<uint32_t>::max();
+
+    static_assert(SLOTS == 64, "occupancy bitmaps are one uint64_t per level");
+
+    struct Node {
+        uint64_t expiry = 0; // tick
+        uint64_t period = 0; // ticks, 0 for one-shot timers
+        Callback callback;
+        uint32_t prev = NIL;
+        uint32_t next = NIL;
+        uint32_t generation = 1;
+        uint16_t level = 0;
+        uint16_t slot = 0;
+        bool armed = false;
+    };
+
+    static uint32_t indexOf(TimerId id) { return static_cast<uint32_t>(id & 0xffffffffu); }
+    static uint32_t generationOf(TimerId id) { return static_cast<uint32_t>(id >> 32); }
+
+    TimerId insert(uint64_t expiry, uint64_t period, Callback callback) {
+        if(m_active == 0) {
+            // an idle wheel is not advanced, catch up so advance() does not walk the idle ticks
+            m_current = std::max(m_current, TscClock::instance().now_ns() / m_tickNs);
+        }
+        uint32_t index;
+        if(!m_free.empty()) {
+            index = m_free.back();
+            m_free.pop_back();
+        } else {
+            index = static_cast<uint32_t>(m_nodes.size());
+            m_nodes.emplace_back();
+        }
+        Node& node = m_nodes[index];
+        node.expiry = std::max(expiry, m_current + 1);
+        node.period = period;
+        node.callback = std::move(callback);
+        node.armed = true;
+        ++m_active;
+        link(index);
+        return (static_cast<TimerId>(node.generation) << 32) | index;
+    }
+
+    void release(uint32_t index) {
+        Node& node = m_nodes[index];
+        node.callback = nullptr;
+        node.armed = false;
+        ++node.generation;
+        --m_active;
+        m_free.push_back(index);
+    }
+
+    // Places a node by its distance from the current tick, the top level parks out-of-range timers
+    void link(uint32_t index) {
+        Node& node = m_nodes[index];
+        const uint64_t expiry = std::min(node.expiry, m_current + MAX_SPAN - 1);
+        const uint64_t delta = expiry - m_current;
+        size_t level = 0;
+        while(level + 1 < LEVELS && delta >= (uint64_t{1} << (SLOT_BITS * (level + 1)))) {
+            ++level;
+        }
+        const auto slot = static_cast<uint16_t>((expiry >> (SLOT_BITS * level)) & SLOT_MASK);
+        node.level = static_cast<uint16_t>(level);
+        node.slot = slot;
+        node.prev = NIL;
+        node.next = m_slots[level][slot];
+        if(node.next != NIL) {
+            m_nodes[node.next].prev = index;
+        }
+        m_slots[level][slot] = index;
+        m_occupied[level] |= uint64_t{1} << slot;
+    }
+
+    void unlink(uint32_t index) {
+        Node& node = m_nodes[index];
+        if(node.prev != NIL) {
+            m_nodes[node.prev].next = node.next;
+        } else {
+            m_slots[node.level][node.slot] = node.next;
+            if(node.next == NIL) {
+                m_occupied[node.level] &= ~(uint64_t{1} << node.slot);
+            }
+        }
+        if(node.next != NIL) {
+            m_nodes[node.next].prev = node.prev;
+        }
+        node.prev = NIL;
+        node.next = NIL;
+    }
+
+    // On every wrap of a level, the slot of the level above that just came into range is
+    // redistributed to lower levels. Higher levels go first so their timers can land in a slot
+    // that is cascaded right after.
+    void cascade() {
+        if((m_current & SLOT_MASK) != 0) {
+            return;
+        }
+        size_t top = 1;
+        while(top + 1 < LEVELS && ((m_current >> (SLOT_BITS * top)) & SLOT_MASK) == 0) {
+            ++top;
+        }
+        for(size_t level = top; level >= 1; --level) {
+            const auto slot = static_cast<size_t>((m_current >> (SLOT_BITS * level)) & SLOT_MASK);
+            uint32_t index = m_slots[level][slot];
+            m_slots[level][slot] = NIL;
+            m_occupied[level] &= ~(uint64_t{1} << slot);
+            while(index != NIL) {
+                const uint32_t next = m_nodes[index].next;
+                link(index);
+                index = next;
+            }
+        }
+    }
+
+    // Callbacks may schedule or cancel timers, so each node is detached before its callback runs
+    // and the callback is moved out of the node table, which can grow meanwhile
+    size_t expire() {
+        const auto slot = static_cast<size_t>(m_current & SLOT_MASK);
+        size_t fired = 0;
+        while(m_slots[0][slot] != NIL) {
+            const uint32_t index = m_slots[0][slot];
+            unlink(index);
+            Node& node = m_nodes[index];
+            Callback callback = std::move(node.callback);
+            if(node.period == 0) {
+                release(index);
+                callback();
+            } else {
+                const uint32_t generation = node.generation;
+                node.expiry = m_current + node.period;
+                link(index);
+                callback();
+                Node& rearmed = m_nodes[index];
+                if(rearmed.generation == generation && rearmed.armed) {
+                    rearmed.callback = std::move(callback);
+                }
+            }
+            ++fired;
+        }
+        return fired;
+    }
+
+    uint64_t m_tickNs;
+    uint64_t m_current; // last tick advance() processed
+    size_t m_active = 0;
+    std::vector<Node> m_nodes;
+    std::vector<uint32_t> m_free;
+    std::array<std::array<uint32_t, SLOTS>, LEVELS> m_slots{};
+    std::array<uint64_t, LEVELS> m_occupied{};
+};
@@ -0,0 +1,102 @@
+#pragma once
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <immintrin.h>
+
+// Decayed trade statistics of one instrument, fed with every aggregated trade of the feed. Each
+// statistic is an exponentially decayed sum over exchange time, so an update and a read are O(1):
+//   sum(t) = sum(t0) * 2^(-(t - t0) / halflife) + x
+// Buyer-initiated volume counts positive in the signed volume. Intensity is the decayed trade count
+// turned into trades per second, the rate a steady flow would need to reach it.
+//
+// Written by the connection thread and read from any thread: a small spin lock guards the sums,
+// like FeedArbiter does for its book.
+// @example
+//   TradeFlow flow(1'000'000'000); // 1s half-life
+//   flow.onTrade(ts, 67000.1, 0.25, true);
+//   const auto stats = flow.snapshot(now);
+//   if(stats.imbalance() > 0.8 && stats.intensity > 50) { ... } // one-sided burst
+class TradeFlow {
+public:
+    struct Snapshot {
+        double signedVolume = 0.0; // base quantity, buys minus sells
+        double volume = 0.0;
+        double intensity = 0.0; // trades per second
+        double lastPrice = 0.0;
+        uint64_t lastTradeNs = 0;
+        uint64_t trades = 0; // undecayed count since construction
+
+        // In [-1, 1], 1 when all recent volume was bought
+        [[nodiscard]] double imbalance() const { return volume > 0.0 ? signedVolume / volume : 0.0; }
+    };
+
+    explicit TradeFlow(uint64_t halflifeNs = 1'000'000'000)
+        : m_halflifeNs(halflifeNs == 0 ? 1 : halflifeNs) {}
+
+    TradeFlow(const TradeFlow&) = delete;
+    TradeFlow& operator=(const TradeFlow&) = delete;
+
+    void onTrade(uint64_t timestampNs, double price, double quantity, bool buyerIsAggressor) {
+        lock();
+        decayTo(m_state, timestampNs);
+        m_state.signedVolume += buyerIsAggressor ? quantity : -quantity;
+        m_state.volume += quantity;
+        m_decayedCount += 1.0;
+        m_state.lastPrice = price;
+        ++m_state.trades;
+        unlock();
+    }
+
+    // Statistics decayed to nowNs, which is exchange time like the trades
+    [[nodiscard]] Snapshot snapshot(uint64_t nowNs) const {
+        lock();
+        Snapshot stats = m_state;
+        const double count = m_decayedCount;
+        unlock();
+        const double factor = decayFactor(stats.lastTradeNs, nowNs);
+        stats.signedVolume *= factor;
+        stats.volume *= factor;
+        stats.intensity = count * factor * std::log(2.0) * 1e9 / static_cast<double>(m_halflifeNs);
+        return stats;
+    }
+
+    void reset() {
+        lock();
+        m_state = {};
+        m_decayedCount = 0.0;
+        unlock();
+    }
+
+private:
+    void lock() const {
+        while(m_lock.test_and_set(std::memory_order_acquire)) {
+            _mm_pause();
+        }
+    }
+
+    void unlock() const { m_lock.clear(std::memory_order_release); }
+
+    [[nodiscard]] double decayFactor(uint64_t fromNs, uint64_t toNs) const {
+        if(toNs <= fromNs) {
+            return 1.0;
+        }
+        return std::exp2(-static_cast<double>(toNs - fromNs) / static_cast<double>(m_halflifeNs));
+    }
+
+    // Trades can arrive slightly out of order, older ones are added undecayed
+    void decayTo(Snapshot& state, uint64_t timestampNs) {
+        const double factor = decayFactor(state.lastTradeNs, timestampNs);
+        state.signedVolume *= factor;
+        state.volume *= factor;
+        m_decayedCount *= factor;
+        if(timestampNs > state.lastTradeNs) {
+            state.lastTradeNs = timestampNs;
+        }
+    }
+
+    const uint64_t m_halflifeNs;
+    mutable std::atomic_flag m_lock = ATOMIC_FLAG_INIT;
+    Snapshot m_state;
+    double m_decayedCount = 0.0;
+};
@@ -1,9 +1,25 @@
 #pragma once
+#include "../utils/backoff.hpp"
+#include "../utils/helper.hpp"
+#include "../utils/instrumentregistry.hpp"
+#include "../utils/latency.hpp"
 #include "../utils/logger.hpp"
+#include "../utils/tickstore.hpp"
+#include "feedarbiter.hpp"
+#include "nativewebsocket.hpp"
 #include <boost/asio.hpp>
 #include <boost/asio/ssl.hpp>
+#include <atomic>
 #include <iostream>
+#include <memory>
+#include <mutex>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
 #include <string>
+#include <string_view>
+#include <sys/socket.h>
+#include <thread>
+#include <vector>
 #include <websocketpp/client.hpp>
 #include <websocketpp/config/asio_client.hpp>
 #include <websocketpp/config/asio_no_tls_client.hpp>
@@ -11,6 +27,25 @@
 typedef websocketpp::client<websocketpp::config::asio_tls_client> client_tls;
 typedef websocketpp::client<websocketpp::config::asio_client> client_non_tls;
 
+#ifndef SO_BUSY_POLL
+#define SO_BUSY_POLL 46
+#endif
+
+// Busy-poll settings for a single websocket connection. When enabled the io_service is
+// driven with poll() in a tight loop instead of blocking in epoll via run().
+struct BusyPollConfig {
+    bool enabled = false;
+    int socket_busy_poll_us = 50; // SO_BUSY_POLL budget, 0 leaves the kernel default
+};
+
+// Snapshot of the poll loop counters of the current connection
+struct PollLoopStats {
+    uint64_t polls = 0;
+    uint64_t handlers_run = 0;
+    uint64_t idle_polls = 0;
+    uint64_t max_handlers_per_poll = 0;
+};
+
 // CRTP base class
 template<typename Derived>
 class WebSocketClient {
@@ -24,9 +59,9 @@ public:
         , proxy_uri(proxy_uri)
         , tls(tls) {
         if(tls) {
-            ws_client = std::make_unique<client_tls>();
+            ws_client = std::make_shared<client_tls>();
         } else {
-            binance_client = std::make_unique<client_non_tls>();
+            binance_client = std::make_shared<client_non_tls>();
         }
     }
 
@@ -38,10 +73,171 @@ public:
     // Start connection
     void start() {
         reconnect_attempt = 0; // reset
+        backoff.reset();
         connect_to_websocket();
     }
 
+    // Must be called before start(), the flag is read by the connection thread
+    void setBusyPoll(const BusyPollConfig& config) { busy_poll = config; }
+
+    [[nodiscard]] bool isBusyPollEnabled() const { return busy_poll.enabled; }
+
+    // Must be called before start(); switches the stream from websocketpp to the in-house framing client
+    void setNativeFraming(bool enabled) { native_framing = enabled; }
+
+    [[nodiscard]] bool isNativeFramingEnabled() const { return native_framing; }
+
+    // Must be called before start(); updates of the instrument are then published through the shared arbiter
+    void setFeedArbiter(mapping::InstrumentId instrument, FeedArbiter* arbiter, size_t index) {
+        if(feed_arbiters.size() <= instrument) {
+            feed_arbiters.resize(instrument + 1, nullptr);
+            last_update_ids.resize(instrument + 1, 0);
+        }
+        feed_arbiters[instrument] = arbiter;
+        feed_index = index;
+    }
+
+    // Must be called before start(); every update of the instrument reaching the strategy is queued
+    // for the recorder through this connection's producer, the file I/O runs on the recording thread
+    void setTickRecorder(mapping::InstrumentId instrument,
+                         tick_store::TickStoreWriter* recorder,
+                         tick_store::TickRecordingThread::Producer* producer) {
+        if(tick_recorders.size() <= instrument) {
+            tick_recorders.resize(instrument + 1, nullptr);
+        }
+        tick_recorders[instrument] = recorder;
+        tick_producer = producer;
+    }
+
+    [[nodiscard]] bool isConnected() const { return connected.load(std::memory_order_acquire); }
+
+    // Sends a text frame on whichever backend is active, never throws. Any thread may call it: the
+    // client is held by a copy, so a reconnect replacing it meanwhile cannot free it under the send.
+    bool send_text(std::string_view payload) {
+        if(native_framing) {
+            const auto native = client_copy(native_client);
+            return native && native->send_text(payload);
+        }
+        std::shared_ptr<client_tls> tls_client;
+        std::shared_ptr<client_non_tls> plain_client;
+        websocketpp::connection_hdl hdl;
+        {
+            std::lock_guard<std::mutex> lock(client_mutex);
+            tls_client = ws_client;
+            plain_client = binance_client;
+            hdl = current_hdl;
+        }
+        websocketpp::lib::error_code ec;
+        if(tls && tls_client) {
+            tls_client->send(hdl, payload.data(), payload.size(), websocketpp::frame::opcode::text, ec);
+        } else if(!tls && plain_client) {
+            plain_client->send(hdl, payload.data(), payload.size(), websocketpp::frame::opcode::text, ec);
+        } else {
+            return false;
+        }
+        if(ec) {
+            LoggerSingleton::get().infra().error("websocket send error: ", ec.message());
+            return false;
+        }
+        return true;
+    }
+
+    [[nodiscard]] PollLoopStats getPollLoopStats() const {
+        return PollLoopStats{poll_stats.polls.load(std::memory_order_relaxed),
+                             poll_stats.handlers_run.load(std::memory_order_relaxed),
+                             poll_stats.idle_polls.load(std::memory_order_relaxed),
+                             poll_stats.max_handlers_per_poll.load(std::memory_order_relaxed)};
+    }
+
+    // Runs on the connection thread until shutdown or until the retry limit is exhausted. Reconnects
+    // happen here, after the failed client has fully unwound, never from inside its own handlers.
     void connect_to_websocket() {
+        do {
+            reconnect_pending = false;
+            if(native_framing) {
+                run_native_connection();
+            } else {
+                run_websocketpp_connection();
+            }
+            if(reconnect_pending && !shutdown_requested) {
+                wait_before_reconnect();
+            }
+        } while(reconnect_pending && !shutdown_requested);
+    }
+
+    void stop() {
+        shutdown_requested = true;
+        if(cleaning_up.exchange(true)) {
+            return; // cleanup already underway, so return immediately.
+        }
+        // Only the event loop is stopped here, the connection thread owns and replaces the client
+        try {
+            if(native_framing) {
+                if(const auto native = client_copy(native_client)) {
+                    LOG_INFRA_DEBUG("stopping native client");
+                    native->stop();
+                }
+            } else if(tls) {
+                if(const auto tls_client = client_copy(ws_client)) {
+                    LOG_INFRA_DEBUG("stopping TLS client");
+                    tls_client->stop();
+                }
+            } else {
+                if(const auto plain_client = client_copy(binance_client)) {
+                    LOG_INFRA_DEBUG("stopping non-TLS client");
+                    plain_client->stop();
+                }
+            }
+        } catch(const std::exception& e) {
+            LoggerSingleton::get().infra().error("error stopping websocket client: ", e.what());
+        }
+    }
+
+    // Called from the close/fail handlers: unwinds the event loop so connect_to_websocket() can rebuild
+    void schedule_reconnection() {
+        if(shutdown_requested) {
+            LOG_INFRA_DEBUG("Shutdown requested; not scheduling reconnection");
+            return;
+        }
+        LOG_INFRA_DEBUG("attempting to restart md channel");
+        reconnect_pending = true;
+        if(native_framing) {
+            return; // the closed socket leaves the io_service without work
+        }
+        if(tls && ws_client) {
+            ws_client->stop();
+        } else if(!tls && binance_client) {
+            binance_client->stop();
+        }
+    }
+
+    // Must be called before start()
+    void setReconnectPolicy(const ReconnectPolicy& policy) { backoff = ReconnectBackoff(policy); }
+
+protected:
+    friend class native_ws::NativeWebSocket<WebSocketClient>;
+
+    // Swaps in the client of a new connection; the previous one is released outside the lock, and
+    // freed once no send_text() or stop() holds it any more
+    template<typename Client>
+    void replace_client(std::shared_ptr<Client>& slot, std::shared_ptr<Client> client) {
+        std::lock_guard<std::mutex> lock(client_mutex);
+        slot.swap(client);
+    }
+
+    template<typename Client>
+    std::shared_ptr<Client> client_copy(const std::shared_ptr<Client>& slot) const {
+        std::lock_guard<std::mutex> lock(client_mutex);
+        return slot;
+    }
+
+    void run_websocketpp_connection() {
+        socket_fd = -1;
+        if(tls) {
+            replace_client(ws_client, std::make_shared<client_tls>());
+        } else {
+            replace_client(binance_client, std::make_shared<client_non_tls>());
+        }
         setupClient();
         websocketpp::lib::error_code ec;
         client_tls::connection_ptr con;
@@ -55,71 +251,208 @@ public:
         }
         if(ec) {
             LoggerSingleton::get().infra().error("connection error: ", ec.message());
+            reconnect_pending = reconnect_attempt + 1 <= retry_limit;
             return;
         }
 
         // Optional proxy setup
         if(!proxy_uri.empty()) {
-            con->set_proxy(proxy_uri);
+            if(tls)
+                con->set_proxy(proxy_uri);
+            else
+                con_non_tls->set_proxy(proxy_uri);
         }
         if(tls)
             ws_client->connect(con);
         else
             binance_client->connect(con_non_tls);
         if(tls)
-            ws_client->run();
+            run_event_loop(*ws_client);
         else
-            binance_client->run();
+            run_event_loop(*binance_client);
     }
 
-    void stop() {
-        if(cleaning_up.exchange(true)) {
-            return; // cleanup already underway, so return immediately.
+    void run_native_connection() {
+        socket_fd = -1;
+        replace_client(native_client,
+                       std::make_shared<native_ws::NativeWebSocket<WebSocketClient>>(*this, uri, proxy_uri));
+        if(!native_client->connect()) {
+            return;
         }
-        try {
-            if(tls) {
-                if(ws_client) {
-                    LOG_INFRA_DEBUG("stopping TLS client");
-                    ws_client->stop(); // Stop the client
-                    ws_client.reset(); // Fully destroy the client
-                }
-            } else {
-                if(binance_client) {
-                    LOG_INFRA_DEBUG("stopping non-TLS client");
-                    binance_client->stop(); // Stop the client
-                    binance_client.reset(); // Fully destroy the client
-                }
-            }
-        } catch(const std::exception& e) {
-            LoggerSingleton::get().infra().error("error stopping websocket client: ", e.what());
+        run_event_loop(*native_client);
+    }
+
+    void wait_before_reconnect() {
+        const auto delay = backoff.nextDelay();
+        reconnect_attempt += 1;
+        LoggerSingleton::get().infra().info("action=schedule_reconnect uri=",
+                                            uri,
+                                            " attempt=",
+                                            reconnect_attempt,
+                                            " delay_ms=",
+                                            delay.count());
+        // Sleep in slices so that a shutdown during the backoff is not delayed
+        const auto deadline = std::chrono::steady_clock::now() + delay;
+        while(!shutdown_requested && std::chrono::steady_clock::now() < deadline) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
         }
     }
 
-    void schedule_reconnection() {
-        if(shutdown_requested) {
-            LOG_INFRA_DEBUG("Shutdown requested; not scheduling reconnection");
+    void on_connection_opened(websocketpp::connection_hdl hdl) {
+        connected.store(true, std::memory_order_release);
+        {
+            std::lock_guard<std::mutex> lock(client_mutex);
+            current_hdl = hdl;
+        }
+        reconnect_attempt = 0;
+        backoff.reset();
+    }
+
+    void on_native_open() {
+        on_connection_opened(websocketpp::connection_hdl{});
+        tune_fd(native_client->native_handle());
+        static_cast<Derived*>(this)->onOpen(current_hdl);
+    }
+
+    void on_native_message(std::string_view payload) {
+        latency::trigger() = latency::now();
+        quickack_due = true;
+        static_cast<Derived*>(this)->onMessage(payload);
+    }
+
+    void on_native_close() { on_connection_closed(websocketpp::connection_hdl{}); }
+
+    // Decides whether a parsed update of an instrument reaches the strategy: without an arbiter any
+    // top-of-book change does, with one only the first arrival of each update id across the connections.
+    // One connection gets the ids of an instrument in order, so an id going backwards on it is an
+    // exchange-side sequence reset. The last id outlives reconnects, a session resuming lower is one too.
+    bool accept_update(
+        mapping::InstrumentId instrument, uint64_t update_id, const Book& book, double old_bid, double old_ask) {
+        latency::record(latency::Metric::MdParse, Derived::LATENCY_VENUE, latency::trigger());
+        bool published;
+        if(instrument < feed_arbiters.size() && feed_arbiters[instrument]) {
+            uint64_t& last_id = last_update_ids[instrument];
+            const uint64_t reset_from = update_id < last_id ? last_id : 0;
+            last_id = update_id;
+            published = feed_arbiters[instrument]->publish(feed_index, update_id, reset_from, book);
+        } else {
+            published = old_bid != book.getBestBid() || old_ask != book.getBestAsk();
+        }
+        if(published && instrument < tick_recorders.size() && tick_recorders[instrument]) {
+            record_tick(*tick_recorders[instrument], book);
+        }
+        return published;
+    }
+
+    // Sizes are 0 on feeds that only keep the best prices
+    void record_tick(tick_store::TickStoreWriter& recorder, const Book& book) {
+        tick_producer->record(recorder,
+                              {book.m_timestamp,
+                               helper::get_current_timestamp_ns(),
+                               book.getBestBid(),
+                               book.bidSide.size > 0 ? book.bidSide.levels[0].quantity : 0.0,
+                               book.getBestAsk(),
+                               book.askSide.size > 0 ? book.askSide.levels[0].quantity : 0.0});
+    }
+
+    void on_connection_closed(websocketpp::connection_hdl hdl) {
+        connected.store(false, std::memory_order_release);
+        socket_fd = -1;
+        if(reconnect_attempt + 1 > retry_limit) {
+            std::string message = "connection_end";
+            static_cast<Derived*>(this)->onClose(hdl, message);
+        } else {
+            std::string message = "disconnect";
+            static_cast<Derived*>(this)->onClose(hdl, message);
+            schedule_reconnection();
+        }
+    }
+
+    template<typename Client>
+    void run_event_loop(Client& client) {
+        if(!busy_poll.enabled) {
+            client.run();
             return;
         }
-        LOG_INFRA_DEBUG("attempting to restart md channel");
-        try {
-            stop();
-            cleaning_up = false;
-            if(tls) {
-                LOG_INFRA_DEBUG("creating new TLS client instance");
-                ws_client = std::make_unique<client_tls>();
-            } else {
-                LOG_INFRA_DEBUG("creating new non-TLS client instance");
-                binance_client = std::make_unique<client_non_tls>();
+        reset_poll_stats();
+        // poll() never blocks; the io_service stops by itself once the connection has no work left
+        while(!client.stopped() && !shutdown_requested.load(std::memory_order_relaxed)) {
+            const uint64_t handlers = client.poll();
+            poll_stats.polls.fetch_add(1, std::memory_order_relaxed);
+            if(handlers == 0) {
+                poll_stats.idle_polls.fetch_add(1, std::memory_order_relaxed);
+                continue;
+            }
+            poll_stats.handlers_run.fetch_add(handlers, std::memory_order_relaxed);
+            if(handlers > poll_stats.max_handlers_per_poll.load(std::memory_order_relaxed)) {
+                poll_stats.max_handlers_per_poll.store(handlers, std::memory_order_relaxed);
+            }
+            // TCP_QUICKACK is not sticky, the kernel drops back to delayed acks after a read. Only a poll that
+            // delivered a message read data; timers and writes leave the flag alone and cost no syscall.
+            if(quickack_due) {
+                quickack_due = false;
+                rearm_quickack();
             }
-            // Reconnect
-            LOG_INFRA_DEBUG("attempting to reconnect");
-            connect_to_websocket();
-        } catch(const std::exception& e) {
-            LoggerSingleton::get().infra().error("error during reconnection: ", e.what());
         }
+        const PollLoopStats stats = getPollLoopStats();
+        LoggerSingleton::get().infra().info("action=busy_poll_exit uri=",
+                                            uri,
+                                            " polls=",
+                                            stats.polls,
+                                            " handlers_run=",
+                                            stats.handlers_run,
+                                            " idle_polls=",
+                                            stats.idle_polls,
+                                            " max_handlers_per_poll=",
+                                            stats.max_handlers_per_poll);
+    }
+
+    void reset_poll_stats() {
+        poll_stats.polls.store(0, std::memory_order_relaxed);
+        poll_stats.handlers_run.store(0, std::memory_order_relaxed);
+        poll_stats.idle_polls.store(0, std::memory_order_relaxed);
+        poll_stats.max_handlers_per_poll.store(0, std::memory_order_relaxed);
+    }
+
+    // Called from the open handler: the TCP socket only exists once the connection is established
+    template<typename Client>
+    void tune_socket(Client& client, websocketpp::connection_hdl hdl) {
+        websocketpp::lib::error_code ec;
+        auto con = client.get_con_from_hdl(hdl, ec);
+        if(ec || !con) {
+            return;
+        }
+        tune_fd(con->get_raw_socket().native_handle());
+    }
+
+    void tune_fd(int fd) {
+        socket_fd = fd;
+        const int one = 1;
+        if(setsockopt(socket_fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one)) != 0) {
+            LoggerSingleton::get().infra().warning("action=set_tcp_nodelay result=fail errno=", errno);
+        }
+        if(!busy_poll.enabled) {
+            return;
+        }
+        if(busy_poll.socket_busy_poll_us > 0 && setsockopt(socket_fd,
+                                                           SOL_SOCKET,
+                                                           SO_BUSY_POLL,
+                                                           &busy_poll.socket_busy_poll_us,
+                                                           sizeof(busy_poll.socket_busy_poll_us)) != 0) {
+            // Raising the value above net.core.busy_read requires CAP_NET_ADMIN
+            LoggerSingleton::get().infra().warning("action=set_so_busy_poll result=fail errno=", errno);
+        }
+        rearm_quickack();
+    }
+
+    void rearm_quickack() const {
+        if(socket_fd < 0) {
+            return;
+        }
+        const int one = 1;
+        setsockopt(socket_fd, IPPROTO_TCP, TCP_QUICKACK, &one, sizeof(one));
     }
 
-protected:
     void setupClient() {
         if(!tls) {
             // if (!binance_client) {
@@ -131,32 +464,17 @@ protected:
             binance_client->clear_error_channels(websocketpp::log::elevel::all);
             binance_client->set_message_handler(
                 [this](websocketpp::connection_hdl hdl, client_non_tls::message_ptr msg) {
-                    static_cast<Derived*>(this)->onMessage(hdl, msg);
+                    latency::trigger() = latency::now();
+                    quickack_due = true;
+                    static_cast<Derived*>(this)->onMessage(std::string_view(msg->get_payload()));
                 });
             binance_client->set_open_handler([this](websocketpp::connection_hdl hdl) {
-                current_hdl = hdl;
+                on_connection_opened(hdl);
+                tune_socket(*binance_client, hdl);
                 static_cast<Derived*>(this)->onOpen(hdl);
             });
-            binance_client->set_close_handler([this](websocketpp::connection_hdl hdl) {
-                if(reconnect_attempt + 1 > retry_limit) {
-                    std::string message = "connection_end";
-                    static_cast<Derived*>(this)->onClose(hdl, message);
-                } else {
-                    std::string message = "disconnect";
-                    static_cast<Derived*>(this)->onClose(hdl, message);
-                    schedule_reconnection();
-                }
-            });
-            binance_client->set_fail_handler([this](websocketpp::connection_hdl hdl) {
-                if(reconnect_attempt + 1 > retry_limit) {
-                    std::string message = "connection_end";
-                    static_cast<Derived*>(this)->onClose(hdl, message);
-                } else {
-                    std::string message = "disconnect";
-                    static_cast<Derived*>(this)->onClose(hdl, message);
-                    schedule_reconnection();
-                }
-            });
+            binance_client->set_close_handler([this](websocketpp::connection_hdl hdl) { on_connection_closed(hdl); });
+            binance_client->set_fail_handler([this](websocketpp::connection_hdl hdl) { on_connection_closed(hdl); });
             return;
         }
         // if (!ws_client) {
@@ -178,42 +496,50 @@ protected:
         });
         // Set handlers using CRTP to access derived class methods
         ws_client->set_message_handler([this](websocketpp::connection_hdl hdl, client_tls::message_ptr msg) {
-            static_cast<Derived*>(this)->onMessage(hdl, msg);
+            latency::trigger() = latency::now();
+            quickack_due = true;
+            static_cast<Derived*>(this)->onMessage(std::string_view(msg->get_payload()));
         });
         ws_client->set_open_handler([this](websocketpp::connection_hdl hdl) {
-            current_hdl = hdl;
+            on_connection_opened(hdl);
+            tune_socket(*ws_client, hdl);
             static_cast<Derived*>(this)->onOpen(hdl);
         });
-        ws_client->set_close_handler([this](websocketpp::connection_hdl hdl) {
-            if(reconnect_attempt + 1 > retry_limit) {
-                std::string message = "connection_end";
-                static_cast<Derived*>(this)->onClose(hdl, message);
-            } else {
-                std::string message = "disconnect";
-                static_cast<Derived*>(this)->onClose(hdl, message);
-                schedule_reconnection();
-            }
-        });
-        ws_client->set_fail_handler([this](websocketpp::connection_hdl hdl) {
-            if(reconnect_attempt + 1 > retry_limit) {
-                std::string message = "connection_end";
-                static_cast<Derived*>(this)->onClose(hdl, message);
-            } else {
-                std::string message = "disconnect";
-                static_cast<Derived*>(this)->onClose(hdl, message);
-                schedule_reconnection();
-            }
-        });
+        ws_client->set_close_handler([this](websocketpp::connection_hdl hdl) { on_connection_closed(hdl); });
+        ws_client->set_fail_handler([this](websocketpp::connection_hdl hdl) { on_connection_closed(hdl); });
     }
 
+    // The connection thread is the only one replacing the clients and current_hdl, and reads them
+    // directly; send_text() and stop() run on other threads and copy them under client_mutex
+    mutable std::mutex client_mutex;
     websocketpp::connection_hdl current_hdl;
     std::atomic<bool> cleaning_up{false};
     std::atomic<bool> shutdown_requested{false};
-    std::unique_ptr<client_tls> ws_client;
-    std::unique_ptr<client_non_tls> binance_client;
+    std::shared_ptr<client_tls> ws_client;
+    std::shared_ptr<client_non_tls> binance_client;
     bool tls = true;
     std::string uri;
     std::string proxy_uri;
     const uint32_t retry_limit = 0;
-    uint32_t reconnect_attempt = 0;
+    uint32_t reconnect_attempt = 0; // consecutive failed attempts, reset once a connection opens
+    ReconnectBackoff backoff;
+    BusyPollConfig busy_poll;
+    int socket_fd = -1;
+    bool quickack_due = false; // a message arrived since the last TCP_QUICKACK, connection thread only
+    bool native_framing = false;
+    std::vector<FeedArbiter*> feed_arbiters; // by InstrumentRegistry id
+    std::vector<uint64_t> last_update_ids; // by InstrumentRegistry id, this connection's last update id
+    std::vector<tick_store::TickStoreWriter*> tick_recorders; // by InstrumentRegistry id, owned by the RedundantFeed
+    tick_store::TickRecordingThread::Producer* tick_producer = nullptr; // likewise
+    size_t feed_index = 0;
+    std::atomic<bool> connected{false};
+    bool reconnect_pending = false;
+    std::shared_ptr<native_ws::NativeWebSocket<WebSocketClient>> native_client;
+
+    struct {
+        std::atomic<uint64_t> polls{0};
+        std::atomic<uint64_t> handlers_run{0};
+        std::atomic<uint64_t> idle_polls{0};
+        std::atomic<uint64_t> max_handlers_per_poll{0};
+    } poll_stats;
 };
@@ -1,6 +1,7 @@
 #pragma once
 #include "../lib/json.hpp"
 #include "../utils/helper.hpp"
+#include "../utils/latency.hpp"
 #include "../utils/logger.hpp"
 #include "../utils/requests.hpp"
 #include "bybitordermanager.hpp"
@@ -194,6 +195,7 @@ public:
             uint64_t clOrderId = bybitOrderManager.cancelQueue.front();
             auto it = bybitOrderManager.orderMap.find(clOrderId);
             if(it != bybitOrderManager.orderMap.end()) {
+                bybitOrderManager.outstandingQty.release(*it->second);
                 bybitOrderManager.orderMap.erase(clOrderId);
             }
             bybitOrderManager.cancelQueue.pop();
@@ -204,6 +206,7 @@ public:
             uint64_t clOrderId = bybitOrderManager.rejectedQueue.front();
             auto it = bybitOrderManager.orderMap.find(clOrderId);
             if(it != bybitOrderManager.orderMap.end()) {
+                bybitOrderManager.outstandingQty.release(*it->second);
                 bybitOrderManager.orderMap.erase(clOrderId);
             }
             bybitOrderManager.rejectedQueue.pop();
@@ -214,6 +217,7 @@ public:
             uint64_t clOrderId = bybitOrderManager.filledQueue.front();
             auto it = bybitOrderManager.orderMap.find(clOrderId);
             if(it != bybitOrderManager.orderMap.end()) {
+                bybitOrderManager.outstandingQty.release(*it->second);
                 bybitOrderManager.orderMap.erase(clOrderId);
             }
             bybitOrderManager.filledQueue.pop();
@@ -277,6 +281,10 @@ public:
                                 order->m_cancelOrderOnExchTS =
                                     std::stoull(orderData["createdTime"].get<std::string>()) * 1000000ULL;
                                 order->m_cancelOrderConfirmationTS = helper::get_current_timestamp_ns();
+                                latency::recordInterval(latency::Metric::OrderAck,
+                                                        latency::Venue::Bybit,
+                                                        order->m_cancelOrderOnOmsTS,
+                                                        order->m_cancelOrderConfirmationTS);
                             }
                             bybitOrderManager.cancelQueue.push(order->m_clientOrderId);
                             maintainOrderLimit();
@@ -290,6 +298,8 @@ public:
                             bybitOrderManager.rejectedQueue.push(order->m_clientOrderId);
                             maintainOrderLimit();
                         }
+                        bybitOrderManager.outstandingQty.sync(*order);
+                        bybitOrderManager.releaseQuote(order->m_clientOrderId);
                         if(orderUpdateCallback) {
                             orderUpdateCallback(*order);
                         }
@@ -305,18 +315,29 @@ public:
                                 order->m_newOrderOnExchTS =
                                     std::stoull(orderData["createdTime"].get<std::string>()) * 1000000ULL;
                                 order->m_newOrderConfirmationTS = helper::get_current_timestamp_ns();
+                                latency::recordInterval(latency::Metric::OrderAck,
+                                                        latency::Venue::Bybit,
+                                                        order->m_newOrderOnOmsTS,
+                                                        order->m_newOrderConfirmationTS);
                             } else {
                                 order->m_modifyOrderOnExchTS =
                                     std::stoull(orderData["createdTime"].get<std::string>()) * 1000000ULL;
                                 order->m_modifyOrderConfirmationTS = helper::get_current_timestamp_ns();
+                                latency::recordInterval(latency::Metric::OrderAck,
+                                                        latency::Venue::Bybit,
+                                                        order->m_modifyOrderOnOmsTS,
+                                                        order->m_modifyOrderConfirmationTS);
                             }
                         }
+                        bybitOrderManager.outstandingQty.sync(*order);
+                        bybitOrderManager.guardQuote(*order);
                         if(orderUpdateCallback) {
                             orderUpdateCallback(*order);
                         }
                     } else if(orderData["orderStatus"] == "PartiallyFilled") {
                         order->m_reason = RejectReason::NONE;
                         order->m_status = OrderStatus::PARTIALLY_FILLED;
+                        bybitOrderManager.outstandingQty.sync(*order);
                         /*
                         order->m_qtyOnExch = std::stod(orderData["leavesQty"].get<std::string>());
 
@@ -349,6 +370,8 @@ public:
                     } else if(orderData["orderStatus"] == "Filled") {
                         order->m_reason = RejectReason::NONE;
                         order->m_status = OrderStatus::FILLED;
+                        bybitOrderManager.outstandingQty.sync(*order);
+                        bybitOrderManager.releaseQuote(order->m_clientOrderId);
                         /*
                         order->m_qtyOnExch = std::stod(orderData["leavesQty"].get<std::string>());
 
@@ -384,9 +407,15 @@ public:
                             order->m_cancelOrderOnExchTS =
                                 std::stoull(orderData["createdTime"].get<std::string>()) * 1000000ULL;
                             order->m_cancelOrderConfirmationTS = helper::get_current_timestamp_ns();
+                            latency::recordInterval(latency::Metric::OrderAck,
+                                                    latency::Venue::Bybit,
+                                                    order->m_cancelOrderOnOmsTS,
+                                                    order->m_cancelOrderConfirmationTS);
                         }
                         bybitOrderManager.cancelQueue.push(order->m_clientOrderId);
                         maintainOrderLimit();
+                        bybitOrderManager.outstandingQty.sync(*order);
+                        bybitOrderManager.releaseQuote(order->m_clientOrderId);
                         if(orderUpdateCallback) {
                             orderUpdateCallback(*order);
                         }
@@ -422,6 +451,7 @@ public:
                         order->m_status = OrderStatus::PARTIALLY_FILLED;
                     } else {
                         order->m_status = OrderStatus::FILLED;
+                        bybitOrderManager.releaseQuote(order->m_clientOrderId);
                         bybitOrderManager.filledQueue.push(order->m_clientOrderId);
                         maintainOrderLimit();
                     }
@@ -436,6 +466,7 @@ public:
 
                     bybitOrderManager.m_positionManager.update_position_by_fillsz(fillSz, order->m_side);
                     bybitOrderManager.m_realisedPnl += fillPnl;
+                    bybitOrderManager.outstandingQty.sync(*order);
                     if(orderUpdateCallback) {
                         orderUpdateCallback(*order);
                     }
@@ -7,6 +7,8 @@
 #include "bybitordersrouting.hpp"
 #include "bybitpositionmanager.hpp"
 #include "orderhandler.hpp"
+#include "outstandingqty.hpp"
+#include "stalequoteguard.hpp"
 #include <functional>
 #include <memory>
 #include <mutex>
@@ -24,16 +26,23 @@ public:
                                const uint32_t track_order_cnt,
                                const std::string api_key,
                                const std::string api_secret,
-                               ByBitPositionManager& manager)
+                               ByBitPositionManager& manager,
+                               const ReconnectPolicy& reconnect_policy = {},
+                               const StaleQuoteGuard::Config& stale_quote_guard = {})
         : m_positionManager(manager)
         , m_trackOrderCnt(track_order_cnt)
         , retry_limit(retry_limit)
-        , m_client(trading_mode, api_key, api_secret) {
+        , m_client(trading_mode, api_key, api_secret)
+        , m_staleQuoteGuard(stale_quote_guard) {
         LOG_INFRA_DEBUG("Order track cnt: ", m_trackOrderCnt);
         bybitOrderRouter = std::make_unique<ByBitOrderRouter>(
-            trading_mode, proxy_uri, retry_limit, api_key, api_secret, [this](std::string message) {
-                this->updateOrderStatus(message);
-            });
+            trading_mode,
+            proxy_uri,
+            retry_limit,
+            api_key,
+            api_secret,
+            [this](std::string message) { this->updateOrderStatus(message); },
+            reconnect_policy);
     }
 
     void run() { bybitOrderRouter->setupRoutingConnection(); }
@@ -104,6 +113,9 @@ public:
         return res;
     }
 
+    // Quantity of pending, live and partially filled orders on one side, O(1)
+    [[nodiscard]] double getOutstandingQty(bool buy) const noexcept { return outstandingQty.get(buy); }
+
     uint64_t placeOrder(const std::string& instrumentId,
                         double price,
                         double qty,
@@ -111,13 +123,25 @@ public:
                         const std::string& ordType = "limit",
                         const std::string& tdMode = "cross",
                         bool banAmend = true) {
+        return placeOrder(
+            mapping::InstrumentRegistry::instance().id(instrumentId), price, qty, buy, ordType, tdMode, banAmend);
+    }
+
+    // Hot path: the instrument is resolved by id, without string lookups
+    uint64_t placeOrder(mapping::InstrumentId instrumentId,
+                        double price,
+                        double qty,
+                        bool buy,
+                        const std::string& ordType = "limit",
+                        const std::string& tdMode = "cross",
+                        bool banAmend = true) {
         // std::lock_guard<std::mutex> lock(m_mutex);
-        std::shared_ptr<OrderHandler> orderHandler = createOrderHandler(instrumentId);
+        const mapping::InstrumentSpec* inst = mapping::InstrumentRegistry::instance().find(instrumentId);
+        std::shared_ptr<OrderHandler> orderHandler = createOrderHandler(inst ? inst->name : "");
         orderHandler->m_newOrderOnOmsTS = helper::get_current_timestamp_ns();
-        mapping::InstrumentInfo inst = mapping::getInstrumentInfo(instrumentId);
-        if(!isWebSocketReady()) {
+        if(!inst || !isWebSocketReady()) {
             orderHandler->m_status = OrderStatus::REJECTED;
-            orderHandler->m_reason = RejectReason::WS_FAILURE;
+            orderHandler->m_reason = inst ? RejectReason::WS_FAILURE : RejectReason::INVALID_INSTRUMENT;
             if(orderStatusUpdateCallback) {
                 orderStatusUpdateCallback(*orderHandler);
             }
@@ -125,7 +149,7 @@ public:
         }
         m_reqId += 1;
         uint64_t clientOrderId =
-            bybitOrderRouter->sendOrder(price, qty, buy, m_reqId, inst.instrument, ordType, tdMode, banAmend);
+            bybitOrderRouter->sendOrder(price, qty, buy, m_reqId, *inst, ordType, tdMode, banAmend);
         reqId_to_orderHandler.emplace(m_reqId, orderHandler);
         if(clientOrderId != 0) {
             orderHandler->m_clientOrderId = clientOrderId;
@@ -134,6 +158,7 @@ public:
             orderHandler->m_side = buy;
             orderHandler->m_qtySubmitted = qty;
             orderHandler->m_priceSubmitted = price;
+            outstandingQty.sync(*orderHandler);
             orderMap.emplace(clientOrderId, std::move(orderHandler));
         } else {
             orderHandler->m_status = OrderStatus::REJECTED;
@@ -150,31 +175,37 @@ public:
 
     // Cancel an existing order by orderId
     uint64_t cancelOrder(uint64_t clientOrderId, const std::string& m_instrument) {
+        return cancelOrder(clientOrderId, mapping::InstrumentRegistry::instance().id(m_instrument));
+    }
+
+    uint64_t cancelOrder(uint64_t clientOrderId, mapping::InstrumentId instrumentId) {
         // std::lock_guard<std::mutex> lock(m_mutex);
+        const mapping::InstrumentSpec* inst = mapping::InstrumentRegistry::instance().find(instrumentId);
         auto orderHandlerIterator = orderMap.find(clientOrderId);
         if(orderHandlerIterator == orderMap.end()) {
-            std::shared_ptr<OrderHandler> newOrderHandler = createOrderHandler(m_instrument);
+            std::shared_ptr<OrderHandler> newOrderHandler = createOrderHandler(inst ? inst->name : "");
             auto [iterator, inserted] = orderMap.emplace(clientOrderId, std::move(newOrderHandler));
             orderHandlerIterator = iterator;
         }
         auto& orderHandler = orderHandlerIterator->second;
         orderHandler->m_clientOrderId = clientOrderId;
-        if(!isWebSocketReady()) {
+        if(!inst || !isWebSocketReady()) {
             orderHandler->m_status = OrderStatus::REJECTED;
-            orderHandler->m_reason = RejectReason::WS_FAILURE;
+            orderHandler->m_reason = inst ? RejectReason::WS_FAILURE : RejectReason::INVALID_INSTRUMENT;
+            outstandingQty.sync(*orderHandler);
             if(orderStatusUpdateCallback) {
                 orderStatusUpdateCallback(*orderHandler);
             }
             return clientOrderId;
         }
         orderHandler->m_cancelOrderOnOmsTS = helper::get_current_timestamp_ns();
-        mapping::InstrumentInfo inst = mapping::getInstrumentInfo(m_instrument);
         m_reqId += 1;
-        uint64_t ret = bybitOrderRouter->sendCancelOrder(clientOrderId, m_reqId, inst.instrument);
+        uint64_t ret = bybitOrderRouter->sendCancelOrder(clientOrderId, m_reqId, *inst);
         reqId_to_orderHandler.emplace(m_reqId, orderHandler);
         if(ret == 0) {
             orderHandler->m_status = OrderStatus::REJECTED;
             orderHandler->m_reason = RejectReason::WS_FAILURE;
+            outstandingQty.sync(*orderHandler);
             if(orderStatusUpdateCallback) {
                 orderStatusUpdateCallback(*orderHandler);
             }
@@ -196,18 +227,24 @@ public:
 
     // Modify an existing order
     uint64_t modifyOrder(uint64_t clientOrderId, double newPrice, double newQty, const std::string& m_instrument) {
+        return modifyOrder(clientOrderId, newPrice, newQty, mapping::InstrumentRegistry::instance().id(m_instrument));
+    }
+
+    uint64_t modifyOrder(uint64_t clientOrderId, double newPrice, double newQty, mapping::InstrumentId instrumentId) {
         // std::lock_guard<std::mutex> lock(m_mutex);
+        const mapping::InstrumentSpec* inst = mapping::InstrumentRegistry::instance().find(instrumentId);
         auto orderHandlerIterator = orderMap.find(clientOrderId);
         if(orderHandlerIterator == orderMap.end()) {
-            std::shared_ptr<OrderHandler> newOrderHandler = createOrderHandler(m_instrument);
+            std::shared_ptr<OrderHandler> newOrderHandler = createOrderHandler(inst ? inst->name : "");
             auto [iterator, inserted] = orderMap.emplace(clientOrderId, std::move(newOrderHandler));
             orderHandlerIterator = iterator;
         }
         auto& orderHandler = orderHandlerIterator->second;
         orderHandler->m_clientOrderId = clientOrderId;
-        if(!isWebSocketReady()) {
+        if(!inst || !isWebSocketReady()) {
             orderHandler->m_status = OrderStatus::REJECTED;
-            orderHandler->m_reason = RejectReason::WS_FAILURE;
+            orderHandler->m_reason = inst ? RejectReason::WS_FAILURE : RejectReason::INVALID_INSTRUMENT;
+            outstandingQty.sync(*orderHandler);
             if(orderStatusUpdateCallback) {
                 orderStatusUpdateCallback(*orderHandler);
             }
@@ -215,13 +252,14 @@ public:
         }
         orderHandler->m_modifyOrderOnOmsTS = helper::get_current_timestamp_ns();
         orderHandler->m_qtySubmitted = newQty;
-        mapping::InstrumentInfo inst = mapping::getInstrumentInfo(m_instrument);
+        outstandingQty.sync(*orderHandler);
         m_reqId += 1;
-        uint64_t ret = bybitOrderRouter->modifyOrder(clientOrderId, newQty, newPrice, m_reqId, inst.instrument);
+        uint64_t ret = bybitOrderRouter->modifyOrder(clientOrderId, newQty, newPrice, m_reqId, *inst);
         reqId_to_orderHandler.emplace(m_reqId, orderHandler);
         if(ret == 0) {
             orderHandler->m_status = OrderStatus::REJECTED;
             orderHandler->m_reason = RejectReason::WS_FAILURE;
+            outstandingQty.sync(*orderHandler);
             if(orderStatusUpdateCallback) {
                 orderStatusUpdateCallback(*orderHandler);
             }
@@ -237,6 +275,49 @@ public:
 
     bool isWebSocketReady() const { return bybitOrderRouter->isWebsocketReady(); }
 
+    // Called by the order stream: a quote is watched from its New report, again after an amend, until
+    // its final state. Its cancel frame is encoded here, off the market-data thread.
+    void guardQuote(const OrderHandler& order) {
+        if(!m_staleQuoteGuard.enabled()) {
+            return;
+        }
+        const mapping::InstrumentSpec* inst = mapping::InstrumentRegistry::instance().find(order.m_instrumentId);
+        if(!inst) {
+            return;
+        }
+        PrebuiltFrame frame =
+            ByBitOrderRouter::buildCancelFrame(order.m_clientOrderId, m_staleQuoteGuard.nextReqId(), *inst);
+        if(!m_staleQuoteGuard.arm(order.m_clientOrderId, order.m_side, order.m_priceOnExch, std::move(frame))) {
+            LoggerSingleton::get().infra().warning("action=guard_quote result=fail reason=no_free_slot order_id=",
+                                                   order.m_clientOrderId);
+        }
+    }
+
+    void releaseQuote(uint64_t clientOrderId) {
+        if(m_staleQuoteGuard.enabled()) {
+            m_staleQuoteGuard.disarm(clientOrderId);
+        }
+    }
+
+    // Called on the reference feed's thread after every touch update, see StaleQuoteGuard
+    size_t checkStaleQuotes(double referenceBid, double referenceAsk) {
+        return m_staleQuoteGuard.onReference(
+            referenceBid, referenceAsk, [this](PrebuiltFrame& frame, const StaleQuoteGuard::Quote& quote) {
+                const bool sent = isWebSocketReady() && bybitOrderRouter->sendFrame(frame);
+                LoggerSingleton::get().infra().warning("action=stale_quote_cancel order_id=",
+                                                       quote.orderId,
+                                                       " side=",
+                                                       quote.buy ? "buy" : "sell",
+                                                       " price=",
+                                                       quote.price,
+                                                       " sent=",
+                                                       sent);
+                return sent;
+            });
+    }
+
+    StaleQuoteGuard& staleQuoteGuard() { return m_staleQuoteGuard; }
+
     std::shared_ptr<OrderHandler> createOrderHandler(const std::string& m_instrument) {
         return std::make_shared<OrderHandler>(m_instrument);
     }
@@ -257,6 +338,18 @@ public:
             uint64_t order_id = 0;
             std::string reqIdStr = parsedJson["reqId"].get<std::string>();
             uint64_t req = std::stoull(reqIdStr);
+            if(req >= StaleQuoteGuard::REQ_ID_BASE) {
+                // guard cancels have no handler, the order stream reports the cancel or the order's fill
+                if(retCode != 0) {
+                    LoggerSingleton::get().infra().info("action=stale_quote_cancel result=rejected req_id=",
+                                                        req,
+                                                        " ret_code=",
+                                                        retCode,
+                                                        " ret_msg=",
+                                                        parsedJson.value("retMsg", ""));
+                }
+                return nullptr;
+            }
             auto iterator = reqId_to_orderHandler.find(req);
             if(retCode == 0) {
                 if(iterator != reqId_to_orderHandler.end()) {
@@ -273,6 +366,7 @@ public:
             } else {
                 auto order = iterator->second;
                 order->m_status = OrderStatus::REJECTED;
+                outstandingQty.sync(*order);
                 reqId_to_orderHandler.erase(iterator);
                 if(parsedJson.contains("header") && parsedJson["header"].contains("Timenow")) {
                     order->m_rejectionTS = std::stoull(parsedJson["header"]["Timenow"].get<std::string>()) * 1000000ULL;
@@ -375,6 +469,7 @@ public:
             uint64_t clOrderId = rejectedQueue.front();
             auto it = orderMap.find(clOrderId);
             if(it != orderMap.end()) {
+                outstandingQty.release(*it->second);
                 orderMap.erase(clOrderId);
             }
             rejectedQueue.pop();
@@ -390,6 +485,7 @@ public:
     std::queue<uint64_t> rejectedQueue;
     double m_realisedPnl = 0.0;
     double m_exposureQty = 0.0;
+    OutstandingQty outstandingQty;
 
 private:
     uint64_t m_reqId = 0;
@@ -403,4 +499,5 @@ private:
     uint32_t retry_limit = 0;
     uint32_t m_trackOrderCnt = 0;
     BybitClient m_client;
+    StaleQuoteGuard m_staleQuoteGuard;
 };
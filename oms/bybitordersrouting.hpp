@@ -1,4 +1,5 @@
 #pragma once
+#include <atomic>
 #include <boost/asio.hpp>
 #include <boost/asio/ssl.hpp>
 #include <chrono>
@@ -6,12 +7,16 @@
 #include <websocketpp/config/asio_client.hpp> // For TLS client (OKX)
 // #include "ordermanager.hpp"
 #include "../lib/json.hpp"
+#include "../utils/backoff.hpp"
 #include "../utils/connections.hpp"
 #include "../utils/helper.hpp"
+#include "../utils/instrumentregistry.hpp"
+#include "../utils/latency.hpp"
 #include "../utils/logger.hpp"
 #include "../utils/requests.hpp"
-#include "../utils/staticparams.hpp"
+#include "stalequoteguard.hpp"
 #include <cmath>
+#include <mutex>
 #include <rapidjson/document.h>
 #include <rapidjson/stringbuffer.h>
 #include <rapidjson/writer.h>
@@ -30,9 +35,13 @@ public:
                      const uint32_t retry_limit,
                      const std::string api_key,
                      const std::string api_secret,
-                     OrderUpdateCallback callback)
+                     OrderUpdateCallback callback,
+                     const ReconnectPolicy& reconnect_policy = {})
         : proxy_uri(proxy_uri)
         , retry_limit(retry_limit)
+        , reconnect_policy(reconnect_policy)
+        , backoff(reconnect_policy)
+        , spare_backoff(reconnect_policy)
         , api_key(api_key)
         , api_secret(api_secret)
         , orderUpdateCallback(std::move(callback))
@@ -61,57 +70,60 @@ public:
             return ctx;
         });
         routing_client.set_message_handler([this](websocketpp::connection_hdl hdl, client_tls::message_ptr msg) {
+            if(isSpare(hdl)) {
+                onSpareMessage(msg->get_payload());
+                return;
+            }
             onOrderUpdateMessage(msg->get_payload());
         });
-        try {
-            routing_client.set_open_handler([this](websocketpp::connection_hdl hdl) {
-                routing_hdl = hdl; // Store the connection handle
-                authenticate();
-            });
-
-        } catch(std::exception e) {
-            LoggerSingleton::get().infra().error("error in setup routing connection: ", e.what());
-        }
+        // Both the active and the spare connection authenticate as soon as they are open
+        routing_client.set_open_handler([this](websocketpp::connection_hdl hdl) { authenticate(hdl); });
 
         routing_client.set_close_handler([this](websocketpp::connection_hdl hdl) {
             LoggerSingleton::get().infra().warning("websocket connection closed");
-            m_wsState = false;
-            handle_disconnect();
+            handle_disconnect(hdl);
         });
 
         routing_client.set_fail_handler([this](websocketpp::connection_hdl hdl) {
             LoggerSingleton::get().infra().error("websocket connection failed");
-            m_wsState = false;
-            handle_disconnect();
+            handle_disconnect(hdl);
         });
-        connect_to_websocket();
+        setRoutingHandle(connect_to_websocket());
+        if(reconnect_policy.spare_connection) {
+            setSpareHandle(connect_to_websocket());
+        }
+        // Reconnects are timers on this io_service, so run() only returns on stop() or connection_end
+        try {
+            routing_client.run();
+        } catch(const std::exception& e) {
+            LoggerSingleton::get().infra().info("websocket run exception: ", e.what());
+        }
     }
 
-    void connect_to_websocket() {
-        reconnect_attempt += 1;
+    connection_hdl connect_to_websocket() {
         websocketpp::lib::error_code ec;
         client_tls::connection_ptr con = routing_client.get_connection(uri, ec);
         if(ec) {
             LoggerSingleton::get().infra().error("connection failed: ", ec.message());
-            return;
+            return {};
         }
         if(proxy_uri != "") {
             LoggerSingleton::get().infra().info("proxy uri: ", proxy_uri);
             con->set_proxy(proxy_uri);
         }
         routing_client.connect(con);
-        try {
-            routing_client.run();
-        } catch(const std::exception& e) {
-            LoggerSingleton::get().infra().info("websocket run exception: ", e.what());
-        }
+        return con->get_handle();
     }
 
     void stop() {
+        stopping = true;
         try {
-            if(!routing_hdl.expired()) { // Check if we have a valid connection
-                // Close the websocket connection gracefully
-                routing_client.close(routing_hdl, websocketpp::close::status::normal, "Shutting down");
+            for(const auto& hdl : {routingHandle(), spareHandle()}) {
+                if(!hdl.expired()) { // Check if we have a valid connection
+                    websocketpp::lib::error_code ec;
+                    // Close the websocket connection gracefully
+                    routing_client.close(hdl, websocketpp::close::status::normal, "Shutting down", ec);
+                }
             }
             // Stop the ASIO io_service
             routing_client.stop();
@@ -120,40 +132,125 @@ public:
         }
     }
 
-    void handle_disconnect() {
+    void handle_disconnect(connection_hdl hdl) {
+        if(stopping) {
+            return;
+        }
+        if(isSpare(hdl)) {
+            LoggerSingleton::get().infra().warning("bybit trades spare stream disconnect");
+            setSpareHandle({});
+            spare_ready = false;
+            schedule_reconnect(false);
+            return;
+        }
+        m_wsState = false;
+        if(reconnect_policy.spare_connection && spare_ready) {
+            promoteSpare();
+            return;
+        }
         LoggerSingleton::get().infra().error("bybit trades stream disconnect");
-        if(reconnect_attempt + 1 > retry_limit) {
+        if(backoff.attempts() + 1 > retry_limit) {
             std::string message = "connection_end";
             orderUpdateCallback(message);
         } else {
             std::string message = "disconnect";
             orderUpdateCallback(message);
-            schedule_reconnect();
+            schedule_reconnect(true);
+        }
+    }
+
+    // The spare is already handshaked and authenticated, so it can take orders right away
+    void promoteSpare() {
+        LoggerSingleton::get().infra().warning("action=promote_spare exchange=bybit stream=trades");
+        {
+            std::lock_guard<std::mutex> lock(hdl_mutex);
+            routing_hdl = std::move(spare_hdl);
+            spare_hdl.reset();
         }
+        spare_ready = false;
+        m_wsState = true;
+        schedule_reconnect(false);
     }
 
-    void schedule_reconnect() {
-        LOG_INFRA_DEBUG("action=reconnecting exchange=bybit stream=trades");
-        connect_to_websocket();
+    // Rebuilds the active (or the spare) connection after a jittered exponential backoff delay
+    void schedule_reconnect(bool active) {
+        ReconnectBackoff& policy = active ? backoff : spare_backoff;
+        const auto delay = policy.nextDelay();
+        LoggerSingleton::get().infra().info("action=schedule_reconnect exchange=bybit stream=",
+                                            active ? "trades" : "trades_spare",
+                                            " attempt=",
+                                            policy.attempts(),
+                                            " delay_ms=",
+                                            delay.count());
+        routing_client.set_timer(delay.count(), [this, active](const websocketpp::lib::error_code& ec) {
+            if(ec || stopping) {
+                return;
+            }
+            LOG_INFRA_DEBUG("action=reconnecting exchange=bybit stream=trades");
+            if(active) {
+                setRoutingHandle(connect_to_websocket());
+            } else {
+                setSpareHandle(connect_to_websocket());
+            }
+        });
     }
 
-    void authenticate() {
+    void authenticate(connection_hdl hdl) {
         websocketpp::lib::error_code ec;
         long long timestamp = helper::get_current_timestamp_ms();
         uint64_t expires = (timestamp + 1000);
         std::string message = "GET/realtime" + std::to_string(expires);
         std::string signature = helper::generate_signature_bybit(api_secret, message);
         nlohmann::json auth_payload = {{"op", "auth"}, {"args", {api_key, expires, signature}}};
-        routing_client.send(routing_hdl, auth_payload.dump(), websocketpp::frame::opcode::text, ec);
+        routing_client.send(hdl, auth_payload.dump(), websocketpp::frame::opcode::text, ec);
+        if(ec) {
+            LoggerSingleton::get().infra().error("bybit auth send error: ", ec.message());
+        }
+    }
+
+    // The spare only authenticates; no order traffic is sent on it until it is promoted
+    void onSpareMessage(const std::string& message) {
+        json parsedJson = json::parse(message, nullptr, false);
+        if(parsedJson.is_discarded() || !parsedJson.contains("op") || parsedJson["op"] != "auth") {
+            return;
+        }
+        spare_ready = parsedJson.contains("retCode") && parsedJson["retCode"] == 0;
+        if(spare_ready) {
+            spare_backoff.reset();
+            LoggerSingleton::get().infra().info("action=spare_ready exchange=bybit stream=trades");
+        } else {
+            LoggerSingleton::get().infra().error("bybit spare auth fail");
+        }
+    }
+
+    bool isSpare(const connection_hdl& hdl) const {
+        const connection_hdl spare = spareHandle();
+        return !spare.expired() && !spare.owner_before(hdl) && !hdl.owner_before(spare);
+    }
+
+    // The handles are replaced on the io thread (reconnects, spare promotion) while the order and
+    // heartbeat threads send on them, so both are only read and written as copies under hdl_mutex
+    connection_hdl routingHandle() const {
+        std::lock_guard<std::mutex> lock(hdl_mutex);
+        return routing_hdl;
+    }
+
+    connection_hdl spareHandle() const {
+        std::lock_guard<std::mutex> lock(hdl_mutex);
+        return spare_hdl;
     }
 
-    bool isWebsocketReady() const { return this->m_wsState; }
+    bool isWebsocketReady() const { return m_wsState.load(std::memory_order_acquire); }
 
     bool send_heartbeat() {
         try {
             nlohmann::json ping_msg = {{"op", "ping"}};
             LOG_INFRA_DEBUG("bybit trades channel heartbeat: ping");
-            routing_client.send(routing_hdl, ping_msg.dump(), websocketpp::frame::opcode::text);
+            routing_client.send(routingHandle(), ping_msg.dump(), websocketpp::frame::opcode::text);
+            if(spare_ready) {
+                websocketpp::lib::error_code ec;
+                routing_client.send(spareHandle(), ping_msg.dump(), websocketpp::frame::opcode::text, ec);
+            }
             return true;
         } catch(const std::exception& e) {
             LoggerSingleton::get().infra().error("action=heartbeat exchage=bybit stream=trades result=fail reason=",
@@ -174,33 +271,33 @@ public:
             if(parsedJson.contains("retMsg") && parsedJson["retMsg"] == "OK") {
                 if(parsedJson.contains("op") && parsedJson["op"] == "auth") {
                     this->m_wsState = true;
+                    backoff.reset();
                 }
             }
         }
         orderUpdateCallback(message);
     }
 
+    // qty is in base currency, the payload carries contracts
     uint64_t sendOrder(double price,
                        double qty,
                        bool buy,
                        uint64_t reqId,
-                       std::string instrumentId,
+                       const mapping::InstrumentSpec& instrument,
                        std::string ordType = "limit",
                        std::string tdMode = "cross",
                        bool banAmend = true) {
+        const uint64_t encode_start = latency::now();
         uint64_t ret = helper::get_current_timestamp_ns();
         std::string clientOrderId1 = std::to_string(ret);
         std::string ts = std::to_string(helper::get_current_timestamp_ms());
         std::string side1 = buy ? "Buy" : "Sell";
-        if(instrumentId == "BTCUSDT")
-            qty = std::round(qty / (bybit::BTCUSDT::btcPerpCtVal) * 1e6) / 1e6;
-        else if(instrumentId == "DOGEUSDT")
-            qty = std::round(qty / (bybit::DOGEUSDT::dogePerpCtVal) * 1e6) / 1e6;
+        qty = instrument.toContracts(qty);
         nlohmann::json place_order_payload_nlohmann = {{"header", {{"X-BAPI-TIMESTAMP", ts}}},
                                                        {"reqId", std::to_string(reqId)},
                                                        {"op", "order.create"},
                                                        {"args",
-                                                        {{{"symbol", instrumentId},
+                                                        {{{"symbol", instrument.symbol},
                                                           {"side", side1},
                                                           {"orderLinkId", clientOrderId1},
                                                           {"qty", std::to_string(qty)},
@@ -213,11 +310,15 @@ public:
         }
         if(ordType == "post_only") {
             place_order_payload_nlohmann["args"][0]["timeInForce"] = "PostOnly";
+        } else if(ordType == "ioc") {
+            place_order_payload_nlohmann["args"][0]["timeInForce"] = "IOC";
         }
         std::string payload_str_nlohmann = place_order_payload_nlohmann.dump();
+        latency::record(latency::Metric::RouterEncode, latency::Venue::Bybit, encode_start);
         LoggerSingleton::get().plain().ws_request("new order payload: ", payload_str_nlohmann);
         try {
-            routing_client.send(routing_hdl, std::move(payload_str_nlohmann), websocketpp::frame::opcode::text);
+            routing_client.send(routingHandle(), std::move(payload_str_nlohmann), websocketpp::frame::opcode::text);
+            latency::record(latency::Metric::TickToTrade, latency::Venue::Bybit, latency::trigger());
         } catch(const websocketpp::exception& e) {
             LoggerSingleton::get().infra().error("websocket send error: ", e.what());
             return 0;
@@ -225,25 +326,26 @@ public:
         return ret;
     }
 
-    uint64_t modifyOrder(uint64_t orderId, double newQty, double newPrice, uint64_t reqId, std::string instrumentId) {
+    uint64_t modifyOrder(
+        uint64_t orderId, double newQty, double newPrice, uint64_t reqId, const mapping::InstrumentSpec& instrument) {
+        const uint64_t encode_start = latency::now();
         std::string ts = std::to_string(helper::get_current_timestamp_ms());
-        if(instrumentId == "BTCUSDT")
-            newQty = std::round(newQty / (bybit::BTCUSDT::btcPerpCtVal) * 1e6) / 1e6;
-        else if(instrumentId == "DOGEUSDT")
-            newQty = std::round(newQty / (bybit::DOGEUSDT::dogePerpCtVal) * 1e6) / 1e6;
+        newQty = instrument.toContracts(newQty);
         nlohmann::json modify_order_payload_nlohmann = {{"header", {{"X-BAPI-TIMESTAMP", ts}}},
                                                         {"reqId", std::to_string(reqId)},
                                                         {"op", "order.amend"},
                                                         {"args",
                                                          {{{"category", "linear"},
-                                                           {"symbol", instrumentId},
+                                                           {"symbol", instrument.symbol},
                                                            {"orderLinkId", std::to_string(orderId)},
                                                            {"qty", std::to_string(newQty)},
                                                            {"price", std::to_string(newPrice)}}}}};
         std::string payload_str_nlohmann = modify_order_payload_nlohmann.dump();
+        latency::record(latency::Metric::RouterEncode, latency::Venue::Bybit, encode_start);
         LoggerSingleton::get().plain().ws_request("modify order payload: ", payload_str_nlohmann);
         try {
-            routing_client.send(routing_hdl, std::move(payload_str_nlohmann), websocketpp::frame::opcode::text);
+            routing_client.send(routingHandle(), std::move(payload_str_nlohmann), websocketpp::frame::opcode::text);
+            latency::record(latency::Metric::TickToTrade, latency::Venue::Bybit, latency::trigger());
         } catch(const websocketpp::exception& e) {
             LoggerSingleton::get().infra().error("websocket send error: ", e.what());
             return 0;
@@ -251,17 +353,21 @@ public:
         return orderId;
     }
 
-    uint64_t sendCancelOrder(uint64_t clOrdId, uint64_t reqId, std::string instrumentId) {
+    uint64_t sendCancelOrder(uint64_t clOrdId, uint64_t reqId, const mapping::InstrumentSpec& instrument) {
+        const uint64_t encode_start = latency::now();
         std::string ts = std::to_string(helper::get_current_timestamp_ms());
         nlohmann::json cancel_order_payload_nlohmann = {
             {"header", {{"X-BAPI-TIMESTAMP", ts}}},
             {"reqId", std::to_string(reqId)},
             {"op", "order.cancel"},
-            {"args", {{{"category", "linear"}, {"symbol", instrumentId}, {"orderLinkId", std::to_string(clOrdId)}}}}};
+            {"args",
+             {{{"category", "linear"}, {"symbol", instrument.symbol}, {"orderLinkId", std::to_string(clOrdId)}}}}};
         std::string payload_str = cancel_order_payload_nlohmann.dump();
+        latency::record(latency::Metric::RouterEncode, latency::Venue::Bybit, encode_start);
         try {
             LoggerSingleton::get().plain().ws_request("cancel order payload: ", payload_str);
-            routing_client.send(routing_hdl, std::move(payload_str), websocketpp::frame::opcode::text);
+            routing_client.send(routingHandle(), std::move(payload_str), websocketpp::frame::opcode::text);
+            latency::record(latency::Metric::TickToTrade, latency::Venue::Bybit, latency::trigger());
         } catch(const websocketpp::exception& e) {
             LoggerSingleton::get().infra().error("websocket send error: ", e.what());
             return 0;
@@ -269,18 +375,59 @@ public:
         return clOrdId;
     }
 
+    // The frame sendCancelOrder would send, encoded ahead of time; sendFrame() refreshes its timestamp
+    static PrebuiltFrame buildCancelFrame(uint64_t clOrdId, uint64_t reqId, const mapping::InstrumentSpec& instrument) {
+        PrebuiltFrame frame;
+        frame.payload = R"({"reqId":")" + std::to_string(reqId) + R"(","header":{"X-BAPI-TIMESTAMP":")";
+        frame.timestampOffset = frame.payload.size();
+        frame.payload += std::to_string(helper::get_current_timestamp_ms());
+        frame.payload += R"("},"op":"order.cancel","args":[{"category":"linear","symbol":")" + instrument.symbol +
+                         R"(","orderLinkId":")" + std::to_string(clOrdId) + R"("}]})";
+        return frame;
+    }
+
+    // Sends a prebuilt frame stamped with the current time, from whichever thread decided to
+    bool sendFrame(PrebuiltFrame& frame) {
+        frame.stamp(helper::get_current_timestamp_ms());
+        try {
+            routing_client.send(routingHandle(), frame.payload, websocketpp::frame::opcode::text);
+            latency::record(latency::Metric::TickToTrade, latency::Venue::Bybit, latency::trigger());
+        } catch(const websocketpp::exception& e) {
+            LoggerSingleton::get().infra().error("websocket send error: ", e.what());
+            return false;
+        }
+        LoggerSingleton::get().plain().ws_request("prebuilt frame payload: ", frame.payload);
+        return true;
+    }
+
 private:
-    bool m_wsState = false;
+    void setRoutingHandle(connection_hdl hdl) {
+        std::lock_guard<std::mutex> lock(hdl_mutex);
+        routing_hdl = std::move(hdl);
+    }
+
+    void setSpareHandle(connection_hdl hdl) {
+        std::lock_guard<std::mutex> lock(hdl_mutex);
+        spare_hdl = std::move(hdl);
+    }
+
+    std::atomic<bool> m_wsState{false}; // read by the stale-quote guard on the reference md thread
     const uint32_t retry_limit = 0;
-    uint32_t reconnect_attempt = 0;
     std::string uri;
     std::string proxy_uri;
+    const ReconnectPolicy reconnect_policy;
+    ReconnectBackoff backoff;
+    ReconnectBackoff spare_backoff;
+    std::atomic<bool> spare_ready{false};
+    std::atomic<bool> stopping{false}; // set by stop() on the caller's thread, read by the io handlers
     rapidjson::StringBuffer buffer;
     rapidjson::Value argsArray;
     rapidjson::Value argsObject;
     OrderUpdateCallback orderUpdateCallback;
 
-    connection_hdl routing_hdl;
+    mutable std::mutex hdl_mutex;
+    connection_hdl routing_hdl; // guarded by hdl_mutex
+    connection_hdl spare_hdl;   // guarded by hdl_mutex
     client_tls routing_client;
 
     std::string connId = "";
@@ -9,11 +9,82 @@
 #include <cmath>
 #include <cstdint>
 #include <iomanip>
+#include <memory>
 #include <nlohmann/json.hpp>
+#include <optional>
 #include <sstream>
+#include <stdexcept>
 #include <string>
+#include <string_view>
 #include <type_traits>
-#include <unordered_map>
+#include <vector>
+
+// Append-only column stored in fixed-size chunks. Appending never moves existing rows and
+// allocates one chunk per ChunkRows rows, instead of a node or a reallocation per fill.
+template<typename T, size_t ChunkRows = 4096>
+class ChunkedColumn {
+public:
+    void push_back(const T& value) {
+        if(size_ == chunks_.size() * ChunkRows) {
+            chunks_.push_back(std::make_unique<T[]>(ChunkRows));
+        }
+        chunks_[size_ / ChunkRows][size_ % ChunkRows] = value;
+        ++size_;
+    }
+
+    // Allocates the chunks for rows up front, e.g. at startup before trading
+    void reserve(size_t rows) {
+        while(chunks_.size() * ChunkRows < rows) {
+            chunks_.push_back(std::make_unique<T[]>(ChunkRows));
+        }
+    }
+
+    [[nodiscard]] const T& operator[](size_t row) const { return chunks_[row / ChunkRows][row % ChunkRows]; }
+    T& operator[](size_t row) { return chunks_[row / ChunkRows][row % ChunkRows]; }
+
+    [[nodiscard]] size_t size() const { return size_; }
+
+    // Keeps the chunks for reuse
+    void clear() { size_ = 0; }
+
+private:
+    std::vector<std::unique_ptr<T[]>> chunks_;
+    size_t size_ = 0;
+};
+
+// Byte storage of variable-length ids such as exchange transaction ids; an id never spans chunks
+class ChunkedStringArena {
+public:
+    static constexpr size_t CHUNK_BYTES = 64 * 1024;
+
+    struct Ref {
+        uint64_t offset = 0;
+        uint32_t length = 0;
+    };
+
+    Ref append(std::string_view value) {
+        if(value.size() > CHUNK_BYTES) {
+            throw std::invalid_argument("id longer than the arena chunk: " + std::string(value.substr(0, 64)));
+        }
+        if(chunks_.empty() || used_ + value.size() > CHUNK_BYTES) {
+            chunks_.push_back(std::make_unique<char[]>(CHUNK_BYTES));
+            used_ = 0;
+        }
+        const Ref ref{.offset = (chunks_.size() - 1) * CHUNK_BYTES + used_,
+                      .length = static_cast<uint32_t>(value.size())};
+        std::copy(value.begin(), value.end(), chunks_.back().get() + used_);
+        used_ += value.size();
+        return ref;
+    }
+
+    [[nodiscard]] std::string_view view(Ref ref) const {
+        return {chunks_[ref.offset / CHUNK_BYTES].get() + ref.offset % CHUNK_BYTES, ref.length};
+    }
+
+private:
+    std::vector<std::unique_ptr<char[]>> chunks_;
+    size_t used_ = 0;
+};
 
 struct OrderTrace {
     using ClientOrderId = uint64_t;
@@ -54,20 +125,164 @@ struct OrderTrace {
     }
 };
 
+// Input row of HedgeGroupAnalysis::add_trade. The transaction id is copied into the store, so it
+// only has to outlive the call.
+struct Trade {
+    using ClientOrderId = uint64_t;
+    using TransactionId = std::string_view;
+    using Price = double;
+    using Quantity = double;
+    using Fee = double;
+    using TimePoint = uint64_t;
+    using Json = nlohmann::json;
+
+    ClientOrderId client_order_id;
+    TransactionId transaction_id;
+    Price price;
+    Quantity quantity;
+    Fee fee;
+    bool side; // true for buy, false for sell
+    bool is_maker;
+    VenueRole venue_role;
+    TimePoint exchange_fill_time;
+    TimePoint infra_notified_time;
+    TimePoint strategy_notified_time;
+
+    [[nodiscard]]
+    Json to_json() const {
+        Json j;
+        j["transaction_id"] = std::string(transaction_id);
+        j["price"] = price;
+        j["quantity"] = quantity;
+        j["fee"] = fee;
+        j["side"] = side ? "buy" : "sell";
+        j["liquidity_role"] = is_maker ? "maker" : "taker";
+        j["venue_role"] = venue_role_to_string(venue_role);
+        j["exchange_fill_time"] = format_ns_iso8601(exchange_fill_time);
+        j["infra_notified_time"] = format_ns_iso8601(infra_notified_time);
+        j["strategy_notified_time"] = format_ns_iso8601(strategy_notified_time);
+        return j;
+    }
+};
+
+// Struct-of-arrays store of every fill and order trace of the session, rows are never removed.
+// Rows of one hedge group are contiguous, groups refer to them by first row and count.
+class HedgeTraceStore {
+public:
+    using ClientOrderId = uint64_t;
+
+    size_t append_trade(const Trade& trade) {
+        trade_client_order_id_.push_back(trade.client_order_id);
+        trade_transaction_id_.push_back(transaction_ids_.append(trade.transaction_id));
+        trade_price_.push_back(trade.price);
+        trade_quantity_.push_back(trade.quantity);
+        trade_fee_.push_back(trade.fee);
+        trade_side_.push_back(trade.side);
+        trade_is_maker_.push_back(trade.is_maker);
+        trade_venue_role_.push_back(trade.venue_role);
+        trade_exchange_fill_time_.push_back(trade.exchange_fill_time);
+        trade_infra_notified_time_.push_back(trade.infra_notified_time);
+        trade_strategy_notified_time_.push_back(trade.strategy_notified_time);
+        return trade_price_.size() - 1;
+    }
+
+    size_t append_order(const OrderTrace& order) {
+        order_client_order_id_.push_back(order.client_order_id);
+        order_exchange_order_id_.push_back(order.exchange_order_id);
+        order_side_.push_back(order.side);
+        order_quantity_.push_back(order.quantity);
+        order_venue_role_.push_back(order.venue_role);
+        order_send_time_oms_.push_back(order.send_time_oms);
+        order_live_time_exchange_.push_back(order.live_time_exchange);
+        order_cancel_time_oms_.push_back(order.cancel_time_oms);
+        order_modify_time_oms_.push_back(order.modify_time_oms);
+        return order_client_order_id_.size() - 1;
+    }
+
+    // Row of client_order_id among the order rows from first_row on, a hedge group has a handful
+    [[nodiscard]] std::optional<size_t> find_order(ClientOrderId client_order_id, size_t first_row) const {
+        for(size_t row = first_row; row < order_count(); ++row) {
+            if(order_client_order_id_[row] == client_order_id) {
+                return row;
+            }
+        }
+        return std::nullopt;
+    }
+
+    [[nodiscard]] size_t trade_count() const { return trade_price_.size(); }
+    [[nodiscard]] size_t order_count() const { return order_client_order_id_.size(); }
+
+    [[nodiscard]] ClientOrderId trade_client_order_id(size_t row) const { return trade_client_order_id_[row]; }
+    [[nodiscard]] double trade_quantity(size_t row) const { return trade_quantity_[row]; }
+
+    [[nodiscard]] Trade trade(size_t row) const {
+        return Trade{.client_order_id = trade_client_order_id_[row],
+                     .transaction_id = transaction_ids_.view(trade_transaction_id_[row]),
+                     .price = trade_price_[row],
+                     .quantity = trade_quantity_[row],
+                     .fee = trade_fee_[row],
+                     .side = trade_side_[row],
+                     .is_maker = trade_is_maker_[row],
+                     .venue_role = trade_venue_role_[row],
+                     .exchange_fill_time = trade_exchange_fill_time_[row],
+                     .infra_notified_time = trade_infra_notified_time_[row],
+                     .strategy_notified_time = trade_strategy_notified_time_[row]};
+    }
+
+    [[nodiscard]] OrderTrace order(size_t row) const {
+        return OrderTrace{.client_order_id = order_client_order_id_[row],
+                          .exchange_order_id = order_exchange_order_id_[row],
+                          .side = order_side_[row],
+                          .quantity = order_quantity_[row],
+                          .venue_role = order_venue_role_[row],
+                          .send_time_oms = order_send_time_oms_[row],
+                          .live_time_exchange = order_live_time_exchange_[row],
+                          .cancel_time_oms = order_cancel_time_oms_[row],
+                          .modify_time_oms = order_modify_time_oms_[row]};
+    }
+
+private:
+    // Trades
+    ChunkedColumn<ClientOrderId> trade_client_order_id_;
+    ChunkedColumn<ChunkedStringArena::Ref> trade_transaction_id_;
+    ChunkedColumn<double> trade_price_;
+    ChunkedColumn<double> trade_quantity_;
+    ChunkedColumn<double> trade_fee_;
+    ChunkedColumn<bool> trade_side_;
+    ChunkedColumn<bool> trade_is_maker_;
+    ChunkedColumn<VenueRole> trade_venue_role_;
+    ChunkedColumn<uint64_t> trade_exchange_fill_time_;
+    ChunkedColumn<uint64_t> trade_infra_notified_time_;
+    ChunkedColumn<uint64_t> trade_strategy_notified_time_;
+    ChunkedStringArena transaction_ids_;
+    // Order traces
+    ChunkedColumn<ClientOrderId> order_client_order_id_;
+    ChunkedColumn<uint64_t> order_exchange_order_id_;
+    ChunkedColumn<bool> order_side_;
+    ChunkedColumn<double> order_quantity_;
+    ChunkedColumn<VenueRole> order_venue_role_;
+    ChunkedColumn<uint64_t> order_send_time_oms_;
+    ChunkedColumn<uint64_t> order_live_time_exchange_;
+    ChunkedColumn<uint64_t> order_cancel_time_oms_;
+    ChunkedColumn<uint64_t> order_modify_time_oms_;
+};
+
 class OrderTraceManager {
 public:
     using ClientOrderId = OrderTrace::ClientOrderId;
 
-    explicit OrderTraceManager(ByBitOrderManager& bybit_mgr, OkxOrderManager& okx_mgr)
+    explicit OrderTraceManager(ByBitOrderManager& bybit_mgr, OkxOrderManager& okx_mgr, HedgeTraceStore& store)
         : bybit_order_manager_{bybit_mgr}
-        , okx_order_manager_{okx_mgr} {}
+        , okx_order_manager_{okx_mgr}
+        , store_{store} {}
 
     OrderTraceManager(const OrderTraceManager&) = delete;
     OrderTraceManager& operator=(const OrderTraceManager&) = delete;
 
+    // Snapshots the order once per hedge group, the group's order rows start at first_row
     template<Exchange E>
-    void add_order_trace(ClientOrderId client_order_id) {
-        if(has_order_trace(client_order_id)) {
+    void add_order_trace(ClientOrderId client_order_id, size_t first_row) {
+        if(store_.find_order(client_order_id, first_row)) {
             return;
         }
 
@@ -85,34 +300,18 @@ public:
             throw std::runtime_error("Unhandled Exchange type");
         }
 
-        order_traces_.emplace(order->m_clientOrderId,
-                              OrderTrace{.client_order_id = order->m_clientOrderId,
-                                         .exchange_order_id = order->m_exchangeOrderId,
-                                         .side = order->m_side,
-                                         .quantity = order->m_qtySubmitted,
-                                         .venue_role = venue_role,
-                                         .send_time_oms = order->m_newOrderOnOmsTS,
-                                         .live_time_exchange = order->m_newOrderOnExchTS,
-                                         .cancel_time_oms = order->m_cancelOrderOnOmsTS,
-                                         .modify_time_oms = order->m_modifyOrderOnOmsTS});
-    }
-
-    [[nodiscard]] const OrderTrace& get_order_trace(ClientOrderId client_order_id) const {
-        try {
-            return order_traces_.at(client_order_id);
-        } catch(const std::out_of_range&) {
-            throw std::out_of_range("No order trace found for client_order_id: " + std::to_string(client_order_id));
-        }
+        store_.append_order(OrderTrace{.client_order_id = order->m_clientOrderId,
+                                       .exchange_order_id = order->m_exchangeOrderId,
+                                       .side = order->m_side,
+                                       .quantity = order->m_qtySubmitted,
+                                       .venue_role = venue_role,
+                                       .send_time_oms = order->m_newOrderOnOmsTS,
+                                       .live_time_exchange = order->m_newOrderOnExchTS,
+                                       .cancel_time_oms = order->m_cancelOrderOnOmsTS,
+                                       .modify_time_oms = order->m_modifyOrderOnOmsTS});
     }
 
-    void reset() { order_traces_.clear(); }
-
 private:
-    [[nodiscard]]
-    bool has_order_trace(ClientOrderId client_order_id) const {
-        return order_traces_.find(client_order_id) != order_traces_.end();
-    }
-
     template<Exchange E>
     static constexpr bool always_false() {
         return false;
@@ -131,47 +330,39 @@ private:
 
     ByBitOrderManager& bybit_order_manager_;
     OkxOrderManager& okx_order_manager_;
-    std::unordered_map<ClientOrderId, OrderTrace> order_traces_;
+    HedgeTraceStore& store_;
 };
 
-struct Trade {
-    using ClientOrderId = uint64_t;
-    using TransactionId = std::string;
-    using Price = double;
-    using Quantity = double;
-    using Fee = double;
+// Metrics of one closed hedge group, computed while its fills arrive
+struct HedgeGroupSummary {
     using TimePoint = uint64_t;
-    using Json = nlohmann::json;
 
-    ClientOrderId client_order_id;
-    TransactionId transaction_id;
-    Price price;
-    Quantity quantity;
-    Fee fee;
-    bool side; // true for buy, false for sell
-    bool is_maker;
-    VenueRole venue_role;
-    TimePoint exchange_fill_time;
-    TimePoint infra_notified_time;
-    TimePoint strategy_notified_time;
-
-    [[nodiscard]]
-    Json to_json() const {
-        Json j;
-        j["transaction_id"] = transaction_id;
-        j["price"] = price;
-        j["quantity"] = quantity;
-        j["fee"] = fee;
-        j["side"] = side ? "buy" : "sell";
-        j["liquidity_role"] = is_maker ? "maker" : "taker";
-        j["venue_role"] = venue_role_to_string(venue_role);
-        j["exchange_fill_time"] = format_ns_iso8601(exchange_fill_time);
-        j["infra_notified_time"] = format_ns_iso8601(infra_notified_time);
-        j["strategy_notified_time"] = format_ns_iso8601(strategy_notified_time);
-        return j;
+    uint64_t sequence = 0; // 1-based net-zero count when the group closed
+    TimePoint start_time = 0;
+    TimePoint close_time = 0;
+    size_t first_trade = 0;
+    size_t trade_count = 0;
+    size_t first_order = 0;
+    size_t order_count = 0;
+    double quote_quantity = 0.0;
+    double hedge_quantity = 0.0;
+    double pnl_without_fee = 0.0;
+    double maker_fee = 0.0;
+    double taker_fee = 0.0;
+
+    [[nodiscard]] double total_fee() const { return maker_fee + taker_fee; }
+    [[nodiscard]] double pnl_with_fee() const { return pnl_without_fee - total_fee(); }
+    [[nodiscard]] std::string id() const {
+        return "hg_" + std::to_string(start_time) + "_" + std::to_string(sequence);
     }
 };
 
+// Groups fills of the quote and hedge legs until the net position is back to zero. On the strategy
+// thread a fill only appends columns and updates running sums; closing a group appends a summary
+// and logs its scalar metrics. The full JSON with orders and fills is rendered on request by
+// export_groups()/log_pending_groups(), which must run on the strategy thread as well, e.g. from
+// a timer of its event loop. Groups no such call logged are logged when the analysis is destroyed
+// at shutdown, so every closed group gets its hedge_group_analysis line.
 class HedgeGroupAnalysis {
 public:
     using Quantity = double;
@@ -181,7 +372,9 @@ public:
 
     explicit HedgeGroupAnalysis(Quantity min_hedge_size, ByBitOrderManager& bybit_mgr, OkxOrderManager& okx_mgr)
         : min_hedge_size_{min_hedge_size}
-        , order_trace_manager_{bybit_mgr, okx_mgr} {}
+        , order_trace_manager_{bybit_mgr, okx_mgr, store_} {}
+
+    ~HedgeGroupAnalysis() { log_pending_groups(); }
 
     template<Exchange E>
     void add_trade(const Trade& trade) {
@@ -189,161 +382,175 @@ public:
             start_time_ = trade.exchange_fill_time;
         }
 
-        const auto& client_order_id = trade.client_order_id;
-        order_trace_manager_.add_order_trace<E>(client_order_id);
-        trades_.emplace_back(trade);
+        order_trace_manager_.add_order_trace<E>(trade.client_order_id, open_.first_order);
+        store_.append_trade(trade);
 
         update_position<E>(trade);
         update_pnl(trade);
         update_fee(trade);
 
         if(is_net_zero()) {
-            close_time_ = trade.exchange_fill_time;
-            update_win_count();
-            log();
-            reset();
+            close_group(trade.exchange_fill_time);
+        }
+    }
+
+    [[nodiscard]] size_t closed_group_count() const { return groups_.size(); }
+    [[nodiscard]] const HedgeGroupSummary& group(size_t index) const { return groups_[index]; }
+    [[nodiscard]] int win_count() const { return win_count_; }
+    [[nodiscard]] double win_rate() const {
+        return net_zero_count_ > 0 ? static_cast<double>(win_count_) / net_zero_count_ : 0.0;
+    }
+
+    // Full record of one closed group, in the format the per-group log line always had
+    [[nodiscard]] Json group_to_json(size_t index) const {
+        const HedgeGroupSummary& summary = groups_[index];
+        Json json_output;
+
+        // Basic information
+        json_output["id"] = summary.id();
+        json_output["net_zero_count"] = summary.sequence;
+        json_output["start_time"] = format_ns_iso8601(summary.start_time);
+        json_output["close_time"] = format_ns_iso8601(summary.close_time);
+
+        // Calculate duration in microseconds
+        auto diff_ns = summary.close_time - summary.start_time;
+        auto duration_us = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::nanoseconds(diff_ns));
+        json_output["duration_us"] = duration_us.count();
+
+        // PnL information
+        auto& pnl_json = json_output["pnl"] = Json::object();
+        pnl_json["pnl_without_fee"] = summary.pnl_without_fee;
+        pnl_json["pnl_with_fee"] = summary.pnl_with_fee();
+        pnl_json["maker_fee"] = summary.maker_fee;
+        pnl_json["taker_fee"] = summary.taker_fee;
+        pnl_json["total_fee"] = summary.total_fee();
+
+        // Position information
+        auto& position_json = json_output["position"] = Json::object();
+        position_json["quote_quantity"] = summary.quote_quantity;
+        position_json["hedge_quantity"] = summary.hedge_quantity;
+
+        // Orders of the group with their fills
+        auto& orders_json = json_output["orders"] = Json::object();
+        const size_t last_trade = summary.first_trade + summary.trade_count;
+        for(size_t order_row = summary.first_order; order_row < summary.first_order + summary.order_count;
+            ++order_row) {
+            const OrderTrace trace = store_.order(order_row);
+            Json order_json = trace.to_json();
+            Json fills = Json::array();
+            double filled_quantity = 0.0;
+            for(size_t trade_row = summary.first_trade; trade_row < last_trade; ++trade_row) {
+                if(store_.trade_client_order_id(trade_row) == trace.client_order_id) {
+                    filled_quantity += store_.trade_quantity(trade_row);
+                    fills.push_back(store_.trade(trade_row).to_json());
+                }
+            }
+            order_json["filled_quantity"] = filled_quantity;
+            order_json["fills"] = std::move(fills);
+            orders_json[std::to_string(trace.client_order_id)] = std::move(order_json);
         }
+        return json_output;
+    }
+
+    // Closed groups from index first on, as a JSON array
+    [[nodiscard]] Json export_groups(size_t first = 0) const {
+        Json groups = Json::array();
+        for(size_t index = first; index < groups_.size(); ++index) {
+            groups.push_back(group_to_json(index));
+        }
+        return groups;
+    }
+
+    // Logs the full record of every group closed since the previous call, returns how many
+    size_t log_pending_groups() {
+        const size_t pending = groups_.size() - logged_groups_;
+        for(; logged_groups_ < groups_.size(); ++logged_groups_) {
+            log_action_pass("hedge_group_analysis", group_to_json(logged_groups_).dump());
+        }
+        return pending;
     }
 
 private:
-    std::string generate_id() {
-        return "hg_" + std::to_string(std::chrono::system_clock::now().time_since_epoch().count()) + "_" +
-               std::to_string(++net_zero_count_);
+    // Rows and running sums of the group still open
+    struct OpenGroup {
+        size_t first_trade = 0;
+        size_t first_order = 0;
+        Quantity quote_quantity = 0.0;
+        Quantity hedge_quantity = 0.0;
+        double pnl_without_fee = 0.0;
+        double maker_fee = 0.0;
+        double taker_fee = 0.0;
+    };
+
+    void close_group(TimePoint close_time) {
+        ++net_zero_count_;
+        const HedgeGroupSummary summary{.sequence = static_cast<uint64_t>(net_zero_count_),
+                                        .start_time = *start_time_,
+                                        .close_time = close_time,
+                                        .first_trade = open_.first_trade,
+                                        .trade_count = store_.trade_count() - open_.first_trade,
+                                        .first_order = open_.first_order,
+                                        .order_count = store_.order_count() - open_.first_order,
+                                        .quote_quantity = open_.quote_quantity,
+                                        .hedge_quantity = open_.hedge_quantity,
+                                        .pnl_without_fee = open_.pnl_without_fee,
+                                        .maker_fee = open_.maker_fee,
+                                        .taker_fee = open_.taker_fee};
+        groups_.push_back(summary);
+        if(summary.pnl_with_fee() > 0) {
+            win_count_++;
+        }
+        log_action_pass("hedge_group_closed",
+                        f("id", summary.sequence),
+                        f("trades", summary.trade_count),
+                        f("orders", summary.order_count),
+                        f("duration_ns", summary.close_time - summary.start_time),
+                        f("pnl_with_fee", summary.pnl_with_fee()),
+                        f("total_fee", summary.total_fee()),
+                        f("win_rate", win_rate()));
+        reset();
     }
 
     void reset() {
-        id_ = generate_id();
         start_time_ = std::nullopt;
-        quote_quantity_ = 0.0;
-        hedge_quantity_ = 0.0;
-        pnl_without_fee_ = 0.0;
-        make_fee_ = 0.0;
-        take_fee_ = 0.0;
-        order_trace_manager_.reset();
-        trades_.clear();
+        open_ = OpenGroup{.first_trade = store_.trade_count(), .first_order = store_.order_count()};
     }
 
-    bool is_net_zero() const { return std::abs(quote_quantity_ + hedge_quantity_) < min_hedge_size_; }
+    bool is_net_zero() const { return std::abs(open_.quote_quantity + open_.hedge_quantity) < min_hedge_size_; }
 
     template<Exchange E>
     void update_position(const Trade& trade) {
         if constexpr(E == Exchange::Bybit) {
-            quote_quantity_ += (trade.side ? trade.quantity : -trade.quantity);
+            open_.quote_quantity += (trade.side ? trade.quantity : -trade.quantity);
         } else if constexpr(E == Exchange::Okx) {
-            quote_quantity_ += (trade.side ? trade.quantity : -trade.quantity);
+            open_.hedge_quantity += (trade.side ? trade.quantity : -trade.quantity);
         }
     }
 
     void update_pnl(const Trade& trade) {
         if(trade.side) {
-            pnl_without_fee_ -= trade.price * trade.quantity;
+            open_.pnl_without_fee -= trade.price * trade.quantity;
         } else {
-            pnl_without_fee_ += trade.price * trade.quantity;
+            open_.pnl_without_fee += trade.price * trade.quantity;
         }
     }
 
     void update_fee(const Trade& trade) {
         if(trade.is_maker) {
-            make_fee_ += trade.fee;
+            open_.maker_fee += trade.fee;
         } else {
-            take_fee_ += trade.fee;
-        }
-    }
-
-    double get_pnl_without_fee() const { return pnl_without_fee_; }
-    double get_pnl_with_fee() const { return get_pnl_without_fee() - get_totol_fee(); }
-    double get_totol_fee() const { return make_fee_ + take_fee_; }
-    double get_maker_fee() const { return make_fee_; }
-    double get_taker_fee() const { return take_fee_; }
-
-    void update_win_count() {
-        if(get_pnl_with_fee() > 0) {
-            win_count_++;
-        }
-    }
-
-    void log() const {
-        if(!start_time_) {
-            return;
-        }
-
-        Json json_output;
-
-        // Basic information
-        json_output["id"] = id_;
-        json_output["net_zero_count"] = net_zero_count_;
-        json_output["win_count"] = win_count_;
-        json_output["win_rate"] = static_cast<double>(win_count_) / net_zero_count_;
-        json_output["start_time"] = format_ns_iso8601(*start_time_);
-        json_output["close_time"] = format_ns_iso8601(close_time_);
-
-        // Calculate duration in microseconds
-        auto diff_ns = close_time_ - *start_time_;
-        auto duration_us = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::nanoseconds(diff_ns));
-        json_output["duration_us"] = duration_us.count();
-
-        // PnL information
-        auto& pnl_json = json_output["pnl"] = Json::object();
-        pnl_json["pnl_without_fee"] = get_pnl_without_fee();
-        pnl_json["pnl_with_fee"] = get_pnl_with_fee();
-        pnl_json["maker_fee"] = get_maker_fee();
-        pnl_json["taker_fee"] = get_taker_fee();
-        pnl_json["total_fee"] = get_totol_fee();
-
-        // Position information
-        auto& position_json = json_output["position"] = Json::object();
-        position_json["quote_quantity"] = quote_quantity_;
-        position_json["hedge_quantity"] = hedge_quantity_;
-
-        // Organize trades by order
-        std::unordered_map<ClientOrderId, Json> id_to_trace;
-        std::unordered_map<ClientOrderId, std::vector<Json>> id_to_trades;
-
-        // First, collect all fills by order
-        for(const auto& trade : trades_) {
-            if(id_to_trace.find(trade.client_order_id) == id_to_trace.end()) {
-                id_to_trace[trade.client_order_id] =
-                    order_trace_manager_.get_order_trace(trade.client_order_id).to_json();
-            }
-
-            id_to_trades[trade.client_order_id].push_back(trade.to_json());
+            open_.taker_fee += trade.fee;
         }
-
-        // Now build the orders section with fills
-        auto& orders_json = json_output["orders"] = Json::object();
-        for(const auto& [id, trace] : id_to_trace) {
-            Json order_json = trace;
-
-            // Calculate filled quantity for this order
-            double filled_quantity = 0.0;
-            for(const auto& trade : id_to_trades[id]) {
-                filled_quantity += trade["quantity"].get<double>();
-            }
-            order_json["filled_quantity"] = filled_quantity;
-
-            // Add fills
-            order_json["fills"] = id_to_trades[id];
-
-            orders_json[std::to_string(id)] = order_json;
-        }
-        json_output["orders"] = orders_json;
-
-        log_action_pass("hedge_group_analysis", json_output.dump());
     }
 
     const Quantity min_hedge_size_;
     int net_zero_count_{0};
     int win_count_{0};
-    std::string id_{generate_id()};
     std::optional<TimePoint> start_time_;
-    TimePoint close_time_{};
-
-    Quantity quote_quantity_{0.0};
-    Quantity hedge_quantity_{0.0};
-    double pnl_without_fee_{0.0};
-    double make_fee_{0.0};
-    double take_fee_{0.0};
+    OpenGroup open_;
 
+    HedgeTraceStore store_;
     OrderTraceManager order_trace_manager_;
-    std::vector<Trade> trades_;
+    ChunkedColumn<HedgeGroupSummary, 1024> groups_;
+    size_t logged_groups_ = 0;
 };
@@ -1,8 +1,8 @@
 #pragma once
 
 #include "../utils/connections.hpp"
+#include "../utils/instrumentregistry.hpp"
 #include "../utils/logger.hpp"
-#include "../utils/staticparams.hpp"
 #include "exchangeclient.hpp"
 #include <chrono>
 #include <curl/curl.h>
@@ -59,11 +59,9 @@ public:
             double positionVal = jsonResponse["data"][0].value("pos", "").empty()
                                      ? 0.0
                                      : std::stod(jsonResponse["data"][0]["pos"].get<std::string>());
-            std::string_view instId = jsonResponse["data"][0]["instId"].get<std::string>();
-            if(instId == "DOGE-USDT-SWAP") {
-                positionVal = positionVal * (okx::DOGE_USDT_SWAP::dogePerpCtVal) * (okx::DOGE_USDT_SWAP::dogePerpCtMul);
-            } else if(instId == "BTC-USDT-SWAP") {
-                positionVal = positionVal * (okx::BTC_USDT_SWAP::btcPerpCtMul) * (okx::BTC_USDT_SWAP::btcPerpCtVal);
+            const std::string instId = jsonResponse["data"][0]["instId"].get<std::string>();
+            if(const auto* spec = mapping::InstrumentRegistry::instance().findBySymbol("okx", instId)) {
+                positionVal = spec->toBaseQty(positionVal);
             }
             return {true, positionVal};
         } catch(const nlohmann::json::exception& e) {
@@ -2,11 +2,13 @@
 
 #include "../src/Side.h"
 #include "../utils/helper.hpp"
+#include "../utils/latency.hpp"
 #include "../utils/logger.hpp"
 #include "okxclient.hpp"
 #include "okxordersrouting.hpp"
 #include "okxpositionmanager.hpp"
 #include "orderhandler.hpp"
+#include "outstandingqty.hpp"
 #include <functional>
 #include <memory>
 #include <mutex>
@@ -26,10 +28,12 @@ public:
                              const std::string api_secret,
                              const std::string api_passphrase,
                              const std::string instrument,
-                             OkxPositionManager& manager)
+                             OkxPositionManager& manager,
+                             const ReconnectPolicy& reconnect_policy = {})
         : m_trackOrderCnt(track_order_cnt)
         , m_positionManager(manager)
         , m_instrument(instrument)
+        , m_baseQtyPerContract(baseQtyPerContract(instrument))
         , retry_limit(retry_limit)
         , m_client(trading_mode, api_key, api_secret, api_passphrase) {
         okxOrderRouter =
@@ -40,7 +44,8 @@ public:
                                              api_secret,
                                              api_passphrase,
                                              m_instrument,
-                                             [this](std::string message) { this->updateOrderStatus(message); });
+                                             [this](std::string message) { this->updateOrderStatus(message); },
+                                             reconnect_policy);
     }
     void run() { okxOrderRouter->setupRoutingConnection(); }
 
@@ -88,6 +93,7 @@ public:
             uint64_t clOrderId = cancelQueue.front();
             auto it = orderMap.find(clOrderId);
             if(it != orderMap.end()) {
+                outstandingQty.release(*it->second);
                 orderMap.erase(clOrderId);
             }
             cancelQueue.pop();
@@ -97,6 +103,7 @@ public:
             uint64_t clOrderId = rejectedQueue.front();
             auto it = orderMap.find(clOrderId);
             if(it != orderMap.end()) {
+                outstandingQty.release(*it->second);
                 orderMap.erase(clOrderId);
             }
             rejectedQueue.pop();
@@ -106,6 +113,7 @@ public:
             uint64_t clOrderId = filledQueue.front();
             auto it = orderMap.find(clOrderId);
             if(it != orderMap.end()) {
+                outstandingQty.release(*it->second);
                 orderMap.erase(clOrderId);
             }
             filledQueue.pop();
@@ -136,6 +144,9 @@ public:
         return res;
     }
 
+    // Quantity of pending, live and partially filled orders on one side, O(1)
+    [[nodiscard]] double getOutstandingQty(bool buy) const noexcept { return outstandingQty.get(buy); }
+
     uint64_t placeOrder(const std::string& instrumentId,
                         double price,
                         double qty,
@@ -143,19 +154,31 @@ public:
                         const std::string& ordType = "limit",
                         const std::string& tdMode = "cross",
                         bool banAmend = true) {
+        return placeOrder(
+            mapping::InstrumentRegistry::instance().id(instrumentId), price, qty, buy, ordType, tdMode, banAmend);
+    }
+
+    // Hot path: the instrument is resolved by id, without string lookups
+    uint64_t placeOrder(mapping::InstrumentId instrumentId,
+                        double price,
+                        double qty,
+                        bool buy,
+                        const std::string& ordType = "limit",
+                        const std::string& tdMode = "cross",
+                        bool banAmend = true) {
         // std::lock_guard<std::mutex> lock(m_mutex);
-        std::shared_ptr<OrderHandler> orderHandler = createOrderHandler(instrumentId);
+        const mapping::InstrumentSpec* inst = mapping::InstrumentRegistry::instance().find(instrumentId);
+        std::shared_ptr<OrderHandler> orderHandler = createOrderHandler(inst ? inst->name : "");
         orderHandler->m_newOrderOnOmsTS = helper::get_current_timestamp_ns();
-        mapping::InstrumentInfo inst = mapping::getInstrumentInfo(instrumentId);
-        if(!isWebSocketReady()) {
+        if(!inst || !isWebSocketReady()) {
             orderHandler->m_status = OrderStatus::REJECTED;
-            orderHandler->m_reason = RejectReason::WS_FAILURE;
+            orderHandler->m_reason = inst ? RejectReason::WS_FAILURE : RejectReason::INVALID_INSTRUMENT;
             if(orderStatusUpdateCallback) {
                 orderStatusUpdateCallback(*orderHandler);
             }
             return 0;
         }
-        uint64_t clientOrderId = okxOrderRouter->sendOrder(price, qty, buy, inst.instrument, ordType, tdMode, banAmend);
+        uint64_t clientOrderId = okxOrderRouter->sendOrder(price, qty, buy, *inst, ordType, tdMode, banAmend);
         if(clientOrderId != 0) {
             orderHandler->m_clientOrderId = clientOrderId;
             orderHandler->m_status = OrderStatus::PENDING;
@@ -163,6 +186,7 @@ public:
             orderHandler->m_side = buy;
             orderHandler->m_qtySubmitted = qty;
             orderHandler->m_priceSubmitted = price;
+            outstandingQty.sync(*orderHandler);
             orderMap.emplace(clientOrderId, std::move(orderHandler));
         } else {
             // Handle failure if necessary
@@ -180,28 +204,34 @@ public:
 
     // Cancel an existing order by orderId
     uint64_t cancelOrder(uint64_t clientOrderId, const std::string& m_instrument) {
+        return cancelOrder(clientOrderId, mapping::InstrumentRegistry::instance().id(m_instrument));
+    }
+
+    uint64_t cancelOrder(uint64_t clientOrderId, mapping::InstrumentId instrumentId) {
         // std::lock_guard<std::mutex> lock(m_mutex);
+        const mapping::InstrumentSpec* inst = mapping::InstrumentRegistry::instance().find(instrumentId);
         auto orderHandlerIterator = orderMap.find(clientOrderId);
         if(orderHandlerIterator == orderMap.end()) {
-            std::shared_ptr<OrderHandler> newOrderHandler = createOrderHandler(m_instrument);
+            std::shared_ptr<OrderHandler> newOrderHandler = createOrderHandler(inst ? inst->name : "");
             auto [iterator, inserted] = orderMap.emplace(clientOrderId, std::move(newOrderHandler));
             orderHandlerIterator = iterator;
         }
         auto& orderHandler = orderHandlerIterator->second;
-        if(!isWebSocketReady()) {
+        if(!inst || !isWebSocketReady()) {
             orderHandler->m_status = OrderStatus::REJECTED;
-            orderHandler->m_reason = RejectReason::WS_FAILURE;
+            orderHandler->m_reason = inst ? RejectReason::WS_FAILURE : RejectReason::INVALID_INSTRUMENT;
+            outstandingQty.sync(*orderHandler);
             if(orderStatusUpdateCallback) {
                 orderStatusUpdateCallback(*orderHandler);
             }
             return clientOrderId;
         }
         orderHandler->m_cancelOrderOnOmsTS = helper::get_current_timestamp_ns();
-        mapping::InstrumentInfo inst = mapping::getInstrumentInfo(m_instrument);
-        uint64_t ret = okxOrderRouter->sendCancelOrder(clientOrderId, inst.instrument);
+        uint64_t ret = okxOrderRouter->sendCancelOrder(clientOrderId, *inst);
         if(ret == 0) {
             orderHandler->m_status = OrderStatus::REJECTED;
             orderHandler->m_reason = RejectReason::WS_FAILURE;
+            outstandingQty.sync(*orderHandler);
             if(orderStatusUpdateCallback) {
                 orderStatusUpdateCallback(*orderHandler);
             }
@@ -222,18 +252,24 @@ public:
     }
 
     // Modify an existing order
-    uint64_t modifyOrder(uint64_t clientOrderId, double newPrice, double newQty, std::string m_instrument) {
+    uint64_t modifyOrder(uint64_t clientOrderId, double newPrice, double newQty, const std::string& m_instrument) {
+        return modifyOrder(clientOrderId, newPrice, newQty, mapping::InstrumentRegistry::instance().id(m_instrument));
+    }
+
+    uint64_t modifyOrder(uint64_t clientOrderId, double newPrice, double newQty, mapping::InstrumentId instrumentId) {
         // std::lock_guard<std::mutex> lock(m_mutex);
+        const mapping::InstrumentSpec* inst = mapping::InstrumentRegistry::instance().find(instrumentId);
         auto orderHandlerIterator = orderMap.find(clientOrderId);
         if(orderHandlerIterator == orderMap.end()) {
-            std::shared_ptr<OrderHandler> newOrderHandler = createOrderHandler(m_instrument);
+            std::shared_ptr<OrderHandler> newOrderHandler = createOrderHandler(inst ? inst->name : "");
             auto [iterator, inserted] = orderMap.emplace(clientOrderId, std::move(newOrderHandler));
             orderHandlerIterator = iterator;
         }
         auto& orderHandler = orderHandlerIterator->second;
-        if(!isWebSocketReady()) {
+        if(!inst || !isWebSocketReady()) {
             orderHandler->m_status = OrderStatus::REJECTED;
-            orderHandler->m_reason = RejectReason::WS_FAILURE;
+            orderHandler->m_reason = inst ? RejectReason::WS_FAILURE : RejectReason::INVALID_INSTRUMENT;
+            outstandingQty.sync(*orderHandler);
             if(orderStatusUpdateCallback) {
                 orderStatusUpdateCallback(*orderHandler);
             }
@@ -241,11 +277,12 @@ public:
         }
         orderHandler->m_modifyOrderOnOmsTS = helper::get_current_timestamp_ns();
         orderHandler->m_qtySubmitted = newQty;
-        mapping::InstrumentInfo inst = mapping::getInstrumentInfo(m_instrument);
-        uint64_t ret = okxOrderRouter->modifyOrder(clientOrderId, newQty, newPrice, inst.instrument);
+        outstandingQty.sync(*orderHandler);
+        uint64_t ret = okxOrderRouter->modifyOrder(clientOrderId, newQty, newPrice, *inst);
         if(ret == 0) {
             orderHandler->m_status = OrderStatus::REJECTED;
             orderHandler->m_reason = RejectReason::WS_FAILURE;
+            outstandingQty.sync(*orderHandler);
             if(orderStatusUpdateCallback) {
                 orderStatusUpdateCallback(*orderHandler);
             }
@@ -291,6 +328,7 @@ public:
                                 order->m_rejectionTS =
                                     std::stoull(parsedMessage["inTime"].get<std::string>()) * microToNano;
                                 order->m_status = OrderStatus::REJECTED;
+                                outstandingQty.sync(*order);
                                 if(error_code == "50018") {
                                     order->m_reason = RejectReason::INSUFFICIENT_FUNDS;
                                     if(!order->m_orderHasBeenLive) {
@@ -408,6 +446,10 @@ public:
                                     order->m_newOrderOnExchTS =
                                         std::stoull(parsedMessage["inTime"].get<std::string>()) * microToNano;
                                     order->m_newOrderConfirmationTS = helper::get_current_timestamp_ns();
+                                    latency::recordInterval(latency::Metric::OrderAck,
+                                                            latency::Venue::Okx,
+                                                            order->m_newOrderOnOmsTS,
+                                                            order->m_newOrderConfirmationTS);
                                 }
                             }
                         }
@@ -422,6 +464,10 @@ public:
                                     order->m_modifyOrderOnExchTS =
                                         std::stoull(parsedMessage["inTime"].get<std::string>()) * microToNano;
                                     order->m_modifyOrderConfirmationTS = helper::get_current_timestamp_ns();
+                                    latency::recordInterval(latency::Metric::OrderAck,
+                                                            latency::Venue::Okx,
+                                                            order->m_modifyOrderOnOmsTS,
+                                                            order->m_modifyOrderConfirmationTS);
                                 }
                             }
                         }
@@ -436,6 +482,10 @@ public:
                                     order->m_cancelOrderOnExchTS =
                                         std::stoull(parsedMessage["inTime"].get<std::string>()) * microToNano;
                                     order->m_cancelOrderConfirmationTS = helper::get_current_timestamp_ns();
+                                    latency::recordInterval(latency::Metric::OrderAck,
+                                                            latency::Venue::Okx,
+                                                            order->m_cancelOrderOnOmsTS,
+                                                            order->m_cancelOrderConfirmationTS);
                                 }
                             }
                         }
@@ -448,12 +498,7 @@ public:
                     if(orderData.contains("clOrdId")) {
                         std::string clOrdId = orderData["clOrdId"];
                         std::string instId = orderData["instId"].get<std::string>();
-                        double factor = 1.0;
-                        if(m_instrument == "DOGE-USDT-SWAP") {
-                            factor = (okx::DOGE_USDT_SWAP::dogePerpCtVal) * (okx::DOGE_USDT_SWAP::dogePerpCtMul);
-                        } else if(m_instrument == "BTC-USDT-SWAP") {
-                            factor = (okx::BTC_USDT_SWAP::btcPerpCtVal) * (okx::BTC_USDT_SWAP::btcPerpCtMul);
-                        }
+                        const double factor = m_baseQtyPerContract;
                         if(clOrdId != "") {
                             uint64_t key = std::stoull(clOrdId);
                             auto iterator = this->orderMap.find(key);
@@ -573,6 +618,7 @@ public:
                                         order->m_transactionId = orderData["tradeId"];
                                     }
                                 }
+                                outstandingQty.sync(*order);
                                 if(orderStatusUpdateCallback) {
                                     orderStatusUpdateCallback(*order);
                                 }
@@ -594,9 +640,11 @@ public:
     std::queue<uint64_t> cancelQueue;
     std::queue<uint64_t> rejectedQueue;
     std::queue<uint64_t> filledQueue;
+    OutstandingQty outstandingQty;
     // std::unordered_map<uint64_t,OrderHandler*>
 private:
     const std::string m_instrument = "";
+    const double m_baseQtyPerContract = 1.0; // fill sizes arrive in contracts
     std::unique_ptr<OkxOrderRouter> okxOrderRouter;
     OrderStatusUpdateCallback orderStatusUpdateCallback;
     WebSocketStatusUpdateCallback websocketStatusUpdateCallback;
@@ -607,4 +655,9 @@ private:
     const uint32_t retry_limit = 0;
     OkxClient m_client;
     uint32_t m_trackOrderCnt;
+
+    static double baseQtyPerContract(const std::string& symbol) {
+        const mapping::InstrumentSpec* spec = mapping::InstrumentRegistry::instance().findBySymbol("okx", symbol);
+        return spec ? spec->baseQtyPerContract : 1.0;
+    }
 };
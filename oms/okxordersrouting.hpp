@@ -1,4 +1,5 @@
 #pragma once
+#include <atomic>
 #include <boost/asio.hpp>
 #include <boost/asio/ssl.hpp>
 #include <chrono>
@@ -6,12 +7,15 @@
 #include <websocketpp/config/asio_client.hpp> // For TLS client (OKX)
 // #include "ordermanager.hpp"
 #include "../lib/json.hpp"
+#include "../utils/backoff.hpp"
 #include "../utils/connections.hpp"
 #include "../utils/helper.hpp"
+#include "../utils/instrumentregistry.hpp"
+#include "../utils/latency.hpp"
 #include "../utils/logger.hpp"
 #include "../utils/requests.hpp"
-#include "../utils/staticparams.hpp"
 #include <cmath>
+#include <mutex>
 #include <rapidjson/document.h>
 #include <rapidjson/stringbuffer.h>
 #include <rapidjson/writer.h>
@@ -35,9 +39,13 @@ public:
                    const std::string api_secret,
                    const std::string api_passphrase,
                    const std::string instrument,
-                   OrderUpdateCallback callback)
+                   OrderUpdateCallback callback,
+                   const ReconnectPolicy& reconnect_policy = {})
         : proxy_uri(proxy_uri)
         , retry_limit(retry_limit)
+        , reconnect_policy(reconnect_policy)
+        , backoff(reconnect_policy)
+        , spare_backoff(reconnect_policy)
         , apiKey(api_key)
         , secretKey(api_secret)
         , passphrase(api_passphrase)
@@ -69,53 +77,61 @@ public:
         });
 
         routing_client.set_message_handler([this](websocketpp::connection_hdl hdl, client_tls::message_ptr msg) {
+            if(isSpare(hdl)) {
+                onSpareMessage(msg->get_payload());
+                return;
+            }
             onOrderUpdateMessage(msg->get_payload());
         });
 
-        routing_client.set_open_handler([this](websocketpp::connection_hdl hdl) {
-            routing_hdl = hdl; // Store the connection handle
-            authenticate();
-        });
+        // Both the active and the spare connection log in as soon as they are open
+        routing_client.set_open_handler([this](websocketpp::connection_hdl hdl) { authenticate(hdl); });
 
         routing_client.set_close_handler([this](websocketpp::connection_hdl hdl) {
             LoggerSingleton::get().infra().warning("okx websocket connection closed");
-            m_wsState = false;
-            handle_disconnect();
+            handle_disconnect(hdl);
         });
 
         routing_client.set_fail_handler([this](websocketpp::connection_hdl hdl) {
             LoggerSingleton::get().infra().error("okx websocket connection failed");
-            m_wsState = false;
-            handle_disconnect();
+            handle_disconnect(hdl);
         });
-        connect_to_websocket();
+        setRoutingHandle(connect_to_websocket());
+        if(reconnect_policy.spare_connection) {
+            setSpareHandle(connect_to_websocket());
+        }
+        // Reconnects are timers on this io_service, so run() only returns on stop() or connection_end
+        try {
+            routing_client.run();
+        } catch(const std::exception& e) {
+            LoggerSingleton::get().infra().error("websocket run exception: ", e.what());
+        }
     }
 
-    void connect_to_websocket() {
-        reconnect_attempt += 1;
+    connection_hdl connect_to_websocket() {
         websocketpp::lib::error_code ec;
         client_tls::connection_ptr con = routing_client.get_connection(uri, ec);
         if(ec) {
             LoggerSingleton::get().infra().error("connection failed: ", ec.message());
-            return;
+            return {};
         }
         if(proxy_uri != "") {
             LoggerSingleton::get().infra().info("proxy uri: ", proxy_uri);
             con->set_proxy(proxy_uri);
         }
         routing_client.connect(con);
-        try {
-            routing_client.run();
-        } catch(const std::exception& e) {
-            LoggerSingleton::get().infra().error("websocket run exception: ", e.what());
-        }
+        return con->get_handle();
     }
 
     void stop() {
+        stopping = true;
         try {
-            if(!routing_hdl.expired()) { // Check if we have a valid connection
-                // Close the websocket connection gracefully
-                routing_client.close(routing_hdl, websocketpp::close::status::normal, "Shutting down");
+            for(const auto& hdl : {routingHandle(), spareHandle()}) {
+                if(!hdl.expired()) { // Check if we have a valid connection
+                    websocketpp::lib::error_code ec;
+                    // Close the websocket connection gracefully
+                    routing_client.close(hdl, websocketpp::close::status::normal, "Shutting down", ec);
+                }
             }
             // Stop the ASIO io_service
             routing_client.stop();
@@ -124,24 +140,70 @@ public:
         }
     }
 
-    void handle_disconnect() {
+    void handle_disconnect(connection_hdl hdl) {
+        if(stopping) {
+            return;
+        }
+        if(isSpare(hdl)) {
+            LoggerSingleton::get().infra().warning("okx trades spare stream disconnect");
+            setSpareHandle({});
+            spare_ready = false;
+            schedule_reconnect(false);
+            return;
+        }
+        m_wsState = false;
+        if(reconnect_policy.spare_connection && spare_ready) {
+            promoteSpare();
+            return;
+        }
         LoggerSingleton::get().infra().error("okx trades stream disconnect");
-        if(reconnect_attempt + 1 > retry_limit) {
+        if(backoff.attempts() + 1 > retry_limit) {
             std::string message = "connection_end";
             orderUpdateCallback(message);
         } else {
             std::string message = "disconnect";
             orderUpdateCallback(message);
-            schedule_reconnect();
+            schedule_reconnect(true);
         }
     }
 
-    void schedule_reconnect() {
-        LOG_INFRA_DEBUG("action=reconnecting exchange=okx stream=trades");
-        connect_to_websocket();
+    // The spare is already handshaked and logged in; only the fills subscription is left to do
+    void promoteSpare() {
+        LoggerSingleton::get().infra().warning("action=promote_spare exchange=okx stream=trades");
+        {
+            std::lock_guard<std::mutex> lock(hdl_mutex);
+            routing_hdl = std::move(spare_hdl);
+            spare_hdl.reset();
+        }
+        spare_ready = false;
+        subscribeFills();
+        schedule_reconnect(false);
     }
 
-    void authenticate() {
+    // Rebuilds the active (or the spare) connection after a jittered exponential backoff delay
+    void schedule_reconnect(bool active) {
+        ReconnectBackoff& policy = active ? backoff : spare_backoff;
+        const auto delay = policy.nextDelay();
+        LoggerSingleton::get().infra().info("action=schedule_reconnect exchange=okx stream=",
+                                            active ? "trades" : "trades_spare",
+                                            " attempt=",
+                                            policy.attempts(),
+                                            " delay_ms=",
+                                            delay.count());
+        routing_client.set_timer(delay.count(), [this, active](const websocketpp::lib::error_code& ec) {
+            if(ec || stopping) {
+                return;
+            }
+            LOG_INFRA_DEBUG("action=reconnecting exchange=okx stream=trades");
+            if(active) {
+                setRoutingHandle(connect_to_websocket());
+            } else {
+                setSpareHandle(connect_to_websocket());
+            }
+        });
+    }
+
+    void authenticate(connection_hdl hdl) {
         std::string timestamp = helper::get_current_timestamp();
         std::string method = "GET";
         std::string request_path = "/users/self/verify/";
@@ -163,30 +225,32 @@ public:
                                     timestamp + "\"}]}";
         // std::cout << "Login payload: " << login_payload << std::endl;
         // std::string auth_message = generate_auth_message();
-        routing_client.send(routing_hdl, std::move(login_payload), websocketpp::frame::opcode::text);
+        websocketpp::lib::error_code ec;
+        routing_client.send(hdl, std::move(login_payload), websocketpp::frame::opcode::text, ec);
+        if(ec) {
+            LoggerSingleton::get().infra().error("okx login send error: ", ec.message());
+        }
     }
 
     double roundedQty(double qty) { return std::round(qty * 10) / 10; }
 
+    // qty is in base currency, the payload carries contracts
     uint64_t sendOrder(double price,
                        double qty,
                        bool buy,
-                       std::string instrumentId,
+                       const mapping::InstrumentSpec& instrument,
                        std::string ordType = "limit",
                        std::string tdMode = "cross",
                        bool banAmend = true) {
+        const uint64_t encode_start = latency::now();
         uint64_t ret4 = helper::get_current_timestamp_ns();
         std::string clientOrderId = std::to_string(ret4);
         std::string side = buy ? "buy" : "sell";
-        if(instrumentId == "BTC-USDT-SWAP") {
-            qty = std::round(qty / (okx::BTC_USDT_SWAP::btcPerpCtVal) * 1e6) / 1e6;
-        } else if(instrumentId == "DOGE-USDT-SWAP") {
-            qty = std::round(qty / (okx::DOGE_USDT_SWAP::dogePerpCtVal) * 1e6) / 1e6;
-        }
+        qty = instrument.toContracts(qty);
         nlohmann::json place_order_payload = {{"id", clientOrderId},
                                               {"op", "order"},
                                               {"args",
-                                               {{{"instId", instrumentId},
+                                               {{{"instId", instrument.symbol},
                                                  {"tdMode", tdMode},
                                                  {"side", side},
                                                  {"ordType", ordType},
@@ -194,15 +258,17 @@ public:
                                                  {"banAmend", banAmend},
                                                  {"clOrdId", clientOrderId}}}}};
 
-        if(ordType == "limit" || ordType == "post_only") {
+        if(ordType == "limit" || ordType == "post_only" || ordType == "ioc") {
             place_order_payload["args"][0]["px"] = price;
         }
 
         std::string payload_str = place_order_payload.dump();
+        latency::record(latency::Metric::RouterEncode, latency::Venue::Okx, encode_start);
         LoggerSingleton::get().plain().ws_request("new order payload: ", payload_str);
 
         try {
-            routing_client.send(routing_hdl, payload_str, websocketpp::frame::opcode::text);
+            routing_client.send(routingHandle(), payload_str, websocketpp::frame::opcode::text);
+            latency::record(latency::Metric::TickToTrade, latency::Venue::Okx, latency::trigger());
         } catch(const websocketpp::exception& e) {
             LoggerSingleton::get().infra().error("websocket send error: ", e.what());
             return 0;
@@ -210,16 +276,19 @@ public:
         return ret4;
     }
 
-    uint64_t sendCancelOrder(uint64_t clOrdId, std::string instrumentId) {
+    uint64_t sendCancelOrder(uint64_t clOrdId, const mapping::InstrumentSpec& instrument) {
+        const uint64_t encode_start = latency::now();
         uint64_t ret = helper::get_current_timestamp_ns();
         std::string clientOrderId = std::to_string(ret);
         json cancel_order_payload = {{"id", clientOrderId},
                                      {"op", "cancel-order"},
-                                     {"args", {{{"instId", instrumentId}, {"clOrdId", clOrdId}}}}};
+                                     {"args", {{{"instId", instrument.symbol}, {"clOrdId", clOrdId}}}}};
         std::string payload_str = cancel_order_payload.dump();
+        latency::record(latency::Metric::RouterEncode, latency::Venue::Okx, encode_start);
         try {
             LoggerSingleton::get().plain().ws_request("cancel order payload: ", payload_str);
-            routing_client.send(routing_hdl, std::move(payload_str), websocketpp::frame::opcode::text);
+            routing_client.send(routingHandle(), std::move(payload_str), websocketpp::frame::opcode::text);
+            latency::record(latency::Metric::TickToTrade, latency::Venue::Okx, latency::trigger());
         } catch(const websocketpp::exception& e) {
             LoggerSingleton::get().infra().error("websocket send error", e.what());
             return 0;
@@ -227,22 +296,20 @@ public:
         return ret;
     }
 
-    uint64_t modifyOrder(long long clOrdId, double newQty, double newPrice, std::string instrumentId) {
+    uint64_t modifyOrder(long long clOrdId, double newQty, double newPrice, const mapping::InstrumentSpec& instrument) {
+        const uint64_t encode_start = latency::now();
         uint64_t ret4 = helper::get_current_timestamp_ns();
         modify_order_payload.SetObject();
         rapidjson::Document::AllocatorType& allocator = modify_order_payload.GetAllocator();
         std::string clientOrderId = std::to_string(ret4);
-        if(instrumentId == "BTC-USDT-SWAP")
-            newQty = std::round(newQty / (okx::BTC_USDT_SWAP::btcPerpCtVal) * 1e6) / 1e6;
-        else if(instrumentId == "DOGE-USDT-SWAP")
-            newQty = std::round(newQty / (okx::DOGE_USDT_SWAP::dogePerpCtVal) * 1e6) / 1e6;
+        newQty = instrument.toContracts(newQty);
         // Add top-level keys
         modify_order_payload.AddMember("id", rapidjson::Value(clientOrderId.c_str(), allocator), allocator);
         modify_order_payload.AddMember("op", "amend-order", allocator);
         argsObject.SetObject();
         argsArray.SetArray();
 
-        argsObject.AddMember("instId", rapidjson::Value(instrumentId.c_str(), allocator), allocator);
+        argsObject.AddMember("instId", rapidjson::Value(instrument.symbol.c_str(), allocator), allocator);
         argsObject.AddMember("clOrdId", rapidjson::Value(std::to_string(clOrdId).c_str(), allocator), allocator);
         argsObject.AddMember("newSz", rapidjson::Value(std::to_string(newQty).c_str(), allocator), allocator);
         argsObject.AddMember("newPx", rapidjson::Value(std::to_string(newPrice).c_str(), allocator), allocator);
@@ -256,9 +323,11 @@ public:
         buffer.Clear();
         rapidjson::Writer<rapidjson::StringBuffer> writer(buffer);
         modify_order_payload.Accept(writer);
+        latency::record(latency::Metric::RouterEncode, latency::Venue::Okx, encode_start);
         LoggerSingleton::get().plain().ws_request("modify order payload: ", buffer.GetString());
         try {
-            routing_client.send(routing_hdl, buffer.GetString(), websocketpp::frame::opcode::text);
+            routing_client.send(routingHandle(), buffer.GetString(), websocketpp::frame::opcode::text);
+            latency::record(latency::Metric::TickToTrade, latency::Venue::Okx, latency::trigger());
         } catch(const websocketpp::exception& e) {
             LoggerSingleton::get().infra().error("websocket send error: ", e.what());
             return 0;
@@ -269,7 +338,12 @@ public:
     bool send_heartbeat() {
         try {
             LOG_INFRA_DEBUG("okx trades channel heartbeat: ping");
-            routing_client.send(routing_hdl, "ping", websocketpp::frame::opcode::text);
+            routing_client.send(routingHandle(), "ping", websocketpp::frame::opcode::text);
+            if(const connection_hdl spare = spareHandle(); !spare.expired()) {
+                // The spare must be kept alive too, okx drops idle connections after 30 seconds
+                websocketpp::lib::error_code ec;
+                routing_client.send(spare, "ping", websocketpp::frame::opcode::text, ec);
+            }
             return true;
         } catch(const websocketpp::exception& e) {
             LoggerSingleton::get().infra().error("action=heartbeat exchage=okx stream=trades result=fail reason=",
@@ -280,6 +354,58 @@ public:
 
     bool isWebsocketReady() const { return m_wsState; }
 
+    bool subscribeFills() {
+        const mapping::InstrumentSpec* spec = mapping::InstrumentRegistry::instance().findBySymbol("okx", instrument);
+        if(!spec || spec->category != "SWAP") {
+            LoggerSingleton::get().infra().warning("need to add support for this instrument to get fill");
+            return false;
+        }
+        std::string OKX_FILLS_SUBSCRIBER_MESSAGE = requests::getOkxFillsSubscribeMessage("SWAP", spec->family());
+        websocketpp::lib::error_code ec;
+        routing_client.send(
+            routingHandle(), std::move(OKX_FILLS_SUBSCRIBER_MESSAGE), websocketpp::frame::opcode::text, ec);
+        if(ec) {
+            LoggerSingleton::get().infra().error("okx fills subscribe send error: ", ec.message());
+            return false;
+        }
+        return true;
+    }
+
+    // The spare only logs in; it subscribes to fills once promoted so that updates are never duplicated
+    void onSpareMessage(const std::string& message) {
+        if(message == "pong") {
+            return;
+        }
+        json parsedMessage = json::parse(message, nullptr, false);
+        if(parsedMessage.is_discarded() || !parsedMessage.contains("event") || parsedMessage["event"] != "login") {
+            return;
+        }
+        spare_ready = parsedMessage.contains("code") && parsedMessage["code"] == "0";
+        if(spare_ready) {
+            spare_backoff.reset();
+            LoggerSingleton::get().infra().info("action=spare_ready exchange=okx stream=trades");
+        } else {
+            LoggerSingleton::get().infra().error("okx spare login fail");
+        }
+    }
+
+    bool isSpare(const connection_hdl& hdl) const {
+        const connection_hdl spare = spareHandle();
+        return !spare.expired() && !spare.owner_before(hdl) && !hdl.owner_before(spare);
+    }
+
+    // The handles are replaced on the io thread (reconnects, spare promotion) while the order and
+    // heartbeat threads send on them, so both are only read and written as copies under hdl_mutex
+    connection_hdl routingHandle() const {
+        std::lock_guard<std::mutex> lock(hdl_mutex);
+        return routing_hdl;
+    }
+
+    connection_hdl spareHandle() const {
+        std::lock_guard<std::mutex> lock(hdl_mutex);
+        return spare_hdl;
+    }
+
     void onOrderUpdateMessage(std::string message) {
         if(message == "pong") {
             LOG_INFRA_DEBUG("okx trades channel heartbeat: pong");
@@ -292,17 +418,10 @@ public:
             if(parsedMessage.contains("code")) {
                 if(parsedMessage["code"] == "0") {
                     this->connId = parsedMessage["connId"].get<std::string>();
-                    std::string OKX_FILLS_SUBSCRIBER_MESSAGE;
-                    if(instrument == "DOGE-USDT-SWAP") {
-                        OKX_FILLS_SUBSCRIBER_MESSAGE = requests::getOkxFillsSubscribeMessage("SWAP", "DOGE-USDT");
-                    } else if(instrument == "BTC-USDT-SWAP") {
-                        OKX_FILLS_SUBSCRIBER_MESSAGE = requests::getOkxFillsSubscribeMessage("SWAP", "BTC-USDT");
-                    } else {
-                        LoggerSingleton::get().infra().warning("need to add support for this instrument to get fill");
+                    backoff.reset();
+                    if(!subscribeFills()) {
                         return;
                     }
-                    routing_client.send(
-                        routing_hdl, std::move(OKX_FILLS_SUBSCRIBER_MESSAGE), websocketpp::frame::opcode::text);
                 } else {
                     LoggerSingleton::get().infra().error("login fail");
                     return;
@@ -318,14 +437,30 @@ public:
     }
 
 private:
+    void setRoutingHandle(connection_hdl hdl) {
+        std::lock_guard<std::mutex> lock(hdl_mutex);
+        routing_hdl = std::move(hdl);
+    }
+
+    void setSpareHandle(connection_hdl hdl) {
+        std::lock_guard<std::mutex> lock(hdl_mutex);
+        spare_hdl = std::move(hdl);
+    }
+
     std::string uri;
     std::string proxy_uri;
     const uint32_t retry_limit;
-    uint32_t reconnect_attempt = 0;
+    ReconnectPolicy reconnect_policy;
+    ReconnectBackoff backoff; // consecutive failures of the active connection, reset on login
+    ReconnectBackoff spare_backoff;
+    mutable std::mutex hdl_mutex;
+    connection_hdl spare_hdl; // guarded by hdl_mutex
+    std::atomic<bool> spare_ready{false};
+    std::atomic<bool> stopping{false}; // set by stop() on the caller's thread, read by the io handlers
 
     std::string connId = "";
     bool m_wsState = false;
-    connection_hdl routing_hdl;
+    connection_hdl routing_hdl; // guarded by hdl_mutex
     client_tls routing_client;
 
     OrderUpdateCallback orderUpdateCallback;
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "../src/Side.h"
+#include "../utils/instrumentregistry.hpp"
 #include "../utils/pinthreads.hpp"
 #include "okxreconciliationmanager.hpp"
 #include <atomic>
@@ -42,6 +43,7 @@ public:
         , m_retryIntervalOnMismatch{retryIntervalOnMismatch}
         , m_running{false}
         , m_instrument{instrument}
+        , m_baseQtyPerContract{baseQtyPerContract(instrument)}
         , m_reconManager(trading_mode,
                          tickSize,
                          tolerableThreshold,
@@ -219,13 +221,7 @@ public:
     // Update position based on fills
     void update_position_by_fillsz(double fill_sz, bool side) noexcept {
         std::lock_guard<std::mutex> lock(m_mutex);
-        double factor = 1;
-        if(m_instrument == "DOGE-USDT-SWAP") {
-            factor = (okx::DOGE_USDT_SWAP::dogePerpCtVal) * (okx::DOGE_USDT_SWAP::dogePerpCtMul);
-        } else if(m_instrument == "BTC-USDT-SWAP") {
-            factor = (okx::BTC_USDT_SWAP::btcPerpCtVal) * (okx::BTC_USDT_SWAP::btcPerpCtMul);
-        }
-        fill_sz *= factor;
+        fill_sz *= m_baseQtyPerContract;
         updateCurrentPosition(fill_sz, side);
     }
 
@@ -234,6 +230,7 @@ private:
     double m_basePosition;
     bool warmup = false;
     std::string m_instrument;
+    double m_baseQtyPerContract; // fill sizes arrive in contracts
     std::atomic<double> m_currentPosition{};
     mutable std::mutex m_mutex;
 
@@ -270,4 +267,9 @@ private:
             this->m_currentPosition -= fill_sz;
         }
     }
+
+    static double baseQtyPerContract(const std::string& symbol) {
+        const mapping::InstrumentSpec* spec = mapping::InstrumentRegistry::instance().findBySymbol("okx", symbol);
+        return spec ? spec->baseQtyPerContract : 1.0;
+    }
 };
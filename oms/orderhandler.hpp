@@ -79,6 +79,7 @@ public:
     double m_qtyOnExch = 0;
     double m_qtySubmitted = 0;
     double m_priceSubmitted = 0;
+    double m_outstandingQty = 0; // share of the manager's OutstandingQty aggregate
 
     uint64_t m_placeOrderNow = 0;
     std::string m_instrumentId = "";
@@ -0,0 +1,53 @@
+#pragma once
+#include "orderhandler.hpp"
+#include <array>
+#include <atomic>
+#include <cmath>
+
+// Per-side quantity that can still fill: submitted qty of PENDING orders plus qty on exchange
+// of LIVE and PARTIALLY_FILLED ones. Managers call sync() after every change to an order's
+// status or quantities, each order remembers its current share in m_outstandingQty so the
+// aggregate only moves by the difference. Readers get the total without touching the order map.
+class OutstandingQty {
+public:
+    static double contribution(const OrderHandler& order) {
+        switch(order.m_status) {
+            case OrderStatus::PENDING:
+                return order.m_qtySubmitted;
+            case OrderStatus::LIVE:
+            case OrderStatus::PARTIALLY_FILLED:
+                return order.m_qtyOnExch;
+            default:
+                return 0.0;
+        }
+    }
+
+    void sync(OrderHandler& order) {
+        const double current = contribution(order);
+        const double delta = current - order.m_outstandingQty;
+        if(delta != 0.0) {
+            m_qty[index(order.m_side)].fetch_add(delta, std::memory_order_relaxed);
+            order.m_outstandingQty = current;
+        }
+    }
+
+    // For orders dropped from the order map
+    void release(OrderHandler& order) {
+        if(order.m_outstandingQty != 0.0) {
+            m_qty[index(order.m_side)].fetch_add(-order.m_outstandingQty, std::memory_order_relaxed);
+            order.m_outstandingQty = 0.0;
+        }
+    }
+
+    [[nodiscard]] double get(bool buy) const {
+        const double qty = m_qty[index(buy)].load(std::memory_order_relaxed);
+        return qty < EPSILON ? 0.0 : qty; // rounding residue once all orders are done
+    }
+
+private:
+    static constexpr double EPSILON = 1e-9;
+
+    static size_t index(bool buy) { return buy ? 0 : 1; }
+
+    std::array<std::atomic<double>, 2> m_qty{};
+};
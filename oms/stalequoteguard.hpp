@@ -0,0 +1,201 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <charconv>
+#include <cstdint>
+#include <immintrin.h>
+#include <string>
+#include <vector>
+
+// A request frame encoded ahead of time. Only its timestamp goes stale: it is rewritten in place,
+// at a fixed offset and width, right before the frame is sent.
+struct PrebuiltFrame {
+    static constexpr size_t TIMESTAMP_DIGITS = 13; // epoch milliseconds
+
+    std::string payload;
+    size_t timestampOffset = 0;
+
+    void stamp(uint64_t timestampMs) {
+        char digits[TIMESTAMP_DIGITS + 1];
+        const auto [end, ec] = std::to_chars(digits, digits + sizeof(digits), timestampMs);
+        if(ec == std::errc() && end - digits == TIMESTAMP_DIGITS &&
+           timestampOffset + TIMESTAMP_DIGITS <= payload.size()) {
+            payload.replace(timestampOffset, TIMESTAMP_DIGITS, digits, TIMESTAMP_DIGITS);
+        }
+    }
+};
+
+// Last line of quote protection, evaluated on the reference feed's own thread. Every resting quote is
+// armed with its cancel frame already encoded; when the reference touch of the quote's side comes
+// within cancelDistance of it, or moves through it, the frame is stamped and sent right away instead
+// of waiting for the strategy's event loop and health check:
+//   bid at q fires once ref_bid * (1 + shift) <= q * (1 + cancelDistance)
+//   ask at q fires once ref_ask * (1 + shift) >= q * (1 - cancelDistance)
+// shift is the reference shift ratio the quotes are priced from (see QuoteMidService), position
+// shift included, set by the caller before every check. A quote fires once and stays fired until it
+// is disarmed on its final state.
+//
+// arm/disarm may come from the order, fills or strategy threads and the check from any md thread; a
+// small spin lock guards the slots, frames are sent after it is released. The check does nothing
+// but compare prices while no quote is stale.
+// @example
+//   StaleQuoteGuard guard({true, 2e-4});
+//   guard.arm(orderId, true, 67000.1, router.buildCancelFrame(orderId, reqId, instrument)); // order thread
+//   guard.onReference(book.getBestBid(), book.getBestAsk(), [&](PrebuiltFrame& frame, const auto& quote) {
+//       return router.sendFrame(frame);
+//   }); // md thread
+//   guard.disarm(orderId); // fills thread, once the order is filled or cancelled
+class StaleQuoteGuard {
+public:
+    // Resting quotes watched at once, arming more is refused
+    static constexpr size_t MAX_QUOTES = 32;
+    // Request ids of guard frames start here, apart from the order manager's own request ids
+    static constexpr uint64_t REQ_ID_BASE = 1ULL << 62;
+
+    struct Config {
+        bool enabled = false;
+        double cancelDistance = 0.0; // ratio of the quote price, like minimum_distance
+    };
+
+    struct Quote {
+        uint64_t orderId;
+        bool buy;
+        double price;
+    };
+
+    explicit StaleQuoteGuard(const Config& config)
+        : m_config(config) {}
+
+    StaleQuoteGuard(const StaleQuoteGuard&) = delete;
+    StaleQuoteGuard& operator=(const StaleQuoteGuard&) = delete;
+
+    [[nodiscard]] bool enabled() const { return m_config.enabled; }
+
+    // Request id for the next frame armed; ids are never reused, so a late response is not mistaken
+    // for another order's
+    uint64_t nextReqId() { return m_reqId.fetch_add(1, std::memory_order_relaxed); }
+
+    // Watches a resting quote, or moves an armed one to its new price. False when disabled or full.
+    bool arm(uint64_t orderId, bool buy, double price, PrebuiltFrame frame) {
+        if(!m_config.enabled) {
+            return false;
+        }
+        lock();
+        Slot* slot = find(orderId);
+        if(!slot) {
+            slot = find(0);
+        }
+        const bool armed = slot != nullptr;
+        if(armed) {
+            slot->quote = {orderId, buy, price};
+            slot->frame = std::move(frame);
+            slot->fired = false;
+        }
+        unlock();
+        return armed;
+    }
+
+    // Moves an armed quote to a new price, keeping its frame; an amend does not change the order id
+    void reprice(uint64_t orderId, double price) {
+        lock();
+        if(Slot* slot = find(orderId)) {
+            slot->quote.price = price;
+        }
+        unlock();
+    }
+
+    // The quote is done, filled, cancelled or rejected. True when the guard had fired its cancel.
+    bool disarm(uint64_t orderId) {
+        lock();
+        Slot* slot = find(orderId);
+        const bool fired = slot && slot->fired;
+        if(slot) {
+            slot->quote.orderId = 0;
+            slot->frame = {};
+        }
+        unlock();
+        return fired;
+    }
+
+    void setReferenceShiftRatio(double ratio) { m_shiftRatio.store(ratio, std::memory_order_relaxed); }
+
+    // send(frame, quote) puts a stamped frame on the wire and returns whether it was sent. Returns
+    // the number of cancels fired.
+    template<typename Send>
+    size_t onReference(double bestBid, double bestAsk, Send&& send) {
+        if(bestBid <= 0.0 || bestAsk <= 0.0) {
+            return 0;
+        }
+        const double shift = 1.0 + m_shiftRatio.load(std::memory_order_relaxed);
+        const double bid = bestBid * shift;
+        const double ask = bestAsk * shift;
+
+        std::array<uint8_t, MAX_QUOTES> stale;
+        size_t count = 0;
+        lock();
+        for(size_t i = 0; i < m_slots.size(); ++i) {
+            const Slot& slot = m_slots[i];
+            if(slot.quote.orderId == 0 || slot.fired) {
+                continue;
+            }
+            const bool isStale = slot.quote.buy ? bid <= slot.quote.price * (1.0 + m_config.cancelDistance)
+                                                : ask >= slot.quote.price * (1.0 - m_config.cancelDistance);
+            if(isStale) {
+                stale[count++] = static_cast<uint8_t>(i);
+            }
+        }
+        if(count == 0) {
+            unlock();
+            return 0;
+        }
+        // Taken out of the slots so a concurrent disarm cannot free them while they are sent
+        std::vector<Slot> firing(count);
+        for(size_t i = 0; i < count; ++i) {
+            Slot& slot = m_slots[stale[i]];
+            slot.fired = true;
+            firing[i].quote = slot.quote;
+            firing[i].frame = std::move(slot.frame);
+        }
+        unlock();
+
+        size_t fired = 0;
+        for(auto& slot : firing) {
+            fired += send(slot.frame, slot.quote) ? 1 : 0;
+        }
+        m_fired.fetch_add(fired, std::memory_order_relaxed);
+        return fired;
+    }
+
+    [[nodiscard]] uint64_t fired() const { return m_fired.load(std::memory_order_relaxed); }
+
+private:
+    struct Slot {
+        Quote quote{0, false, 0.0}; // orderId 0 marks a free slot
+        PrebuiltFrame frame;
+        bool fired = false;
+    };
+
+    void lock() const {
+        while(m_lock.test_and_set(std::memory_order_acquire)) {
+            _mm_pause();
+        }
+    }
+
+    void unlock() const { m_lock.clear(std::memory_order_release); }
+
+    Slot* find(uint64_t orderId) {
+        for(auto& slot : m_slots) {
+            if(slot.quote.orderId == orderId) {
+                return &slot;
+            }
+        }
+        return nullptr;
+    }
+
+    const Config m_config;
+    mutable std::atomic_flag m_lock = ATOMIC_FLAG_INIT;
+    std::array<Slot, MAX_QUOTES> m_slots;
+    std::atomic<double> m_shiftRatio{0.0};
+    std::atomic<uint64_t> m_reqId{REQ_ID_BASE};
+    std::atomic<uint64_t> m_fired{0};
+};
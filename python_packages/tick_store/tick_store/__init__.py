@@ -0,0 +1,7 @@
+"""
+Reader of the columnar tick store the trading engine records (utils/tickstore.hpp)
+"""
+
+from tick_store.reader import COLUMNS, TickFile, read_ticks
+
+__all__ = ["COLUMNS", "TickFile", "read_ticks"]
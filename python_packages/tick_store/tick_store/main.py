@@ -0,0 +1,42 @@
+import argparse
+
+import numpy as np
+
+from tick_store import COLUMNS, read_ticks
+
+
+def parse_arguments():
+    parser = argparse.ArgumentParser(description="Tick store reader")
+    parser.add_argument("root", help="Tick store root (tick_store.root of the strategy config)")
+    parser.add_argument("instrument", help="Registry name, e.g. okx_perp_btc_usdt")
+    parser.add_argument("--start-ns", type=int, default=0, help="First exchange timestamp to read")
+    parser.add_argument("--end-ns", type=int, default=None, help="Exchange timestamp to stop before")
+    parser.add_argument("--csv", action="store_true", help="Print every tick as csv instead of a summary")
+    return parser.parse_args()
+
+
+def main():
+    try:
+        args = parse_arguments()
+        ticks = read_ticks(args.root, args.instrument, args.start_ns, args.end_ns)
+        count = len(ticks["timestamp_ns"])
+        if args.csv:
+            print(",".join(COLUMNS))
+            for row in zip(*(ticks[name].tolist() for name in COLUMNS)):
+                print("{},{},{:.10g},{:.10g},{:.10g},{:.10g}".format(*row))
+            return
+        print(f"ticks: {count}")
+        if count:
+            latency_ms = (ticks["receive_ns"] - ticks["timestamp_ns"]) / 1e6
+            print(f"from: {np.datetime64(int(ticks['timestamp_ns'][0]), 'ns')}")
+            print(f"to: {np.datetime64(int(ticks['timestamp_ns'][-1]), 'ns')}")
+            print(f"receive latency ms p50/p99: {np.percentile(latency_ms, 50):.3f}/{np.percentile(latency_ms, 99):.3f}")
+    except KeyboardInterrupt:
+        pass
+    except Exception as e:
+        print(f"Error: {e}")
+        exit(1)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,120 @@
+import mmap
+import struct
+from pathlib import Path
+
+import numpy as np
+
+# Mirrors utils/tickstore.hpp (VERSION 1)
+FILE_MAGIC = b"TICKSTOR"
+VERSION = 1
+BLOCK_MAGIC = 0x4B4C4254
+NS_PER_DAY = 86_400_000_000_000
+COLUMNS = ("timestamp_ns", "receive_ns", "bid_price", "bid_size", "ask_price", "ask_size")
+
+FILE_HEADER = struct.Struct("<8sIIdd48s")  # magic, version, header_size, price_scale, size_scale, instrument
+BLOCK_HEADER = struct.Struct("<IIQQqq6Q6I")  # magic, count, min_ns, max_ns, base_ns, base_bid, divisors, bytes
+
+
+def _varints(buf: np.ndarray, count: int) -> np.ndarray:
+    """Decodes `count` zigzag varints, vectorized over the whole column"""
+    ends = np.flatnonzero(buf < 0x80)
+    if len(ends) != count or (count and ends[-1] != len(buf) - 1):
+        raise ValueError("Tick store block is corrupt")
+    if count == 0:
+        return np.zeros(0, dtype=np.int64)
+    starts = np.concatenate(([0], ends[:-1] + 1))
+    group = np.repeat(np.arange(count), ends - starts + 1)
+    shift = ((np.arange(len(buf)) - starts[group]) * 7).astype(np.uint64)
+    values = np.add.reduceat((buf & 0x7F).astype(np.uint64) << shift, starts)
+    return (values >> np.uint64(1)).astype(np.int64) ^ -(values & np.uint64(1)).astype(np.int64)
+
+
+class TickFile:
+    """Read-only view of one <root>/<instrument>/<YYYYMMDD>.ticks file"""
+
+    def __init__(self, path: str | Path):
+        self.path = Path(path)
+        with open(self.path, "rb") as f:
+            self._map = mmap.mmap(f.fileno(), 0, prot=mmap.PROT_READ)
+        if len(self._map) < FILE_HEADER.size:
+            raise RuntimeError(f"Tick file too short: {self.path}")
+        magic, version, header_size, self.price_scale, self.size_scale, name = FILE_HEADER.unpack_from(self._map, 0)
+        if magic != FILE_MAGIC or version != VERSION or header_size != FILE_HEADER.size:
+            raise RuntimeError(f"Unexpected tick file layout in {self.path}")
+        self.instrument = name.rstrip(b"\0").decode()
+        # (min_ns, max_ns, offset, header), a torn last block of a crashed writer is left out
+        self.blocks: list[tuple[int, int, int, tuple]] = []
+        offset = FILE_HEADER.size
+        while offset + BLOCK_HEADER.size <= len(self._map):
+            header = BLOCK_HEADER.unpack_from(self._map, offset)
+            size = BLOCK_HEADER.size + sum(header[12:18])
+            if header[0] != BLOCK_MAGIC or offset + size > len(self._map):
+                break
+            self.blocks.append((header[2], header[3], offset, header))
+            offset += size
+
+    @property
+    def tick_count(self) -> int:
+        return sum(block[3][1] for block in self.blocks)
+
+    def _decode(self, offset: int, header: tuple) -> dict[str, np.ndarray]:
+        _, count, _, _, base_ns, base_bid = header[:6]
+        divisors = np.array(header[6:12], dtype=np.int64)
+        position = offset + BLOCK_HEADER.size
+        columns = []
+        for size, divisor in zip(header[12:18], divisors):
+            buf = np.frombuffer(self._map, dtype=np.uint8, count=size, offset=position)
+            columns.append(_varints(buf, count) * divisor)
+            position += size
+        timestamp = base_ns + np.cumsum(columns[0])
+        bid = base_bid + np.cumsum(columns[2])
+        return {
+            "timestamp_ns": timestamp,
+            "receive_ns": timestamp + columns[1],
+            "bid_price": bid * self.price_scale,
+            "bid_size": columns[4] * self.size_scale,
+            "ask_price": (bid + columns[3]) * self.price_scale,
+            "ask_size": columns[5] * self.size_scale,
+        }
+
+    def read(self, start_ns: int = 0, end_ns: int | None = None) -> dict[str, np.ndarray]:
+        """Columns of the ticks with start_ns <= timestamp_ns < end_ns, only overlapping blocks are decoded"""
+        end_ns = end_ns if end_ns is not None else np.iinfo(np.int64).max
+        parts = [
+            self._decode(offset, header)
+            for min_ns, max_ns, offset, header in self.blocks
+            if max_ns >= start_ns and min_ns < end_ns
+        ]
+        return _select(_concat(parts), start_ns, end_ns)
+
+
+def _concat(parts: list[dict[str, np.ndarray]]) -> dict[str, np.ndarray]:
+    if not parts:
+        empty = {name: np.zeros(0, dtype=np.float64) for name in COLUMNS}
+        empty["timestamp_ns"] = empty["receive_ns"] = np.zeros(0, dtype=np.int64)
+        return empty
+    return {name: np.concatenate([part[name] for part in parts]) for name in COLUMNS}
+
+
+def _select(columns: dict[str, np.ndarray], start_ns: int, end_ns: int) -> dict[str, np.ndarray]:
+    keep = (columns["timestamp_ns"] >= start_ns) & (columns["timestamp_ns"] < end_ns)
+    return columns if keep.all() else {name: values[keep] for name, values in columns.items()}
+
+
+def read_ticks(root: str | Path, instrument: str, start_ns: int = 0, end_ns: int | None = None) -> dict[str, np.ndarray]:
+    """Columns of every tick of an instrument in [start_ns, end_ns) across its day files
+
+    Returns:
+        dict of numpy arrays keyed by COLUMNS, e.g. pandas.DataFrame(read_ticks("ticks", "okx_perp_btc_usdt"))
+    """
+    directory = Path(root) / instrument
+    if not directory.is_dir():
+        raise FileNotFoundError(f"No tick store for {instrument} under {root}")
+    first = f"{_day_name(start_ns // NS_PER_DAY)}.ticks"
+    last = f"{_day_name((end_ns - 1) // NS_PER_DAY)}.ticks" if end_ns is not None else "99999999.ticks"
+    files = sorted(path for path in directory.glob("*.ticks") if first <= path.name <= last)
+    return _concat([TickFile(path).read(start_ns, end_ns) for path in files])
+
+
+def _day_name(day: int) -> str:
+    return np.datetime64(int(day), "D").astype(str).replace("-", "")
@@ -10,6 +10,7 @@ COOLDOWN = "purple"
 MARKET_DATA = "magenta1"
 ORDER_MANAGEMENT = "deep_sky_blue1"
 ALIVE = "gold3"
+LATENCY = "cyan"
 
 PANEL_COLORS = {
     "header": HEADER,
@@ -22,4 +23,5 @@ PANEL_COLORS = {
     "order_management": ORDER_MANAGEMENT,
     "quoting_reference": QUOTING_REFERENCE,
     "alive": ALIVE,
+    "latency": LATENCY,
 }
@@ -3,9 +3,11 @@ Core functionality for reading and processing trading status
 """
 
 from watch_trading.core.json import JsonReader
+from watch_trading.core.shm import ShmMetricsReader
 from watch_trading.core.monitor import TradingMonitor
 
 __all__ = [
     "JsonReader",
+    "ShmMetricsReader",
     "TradingMonitor",
 ]
@@ -16,13 +16,15 @@ from watch_trading.renderers import (
     PositionRenderer,
     QuotingReferenceRenderer,
     TradeAnalysisRenderer,
-    ProcessAliveMonitor
+    ProcessAliveMonitor,
+    LatencyRenderer,
 )
 
-from watch_trading.core import JsonReader
+from watch_trading.core.json import JsonReader
+from watch_trading.core.shm import ShmMetricsReader
 
 class TradingMonitor:
-    def __init__(self, data_path: Path, refresh_interval: float = 1.0):
+    def __init__(self, data_path: Path, refresh_interval: float = 1.0, metrics_shm: str | None = None):
         self.layout = Layout()
         self.data_path = Path(data_path)
         self.strategy_name = self.data_path.stem
@@ -32,6 +34,7 @@ class TradingMonitor:
             self.data_path.parent.parent.parent,  # Get project root
             polling_interval=refresh_interval
         )
+        self.metrics_reader = ShmMetricsReader(metrics_shm) if metrics_shm else None
 
     def run(self):
         # Create layout structure once
@@ -88,7 +91,11 @@ class TradingMonitor:
                 layout["left-top"].update(market_table)
                 layout["left-bottom-top"].update(left_stack)
                 layout["left-bottom-bottom-top"].update(alive_panel)
-                layout["left-bottom-bottom-middle"].update(health_panel)
+                if self.metrics_reader is not None:
+                    latency_panel = LatencyRenderer.render(self.metrics_reader.read())
+                    layout["left-bottom-bottom-middle"].update(Group(health_panel, latency_panel))
+                else:
+                    layout["left-bottom-bottom-middle"].update(health_panel)
                 layout["left-bottom-bottom-bottom"].update(trade_analysis_panel)
 
                 # Wait before next refresh
@@ -0,0 +1,81 @@
+import mmap
+import struct
+import time
+from pathlib import Path
+from typing import Any
+
+# Mirrors utils/shmmetrics.hpp (VERSION 1)
+MAGIC = 0x315254454D445254
+VERSION = 1
+VENUES = ("binance", "bybit", "okx")
+LATENCY_METRICS = ("md_parse", "event_queue", "tick_to_decision", "router_encode", "tick_to_trade", "order_ack")
+
+HEADER = struct.Struct("<QIIQQ")  # magic, version, pid, data_size, sequence
+SEQUENCE_OFFSET = 24
+DATA_OFFSET = 64
+DATA = struct.Struct("<QQ3Q3QQQ3d3d3ddd" + "5Q" * (len(LATENCY_METRICS) * len(VENUES)))
+
+
+class ShmMetricsReader:
+    """Read-only view of the engine's shared-memory metrics segment"""
+
+    def __init__(self, name: str, max_attempts: int = 1000):
+        path = Path("/dev/shm") / name.lstrip("/")
+        with open(path, "rb") as f:
+            self._map = mmap.mmap(f.fileno(), DATA_OFFSET + DATA.size, prot=mmap.PROT_READ)
+        magic, version, self.pid, data_size, _ = HEADER.unpack_from(self._map, 0)
+        if magic != MAGIC or version != VERSION or data_size != DATA.size:
+            raise RuntimeError(f"Unexpected metrics segment layout in {path}")
+        self._max_attempts = max_attempts
+
+    def _sequence(self) -> int:
+        return struct.unpack_from("<Q", self._map, SEQUENCE_OFFSET)[0]
+
+    def read(self) -> dict[str, Any]:
+        """Consistent snapshot of the segment, retried while the engine is writing
+
+        Raises:
+            RuntimeError: If no consistent copy could be taken
+        """
+        for _ in range(self._max_attempts):
+            before = self._sequence()
+            if before & 1:
+                time.sleep(0)
+                continue
+            values = DATA.unpack_from(self._map, DATA_OFFSET)
+            if self._sequence() == before:
+                return self._to_dict(values)
+        raise RuntimeError("Metrics segment stayed busy")
+
+    @staticmethod
+    def _to_dict(values: tuple) -> dict[str, Any]:
+        n = len(VENUES)
+        it = iter(values)
+        take = lambda count: [next(it) for _ in range(count)]
+        data: dict[str, Any] = {
+            "updated_ns": next(it),
+            "trading_active": bool(next(it)),
+            "md_updates": dict(zip(VENUES, take(n))),
+            "order_updates": dict(zip(VENUES, take(n))),
+            "ws_disconnects": next(it),
+            "ws_connection_ends": next(it),
+            "best_bid": dict(zip(VENUES, take(n))),
+            "best_ask": dict(zip(VENUES, take(n))),
+            "position": dict(zip(VENUES, take(n))),
+            "realized_pnl": next(it),
+            "unrealized_pnl": next(it),
+        }
+        latency: dict[str, dict[str, dict[str, int]]] = {}
+        for metric in LATENCY_METRICS:
+            latency[metric] = {}
+            for venue in VENUES:
+                count, p50, p99, p999, max_ns = take(5)
+                latency[metric][venue] = {
+                    "count": count,
+                    "p50_ns": p50,
+                    "p99_ns": p99,
+                    "p999_ns": p999,
+                    "max_ns": max_ns,
+                }
+        data["latency"] = latency
+        return data
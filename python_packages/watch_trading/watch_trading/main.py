@@ -13,6 +13,10 @@ def parse_arguments():
                        type=float,
                        default=1.0,
                        help='Refresh interval in seconds (default: 1.0)')
+    parser.add_argument('-m', '--metrics-shm',
+                       type=str,
+                       default=None,
+                       help='Shared-memory metrics segment name (shm_metrics.name) for the latency panel')
     args = parser.parse_args()
 
     if not args.status_path.exists():
@@ -23,14 +27,14 @@ def parse_arguments():
 
     return args
 
-def run_monitor(status_path: Path, refresh_interval: float):
-    monitor = TradingMonitor(status_path, refresh_interval)
+def run_monitor(status_path: Path, refresh_interval: float, metrics_shm: str | None = None):
+    monitor = TradingMonitor(status_path, refresh_interval, metrics_shm)
     monitor.run()
 
 def main():
     try:
         args: argparse.Namespace = parse_arguments()
-        run_monitor(args.status_path, args.interval)
+        run_monitor(args.status_path, args.interval, args.metrics_shm)
     except KeyboardInterrupt:
         print("Monitor stopped by user")
     except Exception as e:
@@ -10,6 +10,7 @@ from watch_trading.renderers.health import HealthRenderer
 from watch_trading.renderers.order import OrderManagementRenderer
 from watch_trading.renderers.trade import TradeAnalysisRenderer
 from watch_trading.renderers.alive import ProcessAliveMonitor
+from watch_trading.renderers.latency import LatencyRenderer
 __all__ = [
     "BaseRenderer",
     "MarketDataRenderer",
@@ -23,4 +24,5 @@ __all__ = [
     "OrderManagementRenderer",
     "TradeAnalysisRenderer",
     "ProcessAliveMonitor",
+    "LatencyRenderer",
 ]
@@ -0,0 +1,57 @@
+from typing import Any
+
+from rich.panel import Panel
+from rich.table import Table
+
+from watch_trading.config.panel_colors import PANEL_COLORS
+from watch_trading.renderers import BaseRenderer
+
+COLOR = PANEL_COLORS["latency"]
+
+JSONData = dict[str, Any]
+
+
+def format_ns(value: int) -> str:
+    if value >= 1_000_000:
+        return f"{value / 1_000_000:.2f}ms"
+    if value >= 1_000:
+        return f"{value / 1_000:.1f}us"
+    return f"{value}ns"
+
+
+class LatencyRenderer(BaseRenderer):
+    """Latency quantiles of the last reporting interval, read from the shared-memory metrics"""
+
+    @classmethod
+    def render(cls, data: JSONData) -> Panel:
+        table = Table(box=None, collapse_padding=True)
+        table.add_column("Metric", style=f"bold {COLOR}")
+        table.add_column("Venue")
+        table.add_column("Count", justify="right")
+        table.add_column("p50", justify="right")
+        table.add_column("p99", justify="right")
+        table.add_column("p99.9", justify="right")
+        table.add_column("Max", justify="right")
+
+        for metric, venues in data["latency"].items():
+            for venue, quantiles in venues.items():
+                if quantiles["count"] == 0:
+                    continue
+                table.add_row(
+                    metric,
+                    venue,
+                    str(quantiles["count"]),
+                    format_ns(quantiles["p50_ns"]),
+                    format_ns(quantiles["p99_ns"]),
+                    format_ns(quantiles["p999_ns"]),
+                    format_ns(quantiles["max_ns"]),
+                )
+
+        return Panel(
+            table,
+            title=f"[bold {COLOR}]Latency[/bold {COLOR}]",
+            border_style=COLOR,
+            expand=True,
+            highlight=True,
+            safe_box=True,
+        )
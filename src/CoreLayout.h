@@ -0,0 +1,102 @@
+#pragma once
+
+#include "Configuration.h"
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+// Which core each engine thread runs on, read from the `core_layout` section. Every role takes a
+// core or a list of cores; the i-th md connection (every redundant connection of every multiplexed
+// symbol chunk) or order stack (one per instrument) of a role, in the order instances first use
+// them, goes to list[i % size]. Roles missing from the config keep the single-instrument layout,
+// and strategy event loops stay unpinned unless `strategy` is given.
+// @example
+//   // core_layout:
+//   //   bybit_md: [1, 7]   # first md connection on 1, second on 7
+//   //   strategy: [8, 9]   # one event loop per instance
+//   CoreLayout layout = CoreLayout::from_config(config);
+//   layout.core(CoreLayout::Role::BybitMd, 1); // 7
+class CoreLayout {
+public:
+    enum class Role : uint8_t {
+        BinanceMd,
+        BybitMd,
+        OkxMd,
+        OkxOrder,
+        BybitOrder,
+        BybitFills,
+        BybitPosition,
+        OkxPosition,
+        Strategy,
+    };
+
+    static constexpr size_t ROLE_COUNT = static_cast<size_t>(Role::Strategy) + 1;
+
+    static const char* role_name(Role role) {
+        switch(role) {
+        case Role::BinanceMd: return "binance_md";
+        case Role::BybitMd: return "bybit_md";
+        case Role::OkxMd: return "okx_md";
+        case Role::OkxOrder: return "okx_order";
+        case Role::BybitOrder: return "bybit_order";
+        case Role::BybitFills: return "bybit_fills";
+        case Role::BybitPosition: return "bybit_position";
+        case Role::OkxPosition: return "okx_position";
+        case Role::Strategy: return "strategy";
+        }
+        return "unknown";
+    }
+
+    CoreLayout() {
+        cores_[index(Role::BinanceMd)] = {0};
+        cores_[index(Role::BybitMd)] = {1};
+        cores_[index(Role::OkxMd)] = {2};
+        cores_[index(Role::OkxOrder)] = {3};
+        cores_[index(Role::BybitOrder)] = {4};
+        cores_[index(Role::BybitFills)] = {4};
+        cores_[index(Role::BybitPosition)] = {5};
+        cores_[index(Role::OkxPosition)] = {6};
+    }
+
+    static CoreLayout from_config(const Configuration& config) {
+        CoreLayout layout;
+        if(!config.has_key("core_layout")) {
+            return layout;
+        }
+        const auto node = config.child("core_layout");
+        for(size_t i = 0; i < ROLE_COUNT; ++i) {
+            const auto role = static_cast<Role>(i);
+            if(!node.has_key(role_name(role))) {
+                continue;
+            }
+            const auto entry = node.child(role_name(role));
+            std::vector<int> cores;
+            if(entry.is_seq()) {
+                entry.for_each_child([&cores](const Configuration& core) { cores.push_back(core.as<int>()); });
+            } else {
+                cores.push_back(entry.as<int>());
+            }
+            if(cores.empty()) {
+                throw std::runtime_error(std::string("core_layout.") + role_name(role) +
+                                         " must list at least one core");
+            }
+            layout.cores_[i] = std::move(cores);
+        }
+        return layout;
+    }
+
+    [[nodiscard]] std::optional<int> core(Role role, size_t index) const {
+        const auto& cores = cores_[static_cast<size_t>(role)];
+        if(cores.empty()) {
+            return std::nullopt;
+        }
+        return cores[index % cores.size()];
+    }
+
+private:
+    static size_t index(Role role) { return static_cast<size_t>(role); }
+
+    std::array<std::vector<int>, ROLE_COUNT> cores_{};
+};
@@ -1,19 +1,25 @@
+#pragma once
+
 #include <cmath>
 #include <concepts>
+#include <functional>
+#include <tuple>
 
 template<typename T>
 concept PositionProvider = requires(T provider) {
     { provider.get_position() } -> std::convertible_to<double>;
 };
 
-template<PositionProvider QuotePositionProvider, PositionProvider HedgePositionProvider>
+// Net exposure over the quote position and any number of hedge venue positions
+template<PositionProvider... Providers>
 class ExposureMonitor {
 public:
-    ExposureMonitor(double exposure_tolerance, const QuotePositionProvider& quote, const HedgePositionProvider& hedge)
-        : exposure_tolerance_(exposure_tolerance), quote_position_manager_(quote), hedge_position_manager_(hedge) {}
+    ExposureMonitor(double exposure_tolerance, const Providers&... providers)
+        : exposure_tolerance_(exposure_tolerance), providers_(providers...) {}
 
     [[nodiscard]] double get_exposure() const {
-        return quote_position_manager_.get_position() + hedge_position_manager_.get_position();
+        return std::apply([](const auto&... provider) { return (0.0 + ... + provider.get().get_position()); },
+                          providers_);
     }
 
     [[nodiscard]] bool has_exposure() const { return std::abs(get_exposure()) > exposure_tolerance_; }
@@ -22,6 +28,5 @@ public:
 
 private:
     double exposure_tolerance_;
-    const QuotePositionProvider& quote_position_manager_;
-    const HedgePositionProvider& hedge_position_manager_;
+    std::tuple<std::reference_wrapper<const Providers>...> providers_;
 };
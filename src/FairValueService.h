@@ -0,0 +1,170 @@
+#pragma once
+
+#include "QuoteMidService.h"
+#include "logging.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// QuoteMidService plus a fair-value shift read from the order books of one or more venues. Every
+// source book gives a shift relative to its own mid, blended by source weight:
+//   - microprice: (bid * ask_size + ask * bid_size) / (bid_size + ask_size), scaled by
+//     microprice_weight (0 keeps the mid, 1 is the full microprice),
+//   - imbalance: sum_k decay^k (bid_k - ask_k) / sum_k decay^k (bid_k + ask_k) over the top
+//     imbalance_levels sizes, in [-1, 1], times imbalance_shift,
+//   - drift: mid / EWMA(mid) - 1 with the EWMA decaying by exchange time over drift_halflife_ns,
+//     times drift_weight; a short-horizon momentum term.
+// The blend is capped at +-max_shift and added to the QuoteMidService ratio, so shift() moves any
+// reference price by the same relative amount, like the constant and position shifts do.
+//
+// on_book_update() is called after a source book changed and costs O(imbalance_levels + sources),
+// independent of the book depth; shift() only reads the cached ratio. Other books are ignored.
+// @example
+//   FairValueService<Book, ByBitPositionManager>::Config config;
+//   config.sources = {{&binance_book, 0.7}, {&okx_book, 0.3}};
+//   config.microprice_weight = 1.0;
+//   FairValueService<Book, ByBitPositionManager> service(config, position_manager);
+//   service.on_book_update(binance_book);
+//   const double quote_mid = service.shift(binance_book.getMid());
+template<typename Book, typename PositionProvider>
+class FairValueService {
+public:
+    struct Source {
+        const Book* book;
+        double weight;
+    };
+
+    struct Config {
+        typename QuoteMidService<PositionProvider>::Config quote_mid;
+
+        std::vector<Source> sources;
+        double microprice_weight{0.0};
+        size_t imbalance_levels{1};
+        double imbalance_decay{1.0};
+        double imbalance_shift{0.0};
+        uint64_t drift_halflife_ns{0};
+        double drift_weight{0.0};
+        double max_shift{1e-3};
+    };
+
+    FairValueService(Config config, const PositionProvider& provider)
+        : config_{std::move(config)}
+        , quote_mid_{config_.quote_mid, provider}
+        , states_(config_.sources.size()) {
+        validate_config();
+    }
+
+    [[nodiscard]] double shift(double reference_price) const {
+        return quote_mid_.shift(reference_price) + reference_price * fair_value_shift_ratio_;
+    }
+
+    [[nodiscard]] double get_const_shift_ratio() const { return quote_mid_.get_const_shift_ratio(); }
+    [[nodiscard]] double get_position_shift_ratio() const { return quote_mid_.get_position_shift_ratio(); }
+    [[nodiscard]] double get_fair_value_shift_ratio() const { return fair_value_shift_ratio_; }
+
+    void on_book_update(const Book& book) {
+        for(size_t i = 0; i < config_.sources.size(); ++i) {
+            if(config_.sources[i].book == &book) {
+                update_source(i, book);
+                return;
+            }
+        }
+    }
+
+private:
+    struct SourceState {
+        bool valid{false};
+        double ratio{0.0};
+        double mid_ewma{0.0};
+        uint64_t last_ns{0};
+    };
+
+    void update_source(size_t index, const Book& book) {
+        SourceState& state = states_[index];
+        const double bid = book.getBestBid();
+        const double ask = book.getBestAsk();
+        state.valid = bid > 0.0 && ask > bid && book.bidSide.size > 0 && book.askSide.size > 0;
+        if(state.valid) {
+            const double mid = (bid + ask) / 2.0;
+            const double bid_size = book.bidSide.levels[0].quantity;
+            const double ask_size = book.askSide.levels[0].quantity;
+            const double microprice = (bid * ask_size + ask * bid_size) / (bid_size + ask_size);
+
+            state.ratio = config_.microprice_weight * (microprice / mid - 1.0) +
+                          config_.imbalance_shift * imbalance(book) + config_.drift_weight * drift(state, mid, book);
+        }
+
+        // a handful of sources, summing them again is cheaper than keeping running sums exact
+        double weighted_ratio = 0.0;
+        double valid_weight = 0.0;
+        for(size_t i = 0; i < states_.size(); ++i) {
+            if(states_[i].valid) {
+                weighted_ratio += config_.sources[i].weight * states_[i].ratio;
+                valid_weight += config_.sources[i].weight;
+            }
+        }
+        const double blended = valid_weight > 0.0 ? weighted_ratio / valid_weight : 0.0;
+        fair_value_shift_ratio_ = std::clamp(blended, -config_.max_shift, config_.max_shift);
+
+        LOG_STRATEGY_DEBUG([&]() {
+            return "[FairValueService] " + f("action", "update_fair_value") + " " +
+                   f("source", book.getInstrumentName()) + " " + f("valid", state.valid) + " " +
+                   f("source_ratio", state.ratio) + " " + f("fair_value_shift_ratio", fair_value_shift_ratio_);
+        }());
+    }
+
+    [[nodiscard]] double imbalance(const Book& book) const {
+        const size_t levels = std::min({config_.imbalance_levels, book.bidSide.size, book.askSide.size});
+        double weight = 1.0;
+        double bids = 0.0;
+        double asks = 0.0;
+        for(size_t k = 0; k < levels; ++k) {
+            bids += weight * book.bidSide.levels[k].quantity;
+            asks += weight * book.askSide.levels[k].quantity;
+            weight *= config_.imbalance_decay;
+        }
+        return bids + asks > 0.0 ? (bids - asks) / (bids + asks) : 0.0;
+    }
+
+    // Time-decayed rather than per tick, so bursts of updates do not shorten the horizon
+    [[nodiscard]] double drift(SourceState& state, double mid, const Book& book) const {
+        const uint64_t now = book.m_timestamp;
+        if(state.mid_ewma <= 0.0 || config_.drift_halflife_ns == 0) {
+            state.mid_ewma = mid;
+        } else if(now > state.last_ns) {
+            const double halflives =
+                static_cast<double>(now - state.last_ns) / static_cast<double>(config_.drift_halflife_ns);
+            state.mid_ewma += (1.0 - std::exp2(-halflives)) * (mid - state.mid_ewma);
+        }
+        state.last_ns = std::max(state.last_ns, now);
+        return mid / state.mid_ewma - 1.0;
+    }
+
+    void validate_config() const {
+        for(const auto& source : config_.sources) {
+            if(!source.book || source.weight < 0.0) {
+                throw std::invalid_argument("fair value sources need a book and a non-negative weight, got: " +
+                                            std::to_string(source.weight));
+            }
+        }
+        if(config_.imbalance_levels == 0 || config_.imbalance_decay <= 0.0 || config_.imbalance_decay > 1.0) {
+            throw std::invalid_argument("imbalance_levels must be positive and imbalance_decay in (0, 1], got: " +
+                                        std::to_string(config_.imbalance_levels) + ", " +
+                                        std::to_string(config_.imbalance_decay));
+        }
+        if(config_.drift_weight != 0.0 && config_.drift_halflife_ns == 0) {
+            throw std::invalid_argument("drift_weight needs a positive drift_halflife");
+        }
+        if(config_.max_shift < 0.0) {
+            throw std::invalid_argument("max_shift must be non-negative, got: " + std::to_string(config_.max_shift));
+        }
+    }
+
+    const Config config_;
+    const QuoteMidService<PositionProvider> quote_mid_;
+    std::vector<SourceState> states_; // parallel to config_.sources
+    double fair_value_shift_ratio_{0.0};
+};
@@ -0,0 +1,151 @@
+#pragma once
+
+#include "../infra/book.hpp"
+#include "Configuration.h"
+#include "Side.h"
+#include "rounding.h"
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+enum class HedgeExecutionMode { Market, SlicedIoc };
+
+inline HedgeExecutionMode parse_hedge_execution_mode(const std::string& mode) {
+    if(mode == "market") return HedgeExecutionMode::Market;
+    if(mode == "sliced_ioc") return HedgeExecutionMode::SlicedIoc;
+    throw std::runtime_error("Invalid hedge execution mode: " + mode);
+}
+
+struct HedgeExecutionConfig {
+    HedgeExecutionMode mode{HedgeExecutionMode::Market};
+    double max_slippage{5e-4}; // furthest slice price relative to the touch
+    size_t max_slices{5};
+    uint64_t time_budget_ns{500'000'000}; // after this the remainder goes out as a market order
+    double price_tick{0.1};
+    double size_tick{0.0001};
+    double level_size_multiplier{1.0}; // book quantity units -> order size units (contract value)
+
+    // Reads hedge_safety_control.execution, defaults keep the single market order
+    static HedgeExecutionConfig from_config(const Configuration& config) {
+        HedgeExecutionConfig execution;
+        execution.price_tick = config.child("markets").child("hedge").child("tick_sizes").get<double>("price", 0.1);
+        execution.size_tick =
+            config.child("markets").child("hedge").child("tick_sizes").get<double>("quantity", 0.0001);
+        const auto safety = config.child("hedge_safety_control");
+        if(!safety.has_key("execution")) {
+            return execution;
+        }
+        const auto node = safety.child("execution");
+        execution.mode = parse_hedge_execution_mode(node.get<std::string>("mode", "market"));
+        execution.max_slippage = node.get<double>("max_slippage", execution.max_slippage);
+        execution.max_slices = std::max<size_t>(1, node.get<size_t>("max_slices", execution.max_slices));
+        execution.time_budget_ns = node.get<uint64_t>("time_budget_ms", 500) * 1'000'000;
+        execution.level_size_multiplier = node.get<double>("level_size_multiplier", 1.0);
+        return execution;
+    }
+};
+
+// Splits a hedge into IOC limit slices by walking the opposite side of the hedge book. Each visible
+// level inside the slippage cap gets its own slice at the level price; whatever the visible depth
+// cannot absorb goes into a last slice at the cap, so the worst fill is bounded either way.
+// An episode starts with the first slice sent for an exposure and ends once the exposure is hedged;
+// if it is still open after time_budget_ns the remainder is sent as a market order.
+class HedgeExecution {
+public:
+    struct Slice {
+        double price;
+        double size;
+    };
+
+    struct Plan {
+        std::vector<Slice> slices;
+        double size{0.};
+        double touch{0.};
+        double limit_price{0.};
+        double visible_size{0.}; // part of the hedge the visible depth inside the cap can absorb
+        double expected_vwap{0.}; // over the visible part, the cap price when nothing is visible
+        double impact{0.}; // (expected_vwap - touch) / touch, positive is adverse
+
+        // Visible part at expected_vwap and the rest at the cap, i.e. the worst average this plan can get
+        [[nodiscard]] double average_price() const {
+            return size > 0. ? (visible_size * expected_vwap + (size - visible_size) * limit_price) / size : 0.;
+        }
+    };
+
+    explicit HedgeExecution(const HedgeExecutionConfig& config)
+        : config_(config)
+        , price_rounder_(config.price_tick, PriceRoundMode::Away)
+        , size_rounder_(config.size_tick, SizeRoundMode::Floor) {}
+
+    [[nodiscard]] bool is_sliced() const { return config_.mode == HedgeExecutionMode::SlicedIoc; }
+
+    // side is the side of the hedge order, a bid hedge walks the asks
+    [[nodiscard]] Plan plan(const Book& book, Side side, double size) const {
+        Plan plan;
+        plan.size = size;
+        const bool buy = side == Side::bid();
+        const PriceLevelArray& levels = buy ? book.askSide : book.bidSide;
+        plan.touch = levels.size > 0 ? levels.levels[0].price : (buy ? book.getBestAsk() : book.getBestBid());
+        if(plan.touch <= 0. || size <= 0.) {
+            return plan;
+        }
+        plan.limit_price = buy ? price_rounder_.round_bid(plan.touch * (1. + config_.max_slippage))
+                               : price_rounder_.round_ask(plan.touch * (1. - config_.max_slippage));
+
+        double remaining = size;
+        double notional = 0.;
+        for(size_t i = 0; i < levels.size && plan.slices.size() + 1 < config_.max_slices; ++i) {
+            const PriceLevel& level = levels.levels[i];
+            if(buy ? level.price > plan.limit_price : level.price < plan.limit_price) {
+                break;
+            }
+            const double take = std::min(remaining, level.quantity * config_.level_size_multiplier);
+            const double rounded = take < remaining ? round_size(take) : take;
+            if(rounded <= 0.) {
+                continue;
+            }
+            plan.slices.push_back({level.price, rounded});
+            notional += rounded * level.price;
+            plan.visible_size += rounded;
+            remaining -= rounded;
+            if(remaining < config_.size_tick) {
+                break;
+            }
+        }
+
+        if(remaining >= config_.size_tick) {
+            plan.slices.push_back({plan.limit_price, remaining});
+        } else if(!plan.slices.empty()) {
+            plan.slices.back().size += remaining; // sub-tick residue rides on the last slice
+        }
+
+        plan.expected_vwap = plan.visible_size > 0. ? notional / plan.visible_size : plan.limit_price;
+        plan.impact = (buy ? plan.expected_vwap - plan.touch : plan.touch - plan.expected_vwap) / plan.touch;
+        return plan;
+    }
+
+    void start_episode(uint64_t now_ns) {
+        if(episode_start_ns_ == 0) {
+            episode_start_ns_ = now_ns;
+        }
+    }
+
+    void finish_episode() { episode_start_ns_ = 0; }
+
+    [[nodiscard]] bool is_budget_exhausted(uint64_t now_ns) const {
+        return episode_start_ns_ != 0 && now_ns - episode_start_ns_ >= config_.time_budget_ns;
+    }
+
+    [[nodiscard]] uint64_t episode_age_ns(uint64_t now_ns) const {
+        return episode_start_ns_ == 0 ? 0 : now_ns - episode_start_ns_;
+    }
+
+private:
+    [[nodiscard]] double round_size(double size) const { return size < config_.size_tick ? 0. : size_rounder_.round(size); }
+
+    HedgeExecutionConfig config_;
+    PriceRounder price_rounder_;
+    SizeRounder size_rounder_;
+    uint64_t episode_start_ns_{0};
+};
@@ -0,0 +1,303 @@
+#pragma once
+
+#include "../infra/book.hpp"
+#include "../utils/instrumentregistry.hpp"
+#include "../utils/latency.hpp"
+#include "Configuration.h"
+#include "ExposureMonitor.h"
+#include "HedgeExecution.h"
+#include "Side.h"
+#include "book_healthchecks.h"
+#include "format.h"
+#include "logging.h"
+#include <cmath>
+#include <limits>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+// One place to hedge: an order stream, its book and its position
+class IHedgeVenue {
+public:
+    virtual ~IHedgeVenue() = default;
+    [[nodiscard]] virtual const std::string& get_instrument() const = 0;
+    [[nodiscard]] virtual const Book& get_book() const = 0;
+    [[nodiscard]] virtual double get_position() const = 0;
+    [[nodiscard]] virtual double get_outstanding_qty(bool buy) const = 0;
+    [[nodiscard]] virtual bool is_order_stream_ready() const = 0;
+    virtual uint64_t place_order(double price, double size, bool buy, const std::string& order_type) = 0;
+};
+
+// Adapts an order manager (OkxOrderManager, ByBitOrderManager) and its position manager
+template<typename Executor, PositionProvider PositionManager>
+class HedgeVenue final : public IHedgeVenue {
+public:
+    HedgeVenue(std::string instrument, Executor& executor, const PositionManager& position_manager, const Book& book)
+        : instrument_(std::move(instrument))
+        , instrument_id_(mapping::InstrumentRegistry::instance().id(instrument_))
+        , executor_(executor)
+        , position_manager_(position_manager)
+        , book_(book) {}
+
+    [[nodiscard]] const std::string& get_instrument() const override { return instrument_; }
+    [[nodiscard]] const Book& get_book() const override { return book_; }
+    [[nodiscard]] double get_position() const override { return position_manager_.get_position(); }
+    [[nodiscard]] double get_outstanding_qty(bool buy) const override { return executor_.getOutstandingQty(buy); }
+    [[nodiscard]] bool is_order_stream_ready() const override { return executor_.isWebSocketReady(); }
+
+    uint64_t place_order(double price, double size, bool buy, const std::string& order_type) override {
+        return executor_.placeOrder(instrument_id_, price, size, buy, order_type);
+    }
+
+private:
+    const std::string instrument_;
+    const mapping::InstrumentId instrument_id_;
+    Executor& executor_;
+    const PositionManager& position_manager_;
+    const Book& book_;
+};
+
+struct HedgeVenueConfig {
+    double taker_fee{0.};
+    latency::Venue latency_venue{latency::Venue::Okx};
+    HedgeExecutionConfig execution;
+
+    // One entry of hedge_routing.venues; tick sizes and execution settings default to the hedge market's
+    static HedgeVenueConfig from_config(const Configuration& venue, const HedgeExecutionConfig& base) {
+        HedgeVenueConfig config;
+        const auto name = venue.get<std::string>("name");
+        config.taker_fee = venue.get<double>("taker_fee", 0.);
+        config.latency_venue = name.rfind("bybit", 0) == 0     ? latency::Venue::Bybit
+                               : name.rfind("binance", 0) == 0 ? latency::Venue::Binance
+                                                               : latency::Venue::Okx;
+        config.execution = base;
+        if(venue.has_key("tick_sizes")) {
+            config.execution.price_tick = venue.child("tick_sizes").get<double>("price", base.price_tick);
+            config.execution.size_tick = venue.child("tick_sizes").get<double>("quantity", base.size_tick);
+        }
+        config.execution.level_size_multiplier =
+            venue.get<double>("level_size_multiplier", base.level_size_multiplier);
+        return config;
+    }
+};
+
+// Hedges the quote position across several venues. Exposure is the quote position plus every venue's
+// position; each decision sends the unhedged part to the venue with the best expected all-in price:
+// the depth-walked average for the size, plus taker fee, plus an adverse-move allowance for the
+// venue's recent order-ack latency. Venues whose order stream is down or whose book is stale or wide
+// are skipped, so hedging carries on while any one venue is healthy.
+//
+// The owner reads hedge_routing, adds the venues with HedgeVenueConfig::from_config and keeps their
+// ack latency current: update_latency every latency interval live, record_ack_latency per order
+// response in the backtest (BacktestEngine hedges through it when hedge_routing is enabled).
+template<PositionProvider QuotePositionManagerType>
+class HedgeRouter {
+public:
+    HedgeRouter(const QuotePositionManagerType& quote_position_manager,
+                double min_hedge_size,
+                uint64_t stale_threshold_ns,
+                double max_spread,
+                double latency_penalty_per_ms)
+        : quote_position_manager_(quote_position_manager)
+        , min_hedge_size_{min_hedge_size}
+        , stale_threshold_ns_{stale_threshold_ns}
+        , max_spread_{max_spread}
+        , latency_penalty_per_ms_{latency_penalty_per_ms} {}
+
+    size_t add_venue(std::unique_ptr<IHedgeVenue> venue, const HedgeVenueConfig& config) {
+        venues_.push_back(VenueState{std::move(venue), config, HedgeExecution{config.execution}});
+        return venues_.size() - 1;
+    }
+
+    [[nodiscard]] size_t venue_count() const { return venues_.size(); }
+
+    // Feeds the order_ack p50 of the last latency interval into the venue scores
+    void update_latency(const latency::LatencyRegistry::IntervalQuantiles& quantiles) {
+        const auto& order_ack = quantiles[static_cast<size_t>(latency::Metric::OrderAck)];
+        for(auto& state : venues_) {
+            const auto& q = order_ack[static_cast<size_t>(state.config.latency_venue)];
+            if(q.count > 0) {
+                state.ack_latency_ns = q.p50_ns;
+            }
+        }
+    }
+
+    // One measured order ack of a venue, from send to response; the latest sample scores the venue
+    void record_ack_latency(size_t venue_index, uint64_t latency_ns) {
+        if(venue_index < venues_.size()) {
+            venues_[venue_index].ack_latency_ns = latency_ns;
+        }
+    }
+
+    [[nodiscard]] double get_exposure() const {
+        double exposure = quote_position_manager_.get_position();
+        for(const auto& state : venues_) {
+            exposure += state.venue->get_position();
+        }
+        return exposure;
+    }
+
+    [[nodiscard]] std::pair<bool, std::string> healthcheck() const {
+        const auto now = helper::get_current_timestamp_ns();
+        for(const auto& state : venues_) {
+            if(venue_healthcheck(state, now).first) {
+                return {true, ""};
+            }
+        }
+        LOG_ACTION_FAIL_DEBUG("check_hedge_router_health", "no_healthy_hedge_venue");
+        return {false, "no_healthy_hedge_venue"};
+    }
+
+    void hedge() {
+        const auto total_exposure = get_exposure();
+        if(!is_exposure_significant(total_exposure)) {
+            for(auto& state : venues_) {
+                state.execution.finish_episode();
+            }
+            LOG_ACTION_PASS_DEBUG("route_hedge",
+                                  f("reason", "total_exposure_within_min_hedge_size"),
+                                  f("total_exposure", total_exposure),
+                                  f("min_hedge_size", min_hedge_size_));
+            return;
+        }
+
+        const auto hedge_side = total_exposure > 0. ? Side::ask() : Side::bid();
+        const auto potential_fills = get_outstanding_qty(hedge_side == Side::bid());
+        const auto unhedged = std::abs(total_exposure) - potential_fills;
+        if(unhedged < min_hedge_size_) {
+            LOG_ACTION_PASS_DEBUG("route_hedge",
+                                  f("reason", "unhedged_exposure_within_min_hedge_size"),
+                                  f("unhedged_exposure", unhedged),
+                                  f("min_hedge_size", min_hedge_size_));
+            return;
+        }
+
+        const auto venue_index = select_venue(hedge_side, unhedged);
+        if(!venue_index) {
+            log_action_fail("route_hedge", "no_healthy_hedge_venue", f("unhedged_exposure", unhedged));
+            return;
+        }
+        auto& state = venues_[*venue_index];
+        log_action_attempt("route_hedge",
+                           f("venue", state.venue->get_instrument()),
+                           f("unhedged_exposure", unhedged),
+                           f("side", hedge_side.to_string()),
+                           f("ack_latency_ns", state.ack_latency_ns));
+        send_hedge_order(state, unhedged, hedge_side);
+    }
+
+private:
+    struct VenueState {
+        std::unique_ptr<IHedgeVenue> venue;
+        HedgeVenueConfig config;
+        HedgeExecution execution;
+        uint64_t ack_latency_ns{0};
+    };
+
+    [[nodiscard]] bool is_exposure_significant(double exposure) const { return std::abs(exposure) >= min_hedge_size_; }
+
+    [[nodiscard]] double get_outstanding_qty(bool buy) const {
+        double total{0.};
+        for(const auto& state : venues_) {
+            total += state.venue->get_outstanding_qty(buy);
+        }
+        return total;
+    }
+
+    [[nodiscard]] std::pair<bool, std::string> venue_healthcheck(const VenueState& state, uint64_t now) const {
+        if(!state.venue->is_order_stream_ready()) {
+            return {false, "hedge_ws_disconnected"};
+        } else if(const auto health = book_health_.check(state.venue->get_book(), now);
+                  health != BookHealth::Healthy) {
+            return {false, std::string("hedge_") + to_string(health)};
+        }
+        return {true, ""};
+    }
+
+    // Expected price per unit after fees and latency, lower is better for both sides.
+    // Books kept at the touch only, like Bybit's, have no levels to walk and are priced at the touch
+    [[nodiscard]] double score(const VenueState& state, Side side, double size) const {
+        const Book& book = state.venue->get_book();
+        const bool buy = side == Side::bid();
+        const double price = (buy ? book.askSide : book.bidSide).size > 0
+                                 ? state.execution.plan(book, side, size).average_price()
+                                 : (buy ? book.getBestAsk() : book.getBestBid());
+        if(price <= 0.) {
+            return std::numeric_limits<double>::infinity();
+        }
+        const double latency_ms = static_cast<double>(state.ack_latency_ns) / 1e6;
+        const double cost = state.config.taker_fee + latency_penalty_per_ms_ * latency_ms;
+        return buy ? price * (1. + cost) : -price * (1. - cost);
+    }
+
+    [[nodiscard]] std::optional<size_t> select_venue(Side side, double size) const {
+        std::optional<size_t> best;
+        double best_score = std::numeric_limits<double>::infinity();
+        const auto now = helper::get_current_timestamp_ns();
+        for(size_t i = 0; i < venues_.size(); ++i) {
+            const auto [healthy, reason] = venue_healthcheck(venues_[i], now);
+            if(!healthy) {
+                LOG_ACTION_FAIL_DEBUG("score_hedge_venue", reason, f("venue", venues_[i].venue->get_instrument()));
+                continue;
+            }
+            const double venue_score = score(venues_[i], side, size);
+            LOG_ACTION_PASS_DEBUG("score_hedge_venue",
+                                  f("venue", venues_[i].venue->get_instrument()),
+                                  f("score", venue_score));
+            if(venue_score < best_score) {
+                best_score = venue_score;
+                best = i;
+            }
+        }
+        return best;
+    }
+
+    void send_hedge_order(VenueState& state, double size, Side side) {
+        const bool buy = side == Side::bid();
+        const auto now = helper::get_current_timestamp_ns();
+        if(state.execution.is_sliced()) {
+            state.execution.start_episode(now);
+        }
+        if(!state.execution.is_sliced() || state.execution.is_budget_exhausted(now)) {
+            const auto order_id = state.venue->place_order(0.0, size, buy, "market");
+            state.execution.finish_episode();
+            log_send_hedge(state, order_id, "market", size, side, "market");
+            return;
+        }
+        const auto plan = state.execution.plan(state.venue->get_book(), side, size);
+        for(const auto& slice : plan.slices) {
+            const auto order_id = state.venue->place_order(slice.price, slice.size, buy, "ioc");
+            log_send_hedge(state, order_id, std::to_string(slice.price), slice.size, side, "ioc");
+            if(order_id == 0) {
+                break;
+            }
+        }
+    }
+
+    static void log_send_hedge(const VenueState& state,
+                               uint64_t order_id,
+                               const std::string& price,
+                               double size,
+                               Side side,
+                               const std::string& order_type) {
+        log_action_attempt("send_hedge",
+                           f("client_order_id", order_id),
+                           f("role", "hedge"),
+                           f("instrument", state.venue->get_instrument()),
+                           f("price", price),
+                           f("size", size),
+                           f("side", side == Side::bid() ? "bid" : "ask"),
+                           f("order_type", order_type));
+    }
+
+    const QuotePositionManagerType& quote_position_manager_;
+    const double min_hedge_size_;
+    const uint64_t stale_threshold_ns_;
+    const double max_spread_;
+    const double latency_penalty_per_ms_;
+    std::vector<VenueState> venues_;
+
+    BookHealthPipeline<BookFreshnessCheck, BookSpreadCheck> book_health_{BookFreshnessCheck{stale_threshold_ns_},
+                                                                         BookSpreadCheck{max_spread_}};
+};
@@ -1,6 +1,8 @@
 #pragma once
 
 #include "../infra/book.hpp"
+#include "../utils/instrumentregistry.hpp"
+#include "HedgeExecution.h"
 #include "Side.h"
 #include "book_healthchecks.h"
 #include "format.h"
@@ -18,23 +20,24 @@ public:
                     const std::string& instrument,
                     double min_hedge_size,
                     uint64_t stale_threshold_ns,
-                    double max_spread)
+                    double max_spread,
+                    const HedgeExecutionConfig& execution_config = {})
         : hedge_executor_(hedge_executor)
         , quote_position_manager_(quote_position_manager)
         , hedge_position_manager_(hedge_position_manager)
         , hedge_book_{hedge_book}
         , instrument_(instrument)
+        , instrument_id_(mapping::InstrumentRegistry::instance().id(instrument))
         , min_hedge_size_{min_hedge_size}
         , stale_threshold_ns_{stale_threshold_ns}
-        , max_spread_{max_spread} {}
+        , max_spread_{max_spread}
+        , execution_{execution_config} {}
 
     [[nodiscard]] std::pair<bool, std::string> healthcheck() const {
-        if(!spread_checker_.check(hedge_book_)) {
-            LOG_ACTION_FAIL_DEBUG("check_hedger_health", "hedge_market_illiquid");
-            return {false, "hedge_market_illiquid"};
-        } else if(!freshness_checker_.check(hedge_book_)) {
-            LOG_ACTION_FAIL_DEBUG("check_hedger_health", "hedge_book_outdated");
-            return {false, "hedge_book_outdated"};
+        if(const auto health = book_health_.check(hedge_book_); health != BookHealth::Healthy) {
+            const auto reason = std::string("hedge_") + to_string(health);
+            LOG_ACTION_FAIL_DEBUG("check_hedger_health", reason);
+            return {false, reason};
         } else if(!hedge_executor_.isWebSocketReady()) {
             LOG_ACTION_FAIL_DEBUG("check_hedger_health", "hedge_ws_disconnected");
             return {false, "hedge_ws_disconnected"};
@@ -46,6 +49,7 @@ public:
         const auto total_exposure = calculate_total_exposure();
 
         if(!is_exposure_significant(total_exposure)) {
+            execution_.finish_episode();
             LOG_ACTION_PASS_DEBUG("hedge",
                                   f("reason", "total_exposure_within_min_hedge_size"),
                                   f("total_exposure", total_exposure),
@@ -74,31 +78,7 @@ private:
     [[nodiscard]] double get_hedge_position() const { return hedge_position_manager_.get_position(); }
     [[nodiscard]] double calculate_total_exposure() const { return get_quote_position() + get_hedge_position(); }
     [[nodiscard]] double get_potential_fill_size(Side::Type side) const {
-        const auto& pending_orders = hedge_executor_.getOrdersByStatus(OrderStatus::PENDING);
-
-        double total_size{0.};
-
-        for(auto order : pending_orders) {
-            if(order->m_side == (side == Side::Type::Bid)) {
-                total_size += order->m_qtySubmitted;
-            }
-        }
-
-        const auto& live_orders = hedge_executor_.getOrdersByStatus(OrderStatus::LIVE);
-        for(auto order : live_orders) {
-            if(order->m_side == (side == Side::Type::Bid)) {
-                total_size += order->m_qtyOnExch;
-            }
-        }
-
-        const auto& partially_filled_orders = hedge_executor_.getOrdersByStatus(OrderStatus::PARTIALLY_FILLED);
-        for(auto order : partially_filled_orders) {
-            if(order->m_side == (side == Side::Type::Bid)) {
-                total_size += order->m_qtyOnExch;
-            }
-        }
-
-        return total_size;
+        return hedge_executor_.getOutstandingQty(side == Side::Type::Bid);
     }
     [[nodiscard]] double calculate_unhedged_exposure(double exposure) const {
         if(exposure > 0.) {
@@ -116,8 +96,56 @@ private:
     [[nodiscard]] Side determine_hedge_side(double exposure) const { return exposure > 0. ? Side::ask() : Side::bid(); }
     [[nodiscard]] const std::string& get_instrument() const { return instrument_; }
 
-    void send_hedge_order(double size, Side side) const {
-        const auto order_id = hedge_executor_.placeOrder(instrument_, 0.0, size, side == Side::bid(), "market");
+    void send_hedge_order(double size, Side side) {
+        if(!execution_.is_sliced()) {
+            send_market_hedge(size, side);
+            return;
+        }
+
+        const auto now = helper::get_current_timestamp_ns();
+        execution_.start_episode(now);
+        if(execution_.is_budget_exhausted(now)) {
+            log_action_attempt("hedge_budget_exhausted",
+                               f("remaining", size),
+                               f("episode_age_ns", execution_.episode_age_ns(now)));
+            send_market_hedge(size, side);
+            execution_.finish_episode();
+            return;
+        }
+
+        const auto plan = execution_.plan(hedge_book_, side, size);
+        if(plan.slices.empty()) {
+            send_market_hedge(size, side);
+            return;
+        }
+        log_action_attempt("plan_hedge",
+                           f("size", size),
+                           f("side", side == Side::bid() ? "bid" : "ask"),
+                           f("touch", plan.touch),
+                           f("limit_price", plan.limit_price),
+                           f("visible_size", plan.visible_size),
+                           f("expected_vwap", plan.expected_vwap),
+                           f("impact", plan.impact),
+                           f("slices", plan.slices.size()));
+        for(const auto& slice : plan.slices) {
+            const auto order_id =
+                hedge_executor_.placeOrder(instrument_id_, slice.price, slice.size, side == Side::bid(), "ioc");
+            log_action_attempt("send_hedge",
+                               f("client_order_id", order_id),
+                               f("role", "hedge"),
+                               f("instrument", instrument_),
+                               f("price", slice.price),
+                               f("size", slice.size),
+                               f("side", side == Side::bid() ? "bid" : "ask"),
+                               f("order_type", "ioc"));
+            if(order_id == 0) {
+                break;
+            }
+        }
+    }
+
+    void send_market_hedge(double size, Side side) const {
+        const auto order_id = hedge_executor_.placeOrder(instrument_id_, 0.0, size, side == Side::bid(), "market");
         log_action_attempt("send_hedge",
                            f("client_order_id", order_id),
                            f("role", "hedge"),
@@ -134,10 +162,12 @@ private:
     const HedgePositionManagerType& hedge_position_manager_;
     const Book& hedge_book_;
     const std::string& instrument_;
+    const mapping::InstrumentId instrument_id_;
     const double min_hedge_size_;
     double max_spread_;
     uint64_t stale_threshold_ns_;
 
-    BookSpreadChecker spread_checker_{max_spread_};
-    BookFreshnessChecker freshness_checker_{stale_threshold_ns_};
+    BookHealthPipeline<BookSpreadCheck, BookFreshnessCheck> book_health_{BookSpreadCheck{max_spread_},
+                                                                         BookFreshnessCheck{stale_threshold_ns_}};
+    HedgeExecution execution_;
 };
@@ -0,0 +1,71 @@
+#pragma once
+
+#include "Configuration.h"
+#include <optional>
+#include <string>
+#include <vector>
+
+/**
+ * @class InstanceConfiguration
+ * @brief Strategy config as seen by one strategy instance of a multi-instrument runtime.
+ *
+ * Every top-level section the instance entry defines (e.g. markets, orders, bybit_position)
+ * shadows the section of the same name in the shared config; all other sections are shared.
+ * Without an instance entry this is the plain single-instrument config.
+ * @example
+ *   // instances:
+ *   //   - name: "eth"
+ *   //     markets: {...}
+ *   for(const auto& instance : InstanceConfiguration::load_all(config)) {
+ *     instance.child("markets");           // the instance's markets
+ *     instance.child("exchange_stability"); // the shared section
+ *   }
+ */
+class InstanceConfiguration {
+public:
+    explicit InstanceConfiguration(Configuration root, std::optional<Configuration> instance = std::nullopt)
+        : root_(std::move(root))
+        , instance_(std::move(instance)) {}
+
+    /**
+     * @brief One view per entry of the top-level `instances` sequence, or a single view of the
+     *        whole config when there is no such sequence.
+     */
+    static std::vector<InstanceConfiguration> load_all(const Configuration& root) {
+        std::vector<InstanceConfiguration> instances;
+        if(!root.has_key("instances")) {
+            instances.emplace_back(root);
+            return instances;
+        }
+        root.child("instances").for_each_child(
+            [&](const Configuration& instance) { instances.emplace_back(root, instance); });
+        if(instances.empty()) {
+            throw std::runtime_error("instances must list at least one strategy instance");
+        }
+        return instances;
+    }
+
+    [[nodiscard]] Configuration child(const std::string& key) const {
+        if(instance_ && instance_->has_key(key)) {
+            return instance_->child(key);
+        }
+        return root_.child(key);
+    }
+
+    [[nodiscard]] bool has_key(const std::string& key) const {
+        return (instance_ && instance_->has_key(key)) || root_.has_key(key);
+    }
+
+    // Instance name used in logs and per-instance resource names, "default" for a single instance
+    [[nodiscard]] std::string name() const {
+        return instance_ ? instance_->get<std::string>("name", "default") : std::string{"default"};
+    }
+
+    [[nodiscard]] bool is_instance() const { return instance_.has_value(); }
+
+    [[nodiscard]] const Configuration& root() const { return root_; }
+
+private:
+    Configuration root_;
+    std::optional<Configuration> instance_;
+};
@@ -0,0 +1,202 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <limits>
+#include <unordered_map>
+#include <vector>
+
+enum class PendingAction : uint8_t {
+    Submit,
+    Cancel,
+    Modify,
+};
+
+// Orders waiting for an exchange acknowledgement of a submit, cancel or modify. Every action has a
+// constant threshold, so deadlines are ordered like insertions and each action keeps a FIFO list:
+// expired orders are the head of the list and are visited in O(expired) without allocating. An
+// order can be pending in several actions at once, e.g. a cancel sent before the submit ack.
+// Lookups go through one id map per action; list nodes are pooled and reused.
+// @example
+//   using namespace std::chrono_literals;
+//   PendingActionTracker<> pending(2s, 500ms, 2s); // submit, cancel resend, modify
+//   pending.add(PendingAction::Cancel, order_id);
+//   pending.for_each_expired(PendingAction::Cancel, [&](uint64_t id) {
+//       resend_cancel(id);
+//       pending.rearm(PendingAction::Cancel, id); // next resend one interval later
+//   });
+template<typename Clock = std::chrono::system_clock>
+class PendingActionTracker {
+public:
+    using TimePoint = typename Clock::time_point;
+    using Duration = typename Clock::duration;
+    using OrderId = uint64_t;
+
+    static constexpr size_t ACTION_COUNT = static_cast<size_t>(PendingAction::Modify) + 1;
+
+    PendingActionTracker(Duration submit_threshold, Duration cancel_resend_interval, Duration modify_threshold) {
+        actions_[index(PendingAction::Submit)].threshold = submit_threshold;
+        actions_[index(PendingAction::Cancel)].threshold = cancel_resend_interval;
+        actions_[index(PendingAction::Modify)].threshold = modify_threshold;
+    }
+
+    // False if the order is already pending for this action, its deadline is kept
+    bool add(PendingAction action, OrderId order_id, TimePoint now = Clock::now()) {
+        auto& list = actions_[index(action)];
+        const auto [it, inserted] = list.ids.try_emplace(order_id, NIL);
+        if(!inserted) {
+            return false;
+        }
+        const uint32_t node = allocate(order_id, now + list.threshold);
+        it->second = node;
+        push_back(list, node);
+        return true;
+    }
+
+    bool remove(PendingAction action, OrderId order_id) {
+        auto& list = actions_[index(action)];
+        const auto it = list.ids.find(order_id);
+        if(it == list.ids.end()) {
+            return false;
+        }
+        const uint32_t node = it->second;
+        list.ids.erase(it);
+        unlink(list, node);
+        free_.push_back(node);
+        return true;
+    }
+
+    // Order reached a final state, nothing of it is pending any more
+    void remove_all(OrderId order_id) {
+        for(size_t action = 0; action < ACTION_COUNT; ++action) {
+            remove(static_cast<PendingAction>(action), order_id);
+        }
+    }
+
+    // Restarts the threshold of a pending order, e.g. after resending its cancel
+    bool rearm(PendingAction action, OrderId order_id, TimePoint now = Clock::now()) {
+        auto& list = actions_[index(action)];
+        const auto it = list.ids.find(order_id);
+        if(it == list.ids.end()) {
+            return false;
+        }
+        const uint32_t node = it->second;
+        unlink(list, node);
+        nodes_[node].deadline = now + list.threshold;
+        push_back(list, node);
+        return true;
+    }
+
+    [[nodiscard]] bool has(PendingAction action, OrderId order_id) const {
+        return actions_[index(action)].ids.count(order_id) > 0;
+    }
+
+    // Calls fn(order_id) for every order of the action pending for at least its threshold, oldest
+    // first. fn may remove or rearm the order it is given, but no other order of the same action.
+    template<typename Fn>
+    size_t for_each_expired(PendingAction action, Fn&& fn, TimePoint now = Clock::now()) {
+        const auto& list = actions_[index(action)];
+        // rearmed orders go behind the last expired one, stop there instead of visiting them again
+        const uint32_t last = last_expired(list, now);
+        if(last == NIL) {
+            return 0;
+        }
+        size_t visited = 0;
+        uint32_t node = list.head;
+        while(node != NIL) {
+            const uint32_t next = nodes_[node].next;
+            const bool is_last = node == last;
+            fn(nodes_[node].order_id);
+            ++visited;
+            if(is_last) {
+                break;
+            }
+            node = next;
+        }
+        return visited;
+    }
+
+    [[nodiscard]] size_t expired_count(PendingAction action, TimePoint now = Clock::now()) const {
+        size_t count = 0;
+        for(uint32_t node = actions_[index(action)].head; node != NIL && nodes_[node].deadline <= now;
+            node = nodes_[node].next) {
+            ++count;
+        }
+        return count;
+    }
+
+    [[nodiscard]] size_t size(PendingAction action) const { return actions_[index(action)].ids.size(); }
+
+    [[nodiscard]] Duration threshold(PendingAction action) const { return actions_[index(action)].threshold; }
+
+private:
+    static constexpr uint32_t NIL = std::numeric_limits<uint32_t>::max();
+
+    struct Node {
+        OrderId order_id = 0;
+        TimePoint deadline{};
+        uint32_t prev = NIL;
+        uint32_t next = NIL;
+    };
+
+    struct ActionList {
+        Duration threshold{};
+        uint32_t head = NIL;
+        uint32_t tail = NIL;
+        std::unordered_map<OrderId, uint32_t> ids;
+    };
+
+    static size_t index(PendingAction action) { return static_cast<size_t>(action); }
+
+    uint32_t allocate(OrderId order_id, TimePoint deadline) {
+        uint32_t node;
+        if(!free_.empty()) {
+            node = free_.back();
+            free_.pop_back();
+        } else {
+            node = static_cast<uint32_t>(nodes_.size());
+            nodes_.emplace_back();
+        }
+        nodes_[node].order_id = order_id;
+        nodes_[node].deadline = deadline;
+        return node;
+    }
+
+    void push_back(ActionList& list, uint32_t node) {
+        nodes_[node].prev = list.tail;
+        nodes_[node].next = NIL;
+        if(list.tail != NIL) {
+            nodes_[list.tail].next = node;
+        } else {
+            list.head = node;
+        }
+        list.tail = node;
+    }
+
+    void unlink(ActionList& list, uint32_t node) {
+        const Node& n = nodes_[node];
+        if(n.prev != NIL) {
+            nodes_[n.prev].next = n.next;
+        } else {
+            list.head = n.next;
+        }
+        if(n.next != NIL) {
+            nodes_[n.next].prev = n.prev;
+        } else {
+            list.tail = n.prev;
+        }
+    }
+
+    uint32_t last_expired(const ActionList& list, TimePoint now) const {
+        uint32_t last = NIL;
+        for(uint32_t node = list.head; node != NIL && nodes_[node].deadline <= now; node = nodes_[node].next) {
+            last = node;
+        }
+        return last;
+    }
+
+    std::array<ActionList, ACTION_COUNT> actions_{};
+    std::vector<Node> nodes_;
+    std::vector<uint32_t> free_;
+};
@@ -1,7 +1,6 @@
 #pragma once
 
 #include "../utils/instrumentmappings.hpp"
-#include "../utils/staticparams.hpp"
 #include "Configuration.h"
 #include "PnlManager.h"
 #include "bybitclient.hpp"
@@ -346,10 +345,8 @@ private:
 
                     // Apply instrument-specific multipliers
                     const std::string instId = tradeJson["instId"];
-                    if(instId == "DOGE-USDT-SWAP") {
-                        quantity *= okx::DOGE_USDT_SWAP::dogePerpCtMul * okx::DOGE_USDT_SWAP::dogePerpCtVal;
-                    } else if(instId == "BTC-USDT-SWAP") {
-                        quantity *= okx::BTC_USDT_SWAP::btcPerpCtMul * okx::BTC_USDT_SWAP::btcPerpCtVal;
+                    if(const auto* spec = mapping::InstrumentRegistry::instance().findBySymbol("okx", instId)) {
+                        quantity = spec->toBaseQty(quantity);
                     }
 
                     return quantity;
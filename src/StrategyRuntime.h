@@ -0,0 +1,139 @@
+#pragma once
+
+#include "../infra/timer.hpp"
+#include "../utils/latency.hpp"
+#include "../utils/logger.hpp"
+#include "Configuration.h"
+#include "CoreLayout.h"
+#include "InstanceConfiguration.h"
+#include "VenueConnections.h"
+#include "logging.h"
+#include "strategy.hpp"
+#include <memory>
+#include <optional>
+#include <set>
+#include <string>
+#include <vector>
+
+/**
+ * @class StrategyRuntime
+ * @brief Runs every strategy instance of the config (e.g. BTC, ETH and DOGE pairs) in one process.
+ *
+ * The instances share the multiplexed feeds and the order stacks of VenueConnections, each has its
+ * own event queue and event loop thread. Threads are placed by the CoreLayout. Signal drives the runtime like a
+ * single strategy: trading starts once every instance is ready.
+ */
+class StrategyRuntime {
+public:
+    explicit StrategyRuntime(Configuration config)
+        : config_(std::move(config))
+        , core_layout_(CoreLayout::from_config(config_))
+        , instances_(checked_instances(config_))
+        , venues_(config_, instances_) {
+        std::vector<VenueConnections::InstanceVenues> acquired;
+        acquired.reserve(instances_.size());
+        for(const auto& instance : instances_) {
+            acquired.push_back(venues_.acquire(instance));
+        }
+        venues_.start();
+        for(size_t i = 0; i < instances_.size(); ++i) {
+            strategies_.push_back(std::make_unique<Strategy>(instances_[i], acquired[i]));
+        }
+        start_latency_reporting();
+        log_action_pass("construct_strategy_runtime", f("instances", strategies_.size()));
+    }
+
+    StrategyRuntime(const StrategyRuntime&) = delete;
+    StrategyRuntime& operator=(const StrategyRuntime&) = delete;
+    StrategyRuntime(StrategyRuntime&&) = delete;
+    StrategyRuntime& operator=(StrategyRuntime&&) = delete;
+
+    ~StrategyRuntime() {
+        cleanup();
+        log_action_pass("destruct_strategy_runtime");
+    }
+
+    // NOTE: This function is called by class Signal at infra side
+    bool is_trading_ready() const {
+        for(const auto& strategy : strategies_) {
+            if(!strategy->is_trading_ready()) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // NOTE: This function is called by class Signal at infra side
+    void initialize_trading() {
+        venues_.pin_threads(core_layout_);
+        for(auto& strategy : strategies_) {
+            strategy->initialize_trading();
+        }
+        venues_.install_callbacks();
+        log_action_pass("initialize_trading", f("instances", strategies_.size()));
+    }
+
+    // NOTE: This function is called by class Signal at infra side
+    void start_trading() {
+        for(size_t i = 0; i < strategies_.size(); ++i) {
+            strategies_[i]->start_trading(core_layout_.core(CoreLayout::Role::Strategy, i));
+        }
+    }
+
+private:
+    // Two instances quoting one instrument would share its order stack and fight over its position
+    static std::vector<InstanceConfiguration> checked_instances(const Configuration& config) {
+        auto instances = InstanceConfiguration::load_all(config);
+        std::set<std::string> quotes;
+        for(const auto& instance : instances) {
+            const auto quote = instance.child("markets").child("quote").get<std::string>("name");
+            if(!quotes.insert(quote).second) {
+                throw std::runtime_error("instance " + instance.name() + " quotes " + quote +
+                                         " which another instance already quotes");
+            }
+        }
+        return instances;
+    }
+
+    // The latency registry is process-wide, every instance publishes the same interval
+    void start_latency_reporting() {
+        bool enabled = true;
+        uint64_t dump_interval_ms = 10000;
+        if(config_.has_key("latency_instrumentation")) {
+            enabled = config_.child("latency_instrumentation").get<bool>("enabled", true);
+            dump_interval_ms = config_.child("latency_instrumentation").get<uint64_t>("dump_interval_ms", 10000);
+        }
+        latency::LatencyRegistry::instance().setEnabled(enabled);
+        if(enabled) {
+            latency_timer_.addCallback([this] {
+                const auto quantiles = latency::LatencyRegistry::instance().logInterval();
+                for(auto& strategy : strategies_) {
+                    strategy->publish_latency(quantiles);
+                }
+            });
+            latency_timer_.start(dump_interval_ms);
+        }
+        log_action_pass("start_latency_reporting", f("enabled", enabled), f("dump_interval_ms", dump_interval_ms));
+    }
+
+    void cleanup() {
+        latency_timer_.stop();
+        venues_.stop_trading_managers();
+        for(auto& strategy : strategies_) {
+            strategy->stop();
+        }
+        venues_.stop_all_ws();
+        venues_.join_threads();
+        if(latency::LatencyRegistry::instance().isEnabled()) {
+            latency::LatencyRegistry::instance().logInterval();
+        }
+        log_action_pass("cleanup");
+    }
+
+    Configuration config_;
+    CoreLayout core_layout_;
+    std::vector<InstanceConfiguration> instances_;
+    VenueConnections venues_;
+    std::vector<std::unique_ptr<Strategy>> strategies_;
+    Timer latency_timer_{};
+};
@@ -1,22 +1,231 @@
+#pragma once
+
+#include <algorithm>
 #include <chrono>
 #include <cmath>
 #include <nlohmann/json.hpp>
+#include <stdexcept>
+#include <string>
 #include <vector>
 
+// Fill statistics of a strategy over a session that runs for weeks. Lifetime metrics are running
+// accumulators and every rolling window keeps its trades in a fixed-size ring buffer, so memory is
+// constant however many fills arrive. A window holds the trades of its time horizon, capped at its
+// last max_trades trades; a zero horizon makes it a pure last-N-trades window.
+// @example
+//   TradeAnalysis analysis({{"1m", std::chrono::minutes(1), 4096}, {"last_100", {}, 100}});
+//   analysis.add_trade({now, 65000.0, 0.01, true, true});
+//   analysis.expire(std::chrono::system_clock::now()); // before publishing, drops trades out of the horizons
+//   analysis.get_status()["windows"]["1m"]["vwap"];
 class TradeAnalysis {
 public:
+    using Clock = std::chrono::system_clock;
+
     struct Trade {
-        std::chrono::system_clock::time_point timestamp;
+        Clock::time_point timestamp;
         double price;
         double quantity;
         bool is_buy; // true for buy, false for sell
         bool is_maker; // true for maker, false for taker
     };
 
+    struct WindowConfig {
+        std::string name;
+        Clock::duration horizon; // zero: bounded by max_trades only
+        size_t max_trades;
+    };
+
+    // Welford mean and variance, samples can be removed again in any order they were added
+    class RunningStats {
+    public:
+        void add(double x) {
+            ++count_;
+            const double delta = x - mean_;
+            mean_ += delta / static_cast<double>(count_);
+            m2_ += delta * (x - mean_);
+        }
+
+        void remove(double x) {
+            if(count_ <= 1) {
+                reset();
+                return;
+            }
+            const double delta = x - mean_;
+            --count_;
+            mean_ -= delta / static_cast<double>(count_);
+            m2_ = std::max(0.0, m2_ - delta * (x - mean_));
+        }
+
+        void reset() {
+            count_ = 0;
+            mean_ = 0.0;
+            m2_ = 0.0;
+        }
+
+        [[nodiscard]] size_t count() const { return count_; }
+        [[nodiscard]] double mean() const { return mean_; }
+        // Sample standard deviation
+        [[nodiscard]] double stddev() const {
+            return count_ > 1 ? std::sqrt(m2_ / static_cast<double>(count_ - 1)) : 0.0;
+        }
+
+    private:
+        size_t count_ = 0;
+        double mean_ = 0.0;
+        double m2_ = 0.0;
+    };
+
+    // Sliding sums over the trades of a ring buffer. Sums are updated on every push and eviction
+    // and recomputed from the buffer once per capacity evictions, which bounds the floating-point
+    // drift of long add/subtract chains at O(1) amortized cost.
+    class RollingWindow {
+    public:
+        explicit RollingWindow(WindowConfig config)
+            : config_(std::move(config)) {
+            if(config_.max_trades == 0) {
+                throw std::invalid_argument("trade analysis window " + config_.name + " needs max_trades > 0");
+            }
+            ring_.resize(config_.max_trades);
+        }
+
+        void add(const Trade& trade) {
+            expire(trade.timestamp);
+            if(size_ == ring_.size()) {
+                evict();
+            }
+            ring_[(head_ + size_) % ring_.size()] = trade;
+            ++size_;
+            accumulate(trade, 1.0);
+            sizes_.add(trade.quantity);
+        }
+
+        // Drops trades older than the horizon
+        void expire(Clock::time_point now) {
+            if(config_.horizon == Clock::duration::zero()) {
+                return;
+            }
+            while(size_ > 0 && ring_[head_].timestamp + config_.horizon <= now) {
+                evict();
+            }
+        }
+
+        void reset() {
+            head_ = 0;
+            size_ = 0;
+            evictions_ = 0;
+            sums_ = {};
+            sizes_.reset();
+        }
+
+        [[nodiscard]] const std::string& name() const { return config_.name; }
+        [[nodiscard]] size_t trade_count() const { return size_; }
+        [[nodiscard]] size_t buy_count() const { return sums_.buy_count; }
+        [[nodiscard]] size_t sell_count() const { return size_ - sums_.buy_count; }
+        [[nodiscard]] double volume() const { return sums_.buy_value + sums_.sell_value; }
+        [[nodiscard]] double net_delta() const { return sums_.buy_quantity - sums_.sell_quantity; }
+        [[nodiscard]] double vwap() const {
+            const double quantity = sums_.buy_quantity + sums_.sell_quantity;
+            return quantity > 0 ? volume() / quantity : 0.0;
+        }
+        [[nodiscard]] double maker_ratio() const {
+            return size_ > 0 ? static_cast<double>(sums_.maker_count) / static_cast<double>(size_) : 0.0;
+        }
+        [[nodiscard]] double maker_volume() const { return sums_.maker_value; }
+        [[nodiscard]] double average_trade_size() const { return sizes_.mean(); }
+        [[nodiscard]] double trade_size_volatility() const { return sizes_.stddev(); }
+
+        [[nodiscard]] nlohmann::json get_status() const {
+            return {{"trades", trade_count()},
+                    {"buys", buy_count()},
+                    {"sells", sell_count()},
+                    {"volume", volume()},
+                    {"maker_volume", maker_volume()},
+                    {"net_delta", net_delta()},
+                    {"vwap", vwap()},
+                    {"maker_ratio", maker_ratio()},
+                    {"average_trade_size", average_trade_size()},
+                    {"trade_size_volatility", trade_size_volatility()}};
+        }
+
+    private:
+        struct Sums {
+            double buy_quantity = 0.0;
+            double sell_quantity = 0.0;
+            double buy_value = 0.0;
+            double sell_value = 0.0;
+            double maker_value = 0.0;
+            size_t buy_count = 0;
+            size_t maker_count = 0;
+        };
+
+        // sign is +1 to add a trade and -1 to remove it
+        void accumulate(const Trade& trade, double sign) {
+            const double value = trade.price * trade.quantity;
+            if(trade.is_buy) {
+                sums_.buy_quantity += sign * trade.quantity;
+                sums_.buy_value += sign * value;
+                sums_.buy_count += sign > 0 ? 1 : -1;
+            } else {
+                sums_.sell_quantity += sign * trade.quantity;
+                sums_.sell_value += sign * value;
+            }
+            if(trade.is_maker) {
+                sums_.maker_value += sign * value;
+                sums_.maker_count += sign > 0 ? 1 : -1;
+            }
+        }
+
+        void evict() {
+            const Trade& oldest = ring_[head_];
+            accumulate(oldest, -1.0);
+            sizes_.remove(oldest.quantity);
+            head_ = (head_ + 1) % ring_.size();
+            --size_;
+            if(++evictions_ >= ring_.size()) {
+                resum();
+            }
+        }
+
+        void resum() {
+            evictions_ = 0;
+            sums_ = {};
+            sizes_.reset();
+            for(size_t i = 0; i < size_; ++i) {
+                const Trade& trade = ring_[(head_ + i) % ring_.size()];
+                accumulate(trade, 1.0);
+                sizes_.add(trade.quantity);
+            }
+        }
+
+        WindowConfig config_;
+        std::vector<Trade> ring_;
+        size_t head_ = 0;
+        size_t size_ = 0;
+        size_t evictions_ = 0;
+        Sums sums_;
+        RunningStats sizes_;
+    };
+
+    static std::vector<WindowConfig> default_windows() {
+        return {{"1m", std::chrono::minutes(1), 4096},
+                {"5m", std::chrono::minutes(5), 16384},
+                {"last_100", Clock::duration::zero(), 100}};
+    }
+
+    TradeAnalysis()
+        : TradeAnalysis(default_windows()) {}
+
+    explicit TradeAnalysis(const std::vector<WindowConfig>& windows) {
+        windows_.reserve(windows.size());
+        for(const auto& window : windows) {
+            windows_.emplace_back(window);
+        }
+    }
+
     // Basic counts
     [[nodiscard]] size_t total_trade_count() const { return buy_count() + sell_count(); }
-    [[nodiscard]] size_t buy_count() const { return buy_trades_.size(); }
-    [[nodiscard]] size_t sell_count() const { return sell_trades_.size(); }
+    [[nodiscard]] size_t buy_count() const { return buy_count_; }
+    [[nodiscard]] size_t sell_count() const { return sell_count_; }
 
     // Maker/Taker metrics
     [[nodiscard]] size_t maker_count() const { return maker_trades_count_; }
@@ -39,10 +248,10 @@ public:
 
     // Price metrics
     [[nodiscard]] double average_buy_price() const {
-        return buy_trades_.empty() ? 0.0 : total_buy_value_ / total_buy_quantity_;
+        return buy_count_ == 0 ? 0.0 : total_buy_value_ / total_buy_quantity_;
     }
     [[nodiscard]] double average_sell_price() const {
-        return sell_trades_.empty() ? 0.0 : total_sell_value_ / total_sell_quantity_;
+        return sell_count_ == 0 ? 0.0 : total_sell_value_ / total_sell_quantity_;
     }
     [[nodiscard]] double weighted_average_price() const {
         const double total_quantity = total_buy_quantity_ + total_sell_quantity_;
@@ -62,31 +271,23 @@ public:
 
     // Risk metrics
     [[nodiscard]] double largest_single_trade_value() const { return max_single_trade_value_; }
-    [[nodiscard]] double average_trade_size() const {
-        if(size_stats_.count == 0) return 0.0;
-        return size_stats_.sum / size_stats_.count;
-    }
-    [[nodiscard]] double trade_size_volatility() const {
-        if(size_stats_.count <= 1) return 0.0;
-
-        double mean = average_trade_size();
-        double variance = (size_stats_.sum_squares - 2 * mean * size_stats_.sum + size_stats_.count * mean * mean) /
-                          (size_stats_.count - 1);
+    [[nodiscard]] double average_trade_size() const { return size_stats_.mean(); }
+    [[nodiscard]] double trade_size_volatility() const { return size_stats_.stddev(); }
 
-        return std::sqrt(std::max(0.0, variance));
-    }
+    // Rolling windows, in the order they were configured
+    [[nodiscard]] const std::vector<RollingWindow>& windows() const { return windows_; }
 
     // Add a new trade to the analysis
     void add_trade(const Trade& trade) {
         if(trade.is_buy) {
-            buy_trades_.push_back(trade);
+            buy_count_++;
             total_buy_quantity_ += trade.quantity;
             total_buy_value_ += trade.price * trade.quantity;
             if(trade.is_maker) {
                 buy_maker_count_++;
             }
         } else {
-            sell_trades_.push_back(trade);
+            sell_count_++;
             total_sell_quantity_ += trade.quantity;
             total_sell_value_ += trade.price * trade.quantity;
             if(trade.is_maker) {
@@ -104,13 +305,23 @@ public:
         double trade_value = trade.price * trade.quantity;
         max_single_trade_value_ = std::max(max_single_trade_value_, trade_value);
 
-        update_size_statistics(trade.quantity);
+        size_stats_.add(trade.quantity);
+        for(auto& window : windows_) {
+            window.add(trade);
+        }
+    }
+
+    // Drops trades that left the window horizons, call before reading windowed metrics on a quiet market
+    void expire(Clock::time_point now) {
+        for(auto& window : windows_) {
+            window.expire(now);
+        }
     }
 
     // Reset analysis
     void reset() {
-        buy_trades_.clear();
-        sell_trades_.clear();
+        buy_count_ = 0;
+        sell_count_ = 0;
         total_buy_quantity_ = 0.0;
         total_sell_quantity_ = 0.0;
         total_buy_value_ = 0.0;
@@ -120,6 +331,10 @@ public:
         buy_maker_count_ = 0;
         sell_maker_count_ = 0;
         maker_volume_ = 0.0;
+        size_stats_.reset();
+        for(auto& window : windows_) {
+            window.reset();
+        }
     }
 
     // Add this function before the private section
@@ -162,12 +377,18 @@ public:
         // Ratios
         status["ratios"] = {{"maker", maker_ratio()}, {"buy_sell", buy_sell_ratio()}};
 
+        // Rolling windows
+        status["windows"] = nlohmann::json::object();
+        for(const auto& window : windows_) {
+            status["windows"][window.name()] = window.get_status();
+        }
+
         return status;
     }
 
 private:
-    std::vector<Trade> buy_trades_;
-    std::vector<Trade> sell_trades_;
+    size_t buy_count_ = 0;
+    size_t sell_count_ = 0;
     double total_buy_quantity_ = 0.0;
     double total_sell_quantity_ = 0.0;
     double total_buy_value_ = 0.0;
@@ -180,15 +401,6 @@ private:
     size_t sell_maker_count_ = 0;
     double maker_volume_ = 0.0;
 
-    struct SizeStatistics {
-        double sum = 0.0;
-        double sum_squares = 0.0;
-        size_t count = 0;
-    } size_stats_;
-
-    void update_size_statistics(double size) {
-        size_stats_.sum += size;
-        size_stats_.sum_squares += size * size;
-        size_stats_.count++;
-    }
+    RunningStats size_stats_;
+    std::vector<RollingWindow> windows_;
 };
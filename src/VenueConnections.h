@@ -0,0 +1,759 @@
+#pragma once
+
+#include "../infra/binancewebsocket.hpp"
+#include "../infra/bybitwebsocket.hpp"
+#include "../infra/okxwebsocket.hpp"
+#include "../infra/redundantfeed.hpp"
+#include "../infra/timer.hpp"
+#include "../oms/bybitfills.hpp"
+#include "../oms/bybitordermanager.hpp"
+#include "../oms/bybitpositionmanager.hpp"
+#include "../oms/okxordermanager.hpp"
+#include "../oms/okxpositionmanager.hpp"
+#include "../utils/connections.hpp"
+#include "../utils/instrumentmappings.hpp"
+#include "../utils/logger.hpp"
+#include "../utils/pinthreads.hpp"
+#include "Configuration.h"
+#include "CoreLayout.h"
+#include "InstanceConfiguration.h"
+#include "logging.h"
+#include <algorithm>
+#include <functional>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Callbacks of every strategy instance using one shared connection, invoked in subscription order
+// on the connection's thread. Subscriptions are only added before VenueConnections::install_callbacks.
+template<typename... Args>
+class CallbackFanout {
+public:
+    void add(std::function<void(Args...)> callback) { callbacks_.push_back(std::move(callback)); }
+
+    [[nodiscard]] size_t size() const { return callbacks_.size(); }
+
+    void operator()(Args... args) const {
+        for(const auto& callback : callbacks_) {
+            callback(args...);
+        }
+    }
+
+private:
+    std::vector<std::function<void(Args...)>> callbacks_;
+};
+
+/**
+ * @class VenueConnections
+ * @brief Market-data feeds and order stacks of all strategy instances in the process.
+ *
+ * Instances quoting or hedging the same instrument share its feed and order stack. The market data
+ * of a venue is multiplexed: the distinct instruments of all instances are subscribed in chunks of
+ * `md_multiplexing.symbols_per_connection` (0 or absent: all of them) per RedundantFeed, and every
+ * frame is routed to the book of its symbol. Order stacks stay one per (venue, instrument). Feeds
+ * are built by the constructor, order stacks by acquire(); both keep their creation order for the
+ * per-role core assignment of the CoreLayout.
+ */
+class VenueConnections {
+public:
+    template<typename Client>
+    struct MdFeed {
+        MdFeed(std::vector<std::string> instrument_names,
+               size_t connections,
+               const typename RedundantFeed<Client>::Factory& factory)
+            : instruments(std::move(instrument_names))
+            , feed(connections, factory)
+            , on_update(mapping::InstrumentRegistry::instance().size()) {}
+
+        // Registry id of the instrument if this feed carries it, InstrumentRegistry::INVALID otherwise
+        [[nodiscard]] mapping::InstrumentId instrument_id(const std::string& instrument) const {
+            if(std::find(instruments.begin(), instruments.end(), instrument) == instruments.end()) {
+                return mapping::InstrumentRegistry::INVALID;
+            }
+            return mapping::InstrumentRegistry::instance().id(instrument);
+        }
+
+        const std::vector<std::string> instruments;
+        RedundantFeed<Client> feed;
+        std::vector<CallbackFanout<>> on_update; // by InstrumentRegistry id, empty for other instruments
+        CallbackFanout<bool> on_status;          // the connection is shared by all symbols
+    };
+
+    // One instrument of a multiplexed feed, as seen by a strategy instance
+    template<typename Client>
+    struct MdSymbol {
+        MdSymbol(MdFeed<Client>& md, mapping::InstrumentId instrument)
+            : feed(md.feed)
+            , instrument(instrument)
+            , on_update(md.on_update[instrument])
+            , on_status(md.on_status) {}
+
+        [[nodiscard]] TopOfBook top_of_book() const { return feed.getTopOfBook(instrument); }
+
+        [[nodiscard]] bool is_ready() const { return feed.isBookReady(instrument); }
+
+        RedundantFeed<Client>& feed;
+        const mapping::InstrumentId instrument;
+        CallbackFanout<>& on_update;
+        CallbackFanout<bool>& on_status;
+    };
+
+    struct BybitOrderStack {
+        explicit BybitOrderStack(const InstanceConfiguration& config)
+            : instrument(config.child("markets").child("quote").get<std::string>("name"))
+            , position_manager(create_bybit_position_manager(config))
+            , order_manager(create_bybit_order_manager(config, position_manager))
+            , fills_manager(create_bybit_fills_manager(config, order_manager)) {}
+
+        const std::string instrument;
+        ByBitPositionManager position_manager;
+        ByBitOrderManager order_manager;
+        ByBitFills fills_manager;
+        CallbackFanout<OrderHandler&> on_order_update;
+        CallbackFanout<bool> on_status;
+        std::thread order_thread;
+        std::thread fills_thread;
+    };
+
+    struct OkxOrderStack {
+        explicit OkxOrderStack(const InstanceConfiguration& config)
+            : instrument(config.child("markets").child("hedge").get<std::string>("name"))
+            , position_manager(create_okx_position_manager(config))
+            , order_manager(create_okx_order_manager(config, position_manager)) {}
+
+        const std::string instrument;
+        OkxPositionManager position_manager;
+        OkxOrderManager order_manager;
+        CallbackFanout<OrderHandler&> on_order_update;
+        CallbackFanout<bool> on_status;
+        std::thread order_thread;
+    };
+
+    // Everything one strategy instance trades on
+    struct InstanceVenues {
+        MdSymbol<BinanceWebSocketClient> binance;
+        MdSymbol<ByBitWebSocketClient> bybit;
+        MdSymbol<OKXWebSocketClient> okx;
+        BybitOrderStack& bybit_orders;
+        OkxOrderStack& okx_orders;
+    };
+
+    // Subscribes the market data of every instance, see md_chunks() for how symbols share sockets
+    VenueConnections(Configuration config, const std::vector<InstanceConfiguration>& instances)
+        : config_(std::move(config)) {
+        create_md_feeds(binance_feeds_, instances, "binance", reference_instrument, create_binance_ws_client);
+        create_md_feeds(bybit_feeds_, instances, "bybit", quote_instrument, create_bybit_ws_client);
+        create_md_feeds(okx_feeds_, instances, "okx", hedge_instrument, create_okx_ws_client);
+    }
+
+    VenueConnections(const VenueConnections&) = delete;
+    VenueConnections& operator=(const VenueConnections&) = delete;
+
+    ~VenueConnections() {
+        stop_trading_managers();
+        stop_all_ws();
+        join_threads();
+    }
+
+    // Must be called for every instance before start()
+    InstanceVenues acquire(const InstanceConfiguration& config) {
+        const auto reference = reference_instrument(config);
+        const auto quote = quote_instrument(config);
+        const auto hedge = hedge_instrument(config);
+        auto binance = find_symbol(binance_feeds_, reference);
+        auto bybit = find_symbol(bybit_feeds_, quote);
+        auto okx = find_symbol(okx_feeds_, hedge);
+        const size_t bybit_stacks = bybit_orders_.size();
+        auto& bybit_orders =
+            find_or_create(bybit_orders_, quote, [&] { return std::make_unique<BybitOrderStack>(config); });
+        if(bybit_orders_.size() != bybit_stacks) {
+            guard_quotes(config, binance, bybit_orders.order_manager);
+        }
+        auto& okx_orders = find_or_create(okx_orders_, hedge, [&] { return std::make_unique<OkxOrderStack>(config); });
+        log_action_pass("acquire_venue_connections",
+                        f("instance", config.name()),
+                        f("reference_instrument", reference),
+                        f("reference_id", binance.instrument),
+                        f("quote_instrument", quote),
+                        f("quote_id", bybit.instrument),
+                        f("hedge_instrument", hedge),
+                        f("hedge_id", okx.instrument));
+        return InstanceVenues{binance, bybit, okx, bybit_orders, okx_orders};
+    }
+
+    void start() {
+        configure_md_transport();
+        configure_tick_store();
+        for_each_feed([](auto& md) { md.feed.start(); });
+        for(auto& stack : bybit_orders_) {
+            stack->order_thread = std::thread([stack = stack.get()] { stack->order_manager.run(); });
+            stack->fills_thread = std::thread([stack = stack.get()] { stack->fills_manager.setupRoutingConnection(); });
+        }
+        for(auto& stack : okx_orders_) {
+            stack->order_thread = std::thread([stack = stack.get()] { stack->order_manager.run(); });
+        }
+        started_ = true;
+        log_action_pass("start_all_ws",
+                        f("binance_feeds", binance_feeds_.size()),
+                        f("bybit_feeds", bybit_feeds_.size()),
+                        f("okx_feeds", okx_feeds_.size()),
+                        f("bybit_order_stacks", bybit_orders_.size()),
+                        f("okx_order_stacks", okx_orders_.size()));
+        start_timer();
+    }
+
+    // Hands every connection the fan-out of its subscribers, after all instances subscribed
+    void install_callbacks() {
+        for_each_feed([](auto& md) {
+            md.feed.setMarketDataUpdateCallback([&md](mapping::InstrumentId instrument) {
+                md.on_update[instrument]();
+            });
+            md.feed.setWebSocketStatusUpdateCallback([&md](bool reached_retry_limit) {
+                md.on_status(reached_retry_limit);
+            });
+        });
+        for(auto& stack : bybit_orders_) {
+            const auto on_order_update = [stack = stack.get()](OrderHandler& order) { stack->on_order_update(order); };
+            const auto on_status = [stack = stack.get()](bool reached) { stack->on_status(reached); };
+            stack->order_manager.setOrderStatusUpdateCallback(on_order_update);
+            stack->order_manager.setWebsocketHealthCallback(on_status);
+            stack->fills_manager.setOrderStatusUpdateCallback(on_order_update);
+            stack->fills_manager.setWebSocketStatusUpdateCallback(on_status);
+        }
+        for(auto& stack : okx_orders_) {
+            const auto on_order_update = [stack = stack.get()](OrderHandler& order) { stack->on_order_update(order); };
+            const auto on_status = [stack = stack.get()](bool reached) { stack->on_status(reached); };
+            stack->order_manager.setOrderStatusUpdateCallback(on_order_update);
+            stack->order_manager.setWebsocketHealthCallback(on_status);
+        }
+        timer_.addCallback([this]() { send_ws_heartbeats(); });
+        log_action_pass("install_venue_callbacks");
+    }
+
+    void pin_threads(const CoreLayout& layout) {
+        using Role = CoreLayout::Role;
+        const auto pin = [&layout](Role role, size_t index, auto&& apply) {
+            if(const auto core = layout.core(role, index)) {
+                apply(*core);
+                log_action_pass(
+                    "pin_thread", f("role", CoreLayout::role_name(role)), f("index", index), f("core", *core));
+            }
+        };
+        // md cores are taken per connection: the connections of the first feed, then the next feed's
+        const auto pin_feeds = [&pin](Role role, auto& feeds) {
+            size_t index = 0;
+            for(auto& md : feeds) {
+                for(size_t connection = 0; connection < md->feed.connections(); ++connection, ++index) {
+                    pin(role, index, [&](int core) { md->feed.pinThread(connection, core); });
+                }
+            }
+        };
+        pin_feeds(Role::BinanceMd, binance_feeds_);
+        pin_feeds(Role::BybitMd, bybit_feeds_);
+        pin_feeds(Role::OkxMd, okx_feeds_);
+        for(size_t i = 0; i < bybit_orders_.size(); ++i) {
+            auto& stack = *bybit_orders_[i];
+            pin(Role::BybitOrder, i, [&](int core) { setThreadAffinity(stack.order_thread, core); });
+            pin(Role::BybitFills, i, [&](int core) { setThreadAffinity(stack.fills_thread, core); });
+            pin(Role::BybitPosition, i, [&](int core) { stack.position_manager.pinThread(core); });
+        }
+        for(size_t i = 0; i < okx_orders_.size(); ++i) {
+            auto& stack = *okx_orders_[i];
+            pin(Role::OkxOrder, i, [&](int core) { setThreadAffinity(stack.order_thread, core); });
+            pin(Role::OkxPosition, i, [&](int core) { stack.position_manager.pinThread(core); });
+        }
+        log_action_pass("setup_thread_affinity");
+    }
+
+    /* -------------------------------------------------------------------------- */
+    /*                             CLEAN UP FUNCTIONS                             */
+    /* -------------------------------------------------------------------------- */
+
+    void stop_trading_managers() {
+        if(!started_ || managers_stopped_) {
+            return;
+        }
+        managers_stopped_ = true;
+        try {
+            for(auto& stack : okx_orders_) {
+                stack->order_manager.stop();
+                log_action_pass("stop_okx_order_manager", f("instrument", stack->instrument));
+            }
+            for(auto& stack : bybit_orders_) {
+                stack->fills_manager.stop();
+                log_action_pass("stop_bybit_fills_manager", f("instrument", stack->instrument));
+                stack->order_manager.stop();
+                log_action_pass("stop_bybit_order_manager", f("instrument", stack->instrument));
+                stack->position_manager.stop();
+                log_action_pass("stop_bybit_position_manager", f("instrument", stack->instrument));
+            }
+            for(auto& stack : okx_orders_) {
+                stack->position_manager.stop();
+                log_action_pass("stop_okx_position_manager", f("instrument", stack->instrument));
+            }
+        } catch(const std::exception& e) {
+            log_action_fail<LogLevel::ERROR>("stop_trading_managers", e.what());
+            throw;
+        }
+    }
+
+    void stop_all_ws() {
+        if(!started_ || ws_stopped_) {
+            return;
+        }
+        ws_stopped_ = true;
+        try {
+            for_each_feed([](auto& md) { md.feed.stop(); });
+            log_action_pass("stop_all_ws");
+        } catch(const std::exception& e) {
+            log_action_fail<LogLevel::ERROR>("stop_all_ws", e.what());
+            throw;
+        }
+    }
+
+    void join_threads() {
+        if(!started_ || joined_) {
+            return;
+        }
+        joined_ = true;
+        try {
+            auto join_if_active = [](std::thread& thread) {
+                if(thread.joinable()) {
+                    thread.join();
+                }
+            };
+            for_each_feed([](auto& md) { md.feed.join(); });
+            for(auto& stack : okx_orders_) {
+                join_if_active(stack->order_thread);
+            }
+            for(auto& stack : bybit_orders_) {
+                join_if_active(stack->order_thread);
+                join_if_active(stack->fills_thread);
+            }
+            timer_.stop();
+            log_action_pass("join_threads");
+        } catch(const std::exception& e) {
+            log_action_fail<LogLevel::ERROR>("join_threads", e.what());
+            throw;
+        }
+    }
+
+private:
+    // The stale-quote guard of a quote instrument runs on the thread of the reference feed of the
+    // instance that created its order stack, ahead of the strategies subscribed to the same feed. The
+    // reference is shifted like QuoteMidService shifts it: the constant shift plus the position shift,
+    // taken from the quote position the fills stream keeps current.
+    static void guard_quotes(const InstanceConfiguration& config,
+                             const MdSymbol<BinanceWebSocketClient>& reference,
+                             ByBitOrderManager& order_manager) {
+        if(!order_manager.staleQuoteGuard().enabled()) {
+            return;
+        }
+        const auto pricing = config.child("quoting_reference_price");
+        const double constant_shift = pricing.get<double>("constant_shift", 0.0);
+        const double position_shift = pricing.get<double>("position_shift", 0.0);
+        reference.on_update.add([&feed = reference.feed,
+                                 instrument = reference.instrument,
+                                 &order_manager,
+                                 constant_shift,
+                                 position_shift] {
+            const double position = order_manager.m_positionManager.get_position();
+            order_manager.staleQuoteGuard().setReferenceShiftRatio(constant_shift - position * position_shift);
+            const auto top = feed.getTopOfBook(instrument);
+            order_manager.checkStaleQuotes(top.bid, top.ask);
+        });
+        log_action_pass("guard_quotes",
+                        f("instance", config.name()),
+                        f("reference_id", reference.instrument),
+                        f("constant_shift", constant_shift),
+                        f("position_shift", position_shift),
+                        f("cancel_distance", stale_quote_guard(config).cancelDistance));
+    }
+
+    /* -------------------------------------------------------------------------- */
+    /*                         STATIC CONSTRUCTION HELPERS                        */
+    /* -------------------------------------------------------------------------- */
+
+    static std::string reference_instrument(const InstanceConfiguration& config) {
+        return config.child("quoting_reference_price").get<std::string>("source");
+    }
+
+    static std::string quote_instrument(const InstanceConfiguration& config) {
+        return config.child("markets").child("quote").get<std::string>("name");
+    }
+
+    static std::string hedge_instrument(const InstanceConfiguration& config) {
+        return config.child("markets").child("hedge").get<std::string>("name");
+    }
+
+    // Splits the distinct instruments of a venue, in the order instances first use them, into the
+    // symbol lists of its md connections
+    static std::vector<std::vector<std::string>> md_chunks(const std::vector<std::string>& instruments,
+                                                           size_t symbols_per_connection) {
+        std::vector<std::vector<std::string>> chunks;
+        for(const auto& instrument : instruments) {
+            if(chunks.empty() || (symbols_per_connection > 0 && chunks.back().size() >= symbols_per_connection)) {
+                chunks.emplace_back();
+            }
+            chunks.back().push_back(instrument);
+        }
+        return chunks;
+    }
+
+    static size_t md_symbols_per_connection(const Configuration& config, const std::string& venue) {
+        if(!config.has_key("md_multiplexing")) {
+            return 0;
+        }
+        const auto multiplexing = config.child("md_multiplexing");
+        return multiplexing.get<size_t>(venue + "_symbols_per_connection",
+                                        multiplexing.get<size_t>("symbols_per_connection", 0));
+    }
+
+    // The connection settings of a feed (redundancy, proxies, retry limit) come from the first
+    // instance subscribing one of its symbols
+    template<typename Client>
+    void create_md_feeds(std::vector<std::unique_ptr<MdFeed<Client>>>& feeds,
+                         const std::vector<InstanceConfiguration>& instances,
+                         const std::string& venue,
+                         std::string (*instrument_of)(const InstanceConfiguration&),
+                         std::unique_ptr<Client> (*create_client)(const InstanceConfiguration&,
+                                                                  const std::vector<std::string>&,
+                                                                  size_t)) {
+        std::vector<std::string> instruments;
+        std::vector<const InstanceConfiguration*> owners;
+        for(const auto& instance : instances) {
+            const auto instrument = instrument_of(instance);
+            if(std::find(instruments.begin(), instruments.end(), instrument) == instruments.end()) {
+                instruments.push_back(instrument);
+                owners.push_back(&instance);
+            }
+        }
+        size_t first = 0;
+        for(auto& chunk : md_chunks(instruments, md_symbols_per_connection(config_, venue))) {
+            const InstanceConfiguration config = *owners[first];
+            first += chunk.size();
+            log_action_pass("create_md_feed", f("venue", venue), f("index", feeds.size()), f("symbols", chunk.size()));
+            feeds.push_back(std::make_unique<MdFeed<Client>>(
+                chunk, md_connections(config, venue), [config, chunk, create_client](size_t i) {
+                    return create_client(config, chunk, i);
+                }));
+        }
+    }
+
+    template<typename Client>
+    static MdSymbol<Client> find_symbol(std::vector<std::unique_ptr<MdFeed<Client>>>& feeds,
+                                        const std::string& instrument) {
+        for(auto& md : feeds) {
+            const mapping::InstrumentId id = md->instrument_id(instrument);
+            if(id != mapping::InstrumentRegistry::INVALID) {
+                return MdSymbol<Client>(*md, id);
+            }
+        }
+        throw std::runtime_error("no md feed subscribes " + instrument);
+    }
+
+    template<typename T, typename Factory>
+    static T& find_or_create(std::vector<std::unique_ptr<T>>& entries,
+                             const std::string& instrument,
+                             Factory&& create) {
+        const auto it = std::find_if(entries.begin(), entries.end(), [&instrument](const auto& entry) {
+            return entry->instrument == instrument;
+        });
+        if(it != entries.end()) {
+            return **it;
+        }
+        entries.push_back(create());
+        return *entries.back();
+    }
+
+    static ByBitPositionManager create_bybit_position_manager(const InstanceConfiguration& config) {
+        std::string quote_instrument = config.child("markets").child("quote").get<std::string>("name");
+        mapping::InstrumentInfo bybit_instrument_info = mapping::getInstrumentInfo(quote_instrument);
+        return ByBitPositionManager{
+            config.child("trading_control").get<bool>("live_trading_enabled"),
+            config.child("bybit_position").get<double>("max_position", 0.0),
+            config.child("bybit_position").get<double>("base_position", 0.0),
+            config.child("markets").child("quote").child("tick_sizes").get<double>("quantity"),
+            config.child("bybit_recon").get<double>("tolerable_threshold", 1.0),
+            config.child("bybit_recon").get<uint32_t>("max_mismatch_cnt", 3),
+            config.child("bybit_recon").get<uint32_t>("max_failure_query_cnt", 5),
+            config.child("bybit_recon").get<uint32_t>("retry_interval_on_failure_ms", 2000),
+            config.child("bybit_recon").get<uint32_t>("normal_recon_interval_ms", 5000),
+            config.child("bybit_recon").get<uint32_t>("retry_interval_on_mismatch_ms", 3000),
+            bybit_instrument_info.category,
+            bybit_instrument_info.instrument,
+            config.child("markets").child("quote").child("exchange_keys").get<std::string>("api_key"),
+            config.child("markets").child("quote").child("exchange_keys").get<std::string>("api_secret")};
+    }
+
+    static OkxPositionManager create_okx_position_manager(const InstanceConfiguration& config) {
+        std::string hedge_instrument = config.child("markets").child("hedge").get<std::string>("name");
+        mapping::InstrumentInfo okx_instrument_info = mapping::getInstrumentInfo(hedge_instrument);
+        return OkxPositionManager{
+            config.child("trading_control").get<bool>("live_trading_enabled"),
+            config.child("okx_position").get<double>("max_position", 0.0),
+            config.child("okx_position").get<double>("base_position", 0.0),
+            config.child("markets").child("hedge").child("tick_sizes").get<double>("quantity"),
+            config.child("okx_recon").get<double>("tolerable_threshold", 1.0),
+            config.child("okx_recon").get<uint32_t>("max_mismatch_cnt", 3),
+            config.child("okx_recon").get<uint32_t>("max_failure_query_cnt", 5),
+            config.child("okx_recon").get<uint32_t>("retry_interval_on_failure_ms", 2000),
+            config.child("okx_recon").get<uint32_t>("normal_recon_interval_ms", 5000),
+            config.child("okx_recon").get<uint32_t>("retry_interval_on_mismatch_ms", 3000),
+            okx_instrument_info.category,
+            okx_instrument_info.instrument,
+            config.child("markets").child("hedge").child("exchange_keys").get<std::string>("api_key", ""),
+            config.child("markets").child("hedge").child("exchange_keys").get<std::string>("api_secret", ""),
+            config.child("markets").child("hedge").child("exchange_keys").get<std::string>("api_passphrase", "")};
+    }
+
+    static ByBitOrderManager create_bybit_order_manager(const InstanceConfiguration& config,
+                                                        ByBitPositionManager& position_manager) {
+        return ByBitOrderManager{
+            config.child("trading_control").get<bool>("live_trading_enabled"),
+            Connections::getByBitProxy(),
+            config.child("exchange_stability").get<uint32_t>("ws_reconnection_retry_limit", 10),
+            config.child("markets").child("quote").get<uint32_t>("number_of_orders_to_track", 100),
+            config.child("markets").child("quote").child("exchange_keys").get<std::string>("api_key"),
+            config.child("markets").child("quote").child("exchange_keys").get<std::string>("api_secret"),
+            position_manager,
+            reconnect_policy(config),
+            stale_quote_guard(config)};
+    }
+
+    static StaleQuoteGuard::Config stale_quote_guard(const InstanceConfiguration& config) {
+        const auto safety = config.child("quote_safety_control");
+        if(!safety.has_key("stale_quote_guard")) {
+            return {};
+        }
+        const auto guard = safety.child("stale_quote_guard");
+        return {guard.get<bool>("enabled", false), guard.get<double>("cancel_distance", 0.0)};
+    }
+
+    static OkxOrderManager create_okx_order_manager(const InstanceConfiguration& config,
+                                                    OkxPositionManager& position_manager) {
+        std::string hedge_instrument = config.child("markets").child("hedge").get<std::string>("name", "");
+        mapping::InstrumentInfo okx_instrument_info = mapping::getInstrumentInfo(hedge_instrument);
+
+        return OkxOrderManager{
+            config.child("trading_control").get<bool>("live_trading_enabled"),
+            config.child("markets").child("hedge").get<uint32_t>("number_of_orders_to_track", 100),
+            config.child("exchange_stability").get<uint32_t>("ws_reconnection_retry_limit", 10),
+            Connections::getOkxProxy(),
+            config.child("markets").child("hedge").child("exchange_keys").get<std::string>("api_key"),
+            config.child("markets").child("hedge").child("exchange_keys").get<std::string>("api_secret"),
+            config.child("markets").child("hedge").child("exchange_keys").get<std::string>("api_passphrase"),
+            okx_instrument_info.instrument,
+            position_manager,
+            reconnect_policy(config)};
+    }
+
+    static ByBitFills create_bybit_fills_manager(const InstanceConfiguration& config,
+                                                 ByBitOrderManager& bybit_order_manager) {
+        return ByBitFills{
+            config.child("trading_control").get<bool>("live_trading_enabled"),
+            Connections::getByBitProxy(),
+            config.child("markets").child("quote").child("exchange_keys").get<std::string>("api_key", ""),
+            config.child("markets").child("quote").child("exchange_keys").get<std::string>("api_secret", ""),
+            config.child("markets").child("quote").get<uint32_t>("number_of_orders_to_track", 100),
+            config.child("exchange_stability").get<uint32_t>("ws_reconnection_retry_limit", 10),
+            bybit_order_manager};
+    }
+
+    static ReconnectPolicy reconnect_policy(const InstanceConfiguration& config) {
+        const auto stability = config.child("exchange_stability");
+        return ReconnectPolicy{stability.get<bool>("order_stream_spare_connection", false),
+                               stability.get<uint32_t>("reconnect_backoff_base_ms", 100),
+                               stability.get<uint32_t>("reconnect_backoff_max_ms", 5000)};
+    }
+
+    static size_t md_connections(const InstanceConfiguration& config, const std::string& venue) {
+        if(!config.has_key("md_redundancy")) {
+            return 1;
+        }
+        return config.child("md_redundancy").get<size_t>(venue + "_connections", 1);
+    }
+
+    // Each redundant connection may go through its own proxy, index i uses md_redundancy.<venue>_proxies[i]
+    static std::string md_proxy(const InstanceConfiguration& config,
+                                const std::string& venue,
+                                size_t index,
+                                const std::string& default_proxy) {
+        const std::string key = venue + "_proxies";
+        if(!config.has_key("md_redundancy") || !config.child("md_redundancy").has_key(key)) {
+            return default_proxy;
+        }
+        const auto proxies = config.child("md_redundancy").child(key);
+        if(index >= proxies.num_children()) {
+            return default_proxy;
+        }
+        try {
+            return proxies.child(index).as<std::string>();
+        } catch(const std::runtime_error&) {
+            return ""; // an empty entry connects directly
+        }
+    }
+
+    // Depth and aggTrade streams next to bookTicker, only subscribed in live trading
+    static BinanceStreamConfig binance_streams(const InstanceConfiguration& config, bool is_live_trading) {
+        BinanceStreamConfig streams;
+        streams.restBaseUrl =
+            is_live_trading ? Connections::getBinanceLiveCurlBaseUrl() : Connections::getBinanceMockCurlBaseUrl();
+        if(!config.has_key("binance_streams")) {
+            return streams;
+        }
+        const auto section = config.child("binance_streams");
+        streams.depth = section.get<bool>("depth_enabled", false);
+        streams.depthSpeed = section.get<std::string>("depth_speed", "100ms");
+        streams.snapshotLimit = section.get<uint32_t>("depth_snapshot_limit", 500);
+        streams.aggTrade = section.get<bool>("agg_trade_enabled", false);
+        streams.tradeFlowHalflifeNs = static_cast<uint64_t>(section.get<double>("trade_flow_halflife_ms", 1000) * 1e6);
+        return streams;
+    }
+
+    // Live streams are combined in the path, e.g. /ws/btcusdt@bookTicker/ethusdt@bookTicker
+    static std::unique_ptr<BinanceWebSocketClient> create_binance_ws_client(const InstanceConfiguration& config,
+                                                                            const std::vector<std::string>& instruments,
+                                                                            size_t index) {
+        const bool is_live_trading = config.child("trading_control").get<bool>("live_trading_enabled");
+        const BinanceStreamConfig streams = binance_streams(config, is_live_trading);
+        std::string binance_uri;
+        if(is_live_trading) {
+            binance_uri = Connections::getBinanceLiveMarket();
+            for(const auto& binance_instr : instruments) {
+                mapping::InstrumentInfo instr = mapping::getInstrumentInfo(binance_instr);
+                binance_uri += "/" + BinanceWebSocketClient::liveStreams(instr.instrument, streams);
+            }
+        } else {
+            binance_uri = Connections::getBinanceMockMarket();
+        }
+        return std::make_unique<BinanceWebSocketClient>(
+            is_live_trading,
+            config.child("exchange_stability").get<uint32_t>("ws_reconnection_retry_limit", 10),
+            binance_uri,
+            md_proxy(config, "binance", index, Connections::getBinanceProxy()),
+            instruments,
+            is_live_trading ? streams : BinanceStreamConfig{});
+    }
+
+    static std::unique_ptr<ByBitWebSocketClient> create_bybit_ws_client(const InstanceConfiguration& config,
+                                                                        const std::vector<std::string>& instruments,
+                                                                        size_t index) {
+        const bool is_live_trading = config.child("trading_control").get<bool>("live_trading_enabled");
+        return std::make_unique<ByBitWebSocketClient>(
+            is_live_trading ? Connections::getByBitLiveMarket() : Connections::getByBitMockMarket(),
+            md_proxy(config, "bybit", index, Connections::getByBitProxy()),
+            instruments,
+            config.child("exchange_stability").get<uint32_t>("ws_reconnection_retry_limit", 10),
+            config.child("markets").child("quote").child("exchange_keys").get<std::string>("api_key"),
+            config.child("markets").child("quote").child("exchange_keys").get<std::string>("api_secret"));
+    }
+
+    static std::unique_ptr<OKXWebSocketClient> create_okx_ws_client(const InstanceConfiguration& config,
+                                                                    const std::vector<std::string>& instruments,
+                                                                    size_t index) {
+        const bool is_live_trading = config.child("trading_control").get<bool>("live_trading_enabled");
+        return std::make_unique<OKXWebSocketClient>(
+            is_live_trading ? Connections::getOkxLiveMarket() : Connections::getOkxMockMarket(),
+            md_proxy(config, "okx", index, Connections::getOkxProxy()),
+            instruments,
+            config.child("exchange_stability").get<uint32_t>("ws_reconnection_retry_limit", 10),
+            config.child("markets").child("hedge").child("exchange_keys").get<std::string>("api_key"),
+            config.child("markets").child("hedge").child("exchange_keys").get<std::string>("api_secret"),
+            config.child("markets").child("hedge").child("exchange_keys").get<std::string>("api_passphrase"));
+    }
+
+    /* -------------------------------------------------------------------------- */
+    /*                             START UP FUNCTIONS                             */
+    /* -------------------------------------------------------------------------- */
+
+    template<typename Func>
+    void for_each_feed(Func&& func) {
+        for(auto& md : binance_feeds_) {
+            func(*md);
+        }
+        for(auto& md : bybit_feeds_) {
+            func(*md);
+        }
+        for(auto& md : okx_feeds_) {
+            func(*md);
+        }
+    }
+
+    void configure_md_transport() {
+        const InstanceConfiguration config{config_};
+        const auto stability = config.child("exchange_stability");
+        const BusyPollConfig busy_poll{stability.get<bool>("busy_poll_enabled", false),
+                                       stability.get<int>("socket_busy_poll_us", 50)};
+        const bool native_framing = stability.get<bool>("native_ws_framing_enabled", false);
+        const ReconnectPolicy policy = reconnect_policy(config);
+        for_each_feed([&](auto& md) {
+            md.feed.setBusyPoll(busy_poll);
+            md.feed.setNativeFraming(native_framing);
+            md.feed.setReconnectPolicy(policy);
+        });
+        log_action_pass("configure_md_transport",
+                        f("busy_poll_enabled", busy_poll.enabled),
+                        f("socket_busy_poll_us", busy_poll.socket_busy_poll_us),
+                        f("native_ws_framing_enabled", native_framing),
+                        f("reconnect_backoff_base_ms", policy.base_delay_ms),
+                        f("reconnect_backoff_max_ms", policy.max_delay_ms));
+    }
+
+    // Top-of-book recording for backtests and analysis, off unless `tick_store.enabled`
+    void configure_tick_store() {
+        if(!config_.has_key("tick_store") || !config_.child("tick_store").get<bool>("enabled", false)) {
+            return;
+        }
+        const auto store = config_.child("tick_store");
+        const auto root = store.get<std::string>("root", "ticks");
+        const auto block_ticks = store.get<uint32_t>("block_ticks", 4096);
+        const auto max_block_age_ms = store.get<uint64_t>("max_block_age_ms", 10000);
+        const auto queue_capacity =
+            store.get<size_t>("queue_capacity", tick_store::TickRecordingThread::DEFAULT_CAPACITY);
+        for_each_feed([&](auto& md) {
+            md.feed.recordTicks(root, block_ticks, max_block_age_ms * 1'000'000, queue_capacity);
+        });
+        log_action_pass("configure_tick_store",
+                        f("root", root),
+                        f("block_ticks", block_ticks),
+                        f("max_block_age_ms", max_block_age_ms),
+                        f("queue_capacity", queue_capacity));
+    }
+
+    void start_timer() {
+        const auto frequency = config_.child("exchange_stability").get<uint64_t>("websocket_heartbeat_ms", 10000);
+        timer_.start(frequency);
+        log_action_pass("start_timer", f("frequency", frequency));
+    }
+
+    void send_ws_heartbeats() {
+        log_event("send_ws_heartbeats");
+        for(auto& stack : bybit_orders_) {
+            stack->order_manager.send_heartbeat();
+            stack->fills_manager.send_heartbeat();
+        }
+        for(auto& stack : okx_orders_) {
+            stack->order_manager.send_heartbeat();
+        }
+        for(auto& md : bybit_feeds_) {
+            md->feed.send_heartbeat();
+        }
+        for(auto& md : okx_feeds_) {
+            md->feed.send_heartbeat();
+        }
+    }
+
+    Configuration config_;
+    std::vector<std::unique_ptr<MdFeed<BinanceWebSocketClient>>> binance_feeds_;
+    std::vector<std::unique_ptr<MdFeed<ByBitWebSocketClient>>> bybit_feeds_;
+    std::vector<std::unique_ptr<MdFeed<OKXWebSocketClient>>> okx_feeds_;
+    std::vector<std::unique_ptr<BybitOrderStack>> bybit_orders_;
+    std::vector<std::unique_ptr<OkxOrderStack>> okx_orders_;
+    Timer timer_{};
+    bool started_ = false;
+    bool managers_stopped_ = false;
+    bool ws_stopped_ = false;
+    bool joined_ = false;
+};
@@ -2,38 +2,90 @@
 
 #include "../infra/book.hpp"
 #include "../utils/helper.hpp"
-#include "format.h"
-#include "logging.h"
-#include <chrono>
+#include <concepts>
+#include <cstdint>
+#include <tuple>
 
-class IBookChecker {
-public:
-    virtual ~IBookChecker() = default;
-    [[nodiscard]] virtual bool check(const Book& book) const = 0;
+// What made a book unfit to trade on, Healthy when every check passed
+enum class BookHealth : uint8_t { Healthy, Stale, WideSpread };
+
+[[nodiscard]] inline const char* to_string(BookHealth health) {
+    switch(health) {
+        case BookHealth::Healthy:
+            return "healthy";
+        case BookHealth::Stale:
+            return "book_outdated";
+        case BookHealth::WideSpread:
+            return "market_illiquid";
+    }
+    return "unknown";
+}
+
+// A book check policy: a plain value with a non-virtual check and the BookHealth it reports on failure.
+// now_ns is taken once by the caller and shared by every check of a pipeline.
+template<typename T>
+concept BookCheck = requires(const T& check, const Book& book, uint64_t now_ns) {
+    { check.check(book, now_ns) } -> std::same_as<bool>;
+    { T::failure } -> std::convertible_to<BookHealth>;
 };
 
-class BookFreshnessChecker : public IBookChecker {
+class BookFreshnessCheck {
 public:
-    explicit BookFreshnessChecker(uint64_t stale_threshold_ns)
+    static constexpr BookHealth failure = BookHealth::Stale;
+
+    explicit BookFreshnessCheck(uint64_t stale_threshold_ns)
         : stale_threshold_ns_{stale_threshold_ns} {}
 
-    [[nodiscard]] bool check(const Book& book) const override {
-        return (get_current_time() - book.m_timestamp) <= stale_threshold_ns_;
+    [[nodiscard]] bool check(const Book& book, uint64_t now_ns) const {
+        return (now_ns - book.m_timestamp) <= stale_threshold_ns_;
     }
 
 private:
-    [[nodiscard]] static uint64_t get_current_time() { return helper::get_current_timestamp_ns(); }
-
-    const uint64_t stale_threshold_ns_;
+    uint64_t stale_threshold_ns_;
 };
 
-class BookSpreadChecker : public IBookChecker {
+class BookSpreadCheck {
 public:
-    explicit BookSpreadChecker(double spread_threshold)
+    static constexpr BookHealth failure = BookHealth::WideSpread;
+
+    explicit BookSpreadCheck(double spread_threshold)
         : spread_threshold_{spread_threshold} {}
 
-    [[nodiscard]] bool check(const Book& book) const override { return book.getSpread() <= spread_threshold_; }
+    [[nodiscard]] bool check(const Book& book, uint64_t) const { return book.getSpread() <= spread_threshold_; }
+
+private:
+    double spread_threshold_;
+};
+
+// Checks composed at compile time and run in declaration order against one timestamp. The first
+// failing check's BookHealth is returned and the rest are skipped; the calls are inlined, there is
+// no virtual dispatch. One pipeline type fits the quote, reference and hedge books alike, the order
+// of the policies decides which failure is reported when several apply.
+// @example
+//   BookHealthPipeline<BookFreshnessCheck, BookSpreadCheck> health{BookFreshnessCheck{400'000'000},
+//                                                                   BookSpreadCheck{5e-4}};
+//   const auto now = helper::get_current_timestamp_ns();
+//   if(const auto result = health.check(hedge_book, now); result != BookHealth::Healthy) {
+//       log_action_fail("check_book_health", to_string(result));
+//   }
+template<BookCheck... Checks>
+class BookHealthPipeline {
+public:
+    explicit BookHealthPipeline(Checks... checks)
+        : checks_{std::move(checks)...} {}
+
+    [[nodiscard]] BookHealth check(const Book& book, uint64_t now_ns) const {
+        BookHealth health = BookHealth::Healthy;
+        std::apply(
+            [&](const auto&... check) {
+                ((check.check(book, now_ns) || (health = std::decay_t<decltype(check)>::failure, false)) && ...);
+            },
+            checks_);
+        return health;
+    }
+
+    [[nodiscard]] BookHealth check(const Book& book) const { return check(book, helper::get_current_timestamp_ns()); }
 
 private:
-    const double spread_threshold_;
+    std::tuple<Checks...> checks_;
 };
@@ -1,11 +1,12 @@
 #include "../infra/pinthreads.hpp"
 #include "../lib/json.hpp"
+#include "../utils/instrumentregistry.hpp"
 #include "../utils/logger.hpp"
 #include "ArgumentParser.h"
 #include "Configuration.h"
 #include "InfraConfigManager.h"
 #include "Signal.h"
-#include "strategy.hpp"
+#include "StrategyRuntime.h"
 #include <fstream>
 #include <iostream>
 #include <string>
@@ -48,15 +49,22 @@ int main(int argc, char** argv) {
         InfraConfigManager config_manager(parser.get_config_path());
         LoggerSingleton::initialize(config_manager.get_config().strategy_log_dir.generic_string(),
                                     config_manager.get_config().strategy_config_path.generic_string());
+        LoggerSingleton::get().infra().info("action=tsc_clock_calibrated invariant=",
+                                            TscClock::instance().isInvariant(),
+                                            " ticks_per_ns=",
+                                            TscClock::instance().ticksPerNs());
         Configuration strategy_config = load_strategy_config(config_manager.get_config().strategy_config_path);
+        mapping::InstrumentRegistry::instance().load(strategy_config);
+        LoggerSingleton::get().infra().info("action=load_instrument_registry instruments=",
+                                            mapping::InstrumentRegistry::instance().size());
 
         Signal signal;
         setup_signal_handler(signal);
 
         int strategy_timeout = strategy_config.child("trading_control").get<int>("strategy_ready_timeout_seconds");
-        Strategy strategy(strategy_config);
+        StrategyRuntime runtime(strategy_config);
         std::chrono::seconds strategy_timeout_duration(strategy_timeout);
-        signal.handleStrategy<Strategy>(strategy, strategy_timeout_duration);
+        signal.handleStrategy<StrategyRuntime>(runtime, strategy_timeout_duration);
         return 0;
     } catch(const ArgumentParserError& e) {
         LoggerSingleton::get().strategy().error("Argument Error: " + std::string(e.what()));
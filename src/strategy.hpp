@@ -1,39 +1,36 @@
-#include "../infra/binancewebsocket.hpp"
-#include "../infra/bybitwebsocket.hpp"
-#include "../infra/okxwebsocket.hpp"
 #include "../infra/timer.hpp"
-#include "../oms/bybitfills.hpp"
-#include "../oms/bybitordermanager.hpp"
-#include "../oms/bybitpositionmanager.hpp"
-#include "../oms/okxordermanager.hpp"
-#include "../oms/okxpositionmanager.hpp"
+#include "../infra/timerwheel.hpp"
 #include "../src/ExposureMonitor.h"
 #include "../src/TradeAnalysis.h"
-#include "../utils/connections.hpp"
 #include "../utils/helper.hpp"
-#include "../utils/instrumentmappings.hpp"
+#include "../utils/latency.hpp"
 #include "../utils/logger.hpp"
 #include "../utils/pinthreads.hpp"
+#include "../utils/shmmetrics.hpp"
 #include "Configuration.h"
 #include "ExchangePnlService.h"
 #include "Hedger.h"
+#include "InstanceConfiguration.h"
 #include "OrderHealthCheck.h"
-#include "PendingCancellationManager.h"
-#include "PendingModificationManager.h"
-#include "PendingSubmissionManager.h"
+#include "PendingActionTracker.h"
 #include "PnlManager.h"
+#include "VenueConnections.h"
 #include <memory>
+#include <optional>
 #include <sstream>
 #include <string>
 #include <thread>
 
+// One strategy instance: a quote instrument, its hedge instrument and reference feed, and the event
+// loop that trades them. Feeds and order stacks belong to VenueConnections and may be shared with
+// other instances of the same process; StrategyRuntime owns the instances and drives Signal.
 class Strategy {
 public:
-    explicit Strategy(Configuration config)
-        : config_(std::move(config)) {
-        log_action_pass("construct_strategy");
-        start_all_ws();
-        start_timer();
+    Strategy(InstanceConfiguration config, const VenueConnections::InstanceVenues& venues)
+        : config_(std::move(config))
+        , venues_(venues) {
+        log_action_pass("construct_strategy", f("instance", name_));
+        start_metrics_publishing();
     }
 
     // Delete copy constructor and assignment
@@ -45,95 +42,81 @@ public:
     Strategy& operator=(Strategy&&) = delete;
 
     ~Strategy() {
-        cleanup();
-        log_action_pass("destruct_strategy");
+        stop();
+        log_action_pass("destruct_strategy", f("instance", name_));
     }
 
     /* -------------------------------------------------------------------------- */
     /*                           Trading Initialization                           */
     /* -------------------------------------------------------------------------- */
 
-    // NOTE: This function is called by class Signal at infra side
+    // NOTE: This function is called by StrategyRuntime before it installs the venue callbacks
     void initialize_trading() {
-        setup_thread_affinity();
         setup_callbacks();
-        log_action_pass("initialize_trading");
+        log_action_pass("initialize_trading", f("instance", name_));
     }
 
-    void setup_thread_affinity() {
-        constexpr int binance_core = 0;
-        constexpr int bybit_core = 1;
-        constexpr int okx_core = 2;
-        constexpr int okx_order_core = 3;
-        constexpr int bybit_order_core = 4;
-        constexpr int bybit_fills_core = bybit_order_core;
-        constexpr int bybit_position_core = 5;
-        constexpr int okx_position_core = 6;
-
-        setThreadAffinity(threads_.binance, binance_core);
-        setThreadAffinity(threads_.bybit, bybit_core);
-        setThreadAffinity(threads_.okx, okx_core);
-        setThreadAffinity(threads_.okx_order_manager, okx_order_core);
-        setThreadAffinity(threads_.bybit_order_manager, bybit_order_core);
-        setThreadAffinity(threads_.bybit_fills, bybit_fills_core);
-        bybit_position_manager_.pinThread(bybit_position_core);
-        okx_position_manager_.pinThread(okx_position_core);
-
-        log_action_pass("setup_thread_affinity",
-                        f("bybit_core", bybit_core),
-                        f("bybit_order_core", bybit_order_core),
-                        f("bybit_position_core", bybit_position_core),
-                        f("bybit_fills_core", bybit_fills_core),
-                        f("okx_core", okx_core),
-                        f("okx_order_core", okx_order_core),
-                        f("okx_position_core", okx_position_core),
-                        f("binance_core", binance_core));
-    }
-
-
-    // NOTE: This function is called by class Signal at infra side
+    // NOTE: This function is called by StrategyRuntime
     bool is_trading_ready() const {
-        if(!binance_ws_.isBookReady()) {
-            log_action_fail<LogLevel::WARNING>("check_trading_ready", "binance_ws_not_ready");
+        if(!venues_.binance.is_ready()) {
+            log_action_fail<LogLevel::WARNING>("check_trading_ready", "binance_ws_not_ready", f("instance", name_));
             return false;
-        } else if(!bybit_ws_.isBookReady()) {
-            log_action_fail<LogLevel::WARNING>("check_trading_ready", "bybit_ws_not_ready");
+        } else if(!venues_.bybit.is_ready()) {
+            log_action_fail<LogLevel::WARNING>("check_trading_ready", "bybit_ws_not_ready", f("instance", name_));
             return false;
-        } else if(!okx_ws_.isBookReady()) {
-            log_action_fail<LogLevel::WARNING>("check_trading_ready", "okx_ws_not_ready");
+        } else if(!venues_.okx.is_ready()) {
+            log_action_fail<LogLevel::WARNING>("check_trading_ready", "okx_ws_not_ready", f("instance", name_));
             return false;
         } else if(!bybit_position_manager_.isPosReconWarmedUp()) {
-            log_action_fail<LogLevel::WARNING>("check_trading_ready", "bybit_position_manager_not_ready");
+            log_action_fail<LogLevel::WARNING>(
+                "check_trading_ready", "bybit_position_manager_not_ready", f("instance", name_));
             return false;
         } else if(!okx_position_manager_.isPosReconWarmedUp()) {
-            log_action_fail<LogLevel::WARNING>("check_trading_ready", "okx_position_manager_not_ready");
+            log_action_fail<LogLevel::WARNING>(
+                "check_trading_ready", "okx_position_manager_not_ready", f("instance", name_));
             return false;
         }
-        log_action_pass("check_trading_ready");
+        log_action_pass("check_trading_ready", f("instance", name_));
         return true;
     }
 
-    // NOTE: This function is called by class Signal at infra side
-    void start_trading() {
+    // NOTE: This function is called by StrategyRuntime, the event loop runs on core when given
+    void start_trading(std::optional<int> core = std::nullopt) {
         event_processor_.start();
+        if(core) {
+            event_processor_.pinThread(*core);
+        }
         event_processor_.submit({EventType::StartTrading, {}});
+        log_action_pass("start_trading", f("instance", name_), f("core", core ? *core : -1));
     }
 
-private:
-    /* -------------------------------------------------------------------------- */
-    /*                          Internal Data Structures                          */
-    /* -------------------------------------------------------------------------- */
+    // Stops the event loop and the metrics timer; connections are stopped by VenueConnections
+    void stop() {
+        event_processor_.stop();
+        metrics_timer_.stop();
+    }
 
-    struct Threads {
-        std::thread okx;
-        std::thread binance;
-        std::thread bybit;
-        std::thread okx_order_manager;
-        std::thread strategy;
-        std::thread bybit_order_manager;
-        std::thread bybit_fills;
-    };
+    void publish_latency(const latency::LatencyRegistry::IntervalQuantiles& quantiles) {
+        if(!shm_metrics_) {
+            return;
+        }
+        static_assert(latency::VENUE_COUNT == shm_metrics::VENUES);
+        static_assert(latency::METRIC_COUNT == shm_metrics::LATENCY_METRICS);
+        shm_metrics_->update(
+            [&quantiles](shm_metrics::MetricsData& data) {
+                for(size_t m = 0; m < latency::METRIC_COUNT; ++m) {
+                    for(size_t v = 0; v < latency::VENUE_COUNT; ++v) {
+                        const auto& q = quantiles[m][v];
+                        data.latency[m][v] = {q.count, q.p50_ns, q.p99_ns, q.p999_ns, q.max_ns};
+                    }
+                }
+            },
+            helper::get_current_timestamp_ns());
+    }
+
+    [[nodiscard]] const std::string& name() const { return name_; }
 
+private:
     /* -------------------------------------------------------------------------- */
     /*                          Event Processing Logic                            */
     /* -------------------------------------------------------------------------- */
@@ -162,7 +145,10 @@ private:
         std::string reason;
     };
     // Market Data
-    struct MarketUpdateEventData {};
+    struct MarketUpdateEventData {
+        uint64_t receive_ticks = 0; // latency::trigger() of the md thread
+        uint64_t enqueue_ticks = 0;
+    };
     // Order Updates
     struct OrderUpdateEventData {
         uint64_t m_newOrderOnOmsTS = 0;
@@ -254,10 +240,21 @@ private:
             condition_.notify_one();
         }
 
-        // Dequeue operation - called by the processing thread
-        bool pop(Event& event) {
+        // Dequeue operation - called by the processing thread, false when deadline_ns (wall ns) passes
+        // with an empty queue or the queue is stopped
+        bool pop(Event& event, uint64_t deadline_ns = TimerWheel::NO_DEADLINE) {
             std::unique_lock<std::mutex> lock(mutex_);
-            condition_.wait(lock, [this] { return !queue_.empty() || !running_; });
+            const auto ready = [this] { return !queue_.empty() || !running_; };
+            if(deadline_ns == TimerWheel::NO_DEADLINE) {
+                condition_.wait(lock, ready);
+            } else {
+                const std::chrono::system_clock::time_point deadline{
+                    std::chrono::duration_cast<std::chrono::system_clock::duration>(
+                        std::chrono::nanoseconds(deadline_ns))};
+                if(!condition_.wait_until(lock, deadline, ready)) {
+                    return false;
+                }
+            }
 
             if(!running_ && queue_.empty()) {
                 return false;
@@ -289,11 +286,19 @@ private:
         // TradeAnalyzers
         EventQueue event_queue_;
         std::thread processor_thread_;
+        TimerWheel timers_;
+        shm_metrics::ShmMetrics* metrics_ = nullptr;
 
     public:
+        // Must be set before start()
+        void setMetrics(shm_metrics::ShmMetrics* metrics) { metrics_ = metrics; }
+
         // Start processing thread
         void start() { processor_thread_ = std::thread(&EventProcessor::process_events, this); }
 
+        // Must be called after start()
+        void pinThread(int core_id) { setThreadAffinity(processor_thread_, core_id); }
+
         // Stop processing thread
         void stop() {
             event_queue_.stop();
@@ -305,17 +310,63 @@ private:
         // Submit event interface - called by each worker thread
         void submit(Event event) { event_queue_.push(std::move(event)); }
 
+        // Timers run on the event loop thread between events; only that thread may use the wheel
+        TimerWheel& timers() { return timers_; }
+
     private:
+        // Waits for the next event no longer than the next timer deadline, so order timeouts fire
+        // on time on a quiet market without a timer thread
         void process_events() {
             while(event_queue_.is_running()) {
                 Event event;
-                if(event_queue_.pop(event)) {
+                if(event_queue_.pop(event, timers_.nextDeadlineNs())) {
                     handle_event(event);
                 }
+                if(timers_.size() != 0) {
+                    timers_.advance(helper::get_current_timestamp_ns());
+                }
             }
         }
 
+        // Routers called from the handler see the md receive stamp as latency::trigger()
+        static void handle_market_update(const Event& event, latency::Venue venue, void (*handler)()) {
+            const auto& data = std::get<MarketUpdateEventData>(event.data);
+            latency::record(latency::Metric::EventQueue, venue, data.enqueue_ticks);
+            latency::ScopedTrigger trigger(data.receive_ticks);
+            handler();
+            latency::record(latency::Metric::TickToDecision, venue, data.receive_ticks);
+        }
+
+        // Event counters of the shared-memory metrics segment, all updated from this thread
+        void count_event(const Event& event) {
+            constexpr auto index = [](latency::Venue venue) { return static_cast<size_t>(venue); };
+            metrics_->update(
+                [&event, index](shm_metrics::MetricsData& data) {
+                    switch(event.type) {
+                    case EventType::StartTrading: data.trading_active = 1; break;
+                    case EventType::StopTrading: data.trading_active = 0; break;
+                    case EventType::BinanceMarketUpdate: ++data.md_updates[index(latency::Venue::Binance)]; break;
+                    case EventType::BybitMarketUpdate: ++data.md_updates[index(latency::Venue::Bybit)]; break;
+                    case EventType::OkxMarketUpdate: ++data.md_updates[index(latency::Venue::Okx)]; break;
+                    case EventType::BybitOrderUpdate: ++data.order_updates[index(latency::Venue::Bybit)]; break;
+                    case EventType::OkxOrderUpdate: ++data.order_updates[index(latency::Venue::Okx)]; break;
+                    case EventType::WebSocketDisconnected:
+                        if(std::get<WsDisconnectedEventData>(event.data).reached_retry_limit) {
+                            ++data.ws_connection_ends;
+                        } else {
+                            ++data.ws_disconnects;
+                        }
+                        break;
+                    default: break;
+                    }
+                },
+                helper::get_current_timestamp_ns());
+        }
+
         void handle_event(const Event& event) {
+            if(metrics_) {
+                count_event(event);
+            }
             switch(event.type) {
             // Trading Control
             case EventType::StartTrading: {
@@ -328,15 +379,15 @@ private:
             }
             // Market Updates
             case EventType::BybitMarketUpdate: {
-                Strategy::handle_bybit_market_update();
+                handle_market_update(event, latency::Venue::Bybit, &Strategy::handle_bybit_market_update);
                 break;
             }
             case EventType::BinanceMarketUpdate: {
-                Strategy::handle_binance_market_update();
+                handle_market_update(event, latency::Venue::Binance, &Strategy::handle_binance_market_update);
                 break;
             }
             case EventType::OkxMarketUpdate: {
-                Strategy::handle_okx_market_update();
+                handle_market_update(event, latency::Venue::Okx, &Strategy::handle_okx_market_update);
                 break;
             }
             // Order Updates
@@ -374,21 +425,21 @@ private:
 
         std::function<void()> create_binance_market_update_callback() {
             return [this]() {
-                MarketUpdateEventData data{};
+                MarketUpdateEventData data{.receive_ticks = latency::trigger(), .enqueue_ticks = latency::now()};
                 processor_.submit({EventType::BinanceMarketUpdate, data});
             };
         }
 
         std::function<void()> create_bybit_market_update_callback() {
             return [this]() {
-                MarketUpdateEventData data{};
+                MarketUpdateEventData data{.receive_ticks = latency::trigger(), .enqueue_ticks = latency::now()};
                 processor_.submit({EventType::BybitMarketUpdate, data});
             };
         }
 
         std::function<void()> create_okx_market_update_callback() {
             return [this]() {
-                MarketUpdateEventData data{};
+                MarketUpdateEventData data{.receive_ticks = latency::trigger(), .enqueue_ticks = latency::now()};
                 processor_.submit({EventType::OkxMarketUpdate, data});
             };
         }
@@ -492,131 +543,6 @@ private:
     /* -------------------------------------------------------------------------- */
 
 
-    static ByBitPositionManager create_bybit_position_manager(const Configuration& config) {
-        std::string quote_instrument = config.child("markets").child("quote").get<std::string>("name");
-        mapping::InstrumentInfo bybit_instrument_info = mapping::getInstrumentInfo(quote_instrument);
-        return ByBitPositionManager{
-            config.child("trading_control").get<bool>("live_trading_enabled"),
-            config.child("bybit_position").get<double>("max_position", 0.0),
-            config.child("bybit_position").get<double>("base_position", 0.0),
-            config.child("markets").child("quote").child("tick_sizes").get<double>("quantity"),
-            config.child("bybit_recon").get<double>("tolerable_threshold", 1.0),
-            config.child("bybit_recon").get<uint32_t>("max_mismatch_cnt", 3),
-            config.child("bybit_recon").get<uint32_t>("max_failure_query_cnt", 5),
-            config.child("bybit_recon").get<uint32_t>("retry_interval_on_failure_ms", 2000),
-            config.child("bybit_recon").get<uint32_t>("normal_recon_interval_ms", 5000),
-            config.child("bybit_recon").get<uint32_t>("retry_interval_on_mismatch_ms", 3000),
-            bybit_instrument_info.category,
-            bybit_instrument_info.instrument,
-            config.child("markets").child("quote").child("exchange_keys").get<std::string>("api_key"),
-            config.child("markets").child("quote").child("exchange_keys").get<std::string>("api_secret")};
-    }
-
-    static OkxPositionManager create_okx_position_manager(const Configuration& config) {
-        std::string hedge_instrument = config.child("markets").child("hedge").get<std::string>("name");
-        mapping::InstrumentInfo okx_instrument_info = mapping::getInstrumentInfo(hedge_instrument);
-        return OkxPositionManager{
-            config.child("trading_control").get<bool>("live_trading_enabled"),
-            config.child("okx_position").get<double>("max_position", 0.0),
-            config.child("okx_position").get<double>("base_position", 0.0),
-            config.child("markets").child("hedge").child("tick_sizes").get<double>("quantity"),
-            config.child("okx_recon").get<double>("tolerable_threshold", 1.0),
-            config.child("okx_recon").get<uint32_t>("max_mismatch_cnt", 3),
-            config.child("okx_recon").get<uint32_t>("max_failure_query_cnt", 5),
-            config.child("okx_recon").get<uint32_t>("retry_interval_on_failure_ms", 2000),
-            config.child("okx_recon").get<uint32_t>("normal_recon_interval_ms", 5000),
-            config.child("okx_recon").get<uint32_t>("retry_interval_on_mismatch_ms", 3000),
-            okx_instrument_info.category,
-            okx_instrument_info.instrument,
-            config.child("markets").child("hedge").child("exchange_keys").get<std::string>("api_key", ""),
-            config.child("markets").child("hedge").child("exchange_keys").get<std::string>("api_secret", ""),
-            config.child("markets").child("hedge").child("exchange_keys").get<std::string>("api_passphrase", "")};
-    }
-
-    static ByBitOrderManager create_bybit_order_manager(const Configuration& config,
-                                                        ByBitPositionManager& position_manager) {
-        return ByBitOrderManager{
-            config.child("trading_control").get<bool>("live_trading_enabled"),
-            Connections::getByBitProxy(),
-            config.child("exchange_stability").get<uint32_t>("ws_reconnection_retry_limit", 10),
-            config.child("markets").child("quote").get<uint32_t>("number_of_orders_to_track", 100),
-            config.child("markets").child("quote").child("exchange_keys").get<std::string>("api_key"),
-            config.child("markets").child("quote").child("exchange_keys").get<std::string>("api_secret"),
-            position_manager};
-    }
-
-    static OkxOrderManager create_okx_order_manager(const Configuration& config, OkxPositionManager& position_manager) {
-        std::string hedge_instrument = config.child("markets").child("hedge").get<std::string>("name", "");
-        mapping::InstrumentInfo okx_instrument_info = mapping::getInstrumentInfo(hedge_instrument);
-
-        return OkxOrderManager{
-            config.child("trading_control").get<bool>("live_trading_enabled"),
-            config.child("markets").child("hedge").get<uint32_t>("number_of_orders_to_track", 100),
-            config.child("exchange_stability").get<uint32_t>("ws_reconnection_retry_limit", 10),
-            Connections::getOkxProxy(),
-            config.child("markets").child("hedge").child("exchange_keys").get<std::string>("api_key"),
-            config.child("markets").child("hedge").child("exchange_keys").get<std::string>("api_secret"),
-            config.child("markets").child("hedge").child("exchange_keys").get<std::string>("api_passphrase"),
-            okx_instrument_info.instrument,
-            position_manager};
-    }
-
-    static ByBitFills create_bybit_fills_manager(const Configuration& config, ByBitOrderManager& bybit_order_manager) {
-        return ByBitFills{
-            config.child("trading_control").get<bool>("live_trading_enabled"),
-            Connections::getByBitProxy(),
-            config.child("markets").child("quote").child("exchange_keys").get<std::string>("api_key", ""),
-            config.child("markets").child("quote").child("exchange_keys").get<std::string>("api_secret", ""),
-            config.child("markets").child("quote").get<uint32_t>("number_of_orders_to_track", 100),
-            config.child("exchange_stability").get<uint32_t>("ws_reconnection_retry_limit", 10),
-            bybit_order_manager};
-    }
-
-    static BinanceWebSocketClient create_binance_ws_client(const Configuration& config) {
-        const bool is_live_trading = config.child("trading_control").get<bool>("live_trading_enabled");
-        std::string binance_uri;
-        if(is_live_trading) {
-            binance_uri = Connections::getBinanceLiveMarket();
-            std::string binance_instr = config.child("quoting_reference_price").get<std::string>("source");
-            mapping::InstrumentInfo instr = mapping::getInstrumentInfo(binance_instr);
-            binance_uri += "/" + instr.instrument + "@bookTicker";
-        } else {
-            binance_uri = Connections::getBinanceMockMarket();
-        }
-        return BinanceWebSocketClient{
-            is_live_trading,
-            config.child("exchange_stability").get<uint32_t>("ws_reconnection_retry_limit", 10),
-            binance_uri,
-            Connections::getBinanceProxy(),
-            config.child("quoting_reference_price").get<std::string>("source")};
-    };
-
-    static ByBitWebSocketClient create_bybit_ws_client(const Configuration& config) {
-        const bool is_live_trading = config.child("trading_control").get<bool>("live_trading_enabled");
-        return ByBitWebSocketClient{
-            is_live_trading ? Connections::getByBitLiveMarket() : Connections::getByBitMockMarket(),
-            Connections::getByBitProxy(),
-            config.child("markets").child("quote").get<std::string>("name"),
-            config.child("exchange_stability").get<uint32_t>("ws_reconnection_retry_limit", 10),
-            config.child("markets").child("quote").child("exchange_keys").get<std::string>("api_key"),
-            config.child("markets").child("quote").child("exchange_keys").get<std::string>("api_secret"),
-        };
-    }
-
-    static OKXWebSocketClient create_okx_ws_client(const Configuration& config) {
-        const bool is_live_trading = config.child("trading_control").get<bool>("live_trading_enabled");
-        return OKXWebSocketClient{
-            is_live_trading ? Connections::getOkxLiveMarket() : Connections::getOkxMockMarket(),
-            Connections::getOkxProxy(),
-            config.child("markets").child("hedge").get<std::string>("name"),
-            config.child("exchange_stability").get<uint32_t>("ws_reconnection_retry_limit", 10),
-            config.child("markets").child("hedge").child("exchange_keys").get<std::string>("api_key"),
-            config.child("markets").child("hedge").child("exchange_keys").get<std::string>("api_secret"),
-            config.child("markets").child("hedge").child("exchange_keys").get<std::string>("api_passphrase"),
-        };
-    }
-
-
     static EventProcessor create_event_processor() {
         return EventProcessor{};
     }
@@ -625,117 +551,72 @@ private:
     /*                             START UP FUNCTIONS                             */
     /* -------------------------------------------------------------------------- */
 
-    void start_all_ws() {
-        threads_.binance = std::thread([this] { binance_ws_.start(); });
-        threads_.bybit = std::thread([this] { bybit_ws_.start(); });
-        threads_.okx = std::thread([this] { okx_ws_.start(); });
-        threads_.okx_order_manager = std::thread([this] { okx_order_manager_.run(); });
-        threads_.bybit_order_manager = std::thread([this] { bybit_order_manager_.run(); });
-        threads_.bybit_fills = std::thread([this] { bybit_fills_manager_.setupRoutingConnection(); });
-        log_action_pass("start_all_ws");
-    }
-
-    void start_timer() {
-        const auto frequency = config_.child("exchange_stability").get<uint64_t>("websocket_heartbeat_ms", 10000);
-        timer_.start(frequency);
-        log_action_pass("start_timer", f("frequency", frequency));
-    }
-
-    /* -------------------------------------------------------------------------- */
-    /*                             CLEAN UP FUNCTIONS                             */
-    /* -------------------------------------------------------------------------- */
-
-    void stop_trading_managers() {
-        try {
-            okx_order_manager_.stop();
-            log_action_pass("stop_okx_order_manager");
-            bybit_fills_manager_.stop();
-            log_action_pass("stop_bybit_fills_manager");
-            bybit_order_manager_.stop();
-            log_action_pass("stop_bybit_order_manager");
-            bybit_position_manager_.stop();
-            log_action_pass("stop_bybit_position_manager");
-            okx_position_manager_.stop();
-            log_action_pass("stop_okx_position_manager");
-        } catch(const std::exception& e) {
-            log_action_fail<LogLevel::ERROR>("stop_trading_managers", e.what());
-            throw;
+    // One segment per instance, named <name>_<instance> when the config lists instances
+    static std::unique_ptr<shm_metrics::ShmMetrics> create_shm_metrics(const InstanceConfiguration& config) {
+        if(!config.has_key("shm_metrics") || !config.child("shm_metrics").get<bool>("enabled", false)) {
+            return nullptr;
         }
-    }
-
-    void stop_all_ws() {
-        try {
-            bybit_ws_.stop();
-            okx_ws_.stop();
-            binance_ws_.stop();
-            log_action_pass("stop_all_ws");
-        } catch(const std::exception& e) {
-            log_action_fail<LogLevel::ERROR>("stop_all_ws", e.what());
-            throw;
+        auto name = config.child("shm_metrics").get<std::string>("name", "trading_metrics");
+        if(config.is_instance()) {
+            name += "_" + config.name();
         }
+        auto metrics = std::make_unique<shm_metrics::ShmMetrics>(name);
+        log_action_pass("create_shm_metrics", f("instance", config.name()), f("name", metrics->name()));
+        return metrics;
     }
 
-    void join_threads() {
-        try {
-            auto join_if_active = [](std::thread& thread) {
-                if(thread.joinable()) {
-                    thread.join();
-                }
-            };
-            join_if_active(threads_.okx);
-            join_if_active(threads_.binance);
-            join_if_active(threads_.bybit);
-            join_if_active(threads_.okx_order_manager);
-            join_if_active(threads_.bybit_order_manager);
-            join_if_active(threads_.bybit_fills);
-            timer_.stop();
-            log_action_pass("join_threads");
-        } catch(const std::exception& e) {
-            log_action_fail<LogLevel::ERROR>("join_threads", e.what());
-            throw;
+    void start_metrics_publishing() {
+        if(!shm_metrics_) {
+            return;
         }
+        event_processor_.setMetrics(shm_metrics_.get());
+        const auto interval = config_.child("shm_metrics").get<uint64_t>("publish_interval_ms", 200);
+        metrics_timer_.addCallback([this] { publish_gauges(); });
+        metrics_timer_.start(interval);
+        log_action_pass("start_metrics_publishing", f("instance", name_), f("publish_interval_ms", interval));
     }
 
-    void cleanup() {
-        // Stop trading managers
-        stop_trading_managers();
-        event_processor_.stop();
-        stop_all_ws();
-        join_threads();
-        log_action_pass("cleanup");
-    }
-
-    void send_ws_heartbeats() {
-        log_event("send_ws_heartbeats");
-        bybit_order_manager_.send_heartbeat();
-        okx_order_manager_.send_heartbeat();
-        bybit_fills_manager_.send_heartbeat();
-        bybit_ws_.send_heartbeat();
-        okx_ws_.send_heartbeat();
+    void publish_gauges() {
+        const auto binance = venues_.binance.top_of_book();
+        const auto bybit = venues_.bybit.top_of_book();
+        const auto okx = venues_.okx.top_of_book();
+        const double bybit_position = bybit_position_manager_.get_position();
+        const double okx_position = okx_position_manager_.get_position();
+        shm_metrics_->update(
+            [&](shm_metrics::MetricsData& data) {
+                constexpr auto binance_index = static_cast<size_t>(latency::Venue::Binance);
+                constexpr auto bybit_index = static_cast<size_t>(latency::Venue::Bybit);
+                constexpr auto okx_index = static_cast<size_t>(latency::Venue::Okx);
+                data.best_bid[binance_index] = binance.bid;
+                data.best_ask[binance_index] = binance.ask;
+                data.best_bid[bybit_index] = bybit.bid;
+                data.best_ask[bybit_index] = bybit.ask;
+                data.best_bid[okx_index] = okx.bid;
+                data.best_ask[okx_index] = okx.ask;
+                data.position[bybit_index] = bybit_position;
+                data.position[okx_index] = okx_position;
+            },
+            helper::get_current_timestamp_ns());
     }
 
+    // Subscribes this instance to the shared connections, VenueConnections installs the fan-out
     void setup_callbacks() {
         // Binance WebSocket
-        binance_ws_.setMarketDataUpdateCallback(callback_adapter_.create_binance_market_update_callback());
-        binance_ws_.setWebSocketStatusUpdateCallback(callback_adapter_.create_ws_disconnected_callback());
+        venues_.binance.on_update.add(callback_adapter_.create_binance_market_update_callback());
+        venues_.binance.on_status.add(callback_adapter_.create_ws_disconnected_callback());
         // Bybit WebSocket
-        bybit_ws_.setMarketDataUpdateCallback(callback_adapter_.create_bybit_market_update_callback());
-        bybit_ws_.setWebSocketStatusUpdateCallback(callback_adapter_.create_ws_disconnected_callback());
+        venues_.bybit.on_update.add(callback_adapter_.create_bybit_market_update_callback());
+        venues_.bybit.on_status.add(callback_adapter_.create_ws_disconnected_callback());
         // Okx WebSocket
-        okx_ws_.setMarketDataUpdateCallback(callback_adapter_.create_okx_market_update_callback());
-        okx_ws_.setWebSocketStatusUpdateCallback(callback_adapter_.create_ws_disconnected_callback());
-        // Bybit Order Manager
-        bybit_order_manager_.setOrderStatusUpdateCallback(callback_adapter_.create_bybit_order_update_callback());
-        bybit_order_manager_.setWebsocketHealthCallback(callback_adapter_.create_ws_disconnected_callback());
+        venues_.okx.on_update.add(callback_adapter_.create_okx_market_update_callback());
+        venues_.okx.on_status.add(callback_adapter_.create_ws_disconnected_callback());
+        // Bybit Order Manager and Fills Manager
+        venues_.bybit_orders.on_order_update.add(callback_adapter_.create_bybit_order_update_callback());
+        venues_.bybit_orders.on_status.add(callback_adapter_.create_ws_disconnected_callback());
         // Okx Order Manager
-        okx_order_manager_.setOrderStatusUpdateCallback(callback_adapter_.create_okx_order_update_callback());
-        okx_order_manager_.setWebsocketHealthCallback(callback_adapter_.create_ws_disconnected_callback());
-        // Bybit Fills Manager
-        bybit_fills_manager_.setOrderStatusUpdateCallback(callback_adapter_.create_bybit_order_update_callback());
-        bybit_fills_manager_.setWebSocketStatusUpdateCallback(callback_adapter_.create_ws_disconnected_callback());
-        // Timer
-        timer_.addCallback([this]() { send_ws_heartbeats(); });
-        log_action_pass("setup_callbacks");
+        venues_.okx_orders.on_order_update.add(callback_adapter_.create_okx_order_update_callback());
+        venues_.okx_orders.on_status.add(callback_adapter_.create_ws_disconnected_callback());
+        log_action_pass("setup_callbacks", f("instance", name_));
     }
 
 
@@ -757,20 +638,19 @@ private:
 
     static void handle_ws_disconnected(const WsDisconnectedEventData& data) {}
 
-    Configuration config_;
-    ByBitPositionManager bybit_position_manager_{create_bybit_position_manager(config_)};
-    OkxPositionManager okx_position_manager_{create_okx_position_manager(config_)};
-    ByBitOrderManager bybit_order_manager_{create_bybit_order_manager(config_, bybit_position_manager_)};
-    OkxOrderManager okx_order_manager_{create_okx_order_manager(config_, okx_position_manager_)};
+    InstanceConfiguration config_;
+    const std::string name_{config_.name()};
+    VenueConnections::InstanceVenues venues_;
+    std::unique_ptr<shm_metrics::ShmMetrics> shm_metrics_{create_shm_metrics(config_)};
+
+    // Shared with the other instances trading the same instruments
+    ByBitPositionManager& bybit_position_manager_{venues_.bybit_orders.position_manager};
+    OkxPositionManager& okx_position_manager_{venues_.okx_orders.position_manager};
+    ByBitOrderManager& bybit_order_manager_{venues_.bybit_orders.order_manager};
+    OkxOrderManager& okx_order_manager_{venues_.okx_orders.order_manager};
+    ByBitFills& bybit_fills_manager_{venues_.bybit_orders.fills_manager};
 
-    ByBitFills bybit_fills_manager_{create_bybit_fills_manager(config_, bybit_order_manager_)};
-    Timer timer_{};
+    Timer metrics_timer_{};
     EventProcessor event_processor_{create_event_processor()};
     CallbackAdapter callback_adapter_{event_processor_};
-    Threads threads_{};
-
-    // WebSocket Clients
-    BinanceWebSocketClient binance_ws_{create_binance_ws_client(config_)};
-    ByBitWebSocketClient bybit_ws_{create_bybit_ws_client(config_)};
-    OKXWebSocketClient okx_ws_{create_okx_ws_client(config_)};
 };
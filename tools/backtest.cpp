@@ -0,0 +1,97 @@
+// Replays recorded market data through the strategy components against simulated exchanges.
+#include "../backtest/BacktestEngine.h"
+#include "../src/Configuration.h"
+#include "../utils/instrumentregistry.hpp"
+#include "../utils/logger.hpp"
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+
+namespace {
+
+void print_usage(const char* program) {
+    std::cerr << "Usage: " << program
+              << " <strategy_config.yaml> <market_data.csv|tick_store_dir> [--from <ns>] [--to <ns>]"
+                 " [--output <file>] [--log-dir <dir>]\n"
+              << "  strategy_config.yaml  strategy config, simulation parameters in its `backtest` section\n"
+              << "  market_data.csv       recorded events, see backtest/MarketData.h for the columns\n"
+              << "  tick_store_dir        root of a tick store, see utils/tickstore.hpp\n"
+              << "  --from/--to <ns>      time range read from a tick store (default: everything)\n"
+              << "  --output <file>       write the result json there instead of stdout\n"
+              << "  --log-dir <dir>       strategy log root (default: backtest_logs)\n";
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    std::string config_path;
+    std::string data_path;
+    std::string output_path;
+    std::string log_dir = "backtest_logs";
+    uint64_t from_ns = 0;
+    uint64_t to_ns = UINT64_MAX;
+    for(int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if(arg == "--from" && i + 1 < argc) {
+            from_ns = std::stoull(argv[++i]);
+        } else if(arg == "--to" && i + 1 < argc) {
+            to_ns = std::stoull(argv[++i]);
+        } else if(arg == "--output" && i + 1 < argc) {
+            output_path = argv[++i];
+        } else if(arg == "--log-dir" && i + 1 < argc) {
+            log_dir = argv[++i];
+        } else if(arg == "-h" || arg == "--help" || arg.rfind("--", 0) == 0) {
+            print_usage(argv[0]);
+            return arg == "-h" || arg == "--help" ? 0 : 1;
+        } else if(config_path.empty()) {
+            config_path = arg;
+        } else if(data_path.empty()) {
+            data_path = arg;
+        } else {
+            print_usage(argv[0]);
+            return 1;
+        }
+    }
+    if(config_path.empty() || data_path.empty()) {
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    try {
+        LoggerSingleton::initialize(log_dir, config_path);
+        const auto config = Configuration::from_file(config_path);
+        if(!config) {
+            throw std::runtime_error("failed to load strategy configuration " + config_path);
+        }
+        mapping::InstrumentRegistry::instance().load(*config);
+
+        const auto load_start = std::chrono::steady_clock::now();
+        const auto data = std::filesystem::is_directory(data_path)
+                              ? backtest::MarketDataSet::load_tick_store(
+                                    data_path, backtest::BacktestEngine::instruments(*config), from_ns, to_ns)
+                              : backtest::MarketDataSet::load_csv(data_path);
+        const auto run_start = std::chrono::steady_clock::now();
+        backtest::BacktestEngine engine(*config, data);
+        const auto result = engine.run();
+        const auto run_end = std::chrono::steady_clock::now();
+
+        auto json = result.to_json();
+        json["load_ms"] = std::chrono::duration_cast<std::chrono::milliseconds>(run_start - load_start).count();
+        json["run_ms"] = std::chrono::duration_cast<std::chrono::milliseconds>(run_end - run_start).count();
+        if(output_path.empty()) {
+            std::cout << json.dump(2) << std::endl;
+        } else {
+            std::ofstream output(output_path);
+            if(!output.is_open()) {
+                throw std::runtime_error("cannot open output file " + output_path);
+            }
+            output << json.dump(2) << std::endl;
+        }
+    } catch(const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,170 @@
+// Runs a grid or random search over strategy knobs, one backtest per combination on every core.
+#include "../backtest/BacktestEngine.h"
+#include "../backtest/MarketData.h"
+#include "../backtest/ParameterSweep.h"
+#include "../src/Configuration.h"
+#include "../utils/instrumentregistry.hpp"
+#include "../utils/logger.hpp"
+#include "../utils/workstealingpool.hpp"
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace {
+
+void print_usage(const char* program) {
+    std::cerr << "Usage: " << program
+              << " <strategy_config.yaml> <market_data.csv|.events|tick_store_dir> <sweep.yaml> [--threads <n>]"
+                 " [--from <ns>] [--to <ns>] [--output <file>] [--log-dir <dir>]\n"
+              << "  strategy_config.yaml  base strategy config, simulation parameters in its `backtest` section\n"
+              << "  market_data           recorded events as csv (converted once to a .events file next to it)\n"
+              << "                        or an existing .events file, mapped once and shared by every run,\n"
+              << "                        or the root of a tick store, see utils/tickstore.hpp\n"
+              << "  sweep.yaml            swept parameters, see backtest/ParameterSweep.h\n"
+              << "  --threads <n>         worker threads (default: one per core)\n"
+              << "  --from/--to <ns>      time range read from a tick store (default: everything)\n"
+              << "  --output <file>       write the results csv there instead of stdout\n"
+              << "  --log-dir <dir>       strategy log root (default: backtest_logs)\n";
+}
+
+int64_t elapsed_ms(std::chrono::steady_clock::time_point since) {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - since).count();
+}
+
+// The csv is parsed once, later sweeps over the same recording map the cached binary directly.
+// A tick store is decoded into memory, its files are already mapped and compact.
+backtest::MarketDataSet open_market_data(const std::string& path,
+                                         const Configuration& config,
+                                         uint64_t from_ns,
+                                         uint64_t to_ns) {
+    const std::filesystem::path source(path);
+    if(std::filesystem::is_directory(source)) {
+        return backtest::MarketDataSet::load_tick_store(
+            path, backtest::BacktestEngine::instruments(config), from_ns, to_ns);
+    }
+    if(source.extension() == ".events") {
+        return backtest::MarketDataSet::map_binary(path);
+    }
+    auto cached = source;
+    cached.replace_extension(".events");
+    if(!std::filesystem::exists(cached) ||
+       std::filesystem::last_write_time(cached) < std::filesystem::last_write_time(source)) {
+        backtest::MarketDataSet::load_csv(path).write_binary(cached.string());
+    }
+    return backtest::MarketDataSet::map_binary(cached.string());
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    std::string config_path;
+    std::string data_path;
+    std::string sweep_path;
+    std::string output_path;
+    std::string log_dir = "backtest_logs";
+    size_t threads = std::thread::hardware_concurrency();
+    uint64_t from_ns = 0;
+    uint64_t to_ns = UINT64_MAX;
+    for(int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if(arg == "--threads" && i + 1 < argc) {
+            threads = std::stoul(argv[++i]);
+        } else if(arg == "--from" && i + 1 < argc) {
+            from_ns = std::stoull(argv[++i]);
+        } else if(arg == "--to" && i + 1 < argc) {
+            to_ns = std::stoull(argv[++i]);
+        } else if(arg == "--output" && i + 1 < argc) {
+            output_path = argv[++i];
+        } else if(arg == "--log-dir" && i + 1 < argc) {
+            log_dir = argv[++i];
+        } else if(arg == "-h" || arg == "--help" || arg.rfind("--", 0) == 0) {
+            print_usage(argv[0]);
+            return arg == "-h" || arg == "--help" ? 0 : 1;
+        } else if(config_path.empty()) {
+            config_path = arg;
+        } else if(data_path.empty()) {
+            data_path = arg;
+        } else if(sweep_path.empty()) {
+            sweep_path = arg;
+        } else {
+            print_usage(argv[0]);
+            return 1;
+        }
+    }
+    if(config_path.empty() || data_path.empty() || sweep_path.empty()) {
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    try {
+        LoggerSingleton::initialize(log_dir, config_path);
+        const auto config = Configuration::from_file(config_path);
+        if(!config) {
+            throw std::runtime_error("failed to load strategy configuration " + config_path);
+        }
+        const auto sweep_config = Configuration::from_file(sweep_path);
+        if(!sweep_config) {
+            throw std::runtime_error("failed to load sweep configuration " + sweep_path);
+        }
+        mapping::InstrumentRegistry::instance().load(*config);
+        const auto sweep = backtest::ParameterSweep::from_config(*sweep_config);
+        sweep.validate(*config);
+        // every run parses its own copy, the shared tree is only read here
+        const std::string base_yaml = config->dump();
+
+        const auto load_start = std::chrono::steady_clock::now();
+        const auto data = open_market_data(data_path, *config, from_ns, to_ns);
+        const int64_t load_ms = elapsed_ms(load_start);
+
+        std::ofstream file;
+        if(!output_path.empty()) {
+            file.open(output_path, std::ios::trunc);
+            if(!file.is_open()) {
+                throw std::runtime_error("cannot open output file " + output_path);
+            }
+        }
+        backtest::SweepResultWriter writer(output_path.empty() ? std::cout : file, sweep.parameters());
+
+        std::mutex best_mutex;
+        size_t best_run = 0;
+        double best_pnl = -std::numeric_limits<double>::infinity();
+
+        const auto sweep_start = std::chrono::steady_clock::now();
+        WorkStealingPool pool(threads);
+        for(size_t run = 0; run < sweep.size(); ++run) {
+            pool.submit([&, run] {
+                const auto run_start = std::chrono::steady_clock::now();
+                try {
+                    const auto run_config = sweep.make_config(base_yaml, run);
+                    backtest::BacktestEngine engine(run_config, data);
+                    const auto result = engine.run();
+                    writer.write(run, sweep.combination(run), result, elapsed_ms(run_start));
+                    std::lock_guard<std::mutex> lock(best_mutex);
+                    if(result.total_pnl_with_fee > best_pnl) {
+                        best_pnl = result.total_pnl_with_fee;
+                        best_run = run;
+                    }
+                } catch(const std::exception& e) {
+                    writer.write_error(run, sweep.combination(run), e.what());
+                }
+            });
+        }
+        pool.wait();
+
+        std::cerr << "runs: " << writer.written() << " failed: " << writer.failed() << " threads: "
+                  << pool.threadCount() << " steals: " << pool.stealCount() << " events: " << data.size()
+                  << " load_ms: " << load_ms << " sweep_ms: " << elapsed_ms(sweep_start) << std::endl;
+        if(writer.written() > writer.failed()) {
+            std::cerr << "best run: " << best_run << " total_with_fee: " << best_pnl << std::endl;
+        }
+    } catch(const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
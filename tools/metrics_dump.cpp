@@ -0,0 +1,98 @@
+// Prints the engine's shared-memory metrics segment, once or every --watch milliseconds.
+#include "../utils/latency.hpp"
+#include "../utils/shmmetrics.hpp"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <thread>
+
+static_assert(latency::VENUE_COUNT == shm_metrics::VENUES);
+static_assert(latency::METRIC_COUNT == shm_metrics::LATENCY_METRICS);
+
+namespace {
+
+void print_usage(const char* program) {
+    std::cerr << "Usage: " << program << " [segment_name] [--watch <ms>]\n"
+              << "  segment_name    shm_metrics.name from the strategy config (default: trading_metrics)\n"
+              << "  --watch <ms>    reprint every <ms> milliseconds\n";
+}
+
+void print_metrics(const shm_metrics::MetricsData& data, uint32_t pid) {
+    std::printf("pid=%u updated_ns=%llu trading_active=%llu ws_disconnects=%llu ws_connection_ends=%llu\n",
+                pid,
+                static_cast<unsigned long long>(data.updated_ns),
+                static_cast<unsigned long long>(data.trading_active),
+                static_cast<unsigned long long>(data.ws_disconnects),
+                static_cast<unsigned long long>(data.ws_connection_ends));
+    std::printf("realized_pnl=%.6f unrealized_pnl=%.6f\n", data.realized_pnl, data.unrealized_pnl);
+    std::printf("%-8s %12s %14s %14s %14s %14s\n", "venue", "md_updates", "order_updates", "best_bid", "best_ask",
+                "position");
+    for(size_t v = 0; v < shm_metrics::VENUES; ++v) {
+        std::printf("%-8s %12llu %14llu %14.6f %14.6f %14.6f\n",
+                    latency::VENUE_NAMES[v],
+                    static_cast<unsigned long long>(data.md_updates[v]),
+                    static_cast<unsigned long long>(data.order_updates[v]),
+                    data.best_bid[v],
+                    data.best_ask[v],
+                    data.position[v]);
+    }
+    std::printf("%-17s %-8s %10s %10s %10s %10s %10s\n", "latency", "venue", "count", "p50_ns", "p99_ns", "p999_ns",
+                "max_ns");
+    for(size_t m = 0; m < shm_metrics::LATENCY_METRICS; ++m) {
+        for(size_t v = 0; v < shm_metrics::VENUES; ++v) {
+            const auto& q = data.latency[m][v];
+            if(q.count == 0) {
+                continue;
+            }
+            std::printf("%-17s %-8s %10llu %10llu %10llu %10llu %10llu\n",
+                        latency::METRIC_NAMES[m],
+                        latency::VENUE_NAMES[v],
+                        static_cast<unsigned long long>(q.count),
+                        static_cast<unsigned long long>(q.p50_ns),
+                        static_cast<unsigned long long>(q.p99_ns),
+                        static_cast<unsigned long long>(q.p999_ns),
+                        static_cast<unsigned long long>(q.max_ns));
+        }
+    }
+    std::fflush(stdout);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    std::string name = "trading_metrics";
+    long watch_ms = 0;
+    for(int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if(arg == "--watch" && i + 1 < argc) {
+            watch_ms = std::strtol(argv[++i], nullptr, 10);
+        } else if(arg == "-h" || arg == "--help" || arg.rfind("--", 0) == 0) {
+            print_usage(argv[0]);
+            return arg == "-h" || arg == "--help" ? 0 : 1;
+        } else {
+            name = arg;
+        }
+    }
+
+    try {
+        shm_metrics::ShmMetricsReader reader(name);
+        shm_metrics::MetricsData data{};
+        do {
+            if(!reader.read(data)) {
+                std::cerr << "metrics segment busy, retrying\n";
+            } else {
+                print_metrics(data, reader.pid());
+            }
+            if(watch_ms > 0) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(watch_ms));
+                std::printf("\n");
+            }
+        } while(watch_ms > 0);
+    } catch(const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,106 @@
+// Imports recorded market data csv files into a tick store, once per recording.
+#include "../backtest/MarketData.h"
+#include "../infra/book.hpp"
+#include "../src/Configuration.h"
+#include "../utils/instrumentregistry.hpp"
+#include "../utils/tickstore.hpp"
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace {
+
+void print_usage(const char* program) {
+    std::cerr << "Usage: " << program
+              << " <store_root> <market_data.csv>... [--instrument <name>] [--config <strategy_config.yaml>]\n"
+              << "  store_root            tick store root, files go to <root>/<instrument>/<YYYYMMDD>.ticks\n"
+              << "  market_data.csv       recorded events, see backtest/MarketData.h for the columns\n"
+              << "  --instrument <name>   instrument of files without an instrument column\n"
+              << "  --config <file>       strategy config whose `instruments` section extends the registry\n";
+}
+
+// Every change of the best prices or sizes becomes a tick, stamped with the exchange time of the
+// event that caused it; the csv has no local receive time.
+size_t import_file(const std::string& root, const std::string& path, const std::string& instrument) {
+    const auto data = backtest::MarketDataSet::load_csv(path, instrument);
+    const auto& registry = mapping::InstrumentRegistry::instance();
+    size_t ticks = 0;
+    for(mapping::InstrumentId id = 0; id < registry.size(); ++id) {
+        const auto events = data.events(id);
+        if(events.empty()) {
+            continue;
+        }
+        const auto& name = registry.get(id).name;
+        tick_store::TickStoreWriter writer(root, name);
+        Book book(name);
+        tick_store::Tick last{};
+        for(const auto& event : events) {
+            if(event.kind != backtest::MarketEventKind::Level) {
+                continue;
+            }
+            backtest::apply_level(book, event);
+            const tick_store::Tick tick{event.timestamp_ns,
+                                        event.timestamp_ns,
+                                        book.getBestBid(),
+                                        book.bidSide.size > 0 ? book.bidSide.levels[0].quantity : 0.0,
+                                        book.getBestAsk(),
+                                        book.askSide.size > 0 ? book.askSide.levels[0].quantity : 0.0};
+            if(tick.bidPrice != last.bidPrice || tick.askPrice != last.askPrice || tick.bidSize != last.bidSize ||
+               tick.askSize != last.askSize) {
+                writer.append(tick);
+                last = tick;
+            }
+        }
+        ticks += writer.appended();
+        std::cerr << path << ": " << name << " ticks=" << writer.appended() << std::endl;
+    }
+    return ticks;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    std::string root;
+    std::vector<std::string> files;
+    std::string instrument;
+    std::string config_path;
+    for(int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if(arg == "--instrument" && i + 1 < argc) {
+            instrument = argv[++i];
+        } else if(arg == "--config" && i + 1 < argc) {
+            config_path = argv[++i];
+        } else if(arg == "-h" || arg == "--help" || arg.rfind("--", 0) == 0) {
+            print_usage(argv[0]);
+            return arg == "-h" || arg == "--help" ? 0 : 1;
+        } else if(root.empty()) {
+            root = arg;
+        } else {
+            files.push_back(arg);
+        }
+    }
+    if(root.empty() || files.empty()) {
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    try {
+        if(!config_path.empty()) {
+            const auto config = Configuration::from_file(config_path);
+            if(!config) {
+                throw std::runtime_error("failed to load strategy configuration " + config_path);
+            }
+            mapping::InstrumentRegistry::instance().load(*config);
+        }
+        size_t ticks = 0;
+        for(const auto& file : files) {
+            ticks += import_file(root, file, instrument);
+        }
+        std::cerr << "imported " << ticks << " ticks from " << files.size() << " files into " << root << std::endl;
+    } catch(const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,41 @@
+#pragma once
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <random>
+
+struct ReconnectPolicy {
+    bool spare_connection = false; // keep a pre-authenticated standby connection on order streams
+    uint32_t base_delay_ms = 100;
+    uint32_t max_delay_ms = 5000;
+};
+
+// Jittered exponential backoff between reconnect attempts. The n-th delay is drawn uniformly from
+// [cap / 2, cap] with cap = min(max_delay, base_delay * 2^n), so simultaneous disconnects of several
+// streams do not hammer the exchange in lockstep.
+class ReconnectBackoff {
+public:
+    explicit ReconnectBackoff(const ReconnectPolicy& policy = {})
+        : m_baseDelayMs(std::max<uint32_t>(policy.base_delay_ms, 1))
+        , m_maxDelayMs(std::max(policy.max_delay_ms, m_baseDelayMs))
+        , m_rng(std::random_device{}()) {}
+
+    std::chrono::milliseconds nextDelay() {
+        const uint64_t exponential = static_cast<uint64_t>(m_baseDelayMs) << std::min<uint32_t>(m_attempts, 20);
+        const uint64_t cap = std::min<uint64_t>(exponential, m_maxDelayMs);
+        ++m_attempts;
+        std::uniform_int_distribution<uint64_t> jitter(cap / 2, cap);
+        return std::chrono::milliseconds(jitter(m_rng));
+    }
+
+    // Call once a connection is fully established again
+    void reset() { m_attempts = 0; }
+
+    [[nodiscard]] uint32_t attempts() const { return m_attempts; }
+
+private:
+    uint32_t m_baseDelayMs;
+    uint32_t m_maxDelayMs;
+    uint32_t m_attempts = 0;
+    std::mt19937_64 m_rng;
+};
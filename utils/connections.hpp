@@ -9,6 +9,10 @@ std::string getBinanceMockMarket() { return "wss://fstream.binancefuture.com/ws"
 
 std::string getBinanceProxy() { return ""; }
 
+std::string getBinanceLiveCurlBaseUrl() { return "https://fapi.binance.com"; }
+
+std::string getBinanceMockCurlBaseUrl() { return "https://testnet.binancefuture.com"; }
+
 std::string getOkxLiveMarket() { return "wss://ws.okx.com:8443/ws/v5/public"; }
 
 std::string getOkxMockMarket() { return "wss://wspap.okx.com:8443/ws/v5/public"; }
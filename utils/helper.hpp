@@ -1,4 +1,5 @@
 #pragma once
+#include "tscclock.hpp"
 #include <chrono>
 #include <fstream>
 #include <iomanip>
@@ -10,7 +11,15 @@
 
 namespace helper {
 
-uint64_t get_current_timestamp_ns() { return std::chrono::high_resolution_clock::now().time_since_epoch().count(); }
+#ifdef BACKTEST_SIMULATED_CLOCK
+// Replay time of the backtest running on this thread, every engine clock reading sees it instead
+// of the wall clock so freshness checks and hedge budgets behave as they did when recorded
+inline thread_local uint64_t simulated_timestamp_ns = 0;
+
+uint64_t get_current_timestamp_ns() { return simulated_timestamp_ns; }
+#else
+uint64_t get_current_timestamp_ns() { return TscClock::instance().now_ns(); }
+#endif
 
 uint64_t get_current_timestamp_ms() {
     auto now = std::chrono::system_clock::now();
@@ -0,0 +1,191 @@
+#pragma once
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace mapping {
+
+using InstrumentId = uint32_t;
+
+// Static description of one tradable instrument. Quantities outside the exchange adapters are in
+// base currency (e.g. BTC); venues quoting in contracts convert with the precomputed factors.
+struct InstrumentSpec {
+    InstrumentId id = 0;
+    std::string name{};     // config name, e.g. okx_perp_btc_usdt
+    std::string exchange{}; // okx, bybit, binance
+    std::string symbol{};   // exchange symbol, e.g. BTC-USDT-SWAP
+    std::string category{}; // exchange product type, e.g. SWAP, linear
+    double contractValue = 1.0;
+    double contractMultiplier = 1.0;
+    double tickSize = 0.0; // price increment, 0 when unknown
+    double lotSize = 0.0;  // quantity increment in base currency, 0 when unknown
+    double baseQtyPerContract = 1.0;
+    double contractsPerBaseQty = 1.0;
+
+    // Order size in contracts, rounded to 1e-6 contracts like the exchange payloads expect
+    [[nodiscard]] double toContracts(double baseQty) const {
+        return std::round(baseQty * contractsPerBaseQty * 1e6) / 1e6;
+    }
+
+    [[nodiscard]] double toBaseQty(double contracts) const { return contracts * baseQtyPerContract; }
+
+    // instFamily of okx derivatives, e.g. BTC-USDT for BTC-USDT-SWAP
+    [[nodiscard]] std::string family() const {
+        const auto dash = symbol.rfind('-');
+        return category == "SWAP" && dash != std::string::npos ? symbol.substr(0, dash) : symbol;
+    }
+};
+
+// Every instrument the engine knows, keyed by dense ids. Built-in entries cover the instruments the
+// engine has always traded; the `instruments` section of the strategy config adds to or overrides
+// them once at startup. After startup the registry is read-only, so hot paths hold an id or a spec
+// reference and never compare strings.
+// @example
+//   // instruments:
+//   //   - name: "okx_perp_eth_usdt"
+//   //     symbol: "ETH-USDT-SWAP"
+//   //     category: "SWAP"
+//   //     contract_value: 0.1
+//   //     tick_size: 0.01
+//   //     lot_size: 0.001
+//   InstrumentRegistry::instance().load(config);
+//   const InstrumentId id = InstrumentRegistry::instance().id("okx_perp_eth_usdt");
+//   InstrumentRegistry::instance().get(id).toContracts(0.05); // 0.5
+class InstrumentRegistry {
+public:
+    static constexpr InstrumentId INVALID = std::numeric_limits<InstrumentId>::max();
+
+    static InstrumentRegistry& instance() {
+        static InstrumentRegistry registry;
+        return registry;
+    }
+
+    InstrumentRegistry(const InstrumentRegistry&) = delete;
+    InstrumentRegistry& operator=(const InstrumentRegistry&) = delete;
+
+    // Adds an instrument, or replaces the one with the same name while keeping its id
+    InstrumentId add(InstrumentSpec spec) {
+        if(spec.name.empty() || spec.symbol.empty()) {
+            throw std::invalid_argument("instrument needs a name and an exchange symbol");
+        }
+        if(spec.contractValue <= 0.0 || spec.contractMultiplier <= 0.0) {
+            throw std::invalid_argument("instrument " + spec.name + " has a non-positive contract size");
+        }
+        if(spec.exchange.empty()) {
+            spec.exchange = spec.name.substr(0, spec.name.find('_'));
+        }
+        spec.baseQtyPerContract = spec.contractValue * spec.contractMultiplier;
+        spec.contractsPerBaseQty = 1.0 / spec.baseQtyPerContract;
+        const auto existing = m_ids.find(spec.name);
+        if(existing != m_ids.end()) {
+            spec.id = existing->second;
+            m_symbols.erase(symbolKey(m_specs[spec.id].exchange, m_specs[spec.id].symbol));
+        } else {
+            spec.id = static_cast<InstrumentId>(m_specs.size());
+            m_specs.emplace_back();
+            m_ids.emplace(spec.name, spec.id);
+        }
+        const InstrumentId id = spec.id;
+        m_symbols[symbolKey(spec.exchange, spec.symbol)] = id;
+        m_specs[id] = std::move(spec);
+        return id;
+    }
+
+    // Reads the optional `instruments` sequence of a config (anything with the Configuration API)
+    template<typename Config>
+    void load(const Config& config) {
+        if(!config.has_key("instruments")) {
+            return;
+        }
+        config.child("instruments").for_each_child([this](const auto& entry) {
+            const auto name = entry.template get<std::string>("name");
+            const InstrumentSpec* current = find(name);
+            InstrumentSpec spec = current ? *current : InstrumentSpec{};
+            spec.name = name;
+            spec.exchange = entry.template get<std::string>("exchange", spec.exchange);
+            spec.symbol = entry.template get<std::string>("symbol", spec.symbol);
+            spec.category = entry.template get<std::string>("category", spec.category);
+            spec.contractValue = entry.template get<double>("contract_value", spec.contractValue);
+            spec.contractMultiplier = entry.template get<double>("contract_multiplier", spec.contractMultiplier);
+            spec.tickSize = entry.template get<double>("tick_size", spec.tickSize);
+            spec.lotSize = entry.template get<double>("lot_size", spec.lotSize);
+            add(std::move(spec));
+        });
+    }
+
+    // Id of a config name, INVALID if unknown
+    [[nodiscard]] InstrumentId id(std::string_view name) const {
+        const auto it = m_ids.find(name);
+        return it == m_ids.end() ? INVALID : it->second;
+    }
+
+    // Id of an exchange symbol as it appears in exchange messages, INVALID if unknown
+    [[nodiscard]] InstrumentId idBySymbol(std::string_view exchange, std::string_view symbol) const {
+        const auto it = m_symbols.find(symbolKey(exchange, symbol));
+        return it == m_symbols.end() ? INVALID : it->second;
+    }
+
+    [[nodiscard]] const InstrumentSpec& get(InstrumentId id) const { return m_specs.at(id); }
+
+    [[nodiscard]] const InstrumentSpec* find(std::string_view name) const {
+        const InstrumentId found = id(name);
+        return found == INVALID ? nullptr : &m_specs[found];
+    }
+
+    [[nodiscard]] const InstrumentSpec* find(InstrumentId id) const {
+        return id < m_specs.size() ? &m_specs[id] : nullptr;
+    }
+
+    [[nodiscard]] const InstrumentSpec* findBySymbol(std::string_view exchange, std::string_view symbol) const {
+        const InstrumentId found = idBySymbol(exchange, symbol);
+        return found == INVALID ? nullptr : &m_specs[found];
+    }
+
+    // Like get(id(name)), for startup code where an unknown instrument is a config error
+    [[nodiscard]] const InstrumentSpec& require(std::string_view name) const {
+        const InstrumentSpec* spec = find(name);
+        if(!spec) {
+            throw std::invalid_argument("unknown instrument: " + std::string(name));
+        }
+        return *spec;
+    }
+
+    [[nodiscard]] size_t size() const { return m_specs.size(); }
+
+private:
+    struct NameHash {
+        using is_transparent = void;
+        size_t operator()(std::string_view name) const { return std::hash<std::string_view>{}(name); }
+    };
+
+    InstrumentRegistry() {
+        add({.name = "okx_perp_btc_usdt", .symbol = "BTC-USDT-SWAP", .category = "SWAP", .contractValue = 0.01});
+        add({.name = "okx_perp_eth_usdt", .symbol = "ETH-USDT-SWAP", .category = "SWAP", .contractValue = 0.1});
+        add({.name = "okx_spot_btc_usdt", .symbol = "BTC-USDT", .category = "spot"});
+        add({.name = "okx_perp_doge_usdt", .symbol = "DOGE-USDT-SWAP", .category = "SWAP", .contractValue = 1000});
+        add({.name = "bybit_perp_doge_usdt", .symbol = "DOGEUSDT", .category = "linear"});
+        add({.name = "bybit_perp_btc_usdt", .symbol = "BTCUSDT", .category = "linear"});
+        add({.name = "bybit_perp_eth_usdt", .symbol = "ETHUSDT", .category = "linear"});
+        add({.name = "binance_perp_btc_usdt", .symbol = "btcusdt", .category = "PERP"});
+        add({.name = "binance_perp_doge_usdt", .symbol = "dogeusdt", .category = "PERP"});
+        add({.name = "binance_perp_eth_usdt", .symbol = "ethusdt", .category = "PERP"});
+    }
+
+    static std::string symbolKey(std::string_view exchange, std::string_view symbol) {
+        std::string key;
+        key.reserve(exchange.size() + symbol.size() + 1);
+        key.append(exchange).append(1, ':').append(symbol);
+        return key;
+    }
+
+    std::vector<InstrumentSpec> m_specs; // index is the id
+    std::unordered_map<std::string, InstrumentId, NameHash, std::equal_to<>> m_ids;
+    std::unordered_map<std::string, InstrumentId> m_symbols; // "exchange:symbol"
+};
+
+} // namespace mapping
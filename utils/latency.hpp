@@ -0,0 +1,289 @@
+#pragma once
+#include "logger.hpp"
+#include "tscclock.hpp"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+// In-process latency instrumentation. Probes take TSC ticks on the hot path and feed
+// per-thread histograms; a reporting thread merges all threads and logs p50/p99/p99.9
+// for the interval since the previous dump.
+//
+// Probe points and the metrics derived from them:
+//   ws receive -> parse done                 md_parse
+//   event enqueue -> event dequeue           event_queue
+//   ws receive -> strategy decision          tick_to_decision
+//   router encode start -> encode done       router_encode
+//   ws receive -> socket send                tick_to_trade
+//   oms submit -> exchange ack               order_ack
+// The ws receive stamp travels with the work as the thread-local trigger(): the md thread
+// sets it per message, the event carries it to the strategy thread, which restores it
+// while the event is handled so the routers can close tick_to_trade.
+namespace latency {
+
+enum class Venue : uint8_t { Binance, Bybit, Okx, Count };
+
+enum class Metric : uint8_t { MdParse, EventQueue, TickToDecision, RouterEncode, TickToTrade, OrderAck, Count };
+
+constexpr size_t VENUE_COUNT = static_cast<size_t>(Venue::Count);
+constexpr size_t METRIC_COUNT = static_cast<size_t>(Metric::Count);
+
+constexpr std::array<const char*, VENUE_COUNT> VENUE_NAMES{"binance", "bybit", "okx"};
+constexpr std::array<const char*, METRIC_COUNT> METRIC_NAMES{
+    "md_parse", "event_queue", "tick_to_decision", "router_encode", "tick_to_trade", "order_ack"};
+
+// Log-linear histogram over [0, 2^MAX_BITS) ns with 2^SUB_BUCKET_BITS sub-buckets per power of two,
+// i.e. about 3% relative precision. Single writer; readers may snapshot concurrently.
+class HdrHistogram {
+public:
+    static constexpr int SUB_BUCKET_BITS = 5;
+    static constexpr int MAX_BITS = 40; // ~18 minutes in ns
+    static constexpr uint64_t SUB_BUCKETS = uint64_t{1} << SUB_BUCKET_BITS;
+    static constexpr size_t BUCKETS = (MAX_BITS - SUB_BUCKET_BITS + 1) * SUB_BUCKETS;
+
+    struct Snapshot {
+        std::array<uint64_t, BUCKETS> counts{};
+        uint64_t total = 0;
+        uint64_t max = 0;
+
+        // Counts since an earlier snapshot of the same histograms. The writers only keep a lifetime max,
+        // so the max of the interval is the top of its highest non-empty bucket, capped by that max.
+        [[nodiscard]] Snapshot since(const Snapshot& earlier) const {
+            Snapshot delta = *this;
+            delta.max = 0;
+            for(size_t i = 0; i < BUCKETS; ++i) {
+                delta.counts[i] -= earlier.counts[i];
+                if(delta.counts[i] != 0) {
+                    delta.max = std::min(highestValueAt(i), max);
+                }
+            }
+            delta.total -= earlier.total;
+            return delta;
+        }
+
+        [[nodiscard]] uint64_t percentile(double q) const {
+            if(total == 0) {
+                return 0;
+            }
+            const uint64_t rank = std::max<uint64_t>(1, static_cast<uint64_t>(q * static_cast<double>(total) + 0.5));
+            uint64_t seen = 0;
+            for(size_t i = 0; i < BUCKETS; ++i) {
+                seen += counts[i];
+                if(seen >= rank) {
+                    return std::min(valueAt(i), max);
+                }
+            }
+            return max;
+        }
+    };
+
+    void record(uint64_t value) {
+        auto& bucket = m_counts[indexOf(value)];
+        bucket.store(bucket.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        if(value > m_max.load(std::memory_order_relaxed)) {
+            m_max.store(value, std::memory_order_relaxed);
+        }
+        m_total.store(m_total.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    }
+
+    void snapshotInto(Snapshot& snapshot) const {
+        for(size_t i = 0; i < BUCKETS; ++i) {
+            snapshot.counts[i] += m_counts[i].load(std::memory_order_relaxed);
+        }
+        snapshot.total += m_total.load(std::memory_order_relaxed);
+        snapshot.max = std::max(snapshot.max, m_max.load(std::memory_order_relaxed));
+    }
+
+    static size_t indexOf(uint64_t value) {
+        if(value < SUB_BUCKETS) {
+            return static_cast<size_t>(value);
+        }
+        int msb = 63 - std::countl_zero(value);
+        if(msb >= MAX_BITS) {
+            return BUCKETS - 1;
+        }
+        const int shift = msb - SUB_BUCKET_BITS;
+        return static_cast<size_t>((shift + 1) * SUB_BUCKETS + ((value >> shift) - SUB_BUCKETS));
+    }
+
+    // Midpoint of the values that share a bucket
+    static uint64_t valueAt(size_t index) {
+        if(index < SUB_BUCKETS) {
+            return index;
+        }
+        const int shift = static_cast<int>(index / SUB_BUCKETS) - 1;
+        const uint64_t lowest = (SUB_BUCKETS + index % SUB_BUCKETS) << shift;
+        return lowest + ((uint64_t{1} << shift) >> 1);
+    }
+
+    // Largest value that falls into a bucket
+    static uint64_t highestValueAt(size_t index) {
+        if(index < SUB_BUCKETS) {
+            return index;
+        }
+        const int shift = static_cast<int>(index / SUB_BUCKETS) - 1;
+        const uint64_t lowest = (SUB_BUCKETS + index % SUB_BUCKETS) << shift;
+        return lowest + (uint64_t{1} << shift) - 1;
+    }
+
+private:
+    std::array<std::atomic<uint64_t>, BUCKETS> m_counts{};
+    std::atomic<uint64_t> m_total{0};
+    std::atomic<uint64_t> m_max{0};
+};
+
+// Owns one histogram per (metric, venue) for every thread that ever recorded. Threads register
+// on their first sample; recorders are kept after a thread exits so its samples are still reported.
+class LatencyRegistry {
+public:
+    using Snapshots = std::array<std::array<HdrHistogram::Snapshot, VENUE_COUNT>, METRIC_COUNT>;
+
+    struct Quantiles {
+        uint64_t count = 0;
+        uint64_t p50_ns = 0;
+        uint64_t p99_ns = 0;
+        uint64_t p999_ns = 0;
+        uint64_t max_ns = 0; // of the interval, at the ~3% precision of the buckets
+    };
+    using IntervalQuantiles = std::array<std::array<Quantiles, VENUE_COUNT>, METRIC_COUNT>;
+
+    struct ThreadHistograms {
+        std::array<std::array<HdrHistogram, VENUE_COUNT>, METRIC_COUNT> histograms;
+    };
+
+    static LatencyRegistry& instance() {
+        static LatencyRegistry registry;
+        return registry;
+    }
+
+    ThreadHistograms& local() {
+        thread_local ThreadHistograms* histograms = registerThread();
+        return *histograms;
+    }
+
+    void setEnabled(bool enabled) { m_enabled.store(enabled, std::memory_order_relaxed); }
+
+    [[nodiscard]] bool isEnabled() const { return m_enabled.load(std::memory_order_relaxed); }
+
+    [[nodiscard]] std::unique_ptr<Snapshots> merge() const {
+        auto merged = std::make_unique<Snapshots>();
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for(const auto& thread : m_threads) {
+            for(size_t m = 0; m < METRIC_COUNT; ++m) {
+                for(size_t v = 0; v < VENUE_COUNT; ++v) {
+                    thread->histograms[m][v].snapshotInto((*merged)[m][v]);
+                }
+            }
+        }
+        return merged;
+    }
+
+    // Logs the samples recorded since the previous call, one line per non-empty (metric, venue),
+    // and returns the same quantiles for other exporters
+    IntervalQuantiles logInterval() {
+        IntervalQuantiles quantiles{};
+        auto current = merge();
+        std::lock_guard<std::mutex> lock(m_dumpMutex);
+        for(size_t m = 0; m < METRIC_COUNT; ++m) {
+            for(size_t v = 0; v < VENUE_COUNT; ++v) {
+                const auto window = m_lastDump ? (*current)[m][v].since((*m_lastDump)[m][v]) : (*current)[m][v];
+                if(window.total == 0) {
+                    continue;
+                }
+                auto& q = quantiles[m][v];
+                q = Quantiles{window.total,
+                              window.percentile(0.50),
+                              window.percentile(0.99),
+                              window.percentile(0.999),
+                              window.max};
+                LoggerSingleton::get().infra().info("action=latency_stats metric=",
+                                                    METRIC_NAMES[m],
+                                                    " venue=",
+                                                    VENUE_NAMES[v],
+                                                    " count=",
+                                                    q.count,
+                                                    " p50_ns=",
+                                                    q.p50_ns,
+                                                    " p99_ns=",
+                                                    q.p99_ns,
+                                                    " p999_ns=",
+                                                    q.p999_ns,
+                                                    " max_ns=",
+                                                    q.max_ns);
+            }
+        }
+        m_lastDump = std::move(current);
+        return quantiles;
+    }
+
+private:
+    LatencyRegistry() = default;
+
+    ThreadHistograms* registerThread() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_threads.push_back(std::make_unique<ThreadHistograms>());
+        return m_threads.back().get();
+    }
+
+    std::atomic<bool> m_enabled{true};
+    mutable std::mutex m_mutex;
+    std::vector<std::unique_ptr<ThreadHistograms>> m_threads;
+    std::mutex m_dumpMutex;
+    std::unique_ptr<Snapshots> m_lastDump;
+};
+
+inline uint64_t now() { return TscClock::instance().ticks(); }
+
+// ws receive stamp of the market-data update this thread is currently working on, 0 if none
+inline uint64_t& trigger() {
+    thread_local uint64_t ticks = 0;
+    return ticks;
+}
+
+inline void recordNs(Metric metric, Venue venue, uint64_t ns) {
+    auto& registry = LatencyRegistry::instance();
+    if(!registry.isEnabled()) {
+        return;
+    }
+    registry.local().histograms[static_cast<size_t>(metric)][static_cast<size_t>(venue)].record(ns);
+}
+
+// Records now() - start_ticks, ignored when the start probe never fired
+inline void record(Metric metric, Venue venue, uint64_t start_ticks) {
+    if(start_ticks == 0) {
+        return;
+    }
+    const uint64_t end = now();
+    recordNs(metric, venue, end > start_ticks ? TscClock::instance().ticks_to_ns(end - start_ticks) : 0);
+}
+
+// For the OMS wall-clock stamps (helper::get_current_timestamp_ns), ignored when either side is unset
+inline void recordInterval(Metric metric, Venue venue, uint64_t from_ns, uint64_t to_ns) {
+    if(from_ns == 0 || to_ns < from_ns) {
+        return;
+    }
+    recordNs(metric, venue, to_ns - from_ns);
+}
+
+// Restores the trigger of an event being handled and clears it again on scope exit
+class ScopedTrigger {
+public:
+    explicit ScopedTrigger(uint64_t ticks)
+        : m_previous(trigger()) {
+        trigger() = ticks;
+    }
+    ~ScopedTrigger() { trigger() = m_previous; }
+
+    ScopedTrigger(const ScopedTrigger&) = delete;
+    ScopedTrigger& operator=(const ScopedTrigger&) = delete;
+
+private:
+    uint64_t m_previous;
+};
+
+} // namespace latency
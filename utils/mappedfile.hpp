@@ -0,0 +1,59 @@
+#pragma once
+#include <cerrno>
+#include <cstddef>
+#include <cstring>
+#include <fcntl.h>
+#include <stdexcept>
+#include <string>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Read-only mapping of a whole file. The pages are shared by every thread and process mapping the
+// same file, so large recorded data sets are loaded once however many readers use them.
+class MappedFile {
+public:
+    explicit MappedFile(const std::string& path)
+        : m_path(path) {
+        const int fd = open(path.c_str(), O_RDONLY);
+        if(fd < 0) {
+            throw std::runtime_error("open failed for " + path + ": " + std::strerror(errno));
+        }
+        struct stat info {};
+        if(fstat(fd, &info) != 0) {
+            const int err = errno;
+            close(fd);
+            throw std::runtime_error("fstat failed for " + path + ": " + std::strerror(err));
+        }
+        m_size = static_cast<size_t>(info.st_size);
+        if(m_size == 0) {
+            close(fd);
+            return;
+        }
+        void* addr = mmap(nullptr, m_size, PROT_READ, MAP_SHARED, fd, 0);
+        close(fd);
+        if(addr == MAP_FAILED) {
+            throw std::runtime_error("mmap failed for " + path + ": " + std::strerror(errno));
+        }
+        m_data = static_cast<const std::byte*>(addr);
+        madvise(const_cast<std::byte*>(m_data), m_size, MADV_SEQUENTIAL);
+    }
+
+    ~MappedFile() {
+        if(m_data) {
+            munmap(const_cast<std::byte*>(m_data), m_size);
+        }
+    }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    [[nodiscard]] const std::byte* data() const { return m_data; }
+    [[nodiscard]] size_t size() const { return m_size; }
+    [[nodiscard]] const std::string& path() const { return m_path; }
+
+private:
+    std::string m_path;
+    const std::byte* m_data = nullptr;
+    size_t m_size = 0;
+};
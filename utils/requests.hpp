@@ -1,6 +1,7 @@
 #pragma once
 #include <sstream>
 #include <string>
+#include <vector>
 #include "instrumentmappings.hpp"
 namespace requests {
     
@@ -49,6 +50,16 @@ namespace requests {
         return message.str();
     }
 
+    std::string getBinanceDirectStream(const std::vector<std::string>& instruments) {
+        std::ostringstream message;
+        message << R"({"method": "SUBSCRIBE", "params": [)";
+        for(size_t i = 0; i < instruments.size(); ++i) {
+            message << (i == 0 ? "" : ", ") << "\"" << instruments[i] << "@depth20@100ms\"";
+        }
+        message << R"(], "id": 1})";
+        return message.str();
+    }
+
     std::string getOkxTopOfBookSubscribeMessage(std::string instrument) {
         std::ostringstream message;
         message << R"({
@@ -64,6 +75,17 @@ namespace requests {
         return message.str();
     }
 
+    // One bbo-tbt subscription for several instruments, pushes carry the instId in "arg"
+    std::string getOkxTopOfBookSubscribeMessage(const std::vector<std::string>& instruments) {
+        std::ostringstream message;
+        message << R"({"op": "subscribe", "args": [)";
+        for(size_t i = 0; i < instruments.size(); ++i) {
+            message << (i == 0 ? "" : ", ") << R"({"channel": "bbo-tbt", "instId": ")" << instruments[i] << R"("})";
+        }
+        message << "]}";
+        return message.str();
+    }
+
     std::string getOkxTopFiveLevelBookSubscribeMessage(std::string instrument) {
         std::ostringstream message;
         message << R"({
@@ -175,4 +197,15 @@ namespace requests {
 
         return message.str();
     }
+
+    // One orderbook subscription for several symbols, pushes carry the symbol in data.s
+    std::string getByBitOrderBookMessage(uint16_t depth, const std::vector<std::string>& symbols) {
+        std::ostringstream message;
+        message << R"({"op": "subscribe", "args": [)";
+        for(size_t i = 0; i < symbols.size(); ++i) {
+            message << (i == 0 ? "" : ", ") << R"("orderbook.)" << depth << "." << symbols[i] << R"(")";
+        }
+        message << "]}";
+        return message.str();
+    }
 } // namespace requests
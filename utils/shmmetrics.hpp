@@ -0,0 +1,185 @@
+#pragma once
+#include <atomic>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <fcntl.h>
+#include <immintrin.h>
+#include <stdexcept>
+#include <string>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Fixed-layout metrics segment in POSIX shared memory (/dev/shm/<name>). The engine updates it
+// in place under a seqlock; monitors (watch_trading, metrics_dump) map it read-only and retry
+// a copy while a write is in flight. The layout is read byte-for-byte by Python, so any change
+// to MetricsData must bump VERSION and update watch_trading/core/shm.py.
+namespace shm_metrics {
+
+constexpr uint64_t MAGIC = 0x315254454d445254ULL; // "TRDMETR1"
+constexpr uint32_t VERSION = 1;
+constexpr size_t VENUES = 3; // latency::Venue order: binance, bybit, okx
+constexpr size_t LATENCY_METRICS = 6; // latency::Metric order
+constexpr size_t DATA_OFFSET = 64;
+
+// Samples of the last latency reporting interval only, max_ns included (at histogram bucket
+// precision); a (metric, venue) without samples in that interval is all zeros
+struct LatencyQuantiles {
+    uint64_t count;
+    uint64_t p50_ns;
+    uint64_t p99_ns;
+    uint64_t p999_ns;
+    uint64_t max_ns;
+};
+
+struct MetricsData {
+    uint64_t updated_ns;
+    uint64_t trading_active;
+    uint64_t md_updates[VENUES];
+    uint64_t order_updates[VENUES];
+    uint64_t ws_disconnects;
+    uint64_t ws_connection_ends;
+    double best_bid[VENUES];
+    double best_ask[VENUES];
+    double position[VENUES];
+    double realized_pnl;
+    double unrealized_pnl;
+    LatencyQuantiles latency[LATENCY_METRICS][VENUES];
+};
+
+struct alignas(64) MetricsHeader {
+    uint64_t magic;
+    uint32_t version;
+    uint32_t pid;
+    uint64_t data_size;
+    std::atomic<uint64_t> sequence; // odd while a write is in flight
+};
+
+struct Segment {
+    MetricsHeader header;
+    MetricsData data;
+};
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free);
+static_assert(sizeof(MetricsHeader) == DATA_OFFSET);
+static_assert(offsetof(Segment, data) == DATA_OFFSET);
+static_assert(offsetof(MetricsData, best_bid) == 80);
+static_assert(offsetof(MetricsData, latency) == 168);
+static_assert(sizeof(MetricsData) == 168 + LATENCY_METRICS * VENUES * sizeof(LatencyQuantiles));
+
+inline std::string shmName(const std::string& name) { return name.front() == '/' ? name : "/" + name; }
+
+// Writer side, owned by the engine. Updates from several threads are serialized by a spinlock,
+// each one costs the stores it makes plus two sequence increments.
+class ShmMetrics {
+public:
+    explicit ShmMetrics(const std::string& name)
+        : m_name(shmName(name)) {
+        const int fd = shm_open(m_name.c_str(), O_CREAT | O_RDWR, 0644);
+        if(fd < 0) {
+            throw std::runtime_error("shm_open failed for " + m_name + ": " + std::strerror(errno));
+        }
+        if(ftruncate(fd, sizeof(Segment)) != 0) {
+            const int err = errno;
+            close(fd);
+            throw std::runtime_error("ftruncate failed for " + m_name + ": " + std::strerror(err));
+        }
+        void* addr = mmap(nullptr, sizeof(Segment), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        close(fd);
+        if(addr == MAP_FAILED) {
+            throw std::runtime_error("mmap failed for " + m_name + ": " + std::strerror(errno));
+        }
+        m_segment = static_cast<Segment*>(addr);
+        std::memset(&m_segment->data, 0, sizeof(MetricsData));
+        m_segment->header.magic = MAGIC;
+        m_segment->header.version = VERSION;
+        m_segment->header.pid = static_cast<uint32_t>(getpid());
+        m_segment->header.data_size = sizeof(MetricsData);
+        m_segment->header.sequence.store(0, std::memory_order_release);
+    }
+
+    ~ShmMetrics() {
+        if(m_segment) {
+            munmap(m_segment, sizeof(Segment));
+            shm_unlink(m_name.c_str());
+        }
+    }
+
+    ShmMetrics(const ShmMetrics&) = delete;
+    ShmMetrics& operator=(const ShmMetrics&) = delete;
+
+    template<typename Func>
+    void update(Func&& func, uint64_t now_ns) {
+        while(m_lock.test_and_set(std::memory_order_acquire)) {
+            _mm_pause();
+        }
+        auto& sequence = m_segment->header.sequence;
+        sequence.store(sequence.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        func(m_segment->data);
+        m_segment->data.updated_ns = now_ns;
+        sequence.store(sequence.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+        m_lock.clear(std::memory_order_release);
+    }
+
+    [[nodiscard]] const std::string& name() const { return m_name; }
+
+private:
+    std::string m_name;
+    Segment* m_segment = nullptr;
+    std::atomic_flag m_lock = ATOMIC_FLAG_INIT;
+};
+
+// Reader side for external tools. Never writes to the segment.
+class ShmMetricsReader {
+public:
+    explicit ShmMetricsReader(const std::string& name)
+        : m_name(shmName(name)) {
+        const int fd = shm_open(m_name.c_str(), O_RDONLY, 0);
+        if(fd < 0) {
+            throw std::runtime_error("shm_open failed for " + m_name + ": " + std::strerror(errno));
+        }
+        void* addr = mmap(nullptr, sizeof(Segment), PROT_READ, MAP_SHARED, fd, 0);
+        close(fd);
+        if(addr == MAP_FAILED) {
+            throw std::runtime_error("mmap failed for " + m_name + ": " + std::strerror(errno));
+        }
+        m_segment = static_cast<const Segment*>(addr);
+        if(m_segment->header.magic != MAGIC || m_segment->header.version != VERSION) {
+            munmap(const_cast<Segment*>(m_segment), sizeof(Segment));
+            throw std::runtime_error("unexpected metrics segment layout in " + m_name);
+        }
+    }
+
+    ~ShmMetricsReader() { munmap(const_cast<Segment*>(m_segment), sizeof(Segment)); }
+
+    ShmMetricsReader(const ShmMetricsReader&) = delete;
+    ShmMetricsReader& operator=(const ShmMetricsReader&) = delete;
+
+    // Consistent copy of the data, false if the writer kept it busy for all attempts
+    bool read(MetricsData& out, int attempts = 1000) const {
+        const auto& sequence = m_segment->header.sequence;
+        for(int i = 0; i < attempts; ++i) {
+            const uint64_t before = sequence.load(std::memory_order_acquire);
+            if(before & 1) {
+                continue;
+            }
+            std::memcpy(&out, &m_segment->data, sizeof(MetricsData));
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if(sequence.load(std::memory_order_relaxed) == before) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    [[nodiscard]] uint32_t pid() const { return m_segment->header.pid; }
+
+private:
+    std::string m_name;
+    const Segment* m_segment = nullptr;
+};
+
+} // namespace shm_metrics
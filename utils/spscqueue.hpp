@@ -0,0 +1,60 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <memory>
+
+// Bounded single-producer single-consumer ring. push() and pop() never block, allocate or take a
+// lock; a full ring rejects the push and leaves the decision to the producer. Each side keeps a
+// cached copy of the other side's index, so the shared cache line is only read once that copy
+// runs out.
+template<typename T>
+class SpscQueue {
+public:
+    // Rounded up to a power of two
+    explicit SpscQueue(size_t capacity)
+        : m_mask(std::bit_ceil(std::max<size_t>(capacity, 2)) - 1)
+        , m_slots(std::make_unique<T[]>(m_mask + 1)) {}
+
+    SpscQueue(const SpscQueue&) = delete;
+    SpscQueue& operator=(const SpscQueue&) = delete;
+
+    // Producer thread only
+    bool push(const T& value) {
+        const size_t head = m_head.load(std::memory_order_relaxed);
+        if(head - m_cachedTail > m_mask) {
+            m_cachedTail = m_tail.load(std::memory_order_acquire);
+            if(head - m_cachedTail > m_mask) {
+                return false;
+            }
+        }
+        m_slots[head & m_mask] = value;
+        m_head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer thread only
+    bool pop(T& value) {
+        const size_t tail = m_tail.load(std::memory_order_relaxed);
+        if(tail == m_cachedHead) {
+            m_cachedHead = m_head.load(std::memory_order_acquire);
+            if(tail == m_cachedHead) {
+                return false;
+            }
+        }
+        value = m_slots[tail & m_mask];
+        m_tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    [[nodiscard]] size_t capacity() const { return m_mask + 1; }
+
+private:
+    const size_t m_mask;
+    const std::unique_ptr<T[]> m_slots;
+    alignas(64) std::atomic<size_t> m_head{0}; // producer's line
+    size_t m_cachedTail = 0;
+    alignas(64) std::atomic<size_t> m_tail{0}; // consumer's line
+    size_t m_cachedHead = 0;
+};
@@ -1,21 +0,0 @@
-#pragma once
-namespace okx{
-    namespace DOGE_USDT_SWAP{
-        constexpr double dogePerpCtVal = 1000;
-        constexpr double dogePerpCtMul = 1;
-    }
-    namespace BTC_USDT_SWAP {
-        constexpr double btcPerpCtVal = 0.01;
-        constexpr double btcPerpCtMul = 1;
-    }
-}
-namespace bybit{
-    namespace DOGEUSDT{
-        constexpr double dogePerpCtVal = 1;
-        constexpr double dogePerpCtMul = 1;
-    }
-    namespace BTCUSDT {
-        constexpr double btcPerpCtVal = 1;
-        constexpr double btcPerpCtMul = 1;
-    }
-}
\ No newline at end of file
@@ -0,0 +1,672 @@
+#pragma once
+#include "mappedfile.hpp"
+#include "spscqueue.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <filesystem>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <numeric>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <sys/stat.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+// Columnar top-of-book store: one file per instrument and UTC day, <root>/<instrument>/<YYYYMMDD>.ticks.
+//
+// A file is a FileHeader followed by self-contained blocks of up to blockTicks ticks. Each block
+// stores its six columns one after another, every value as a zigzag varint of its difference to a
+// reference (the previous tick, or the same tick's timestamp or bid) divided by the block's common
+// divisor of those differences, so millisecond timestamps and prices on a tick grid shrink to a
+// byte or two. Prices and sizes are fixed point at PRICE_SCALE and SIZE_SCALE.
+//
+// Block headers double as the time-range index: readers map the file, walk the headers once and
+// decode only the blocks overlapping the requested range. Writers only ever append whole blocks,
+// so a reader sees every block completed before it opened the file, and a writer reopening a file
+// after a crash cuts a torn last block off. The layout is read byte-for-byte by Python, so any
+// change must bump VERSION and update python_packages/tick_store/tick_store/reader.py.
+namespace tick_store {
+
+constexpr char FILE_MAGIC[8] = {'T', 'I', 'C', 'K', 'S', 'T', 'O', 'R'};
+constexpr uint32_t VERSION = 1;
+constexpr uint32_t BLOCK_MAGIC = 0x4b4c4254; // "TBLK"
+constexpr size_t COLUMNS = 6;               // timestamp, receive, bid, ask, bid size, ask size
+constexpr double PRICE_SCALE = 1e-8;
+constexpr double SIZE_SCALE = 1e-8;
+constexpr uint64_t NS_PER_DAY = 86'400'000'000'000ULL;
+
+// One top-of-book observation. Sizes are 0 when the venue does not report them (bybit tickers).
+struct Tick {
+    uint64_t timestampNs = 0; // exchange time
+    uint64_t receiveNs = 0;   // local time the update arrived
+    double bidPrice = 0.0;
+    double bidSize = 0.0;
+    double askPrice = 0.0;
+    double askSize = 0.0;
+};
+
+struct FileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t headerSize;
+    double priceScale;
+    double sizeScale;
+    char instrument[48]; // registry name, zero padded
+};
+
+struct BlockHeader {
+    uint32_t magic;
+    uint32_t count;
+    uint64_t minNs; // timestamp range of the block, the index of the reader
+    uint64_t maxNs;
+    int64_t baseNs;  // timestamp of the first tick
+    int64_t baseBid; // fixed point bid of the first tick
+    uint64_t divisors[COLUMNS];
+    uint32_t columnBytes[COLUMNS];
+};
+
+static_assert(sizeof(FileHeader) == 80 && sizeof(BlockHeader) == 112, "layout is shared with the python reader");
+
+namespace detail {
+
+inline uint64_t zigzag(int64_t value) {
+    return (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63);
+}
+
+inline int64_t unzigzag(uint64_t value) { return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1); }
+
+inline void putVarint(std::vector<uint8_t>& out, uint64_t value) {
+    while(value >= 0x80) {
+        out.push_back(static_cast<uint8_t>(value) | 0x80);
+        value >>= 7;
+    }
+    out.push_back(static_cast<uint8_t>(value));
+}
+
+inline uint64_t getVarint(const uint8_t*& pos, const uint8_t* end) {
+    uint64_t value = 0;
+    for(int shift = 0; pos < end && shift < 64; shift += 7) {
+        const uint8_t byte = *pos++;
+        value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+        if(!(byte & 0x80)) {
+            return value;
+        }
+    }
+    throw std::runtime_error("tick store block is corrupt");
+}
+
+inline int64_t toFixed(double value, double scale) { return std::llround(value / scale); }
+
+// Days since the epoch to YYYYMMDD, proleptic gregorian
+inline std::string dayName(uint64_t day) {
+    const std::chrono::year_month_day date{std::chrono::sys_days{std::chrono::days{static_cast<int64_t>(day)}}};
+    char name[16];
+    std::snprintf(name,
+                  sizeof(name),
+                  "%04d%02u%02u",
+                  static_cast<int>(date.year()),
+                  static_cast<unsigned>(date.month()),
+                  static_cast<unsigned>(date.day()));
+    return name;
+}
+
+} // namespace detail
+
+inline std::filesystem::path dayPath(const std::filesystem::path& root, std::string_view instrument, uint64_t day) {
+    return root / std::string(instrument) / (detail::dayName(day) + ".ticks");
+}
+
+// Read-only view of one day file
+class TickFile {
+public:
+    struct BlockInfo {
+        uint64_t minNs;
+        uint64_t maxNs;
+        size_t offset; // of the block header
+        uint32_t count;
+    };
+
+    explicit TickFile(const std::string& path)
+        : m_file(path) {
+        if(m_file.size() < sizeof(FileHeader)) {
+            throw std::runtime_error("tick file too short: " + path);
+        }
+        std::memcpy(&m_header, m_file.data(), sizeof(m_header));
+        if(std::memcmp(m_header.magic, FILE_MAGIC, sizeof(FILE_MAGIC)) != 0 || m_header.version != VERSION ||
+           m_header.headerSize != sizeof(FileHeader)) {
+            throw std::runtime_error("unexpected tick file layout: " + path);
+        }
+        size_t offset = sizeof(FileHeader);
+        BlockHeader block{};
+        while(offset + sizeof(BlockHeader) <= m_file.size()) {
+            std::memcpy(&block, m_file.data() + offset, sizeof(block));
+            size_t bytes = 0;
+            for(const uint32_t column : block.columnBytes) {
+                bytes += column;
+            }
+            if(block.magic != BLOCK_MAGIC || offset + sizeof(BlockHeader) + bytes > m_file.size()) {
+                break; // torn by a crash while writing, everything before it is intact
+            }
+            m_blocks.push_back({block.minNs, block.maxNs, offset, block.count});
+            m_tickCount += block.count;
+            offset += sizeof(BlockHeader) + bytes;
+        }
+    }
+
+    [[nodiscard]] std::string_view instrument() const {
+        return {m_header.instrument, strnlen(m_header.instrument, sizeof(m_header.instrument))};
+    }
+    [[nodiscard]] const std::vector<BlockInfo>& blocks() const { return m_blocks; }
+    [[nodiscard]] size_t tickCount() const { return m_tickCount; }
+
+    // Appends the ticks of one block to out
+    void decodeBlock(size_t index, std::vector<Tick>& out) const {
+        BlockHeader block{};
+        std::memcpy(&block, m_file.data() + m_blocks.at(index).offset, sizeof(block));
+        const auto* pos = reinterpret_cast<const uint8_t*>(m_file.data() + m_blocks[index].offset + sizeof(block));
+        const size_t first = out.size();
+        out.resize(first + block.count);
+        Tick* ticks = out.data() + first;
+
+        int64_t previous = block.baseNs;
+        const uint8_t* end = pos + block.columnBytes[0];
+        for(uint32_t i = 0; i < block.count; ++i) {
+            previous += detail::unzigzag(detail::getVarint(pos, end)) * static_cast<int64_t>(block.divisors[0]);
+            ticks[i].timestampNs = static_cast<uint64_t>(previous);
+        }
+        end = pos + block.columnBytes[1];
+        for(uint32_t i = 0; i < block.count; ++i) {
+            ticks[i].receiveNs = static_cast<uint64_t>(
+                static_cast<int64_t>(ticks[i].timestampNs) +
+                detail::unzigzag(detail::getVarint(pos, end)) * static_cast<int64_t>(block.divisors[1]));
+        }
+        // bids are kept fixed point until the ask, which is stored as the spread to them, is decoded
+        std::vector<int64_t> bids(block.count);
+        previous = block.baseBid;
+        end = pos + block.columnBytes[2];
+        for(uint32_t i = 0; i < block.count; ++i) {
+            previous += detail::unzigzag(detail::getVarint(pos, end)) * static_cast<int64_t>(block.divisors[2]);
+            bids[i] = previous;
+            ticks[i].bidPrice = static_cast<double>(previous) * m_header.priceScale;
+        }
+        end = pos + block.columnBytes[3];
+        for(uint32_t i = 0; i < block.count; ++i) {
+            const int64_t spread =
+                detail::unzigzag(detail::getVarint(pos, end)) * static_cast<int64_t>(block.divisors[3]);
+            ticks[i].askPrice = static_cast<double>(bids[i] + spread) * m_header.priceScale;
+        }
+        end = pos + block.columnBytes[4];
+        for(uint32_t i = 0; i < block.count; ++i) {
+            ticks[i].bidSize = static_cast<double>(detail::unzigzag(detail::getVarint(pos, end)) *
+                                                   static_cast<int64_t>(block.divisors[4])) *
+                               m_header.sizeScale;
+        }
+        end = pos + block.columnBytes[5];
+        for(uint32_t i = 0; i < block.count; ++i) {
+            ticks[i].askSize = static_cast<double>(detail::unzigzag(detail::getVarint(pos, end)) *
+                                                   static_cast<int64_t>(block.divisors[5])) *
+                               m_header.sizeScale;
+        }
+    }
+
+    // Appends the ticks with fromNs <= timestampNs < toNs, only overlapping blocks are decoded
+    size_t read(uint64_t fromNs, uint64_t toNs, std::vector<Tick>& out) const {
+        const size_t before = out.size();
+        for(size_t index = 0; index < m_blocks.size(); ++index) {
+            const auto& block = m_blocks[index];
+            if(block.maxNs < fromNs || block.minNs >= toNs) {
+                continue;
+            }
+            const size_t first = out.size();
+            decodeBlock(index, out);
+            if(block.minNs < fromNs || block.maxNs >= toNs) {
+                const auto outside = [fromNs, toNs](const Tick& tick) {
+                    return tick.timestampNs < fromNs || tick.timestampNs >= toNs;
+                };
+                out.erase(std::remove_if(out.begin() + static_cast<std::ptrdiff_t>(first), out.end(), outside),
+                          out.end());
+            }
+        }
+        return out.size() - before;
+    }
+
+private:
+    MappedFile m_file;
+    FileHeader m_header{};
+    std::vector<BlockInfo> m_blocks;
+    size_t m_tickCount = 0;
+};
+
+// Appends ticks of one instrument to one file. A block is written once it holds blockTicks ticks,
+// or once it got older than maxBlockAgeNs, checked on append and by flushAged(), so a quiet market
+// still reaches disk. Not thread-safe, see TickStoreWriter.
+class TickFileWriter {
+public:
+    TickFileWriter(const std::string& path,
+                   std::string_view instrument,
+                   uint32_t blockTicks = 4096,
+                   uint64_t maxBlockAgeNs = 10'000'000'000)
+        : m_path(path)
+        , m_blockTicks(std::max<uint32_t>(1, blockTicks))
+        , m_maxBlockAgeNs(maxBlockAgeNs) {
+        if(instrument.size() >= sizeof(FileHeader::instrument)) {
+            throw std::invalid_argument("instrument name too long for a tick file: " + std::string(instrument));
+        }
+        m_fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+        if(m_fd < 0) {
+            throw std::runtime_error("open failed for " + path + ": " + std::strerror(errno));
+        }
+        try {
+            openOrCreate(instrument);
+        } catch(...) {
+            ::close(m_fd);
+            throw;
+        }
+        m_pending.reserve(m_blockTicks);
+    }
+
+    ~TickFileWriter() {
+        try {
+            flush();
+        } catch(...) {
+        }
+        ::close(m_fd);
+    }
+
+    TickFileWriter(const TickFileWriter&) = delete;
+    TickFileWriter& operator=(const TickFileWriter&) = delete;
+
+    void append(const Tick& tick) {
+        flushAged(tick.receiveNs);
+        m_pending.push_back(tick);
+        if(m_pending.size() >= m_blockTicks) {
+            flush();
+        }
+    }
+
+    // Writes the pending block if its first tick was received maxBlockAgeNs or more before nowNs
+    void flushAged(uint64_t nowNs) {
+        if(!m_pending.empty() && nowNs >= m_pending.front().receiveNs + m_maxBlockAgeNs) {
+            flush();
+        }
+    }
+
+    // Writes the pending ticks as a (possibly short) block
+    void flush() {
+        if(m_pending.empty()) {
+            return;
+        }
+        encodeBlock();
+        m_pending.clear();
+        const uint8_t* data = m_buffer.data();
+        size_t left = m_buffer.size();
+        while(left > 0) {
+            const ssize_t written = ::write(m_fd, data, left);
+            if(written < 0) {
+                if(errno == EINTR) {
+                    continue;
+                }
+                throw std::runtime_error("write failed for " + m_path + ": " + std::strerror(errno));
+            }
+            data += written;
+            left -= static_cast<size_t>(written);
+        }
+    }
+
+    [[nodiscard]] const std::string& path() const { return m_path; }
+
+private:
+    void openOrCreate(std::string_view instrument) {
+        struct stat info {};
+        if(fstat(m_fd, &info) != 0) {
+            throw std::runtime_error("fstat failed for " + m_path + ": " + std::strerror(errno));
+        }
+        FileHeader header{};
+        if(info.st_size == 0) {
+            std::memcpy(header.magic, FILE_MAGIC, sizeof(FILE_MAGIC));
+            header.version = VERSION;
+            header.headerSize = sizeof(FileHeader);
+            header.priceScale = PRICE_SCALE;
+            header.sizeScale = SIZE_SCALE;
+            std::memcpy(header.instrument, instrument.data(), instrument.size());
+            if(::pwrite(m_fd, &header, sizeof(header), 0) != static_cast<ssize_t>(sizeof(header))) {
+                throw std::runtime_error("cannot write tick file header: " + m_path);
+            }
+            ::lseek(m_fd, sizeof(header), SEEK_SET);
+            return;
+        }
+        // reopened after a restart: keep the complete blocks and continue after them
+        const TickFile existing(m_path);
+        if(existing.instrument() != instrument) {
+            throw std::runtime_error("tick file " + m_path + " belongs to " + std::string(existing.instrument()));
+        }
+        size_t end = sizeof(FileHeader);
+        if(!existing.blocks().empty()) {
+            BlockHeader last{};
+            if(::pread(m_fd, &last, sizeof(last), static_cast<off_t>(existing.blocks().back().offset)) !=
+               static_cast<ssize_t>(sizeof(last))) {
+                throw std::runtime_error("cannot read tick file " + m_path);
+            }
+            end = existing.blocks().back().offset + sizeof(BlockHeader);
+            for(const uint32_t column : last.columnBytes) {
+                end += column;
+            }
+        }
+        if(static_cast<size_t>(info.st_size) != end && ::ftruncate(m_fd, static_cast<off_t>(end)) != 0) {
+            throw std::runtime_error("cannot cut the torn block of " + m_path);
+        }
+        ::lseek(m_fd, static_cast<off_t>(end), SEEK_SET);
+    }
+
+    // Differences are divided by their common divisor before they are zigzag varint encoded
+    void encodeColumn(size_t column, const std::vector<int64_t>& deltas, BlockHeader& header) {
+        uint64_t divisor = 0;
+        for(const int64_t delta : deltas) {
+            divisor = std::gcd(divisor, static_cast<uint64_t>(delta < 0 ? -delta : delta));
+        }
+        divisor = std::max<uint64_t>(divisor, 1);
+        const size_t start = m_buffer.size();
+        for(const int64_t delta : deltas) {
+            detail::putVarint(m_buffer, detail::zigzag(delta / static_cast<int64_t>(divisor)));
+        }
+        header.divisors[column] = divisor;
+        header.columnBytes[column] = static_cast<uint32_t>(m_buffer.size() - start);
+    }
+
+    void encodeBlock() {
+        const size_t count = m_pending.size();
+        BlockHeader header{};
+        header.magic = BLOCK_MAGIC;
+        header.count = static_cast<uint32_t>(count);
+        header.minNs = std::numeric_limits<uint64_t>::max();
+        header.baseNs = static_cast<int64_t>(m_pending.front().timestampNs);
+        header.baseBid = detail::toFixed(m_pending.front().bidPrice, PRICE_SCALE);
+        m_buffer.assign(sizeof(BlockHeader), 0);
+
+        std::vector<int64_t> deltas(count);
+        int64_t previous = header.baseNs;
+        for(size_t i = 0; i < count; ++i) {
+            const auto timestamp = static_cast<int64_t>(m_pending[i].timestampNs);
+            deltas[i] = timestamp - previous;
+            previous = timestamp;
+            header.minNs = std::min(header.minNs, m_pending[i].timestampNs);
+            header.maxNs = std::max(header.maxNs, m_pending[i].timestampNs);
+        }
+        encodeColumn(0, deltas, header);
+        for(size_t i = 0; i < count; ++i) {
+            deltas[i] = static_cast<int64_t>(m_pending[i].receiveNs) - static_cast<int64_t>(m_pending[i].timestampNs);
+        }
+        encodeColumn(1, deltas, header);
+        std::vector<int64_t> bids(count);
+        previous = header.baseBid;
+        for(size_t i = 0; i < count; ++i) {
+            bids[i] = detail::toFixed(m_pending[i].bidPrice, PRICE_SCALE);
+            deltas[i] = bids[i] - previous;
+            previous = bids[i];
+        }
+        encodeColumn(2, deltas, header);
+        for(size_t i = 0; i < count; ++i) {
+            deltas[i] = detail::toFixed(m_pending[i].askPrice, PRICE_SCALE) - bids[i];
+        }
+        encodeColumn(3, deltas, header);
+        for(size_t i = 0; i < count; ++i) {
+            deltas[i] = detail::toFixed(m_pending[i].bidSize, SIZE_SCALE);
+        }
+        encodeColumn(4, deltas, header);
+        for(size_t i = 0; i < count; ++i) {
+            deltas[i] = detail::toFixed(m_pending[i].askSize, SIZE_SCALE);
+        }
+        encodeColumn(5, deltas, header);
+        std::memcpy(m_buffer.data(), &header, sizeof(header));
+    }
+
+    std::string m_path;
+    uint32_t m_blockTicks;
+    uint64_t m_maxBlockAgeNs;
+    int m_fd = -1;
+    std::vector<Tick> m_pending;
+    std::vector<uint8_t> m_buffer;
+};
+
+// Appender of one instrument across days, the live engine keeps one per md symbol and feeds it from
+// a TickRecordingThread. Ticks go to the file of the UTC day of their exchange timestamp.
+// Thread-safe, append() blocks on block encoding and file I/O so it has no place on an md thread.
+// @example
+//   tick_store::TickStoreWriter writer("ticks", "okx_perp_btc_usdt");
+//   writer.append({book.m_timestamp, receive_ns, book.getBestBid(), bid_size, book.getBestAsk(), ask_size});
+class TickStoreWriter {
+public:
+    TickStoreWriter(std::filesystem::path root,
+                    std::string instrument,
+                    uint32_t blockTicks = 4096,
+                    uint64_t maxBlockAgeNs = 10'000'000'000)
+        : m_root(std::move(root))
+        , m_instrument(std::move(instrument))
+        , m_blockTicks(blockTicks)
+        , m_maxBlockAgeNs(maxBlockAgeNs) {
+        std::filesystem::create_directories(m_root / m_instrument);
+    }
+
+    void append(Tick tick) {
+        if(tick.timestampNs == 0) {
+            tick.timestampNs = tick.receiveNs; // venue without exchange time
+        }
+        std::lock_guard<std::mutex> lock(m_mutex);
+        const uint64_t day = tick.timestampNs / NS_PER_DAY;
+        if(!m_file || day != m_day) {
+            m_file.reset(); // flushes the previous day
+            m_file = std::make_unique<TickFileWriter>(
+                dayPath(m_root, m_instrument, day).string(), m_instrument, m_blockTicks, m_maxBlockAgeNs);
+            m_day = day;
+        }
+        m_file->append(tick);
+        ++m_appended;
+    }
+
+    void flush() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if(m_file) {
+            m_file->flush();
+        }
+    }
+
+    // nowNs on the receive clock, the wall clock of the md threads
+    void flushAged(uint64_t nowNs) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if(m_file) {
+            m_file->flushAged(nowNs);
+        }
+    }
+
+    [[nodiscard]] const std::string& instrument() const { return m_instrument; }
+
+    [[nodiscard]] uint64_t appended() const {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_appended;
+    }
+
+private:
+    const std::filesystem::path m_root;
+    const std::string m_instrument;
+    const uint32_t m_blockTicks;
+    const uint64_t m_maxBlockAgeNs;
+    mutable std::mutex m_mutex;
+    std::unique_ptr<TickFileWriter> m_file;
+    uint64_t m_day = 0;
+    uint64_t m_appended = 0;
+};
+
+// Moves tick store I/O off the md threads. Every md connection records through its own Producer, an
+// SPSC ring it pushes to without blocking; one background thread drains all rings into the
+// TickStoreWriters, so block encoding, write() and day files are never on a connection thread. A
+// full ring drops the tick and counts it instead of stalling the feed. While the rings are empty the
+// thread also writes blocks past their max age, so a feed that went quiet does not hold its last ticks.
+// @example
+//   tick_store::TickRecordingThread recording(connections);
+//   recording.producer(i).record(writer, tick); // on connection i
+//   recording.stop();                           // drains every ring, then writers can be flushed
+class TickRecordingThread {
+public:
+    static constexpr size_t DEFAULT_CAPACITY = 16384; // ticks per connection, about 1 MB
+    static constexpr auto IDLE_SLEEP = std::chrono::milliseconds(1);
+    static constexpr auto AGE_CHECK_INTERVAL = std::chrono::milliseconds(100);
+
+    struct Entry {
+        TickStoreWriter* writer = nullptr;
+        Tick tick;
+    };
+
+    class Producer {
+    public:
+        explicit Producer(size_t capacity)
+            : m_queue(capacity) {}
+
+        // Connection thread only
+        void record(TickStoreWriter& writer, const Tick& tick) {
+            if(!m_queue.push({&writer, tick})) {
+                m_dropped.store(m_dropped.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+            }
+        }
+
+        [[nodiscard]] uint64_t dropped() const { return m_dropped.load(std::memory_order_relaxed); }
+
+    private:
+        friend class TickRecordingThread;
+
+        SpscQueue<Entry> m_queue;
+        std::atomic<uint64_t> m_dropped{0};
+    };
+
+    explicit TickRecordingThread(size_t producers, size_t capacity = DEFAULT_CAPACITY) {
+        m_producers.reserve(producers);
+        for(size_t i = 0; i < producers; ++i) {
+            m_producers.push_back(std::make_unique<Producer>(capacity));
+        }
+    }
+
+    ~TickRecordingThread() { stop(); }
+
+    TickRecordingThread(const TickRecordingThread&) = delete;
+    TickRecordingThread& operator=(const TickRecordingThread&) = delete;
+
+    Producer& producer(size_t index) { return *m_producers.at(index); }
+
+    void start() {
+        if(!m_thread.joinable()) {
+            m_thread = std::thread([this] { run(); });
+        }
+    }
+
+    // Returns once everything pushed before the call is in the writers
+    void stop() {
+        m_stopping.store(true, std::memory_order_release);
+        if(m_thread.joinable()) {
+            m_thread.join();
+        }
+    }
+
+    [[nodiscard]] uint64_t dropped() const {
+        uint64_t dropped = 0;
+        for(const auto& producer : m_producers) {
+            dropped += producer->dropped();
+        }
+        return dropped;
+    }
+
+    // Ticks or aged block writes a writer threw on (disk full, unwritable root); the thread keeps draining
+    [[nodiscard]] uint64_t failed() const { return m_failed.load(std::memory_order_relaxed); }
+
+private:
+    void run() {
+        Entry entry;
+        std::vector<TickStoreWriter*> writers; // every writer recorded to, for the age check
+        auto lastAgeCheck = std::chrono::steady_clock::now();
+        while(true) {
+            const bool stopping = m_stopping.load(std::memory_order_acquire);
+            bool idle = true;
+            for(const auto& producer : m_producers) {
+                while(producer->m_queue.pop(entry)) {
+                    idle = false;
+                    if(std::find(writers.begin(), writers.end(), entry.writer) == writers.end()) {
+                        writers.push_back(entry.writer);
+                    }
+                    try {
+                        entry.writer->append(entry.tick);
+                    } catch(const std::exception&) {
+                        m_failed.fetch_add(1, std::memory_order_relaxed);
+                    }
+                }
+            }
+            if(idle && stopping) {
+                return; // a whole pass after the stop request found nothing
+            }
+            if(!idle) {
+                continue;
+            }
+            if(std::chrono::steady_clock::now() - lastAgeCheck >= AGE_CHECK_INTERVAL) {
+                lastAgeCheck = std::chrono::steady_clock::now();
+                flushAged(writers);
+            }
+            std::this_thread::sleep_for(IDLE_SLEEP);
+        }
+    }
+
+    void flushAged(const std::vector<TickStoreWriter*>& writers) {
+        const auto nowNs = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                                     std::chrono::system_clock::now().time_since_epoch())
+                                                     .count());
+        for(TickStoreWriter* writer : writers) {
+            try {
+                writer->flushAged(nowNs);
+            } catch(const std::exception&) {
+                m_failed.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+    }
+
+    std::vector<std::unique_ptr<Producer>> m_producers;
+    std::atomic<bool> m_stopping{false};
+    std::atomic<uint64_t> m_failed{0};
+    std::thread m_thread;
+};
+
+// Ticks of one instrument with fromNs <= timestampNs < toNs across its day files, in file order
+inline std::vector<Tick> read(const std::filesystem::path& root,
+                              std::string_view instrument,
+                              uint64_t fromNs = 0,
+                              uint64_t toNs = std::numeric_limits<uint64_t>::max()) {
+    std::vector<std::filesystem::path> files;
+    const auto directory = root / std::string(instrument);
+    if(!std::filesystem::is_directory(directory)) {
+        throw std::runtime_error("no tick store for " + std::string(instrument) + " under " + root.string());
+    }
+    const std::string first = detail::dayName(fromNs / NS_PER_DAY) + ".ticks";
+    const std::string last = toNs == std::numeric_limits<uint64_t>::max()
+                                 ? std::string("99999999.ticks")
+                                 : detail::dayName((toNs - 1) / NS_PER_DAY) + ".ticks";
+    for(const auto& entry : std::filesystem::directory_iterator(directory)) {
+        const auto name = entry.path().filename().string();
+        if(entry.path().extension() == ".ticks" && name >= first && name <= last) {
+            files.push_back(entry.path());
+        }
+    }
+    std::sort(files.begin(), files.end());
+    std::vector<Tick> ticks;
+    for(const auto& path : files) {
+        TickFile(path.string()).read(fromNs, toNs, ticks);
+    }
+    return ticks;
+}
+
+} // namespace tick_store
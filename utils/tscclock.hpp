@@ -0,0 +1,229 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <ctime>
+#include <fstream>
+#include <string>
+#include <thread>
+#if defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#include <x86intrin.h>
+#define TSC_CLOCK_AVAILABLE 1
+#else
+#define TSC_CLOCK_AVAILABLE 0
+#endif
+
+// Wall-clock nanoseconds from the invariant TSC. A reading is one rdtscp plus a fixed-point
+// multiply instead of a clock_gettime() vDSO call. The tick rate is calibrated against
+// CLOCK_REALTIME at startup and re-anchored every RECALIBRATION_INTERVAL_NS by whichever thread
+// first notices the anchor is due, so NTP adjustments are followed with at most a few ns step.
+// Readings from different cores are compared directly: the TSC is only used while the kernel keeps
+// it as its clocksource, which it drops when the cores' counters do not agree.
+// Without an invariant, kernel-trusted TSC every call falls back to CLOCK_REALTIME.
+class TscClock {
+public:
+    static constexpr uint64_t RECALIBRATION_INTERVAL_NS = 1'000'000'000;
+
+    static TscClock& instance() {
+        static TscClock clock;
+        return clock;
+    }
+
+    TscClock(const TscClock&) = delete;
+    TscClock& operator=(const TscClock&) = delete;
+
+    // Wall time in ns since the epoch, same scale as system_clock
+    uint64_t now_ns() {
+#if TSC_CLOCK_AVAILABLE
+        if(m_invariant) {
+            uint32_t cpu;
+            return wall_ns(read(cpu));
+        }
+#endif
+        return realtime_ns();
+    }
+
+    // Raw counter for interval measurement; store it on the hot path and convert with to_wall_ns() later
+    uint64_t ticks() const {
+        if(!m_invariant) {
+            return realtime_ns();
+        }
+        uint32_t cpu = 0;
+        return read(cpu);
+    }
+
+    // Lazily converts a ticks() reading taken on any core, meant for recent readings only
+    uint64_t to_wall_ns(uint64_t tsc) const {
+        if(!m_invariant) {
+            return tsc;
+        }
+        const Anchor anchor = load_anchor();
+        return anchor.ns + scale(static_cast<int64_t>(tsc - anchor.tsc), anchor.mult);
+    }
+
+    // Converts a difference of two ticks() readings to ns
+    uint64_t ticks_to_ns(uint64_t delta) const {
+        if(!m_invariant) {
+            return delta;
+        }
+        return scale(static_cast<int64_t>(delta), load_anchor().mult);
+    }
+
+    [[nodiscard]] bool isInvariant() const { return m_invariant; }
+
+    [[nodiscard]] double ticksPerNs() const {
+        const uint64_t mult = load_anchor().mult;
+        return mult == 0 ? 0.0 : static_cast<double>(uint64_t{1} << FRACTION_BITS) / static_cast<double>(mult);
+    }
+
+private:
+    static constexpr int FRACTION_BITS = 32;
+    static constexpr uint64_t CALIBRATION_SPIN_NS = 10'000'000;
+
+    struct Anchor {
+        uint64_t tsc = 0;
+        uint64_t ns = 0;
+        uint64_t mult = 0; // ns per tick in 32.32 fixed point
+    };
+
+    TscClock() {
+        m_invariant = detect_invariant_tsc() && kernel_uses_tsc();
+        if(!m_invariant) {
+            return;
+        }
+        uint32_t cpu = 0;
+        const auto first = sample(cpu);
+        const uint64_t deadline = first.ns + CALIBRATION_SPIN_NS;
+        while(realtime_ns() < deadline) {
+            std::this_thread::yield();
+        }
+        auto second = sample(cpu);
+        second.mult = rate(first, second);
+        store_anchor(second);
+    }
+
+    static uint64_t realtime_ns() {
+        timespec ts;
+        clock_gettime(CLOCK_REALTIME, &ts);
+        return static_cast<uint64_t>(ts.tv_sec) * 1'000'000'000ULL + static_cast<uint64_t>(ts.tv_nsec);
+    }
+
+    // The kernel checks at boot, and keeps watching, that the counters of all cores agree
+    static bool kernel_uses_tsc() {
+        std::ifstream file("/sys/devices/system/clocksource/clocksource0/current_clocksource");
+        std::string source;
+        return (file >> source) && source == "tsc";
+    }
+
+#if TSC_CLOCK_AVAILABLE
+    static bool detect_invariant_tsc() {
+        unsigned int eax, ebx, ecx, edx;
+        if(!__get_cpuid(0x80000000, &eax, &ebx, &ecx, &edx) || eax < 0x80000007) {
+            return false;
+        }
+        __get_cpuid(0x80000007, &eax, &ebx, &ecx, &edx);
+        return (edx & (1u << 8)) != 0;
+    }
+
+    // Linux stores (node << 12) | cpu in TSC_AUX
+    static uint64_t read(uint32_t& cpu) {
+        const uint64_t tsc = __rdtscp(&cpu);
+        cpu &= 0xfff;
+        return tsc;
+    }
+#else
+    static bool detect_invariant_tsc() { return false; }
+    static uint64_t read(uint32_t& cpu) {
+        cpu = 0;
+        return 0;
+    }
+#endif
+
+    // Tightest (tsc, realtime) pair out of a few tries; the tsc is the midpoint around clock_gettime
+    static Anchor sample(uint32_t& cpu) {
+        Anchor best;
+        uint64_t best_window = UINT64_MAX;
+        for(int i = 0; i < 8; ++i) {
+            uint32_t cpu_before, cpu_after;
+            const uint64_t before = read(cpu_before);
+            const uint64_t ns = realtime_ns();
+            const uint64_t after = read(cpu_after);
+            if(cpu_before != cpu_after || after - before >= best_window) {
+                continue;
+            }
+            best_window = after - before;
+            best.tsc = before + (after - before) / 2;
+            best.ns = ns;
+            cpu = cpu_after;
+        }
+        return best;
+    }
+
+    static uint64_t rate(const Anchor& from, const Anchor& to) {
+        const uint64_t ticks = to.tsc - from.tsc;
+        if(ticks == 0 || to.ns <= from.ns) {
+            return from.mult;
+        }
+        return static_cast<uint64_t>((static_cast<unsigned __int128>(to.ns - from.ns) << FRACTION_BITS) / ticks);
+    }
+
+    static uint64_t scale(int64_t ticks, uint64_t mult) {
+        if(ticks < 0) {
+            return -static_cast<uint64_t>((static_cast<unsigned __int128>(-ticks) * mult) >> FRACTION_BITS);
+        }
+        return static_cast<uint64_t>((static_cast<unsigned __int128>(ticks) * mult) >> FRACTION_BITS);
+    }
+
+    uint64_t wall_ns(uint64_t tsc) {
+        Anchor anchor = load_anchor();
+        const int64_t elapsed = static_cast<int64_t>(tsc - anchor.tsc);
+        if(elapsed > 0 && scale(elapsed, anchor.mult) >= RECALIBRATION_INTERVAL_NS) {
+            recalibrate(anchor);
+        }
+        return anchor.ns + scale(static_cast<int64_t>(tsc - anchor.tsc), anchor.mult);
+    }
+
+    void recalibrate(Anchor& anchor) {
+        if(m_recalibrating.test_and_set(std::memory_order_acquire)) {
+            return;
+        }
+        uint32_t cpu = 0;
+        Anchor next = sample(cpu);
+        if(next.tsc != 0) {
+            next.mult = rate(anchor, next);
+            store_anchor(next);
+            anchor = next;
+        }
+        m_recalibrating.clear(std::memory_order_release);
+    }
+
+    // Seqlock: one writer (guarded by m_recalibrating), readers retry while a write is in flight
+    Anchor load_anchor() const {
+        Anchor anchor;
+        uint32_t seq;
+        do {
+            seq = m_sequence.load(std::memory_order_acquire);
+            anchor.tsc = m_anchorTsc.load(std::memory_order_relaxed);
+            anchor.ns = m_anchorNs.load(std::memory_order_relaxed);
+            anchor.mult = m_mult.load(std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_acquire);
+        } while((seq & 1) || seq != m_sequence.load(std::memory_order_relaxed));
+        return anchor;
+    }
+
+    void store_anchor(const Anchor& anchor) {
+        m_sequence.fetch_add(1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        m_anchorTsc.store(anchor.tsc, std::memory_order_relaxed);
+        m_anchorNs.store(anchor.ns, std::memory_order_relaxed);
+        m_mult.store(anchor.mult, std::memory_order_relaxed);
+        m_sequence.fetch_add(1, std::memory_order_release);
+    }
+
+    bool m_invariant = false;
+    alignas(64) std::atomic<uint32_t> m_sequence{0};
+    std::atomic<uint64_t> m_anchorTsc{0};
+    std::atomic<uint64_t> m_anchorNs{0};
+    std::atomic<uint64_t> m_mult{0};
+    std::atomic_flag m_recalibrating = ATOMIC_FLAG_INIT;
+};
@@ -0,0 +1,182 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// Fixed set of worker threads, each with its own task deque. A worker runs its newest task first
+// and, once its deque is empty, steals the oldest task of another worker, so long and short tasks
+// even out across cores without a shared queue every pop contends on. Submissions from outside the
+// pool are dealt round-robin, submissions from a task go to the deque of the worker running it.
+// Meant for coarse tasks (whole backtests, file conversions); each deque has its own mutex. Workers
+// claim tasks from an atomic count, the pool mutex is only taken to sleep on an empty pool and to
+// wake a sleeping worker.
+// @example
+//   WorkStealingPool pool; // one worker per core
+//   for(const auto& params : grid) {
+//       pool.submit([&, params] { results.add(run_backtest(params)); });
+//   }
+//   pool.wait(); // rethrows the first exception a task threw
+class WorkStealingPool {
+public:
+    using Task = std::function<void()>;
+
+    explicit WorkStealingPool(size_t threadCount = std::thread::hardware_concurrency())
+        : m_queues(std::max<size_t>(1, threadCount)) {
+        for(auto& queue : m_queues) {
+            queue = std::make_unique<Queue>();
+        }
+        m_threads.reserve(m_queues.size());
+        for(size_t index = 0; index < m_queues.size(); ++index) {
+            m_threads.emplace_back([this, index] { run(index); });
+        }
+    }
+
+    ~WorkStealingPool() {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stopping = true;
+        }
+        m_workAvailable.notify_all();
+        for(auto& thread : m_threads) {
+            thread.join();
+        }
+    }
+
+    WorkStealingPool(const WorkStealingPool&) = delete;
+    WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+    void submit(Task task) {
+        const size_t index = t_worker.pool == this
+                                 ? t_worker.index
+                                 : m_nextQueue.fetch_add(1, std::memory_order_relaxed) % m_queues.size();
+        m_unfinished.fetch_add(1, std::memory_order_relaxed);
+        {
+            std::lock_guard<std::mutex> lock(m_queues[index]->mutex);
+            m_queues[index]->tasks.push_back(std::move(task));
+        }
+        m_queued.fetch_add(1, std::memory_order_seq_cst);
+        // Pairs with the sleeper count in run(): either the worker sees the task or we see the worker
+        if(m_sleeping.load(std::memory_order_seq_cst) > 0) {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_workAvailable.notify_one();
+        }
+    }
+
+    // Blocks until every submitted task finished, must not be called from a task
+    void wait() {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_allDone.wait(lock, [this] { return m_unfinished.load(std::memory_order_acquire) == 0; });
+        if(m_error) {
+            std::rethrow_exception(std::exchange(m_error, nullptr));
+        }
+    }
+
+    [[nodiscard]] size_t threadCount() const { return m_threads.size(); }
+
+    // Tasks taken from another worker's deque so far
+    [[nodiscard]] size_t stealCount() const { return m_steals.load(std::memory_order_relaxed); }
+
+private:
+    struct alignas(64) Queue {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    struct WorkerSlot {
+        const WorkStealingPool* pool;
+        size_t index;
+    };
+
+    static inline thread_local WorkerSlot t_worker{nullptr, 0}; // pool and deque of a worker thread
+
+    bool popOwn(size_t index, Task& task) {
+        Queue& queue = *m_queues[index];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if(queue.tasks.empty()) {
+            return false;
+        }
+        task = std::move(queue.tasks.back());
+        queue.tasks.pop_back();
+        return true;
+    }
+
+    bool steal(size_t thief, Task& task) {
+        for(size_t offset = 1; offset < m_queues.size(); ++offset) {
+            Queue& queue = *m_queues[(thief + offset) % m_queues.size()];
+            std::lock_guard<std::mutex> lock(queue.mutex);
+            if(!queue.tasks.empty()) {
+                task = std::move(queue.tasks.front());
+                queue.tasks.pop_front();
+                m_steals.fetch_add(1, std::memory_order_relaxed);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Claims one task, which is in some deque until taken
+    bool claim() {
+        size_t queued = m_queued.load(std::memory_order_acquire);
+        while(queued > 0) {
+            if(m_queued.compare_exchange_weak(queued, queued - 1, std::memory_order_acq_rel)) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void run(size_t index) {
+        t_worker = {this, index};
+        while(true) {
+            if(!claim()) {
+                std::unique_lock<std::mutex> lock(m_mutex);
+                m_sleeping.fetch_add(1, std::memory_order_seq_cst);
+                m_workAvailable.wait(
+                    lock, [this] { return m_queued.load(std::memory_order_seq_cst) > 0 || m_stopping; });
+                m_sleeping.fetch_sub(1, std::memory_order_relaxed);
+                if(m_queued.load(std::memory_order_acquire) == 0) {
+                    return; // stopping with nothing left
+                }
+                continue; // another worker may claim it first
+            }
+            Task task;
+            while(!popOwn(index, task) && !steal(index, task)) {
+                std::this_thread::yield(); // tasks are pushed before they are counted, one is left
+            }
+            try {
+                task();
+            } catch(...) {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                if(!m_error) {
+                    m_error = std::current_exception();
+                }
+            }
+            if(m_unfinished.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_allDone.notify_all();
+            }
+        }
+    }
+
+    std::vector<std::unique_ptr<Queue>> m_queues;
+    std::vector<std::thread> m_threads;
+    std::mutex m_mutex; // guards m_stopping and m_error, workers sleep on it
+    std::condition_variable m_workAvailable;
+    std::condition_variable m_allDone;
+    std::atomic<size_t> m_queued{0};   // tasks pushed to a deque and not claimed yet
+    std::atomic<size_t> m_sleeping{0}; // workers waiting on m_workAvailable
+    bool m_stopping = false;
+    std::exception_ptr m_error;
+    std::atomic<size_t> m_unfinished{0};
+    std::atomic<size_t> m_nextQueue{0};
+    std::atomic<size_t> m_steals{0};
+};